@@ -30,6 +30,7 @@
 #include "metrics/metrics.h"
 #include "healthcheck/healthcheck-stats.h"
 #include "logmsg/logmsg.h"
+#include "logmatcher-prefilter.h"
 #include "logsource.h"
 #include "logwriter.h"
 #include "afinter.h"
@@ -231,6 +232,7 @@ app_startup(void)
   healthcheck_stats_global_init();
   tzset();
   log_msg_global_init();
+  log_matcher_prefilter_global_init();
   log_source_global_init();
   log_template_global_init();
   value_pairs_global_init();
@@ -281,6 +283,7 @@ app_shutdown(void)
   scratch_buffers_global_deinit();
   value_pairs_global_deinit();
   log_template_global_deinit();
+  log_matcher_prefilter_global_deinit();
   log_msg_global_deinit();
 
   afinter_global_deinit();
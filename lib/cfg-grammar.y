@@ -264,6 +264,7 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 %token KW_BATCH_SIZE                  10601
 %token KW_FILTERX_JIT                 10602
 %token KW_FILTERX_JIT_DEBUG_INFO      10603
+%token KW_REGEXP_PREFILTER            10604
 
 %token KW_STATS                       10400
 %token KW_FREQ                        10401
@@ -310,6 +311,7 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 %token KW_FRAC_DIGITS                 10152
 
 %token KW_LOG_FIFO_SIZE               10160
+%token KW_LOG_FIFO_LOCK_FREE          10161
 %token KW_LOG_FETCH_LIMIT             10162
 %token KW_LOG_IW_SIZE                 10163
 %token KW_LOG_PREFIX                  10164
@@ -1134,12 +1136,14 @@ options_item
 	| KW_USE_RCPTID '(' yesno ')'		{ cfg_set_use_uniqid($3); }
 	| KW_USE_UNIQID '(' yesno ')'		{ cfg_set_use_uniqid($3); }
 	| KW_LOG_FIFO_SIZE '(' positive_integer ')'	{ configuration->log_fifo_size = $3; }
+	| KW_LOG_FIFO_LOCK_FREE '(' yesno ')'	{ configuration->log_fifo_lock_free = $3; }
 	| KW_LOG_IW_SIZE '(' positive_integer ')'	{ msg_warning("WARNING: Support for the global log-iw-size() option was removed, please use a per-source log-iw-size()", cfg_lexer_format_location_tag(lexer, &@1)); }
 	| KW_LOG_FETCH_LIMIT '(' positive_integer ')'	{ msg_warning("WARNING: Support for the global log-fetch-limit() option was removed, please use a per-source log-fetch-limit()", cfg_lexer_format_location_tag(lexer, &@1)); }
 	| KW_LOG_MSG_SIZE '(' positive_integer ')'	{ configuration->log_msg_size = $3; }
 	| KW_LOG_FLOW_CONTROL '(' yesno ')' { configuration->flow_control = $3; }
 	| KW_TRIM_LARGE_MESSAGES '(' yesno ')'	{ configuration->trim_large_messages = $3; }
 	| KW_KEEP_TIMESTAMP '(' yesno ')'	{ configuration->keep_timestamp = $3; }
+	| KW_REGEXP_PREFILTER '(' yesno ')'	{ configuration->regexp_prefilter = $3; }
 	| KW_CREATE_DIRS '(' yesno ')'		{ configuration->create_dirs = $3; }
 	| KW_CUSTOM_DOMAIN '(' string ')'	{ configuration->custom_domain = g_strdup($3); free($3); }
 	| KW_FILE_TEMPLATE '(' string ')'	{ configuration->file_template_name = g_strdup($3); free($3); }
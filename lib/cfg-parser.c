@@ -146,8 +146,10 @@ static CfgLexerKeyword main_keywords[] =
   { "log_level",          KW_LOG_LEVEL },
   { "filterx_jit",        KW_FILTERX_JIT },
   { "filterx_jit_debug_info", KW_FILTERX_JIT_DEBUG_INFO },
+  { "regexp_prefilter",   KW_REGEXP_PREFILTER },
 
   { "log_fifo_size",      KW_LOG_FIFO_SIZE },
+  { "log_fifo_lock_free", KW_LOG_FIFO_LOCK_FREE },
   { "log_fetch_limit",    KW_LOG_FETCH_LIMIT },
   { "log_iw_size",        KW_LOG_IW_SIZE },
   { "log_msg_size",       KW_LOG_MSG_SIZE },
@@ -460,6 +460,7 @@ cfg_new(gint version)
   self->time_reap = 60;
 
   self->log_fifo_size = 10000;
+  self->log_fifo_lock_free = FALSE;
   self->log_msg_size = 65536;
 
   file_perm_options_global_defaults(&self->file_perm_options);
@@ -473,6 +474,7 @@ cfg_new(gint version)
 
   self->recv_time_zone = NULL;
   self->keep_timestamp = TRUE;
+  self->regexp_prefilter = FALSE;
   self->log_level = -1;
 
   self->use_uniqid = FALSE;
@@ -93,6 +93,7 @@ struct _GlobalConfig
   gint type_cast_strictness;
 
   gint log_fifo_size;
+  gboolean log_fifo_lock_free;
   gint log_msg_size;
   gboolean flow_control;
   gboolean trim_large_messages;
@@ -103,6 +104,7 @@ struct _GlobalConfig
   gboolean use_uniqid;
 
   gboolean keep_timestamp;
+  gboolean regexp_prefilter;
 
   gchar *recv_time_zone;
   LogTemplateOptions template_options;
@@ -269,6 +269,10 @@ _create_memory_queue(LogDestDriver *self, const gchar *persist_name, gint stats_
 
   gint log_fifo_size = self->log_fifo_size < 0 ? cfg->log_fifo_size : self->log_fifo_size;
 
+  if (cfg->log_fifo_lock_free)
+    return log_queue_fifo_lock_free_new(log_fifo_size, persist_name, stats_level, driver_sck_builder,
+                                        queue_sck_builder);
+
   return log_queue_fifo_new(log_fifo_size, persist_name, stats_level, driver_sck_builder, queue_sck_builder);
 }
 
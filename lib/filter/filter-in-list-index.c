@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "filter-in-list-index.h"
+#include "messages.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define IN_LIST_INDEX_MAGIC       "SNGINLST"
+#define IN_LIST_INDEX_VERSION     2
+#define IN_LIST_INDEX_BYTE_ORDER  0x01020304
+
+#define IN_LIST_INDEX_FLAG_IGNORE_CASE 0x0001
+
+#define IN_LIST_INDEX_MIN_SLOTS 8
+
+/*
+ * On-disk (and in-memory) layout:
+ *
+ *   InListIndexHeader
+ *   InListIndexSlot[num_slots]      open addressing with linear probing
+ *   gchar strings[strings_size]     the entries, without separators
+ *
+ * The index is tied to the list file it was built from by its size and
+ * mtime (with nanoseconds), and to the host by the byte order marker; any
+ * mismatch causes the index to be rebuilt from the list file.
+ */
+typedef struct _InListIndexHeader
+{
+  gchar magic[8];
+  guint32 version;
+  guint32 byte_order;
+  guint32 flags;
+  guint32 __reserved;
+  guint64 source_size;
+  gint64 source_mtime;
+  gint64 source_mtime_nsec;
+  guint64 num_entries;
+  guint64 num_slots;
+  guint64 strings_size;
+} InListIndexHeader;
+
+typedef struct _InListIndexSlot
+{
+  guint32 hash;
+  /* 0 means the slot is empty, empty lines are never stored */
+  guint32 length;
+  guint64 offset;
+} InListIndexSlot;
+
+struct _InListIndex
+{
+  InListIndexHeader *header;
+  InListIndexSlot *slots;
+  gchar *strings;
+  guint64 slot_mask;
+  gboolean ignore_case;
+
+  gpointer buffer;
+  gsize buffer_size;
+  gboolean mapped;
+};
+
+/* FNV-1a, it needs to be stable across runs as it is stored in the index file */
+static inline guint32
+_hash(const gchar *value, gsize value_len, gboolean ignore_case)
+{
+  guint32 hash = 2166136261U;
+
+  for (gsize i = 0; i < value_len; i++)
+    {
+      guchar c = ignore_case ? g_ascii_tolower(value[i]) : value[i];
+      hash = (hash ^ c) * 16777619U;
+    }
+  return hash;
+}
+
+static inline gboolean
+_equals(const gchar *entry, const gchar *value, gsize value_len, gboolean ignore_case)
+{
+  if (!ignore_case)
+    return memcmp(entry, value, value_len) == 0;
+
+  /* entries are stored in lowercase in ignore-case mode */
+  for (gsize i = 0; i < value_len; i++)
+    {
+      if (entry[i] != g_ascii_tolower(value[i]))
+        return FALSE;
+    }
+  return TRUE;
+}
+
+static inline gsize
+_calculate_buffer_size(guint64 num_slots, guint64 strings_size)
+{
+  return sizeof(InListIndexHeader) + num_slots * sizeof(InListIndexSlot) + strings_size;
+}
+
+static void
+_setup_pointers(InListIndex *self)
+{
+  self->header = (InListIndexHeader *) self->buffer;
+  self->slots = (InListIndexSlot *) (self->header + 1);
+  self->strings = (gchar *) (self->slots + self->header->num_slots);
+  self->slot_mask = self->header->num_slots - 1;
+  self->ignore_case = !!(self->header->flags & IN_LIST_INDEX_FLAG_IGNORE_CASE);
+}
+
+gboolean
+in_list_index_lookup(InListIndex *self, const gchar *value, gssize value_len)
+{
+  if (value_len < 0)
+    value_len = strlen(value);
+
+  if (value_len == 0 || value_len > G_MAXUINT32)
+    return FALSE;
+
+  guint32 hash = _hash(value, value_len, self->ignore_case);
+
+  /* the table is at most half full, so there is always an empty slot to stop at */
+  for (guint64 i = hash & self->slot_mask; ; i = (i + 1) & self->slot_mask)
+    {
+      const InListIndexSlot *slot = &self->slots[i];
+
+      if (slot->length == 0)
+        return FALSE;
+
+      if (slot->hash == hash && slot->length == value_len &&
+          _equals(self->strings + slot->offset, value, value_len, self->ignore_case))
+        return TRUE;
+    }
+}
+
+gsize
+in_list_index_get_num_entries(InListIndex *self)
+{
+  return self->header->num_entries;
+}
+
+gboolean
+in_list_index_is_mapped(InListIndex *self)
+{
+  return self->mapped;
+}
+
+void
+in_list_index_free(InListIndex *self)
+{
+  if (self->mapped)
+    munmap(self->buffer, self->buffer_size);
+  else
+    g_free(self->buffer);
+  g_free(self);
+}
+
+/* building the index from the list file */
+
+typedef struct _InListEntry
+{
+  gsize offset;
+  gsize length;
+} InListEntry;
+
+static gboolean
+_read_list_file(const gchar *list_file, GArray *entries, GString *pool)
+{
+  FILE *stream = fopen(list_file, "r");
+  if (!stream)
+    {
+      msg_error("Error opening in-list filter list file",
+                evt_tag_str("file", list_file),
+                evt_tag_error("errno"));
+      return FALSE;
+    }
+
+  gchar *line = NULL;
+  size_t line_size = 0;
+  ssize_t line_len;
+
+  while ((line_len = getline(&line, &line_size, stream)) >= 0)
+    {
+      if (line_len > 0 && line[line_len - 1] == '\n')
+        line_len--;
+
+      if (line_len == 0 || line_len > G_MAXUINT32)
+        continue;
+
+      InListEntry entry = { .offset = pool->len, .length = line_len };
+      g_string_append_len(pool, line, line_len);
+      g_array_append_val(entries, entry);
+    }
+
+  free(line);
+  fclose(stream);
+  return TRUE;
+}
+
+static guint64
+_calculate_num_slots(guint64 num_entries)
+{
+  guint64 num_slots = IN_LIST_INDEX_MIN_SLOTS;
+
+  while (num_slots < num_entries * 2)
+    num_slots <<= 1;
+  return num_slots;
+}
+
+static gboolean
+_insert_entry(InListIndex *self, const gchar *value, gsize value_len)
+{
+  guint32 hash = _hash(value, value_len, self->ignore_case);
+
+  guint64 i;
+  for (i = hash & self->slot_mask; self->slots[i].length != 0; i = (i + 1) & self->slot_mask)
+    {
+      const InListIndexSlot *slot = &self->slots[i];
+
+      if (slot->hash == hash && slot->length == value_len &&
+          _equals(self->strings + slot->offset, value, value_len, self->ignore_case))
+        return FALSE;
+    }
+
+  InListIndexSlot *slot = &self->slots[i];
+  slot->hash = hash;
+  slot->length = value_len;
+  slot->offset = self->header->strings_size;
+
+  gchar *entry = self->strings + self->header->strings_size;
+  for (gsize j = 0; j < value_len; j++)
+    entry[j] = self->ignore_case ? g_ascii_tolower(value[j]) : value[j];
+
+  self->header->strings_size += value_len;
+  self->header->num_entries++;
+  return TRUE;
+}
+
+static gint64
+_get_mtime_nsec(const struct stat *st)
+{
+#ifdef __APPLE__
+  return st->st_mtimespec.tv_nsec;
+#else
+  return st->st_mtim.tv_nsec;
+#endif
+}
+
+static InListIndex *
+_build_from_list_file(const gchar *list_file, const struct stat *st, gboolean ignore_case)
+{
+  GArray *entries = g_array_new(FALSE, FALSE, sizeof(InListEntry));
+  GString *pool = g_string_new(NULL);
+  InListIndex *self = NULL;
+
+  if (!_read_list_file(list_file, entries, pool))
+    goto exit;
+
+  guint64 num_slots = _calculate_num_slots(entries->len);
+
+  self = g_new0(InListIndex, 1);
+  /* the string pool is an upper bound, duplicate entries are only stored once */
+  self->buffer = g_malloc0(_calculate_buffer_size(num_slots, pool->len));
+
+  InListIndexHeader *header = (InListIndexHeader *) self->buffer;
+  memcpy(header->magic, IN_LIST_INDEX_MAGIC, sizeof(header->magic));
+  header->version = IN_LIST_INDEX_VERSION;
+  header->byte_order = IN_LIST_INDEX_BYTE_ORDER;
+  header->flags = ignore_case ? IN_LIST_INDEX_FLAG_IGNORE_CASE : 0;
+  header->source_size = st->st_size;
+  header->source_mtime = st->st_mtime;
+  header->source_mtime_nsec = _get_mtime_nsec(st);
+  header->num_slots = num_slots;
+  _setup_pointers(self);
+
+  for (guint i = 0; i < entries->len; i++)
+    {
+      InListEntry *entry = &g_array_index(entries, InListEntry, i);
+      _insert_entry(self, pool->str + entry->offset, entry->length);
+    }
+  self->buffer_size = _calculate_buffer_size(num_slots, header->strings_size);
+
+exit:
+  g_string_free(pool, TRUE);
+  g_array_free(entries, TRUE);
+  return self;
+}
+
+/* index files */
+
+static gboolean
+_validate_mapped_index(InListIndex *self, const struct stat *list_st, gboolean ignore_case)
+{
+  const InListIndexHeader *header = (const InListIndexHeader *) self->buffer;
+
+  if (self->buffer_size < sizeof(*header) ||
+      memcmp(header->magic, IN_LIST_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != IN_LIST_INDEX_VERSION ||
+      header->byte_order != IN_LIST_INDEX_BYTE_ORDER)
+    return FALSE;
+
+  if (header->source_size != (guint64) list_st->st_size ||
+      header->source_mtime != (gint64) list_st->st_mtime ||
+      header->source_mtime_nsec != _get_mtime_nsec(list_st) ||
+      !!(header->flags & IN_LIST_INDEX_FLAG_IGNORE_CASE) != !!ignore_case)
+    return FALSE;
+
+  if (header->num_slots < IN_LIST_INDEX_MIN_SLOTS ||
+      (header->num_slots & (header->num_slots - 1)) != 0 ||
+      header->num_slots > (G_MAXSIZE - sizeof(*header)) / sizeof(InListIndexSlot) ||
+      header->num_entries > header->num_slots / 2 ||
+      header->strings_size > G_MAXSIZE - sizeof(*header) - header->num_slots * sizeof(InListIndexSlot) ||
+      /* slot_mask is derived from num_slots, which has to match the size of the file */
+      _calculate_buffer_size(header->num_slots, header->strings_size) != self->buffer_size)
+    return FALSE;
+
+  _setup_pointers(self);
+
+  /* lookups rely on finding an empty slot, so the number of used slots is
+   * checked against num_entries and the load factor, not just trusted */
+  guint64 used_slots = 0;
+  for (guint64 i = 0; i < header->num_slots; i++)
+    {
+      const InListIndexSlot *slot = &self->slots[i];
+
+      if (slot->length == 0)
+        continue;
+
+      if (slot->offset > header->strings_size || slot->length > header->strings_size - slot->offset)
+        return FALSE;
+      used_slots++;
+    }
+  return used_slots == header->num_entries;
+}
+
+static InListIndex *
+_map_index_file(const gchar *index_file, const struct stat *list_st, gboolean ignore_case)
+{
+  struct stat st;
+
+  gint fd = open(index_file, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+
+  if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+      close(fd);
+      return NULL;
+    }
+
+  gpointer map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    {
+      msg_warning("Error mapping in-list() index file, rebuilding index from the list file",
+                  evt_tag_str("index_file", index_file),
+                  evt_tag_error("errno"));
+      return NULL;
+    }
+
+  InListIndex *self = g_new0(InListIndex, 1);
+  self->buffer = map;
+  self->buffer_size = st.st_size;
+  self->mapped = TRUE;
+
+  if (!_validate_mapped_index(self, list_st, ignore_case))
+    {
+      msg_debug("in-list() index file is stale or invalid, rebuilding",
+                evt_tag_str("index_file", index_file));
+      in_list_index_free(self);
+      return NULL;
+    }
+
+  return self;
+}
+
+static void
+_write_index_file(InListIndex *self, const gchar *index_file)
+{
+  gchar *tmp_file = g_strdup_printf("%s.tmp", index_file);
+  const gchar *buffer = self->buffer;
+  gsize remaining = self->buffer_size;
+
+  gint fd = open(tmp_file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    goto error;
+
+  while (remaining > 0)
+    {
+      ssize_t written = write(fd, buffer, remaining);
+      if (written < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          close(fd);
+          goto error;
+        }
+      buffer += written;
+      remaining -= written;
+    }
+
+  if (close(fd) < 0 || rename(tmp_file, index_file) < 0)
+    goto error;
+
+  g_free(tmp_file);
+  return;
+
+error:
+  msg_warning("Error writing in-list() index file, the list will be parsed again on the next load",
+              evt_tag_str("index_file", index_file),
+              evt_tag_error("errno"));
+  unlink(tmp_file);
+  g_free(tmp_file);
+}
+
+/*
+ * Load the entries of @list_file. If @index_file is given and it was built
+ * from the current version of @list_file, it is mapped into memory instead
+ * of parsing the list, otherwise it is (re)written after parsing.
+ */
+InListIndex *
+in_list_index_load(const gchar *list_file, const gchar *index_file, gboolean ignore_case)
+{
+  struct stat st;
+
+  if (stat(list_file, &st) < 0)
+    {
+      msg_error("Error opening in-list filter list file",
+                evt_tag_str("file", list_file),
+                evt_tag_error("errno"));
+      return NULL;
+    }
+
+  InListIndex *self = NULL;
+  if (index_file)
+    {
+      self = _map_index_file(index_file, &st, ignore_case);
+      if (self)
+        return self;
+    }
+
+  self = _build_from_list_file(list_file, &st, ignore_case);
+  if (self && index_file)
+    _write_index_file(self, index_file);
+
+  return self;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2023 Balazs Scheidler <bazsi77@gmail.com>
+ * Copyright (c) 2026 Axoflow
  *
  * This program is free software: you can redistribute it and/or modify it
  * under the terms of the GNU General Public License as published by
@@ -20,16 +20,24 @@
  *
  */
 
-#include "vmlinux.h"
-#include <bpf/bpf_helpers.h>
+#ifndef FILTER_IN_LIST_INDEX_H_INCLUDED
+#define FILTER_IN_LIST_INDEX_H_INCLUDED
 
-int number_of_sockets;
+#include "syslog-ng.h"
 
-SEC("socket")
-int random_choice(struct __sk_buff *skb)
-{
-  if (number_of_sockets == 0)
-    return -1;
+/*
+ * Immutable open-addressing hash set of the lines of an in-list() file.
+ *
+ * The set is a single contiguous buffer (header, slot array, string pool),
+ * so it can be written to an index file as-is and mapped back into memory
+ * on the next load, without parsing the list again.
+ */
+typedef struct _InListIndex InListIndex;
+
+InListIndex *in_list_index_load(const gchar *list_file, const gchar *index_file, gboolean ignore_case);
+gboolean in_list_index_lookup(InListIndex *self, const gchar *value, gssize value_len);
+gsize in_list_index_get_num_entries(InListIndex *self);
+gboolean in_list_index_is_mapped(InListIndex *self);
+void in_list_index_free(InListIndex *self);
 
-  return bpf_get_prandom_u32() % number_of_sockets;
-}
+#endif
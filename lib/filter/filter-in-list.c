@@ -22,19 +22,16 @@
  */
 
 #include "filter-in-list.h"
+#include "filter-in-list-index.h"
 #include "logmsg/logmsg.h"
-#include "str-utils.h"
 
-#include <errno.h>
-#include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
 
 typedef struct _FilterInList
 {
   FilterExprNode super;
   NVHandle value_handle;
-  GTree *tree;
+  InListIndex *index;
 } FilterInList;
 
 static gboolean
@@ -46,11 +43,10 @@ filter_in_list_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTempl
   gssize len = 0;
 
   value = log_msg_get_value(msg, self->value_handle, &len);
-  APPEND_ZERO(value, value, len);
 
-  gboolean result = (g_tree_lookup(self->tree, value) != NULL);
+  gboolean result = in_list_index_lookup(self->index, value, len);
   msg_trace("in-list() evaluation started",
-            evt_tag_str("value", value),
+            evt_tag_mem("value", value, len),
             evt_tag_msg_reference(msg));
 
   return result ^ s->comp;
@@ -61,39 +57,70 @@ filter_in_list_free(FilterExprNode *s)
 {
   FilterInList *self = (FilterInList *)s;
 
-  g_tree_destroy(self->tree);
+  in_list_index_free(self->index);
 }
 
-FilterExprNode *
-filter_in_list_new(const gchar *list_file, const gchar *property)
+void
+filter_in_list_options_defaults(FilterInListOptions *options)
+{
+  options->ignore_case = FALSE;
+  options->index_file = NULL;
+}
+
+void
+filter_in_list_options_destroy(FilterInListOptions *options)
+{
+  g_free(options->index_file);
+  options->index_file = NULL;
+}
+
+void
+filter_in_list_options_set_index_file(FilterInListOptions *options, const gchar *index_file)
 {
-  FilterInList *self;
-  FILE *stream;
-  gchar line[16384];
+  g_free(options->index_file);
+  options->index_file = g_strdup(index_file);
+}
 
-  stream = fopen(list_file, "r");
-  if (!stream)
+gboolean
+filter_in_list_options_process_flag(FilterInListOptions *options, const gchar *flag)
+{
+  if (strcmp(flag, "ignore-case") == 0)
     {
-      msg_error("Error opening in-list filter list file",
-                evt_tag_str("file", list_file),
-                evt_tag_error("errno"));
-      return NULL;
+      options->ignore_case = TRUE;
+      return TRUE;
     }
+  return FALSE;
+}
+
+FilterExprNode *
+filter_in_list_new_with_options(const gchar *list_file, const gchar *property, const FilterInListOptions *options)
+{
+  InListIndex *index = in_list_index_load(list_file, options->index_file, options->ignore_case);
+  if (!index)
+    return NULL;
+
+  msg_debug("in-list() filter loaded",
+            evt_tag_str("file", list_file),
+            evt_tag_long("entries", in_list_index_get_num_entries(index)),
+            evt_tag_str("index", in_list_index_is_mapped(index) ? "mapped" : "built"));
 
-  self = g_new0(FilterInList, 1);
+  FilterInList *self = g_new0(FilterInList, 1);
   filter_expr_node_init_instance(&self->super);
   self->value_handle = log_msg_get_value_handle(property);
-  self->tree = g_tree_new_full((GCompareDataFunc)strcmp, NULL, g_free, NULL);
-
-  while (fgets(line, sizeof(line), stream) != NULL)
-    {
-      line[strlen(line) - 1] = '\0';
-      if (line[0])
-        g_tree_insert(self->tree, g_strdup(line), GINT_TO_POINTER(1));
-    }
-  fclose(stream);
+  self->index = index;
 
   self->super.eval = filter_in_list_eval;
   self->super.free_fn = filter_in_list_free;
   return &self->super;
 }
+
+FilterExprNode *
+filter_in_list_new(const gchar *list_file, const gchar *property)
+{
+  FilterInListOptions options;
+
+  filter_in_list_options_defaults(&options);
+  FilterExprNode *self = filter_in_list_new_with_options(list_file, property, &options);
+  filter_in_list_options_destroy(&options);
+  return self;
+}
@@ -26,6 +26,19 @@
 
 #include "filter-expr.h"
 
+typedef struct _FilterInListOptions
+{
+  gboolean ignore_case;
+  gchar *index_file;
+} FilterInListOptions;
+
+void filter_in_list_options_defaults(FilterInListOptions *options);
+void filter_in_list_options_destroy(FilterInListOptions *options);
+void filter_in_list_options_set_index_file(FilterInListOptions *options, const gchar *index_file);
+gboolean filter_in_list_options_process_flag(FilterInListOptions *options, const gchar *flag);
+
+FilterExprNode *filter_in_list_new_with_options(const gchar *list_file, const gchar *property,
+                                                const FilterInListOptions *options);
 FilterExprNode *filter_in_list_new(const gchar *list_file,
                                    const gchar *property);
 
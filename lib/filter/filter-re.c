@@ -25,6 +25,7 @@
 #include "str-utils.h"
 #include "messages.h"
 #include "scratch-buffers.h"
+#include "cfg.h"
 #include <string.h>
 
 typedef struct _FilterRE
@@ -68,6 +69,10 @@ filter_re_init(FilterExprNode *s, GlobalConfig *cfg)
   if (self->matcher_options.flags & LMF_STORE_MATCHES)
     self->super.modify = TRUE;
 
+  /* only evaluations against a name-value pair go through the prefilter */
+  if (cfg && cfg->regexp_prefilter && self->value_handle)
+    log_matcher_attach_prefilter(self->matcher, log_matcher_prefilter_get(cfg));
+
   return TRUE;
 }
 
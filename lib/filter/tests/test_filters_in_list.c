@@ -30,14 +30,21 @@
 #include "apphook.h"
 #include "plugin.h"
 #include "filter/filter-in-list.h"
+#include "filter/filter-in-list-index.h"
 #include "msg-format.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 
 
 #define MSG_1 "<15>Sep  4 15:03:55 localhost test-program[3086]: some random message"
 #define MSG_2 "<15>Sep  4 15:03:55 localhost foo[3086]: some random message"
+#define MSG_UPPER "<15>Sep  4 15:03:55 localhost TEST-Program[3086]: some random message"
 #define MSG_3 "<15>Sep  4 15:03:55 192.168.1.1 foo[3086]: some random message"
 #define MSG_LONG "<15>Sep  4 15:03:55 test-hostAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA foo[3086]: some random message"
 
@@ -128,6 +135,214 @@ Test(template_filters, test_filter_with_long_line)
   g_free(list_file_with_long_line);
 }
 
+Test(template_filters, test_ignore_case_flag)
+{
+  gchar *list_file_with_one_line = g_strdup_printf(LIST_FILE_DIR "test.list", top_srcdir);
+  FilterInListOptions options;
+
+  cr_assert_not(evaluate_testcase(MSG_UPPER, filter_in_list_new(list_file_with_one_line, "PROGRAM")),
+                "in-list filter should be case sensitive by default");
+
+  filter_in_list_options_defaults(&options);
+  cr_assert(filter_in_list_options_process_flag(&options, "ignore-case"));
+  cr_assert(evaluate_testcase(MSG_UPPER, filter_in_list_new_with_options(list_file_with_one_line, "PROGRAM", &options)),
+            "in-list filter with ignore-case should match");
+  cr_assert(evaluate_testcase(MSG_1, filter_in_list_new_with_options(list_file_with_one_line, "PROGRAM", &options)),
+            "in-list filter with ignore-case should match");
+  filter_in_list_options_destroy(&options);
+
+  g_free(list_file_with_one_line);
+}
+
+Test(template_filters, test_unknown_flag_is_rejected)
+{
+  FilterInListOptions options;
+
+  filter_in_list_options_defaults(&options);
+  cr_assert_not(filter_in_list_options_process_flag(&options, "no-such-flag"));
+  filter_in_list_options_destroy(&options);
+}
+
+static gchar *
+_create_list_file(const gchar *dir, const gchar *contents)
+{
+  gchar *list_file = g_build_filename(dir, "test.list", NULL);
+
+  cr_assert(g_file_set_contents(list_file, contents, -1, NULL));
+  return list_file;
+}
+
+static void
+_remove_dir(gchar *dir, gchar *list_file, gchar *index_file)
+{
+  g_unlink(list_file);
+  g_unlink(index_file);
+  g_rmdir(dir);
+  g_free(list_file);
+  g_free(index_file);
+  g_free(dir);
+}
+
+Test(template_filters, test_index_skips_duplicates_and_empty_lines)
+{
+  gchar *dir = g_dir_make_tmp("test_filters_in_list_XXXXXX", NULL);
+  gchar *list_file = _create_list_file(dir, "foo\nbar\n\nfoo\nbaz");
+
+  InListIndex *index = in_list_index_load(list_file, NULL, FALSE);
+  cr_assert_not_null(index);
+  cr_assert_eq(in_list_index_get_num_entries(index), 3);
+  cr_assert(in_list_index_lookup(index, "foo", -1));
+  cr_assert(in_list_index_lookup(index, "bar", -1));
+  cr_assert(in_list_index_lookup(index, "baz", -1), "last line without a newline should be kept intact");
+  cr_assert_not(in_list_index_lookup(index, "ba", -1));
+  cr_assert_not(in_list_index_lookup(index, "", -1));
+  cr_assert_not(in_list_index_lookup(index, "foobar", 3 + 3));
+  cr_assert(in_list_index_lookup(index, "foobar", 3));
+  in_list_index_free(index);
+
+  _remove_dir(dir, list_file, g_build_filename(dir, "unused.idx", NULL));
+}
+
+Test(template_filters, test_index_file_is_written_and_mapped_on_next_load)
+{
+  gchar *dir = g_dir_make_tmp("test_filters_in_list_XXXXXX", NULL);
+  gchar *list_file = _create_list_file(dir, "foo\nbar\n");
+  gchar *index_file = g_build_filename(dir, "test.idx", NULL);
+
+  InListIndex *index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  cr_assert_not(in_list_index_is_mapped(index));
+  cr_assert(g_file_test(index_file, G_FILE_TEST_EXISTS));
+  in_list_index_free(index);
+
+  index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  cr_assert(in_list_index_is_mapped(index));
+  cr_assert_eq(in_list_index_get_num_entries(index), 2);
+  cr_assert(in_list_index_lookup(index, "foo", -1));
+  cr_assert(in_list_index_lookup(index, "bar", -1));
+  cr_assert_not(in_list_index_lookup(index, "baz", -1));
+  in_list_index_free(index);
+
+  /* the index records the case sensitivity it was built with */
+  index = in_list_index_load(list_file, index_file, TRUE);
+  cr_assert_not_null(index);
+  cr_assert_not(in_list_index_is_mapped(index));
+  cr_assert(in_list_index_lookup(index, "FOO", -1));
+  in_list_index_free(index);
+
+  _remove_dir(dir, list_file, index_file);
+}
+
+Test(template_filters, test_stale_index_file_is_rebuilt)
+{
+  gchar *dir = g_dir_make_tmp("test_filters_in_list_XXXXXX", NULL);
+  gchar *list_file = _create_list_file(dir, "foo\n");
+  gchar *index_file = g_build_filename(dir, "test.idx", NULL);
+
+  InListIndex *index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  in_list_index_free(index);
+
+  g_free(_create_list_file(dir, "foo\nbar\n"));
+
+  index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  cr_assert_not(in_list_index_is_mapped(index));
+  cr_assert(in_list_index_lookup(index, "bar", -1));
+  in_list_index_free(index);
+
+  _remove_dir(dir, list_file, index_file);
+}
+
+Test(template_filters, test_corrupt_index_file_is_rebuilt)
+{
+  gchar *dir = g_dir_make_tmp("test_filters_in_list_XXXXXX", NULL);
+  gchar *list_file = _create_list_file(dir, "foo\n");
+  gchar *index_file = g_build_filename(dir, "test.idx", NULL);
+
+  cr_assert(g_file_set_contents(index_file, "garbage", -1, NULL));
+
+  InListIndex *index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  cr_assert_not(in_list_index_is_mapped(index));
+  cr_assert(in_list_index_lookup(index, "foo", -1));
+  in_list_index_free(index);
+
+  _remove_dir(dir, list_file, index_file);
+}
+
+Test(template_filters, test_index_file_changed_within_the_same_second_is_rebuilt)
+{
+  gchar *dir = g_dir_make_tmp("test_filters_in_list_XXXXXX", NULL);
+  gchar *list_file = _create_list_file(dir, "foo\n");
+  gchar *index_file = g_build_filename(dir, "test.idx", NULL);
+  struct stat st;
+
+  InListIndex *index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  in_list_index_free(index);
+
+  /* same size and same mtime in seconds, only the nanoseconds differ */
+  cr_assert_eq(stat(list_file, &st), 0);
+  g_free(_create_list_file(dir, "bar\n"));
+  struct timespec times[2] = { st.st_atim, st.st_mtim };
+  times[1].tv_nsec = (st.st_mtim.tv_nsec + 1) % 1000000000;
+  cr_assert_eq(utimensat(AT_FDCWD, list_file, times, 0), 0);
+
+  index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  cr_assert_not(in_list_index_is_mapped(index));
+  cr_assert(in_list_index_lookup(index, "bar", -1));
+  cr_assert_not(in_list_index_lookup(index, "foo", -1));
+  in_list_index_free(index);
+
+  _remove_dir(dir, list_file, index_file);
+}
+
+/* the header is 72 bytes, followed by 8 slots of 16 bytes for a single entry */
+#define INDEX_HEADER_SIZE 72
+#define INDEX_SLOT_SIZE 16
+#define INDEX_MIN_SLOTS 8
+
+Test(template_filters, test_index_file_without_empty_slots_is_rebuilt)
+{
+  gchar *dir = g_dir_make_tmp("test_filters_in_list_XXXXXX", NULL);
+  gchar *list_file = _create_list_file(dir, "foo\n");
+  gchar *index_file = g_build_filename(dir, "test.idx", NULL);
+  gchar *contents;
+  gsize length;
+
+  InListIndex *index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  in_list_index_free(index);
+
+  /* point every slot at the first character of "foo", lookups of missing
+   * values would never find an empty slot to stop at */
+  cr_assert(g_file_get_contents(index_file, &contents, &length, NULL));
+  cr_assert_eq(length, INDEX_HEADER_SIZE + INDEX_MIN_SLOTS * INDEX_SLOT_SIZE + 3);
+  for (gint i = 0; i < INDEX_MIN_SLOTS; i++)
+    {
+      gchar *slot = contents + INDEX_HEADER_SIZE + i * INDEX_SLOT_SIZE;
+      guint32 slot_length = 1;
+      guint64 offset = 0;
+
+      memcpy(slot + 4, &slot_length, sizeof(slot_length));
+      memcpy(slot + 8, &offset, sizeof(offset));
+    }
+  cr_assert(g_file_set_contents(index_file, contents, length, NULL));
+  g_free(contents);
+
+  index = in_list_index_load(list_file, index_file, FALSE);
+  cr_assert_not_null(index);
+  cr_assert_not(in_list_index_is_mapped(index));
+  cr_assert(in_list_index_lookup(index, "foo", -1));
+  cr_assert_not(in_list_index_lookup(index, "bar", -1));
+  in_list_index_free(index);
+
+  _remove_dir(dir, list_file, index_file);
+}
+
 static void
 setup(void)
 {
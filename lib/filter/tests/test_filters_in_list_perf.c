@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/stopwatch.h"
+
+#include "filter/filter-in-list-index.h"
+#include "apphook.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#define LOOKUP_COUNT 1000000
+
+/* sha1-like entries, as in lists of IOC hashes */
+static void
+_format_entry(gchar *buf, gsize buf_len, gsize i)
+{
+  g_snprintf(buf, buf_len, "%08" G_GSIZE_MODIFIER "x%032" G_GSIZE_MODIFIER "x", i * 2654435761U, i);
+}
+
+static gchar *
+_create_list_file(const gchar *dir, gsize num_entries)
+{
+  gchar *list_file = g_strdup_printf("%s/%" G_GSIZE_FORMAT ".list", dir, num_entries);
+  FILE *stream = fopen(list_file, "w");
+  gchar buf[64];
+
+  cr_assert_not_null(stream);
+  for (gsize i = 0; i < num_entries; i++)
+    {
+      _format_entry(buf, sizeof(buf), i);
+      fprintf(stream, "%s\n", buf);
+    }
+  fclose(stream);
+  return list_file;
+}
+
+static GTree *
+_load_tree(const gchar *list_file)
+{
+  GTree *tree = g_tree_new_full((GCompareDataFunc) strcmp, NULL, g_free, NULL);
+  FILE *stream = fopen(list_file, "r");
+  gchar line[256];
+
+  while (fgets(line, sizeof(line), stream))
+    {
+      line[strlen(line) - 1] = '\0';
+      g_tree_insert(tree, g_strdup(line), GINT_TO_POINTER(1));
+    }
+  fclose(stream);
+  return tree;
+}
+
+/* every second lookup is a hit */
+static gchar **
+_create_lookup_values(gsize num_entries)
+{
+  gchar **values = g_new0(gchar *, 1024 + 1);
+  gchar buf[64];
+
+  for (gsize i = 0; i < 1024; i++)
+    {
+      _format_entry(buf, sizeof(buf), (i % 2 == 0) ? (i * 7919) % num_entries : num_entries + i);
+      values[i] = g_strdup(buf);
+    }
+  return values;
+}
+
+static void
+_benchmark_list_size(const gchar *dir, gsize num_entries)
+{
+  gchar *list_file = _create_list_file(dir, num_entries);
+  gchar *index_file = g_strdup_printf("%s.idx", list_file);
+  gchar **values = _create_lookup_values(num_entries);
+  gsize hits = 0;
+
+  start_stopwatch();
+  GTree *tree = _load_tree(list_file);
+  stop_stopwatch_and_display_result(1, "  %8" G_GSIZE_FORMAT " entries, gtree load        ", num_entries);
+
+  start_stopwatch();
+  InListIndex *index = in_list_index_load(list_file, index_file, FALSE);
+  stop_stopwatch_and_display_result(1, "  %8" G_GSIZE_FORMAT " entries, index build       ", num_entries);
+  cr_assert_not(in_list_index_is_mapped(index));
+  in_list_index_free(index);
+
+  start_stopwatch();
+  index = in_list_index_load(list_file, index_file, FALSE);
+  stop_stopwatch_and_display_result(1, "  %8" G_GSIZE_FORMAT " entries, index map         ", num_entries);
+  cr_assert(in_list_index_is_mapped(index));
+
+  start_stopwatch();
+  for (gsize i = 0; i < LOOKUP_COUNT; i++)
+    hits += g_tree_lookup(tree, values[i % 1024]) != NULL;
+  stop_stopwatch_and_display_result(LOOKUP_COUNT, "  %8" G_GSIZE_FORMAT " entries, gtree lookup      ", num_entries);
+
+  start_stopwatch();
+  for (gsize i = 0; i < LOOKUP_COUNT; i++)
+    hits -= in_list_index_lookup(index, values[i % 1024], -1);
+  stop_stopwatch_and_display_result(LOOKUP_COUNT, "  %8" G_GSIZE_FORMAT " entries, index lookup      ", num_entries);
+
+  cr_assert_eq(hits, 0, "gtree and index lookups should give the same results");
+
+  in_list_index_free(index);
+  g_tree_destroy(tree);
+  g_strfreev(values);
+  g_unlink(index_file);
+  g_unlink(list_file);
+  g_free(index_file);
+  g_free(list_file);
+}
+
+Test(filters_in_list_perf, test_in_list_lookup_performance)
+{
+  app_startup();
+
+  gchar *dir = g_dir_make_tmp("test_filters_in_list_perf_XXXXXX", NULL);
+  cr_assert_not_null(dir);
+
+  for (gsize num_entries = 10; num_entries <= 1000000; num_entries *= 10)
+    _benchmark_list_size(dir, num_entries);
+
+  g_rmdir(dir);
+  g_free(dir);
+
+  app_shutdown();
+}
@@ -126,6 +126,40 @@ _simple_eval(FilterXExpr *s)
   return res;
 }
 
+/*
+ * Evaluate a call of @function_proto at optimization time, if all of its
+ * arguments are literals. Returns NULL if @s is not such a call or if the
+ * call fails.
+ */
+FilterXObject *
+filterx_simple_function_eval_literal_call(FilterXExpr *s, FilterXSimpleFunctionProto function_proto)
+{
+  FilterXSimpleFunction *self = (FilterXSimpleFunction *) s;
+
+  if (!s || s->eval != _simple_eval || self->function_proto != function_proto)
+    return NULL;
+
+  gsize args_len = self->args->len;
+  FilterXObject *args[self->args->len];
+  for (gsize i = 0; i < args_len; i++)
+    {
+      FilterXExpr *arg = g_ptr_array_index(self->args, i);
+
+      if (!filterx_expr_is_literal(arg))
+        return NULL;
+    }
+
+  for (gsize i = 0; i < args_len; i++)
+    args[i] = filterx_literal_get_value(g_ptr_array_index(self->args, i));
+
+  FilterXObject *res = self->function_proto(s, args, args_len);
+  if (!res)
+    filterx_eval_clear_errors();
+
+  _simple_function_free_args(args, args_len);
+  return res;
+}
+
 static void
 _simple_free(FilterXExpr *s)
 {
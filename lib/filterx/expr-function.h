@@ -34,6 +34,7 @@
 typedef FilterXObject *(*FilterXSimpleFunctionProto)(FilterXExpr *s, FilterXObject *args[], gsize args_len);
 
 void filterx_simple_function_argument_error(FilterXExpr *s, gchar *error_info);
+FilterXObject *filterx_simple_function_eval_literal_call(FilterXExpr *s, FilterXSimpleFunctionProto function_proto);
 
 static inline void
 filterx_simple_function_free_args(FilterXObject *args[], gsize args_len)
@@ -23,6 +23,12 @@
 #include "filterx/object-primitive.h"
 #include "filterx/filterx-sequence.h"
 #include "filterx/object-dict.h"
+#include "filterx/object-list.h"
+#include "filterx/object-string.h"
+#include "filterx/object-subnet.h"
+#include "filterx/expr-literal-container.h"
+#include "filterx/expr-function.h"
+#include "filterx/filterx-ref.h"
 #include "filterx/expr-literal.h"
 #include "filterx/filterx-eval.h"
 #include "filterx/filterx-object.h"
@@ -31,8 +37,85 @@
 typedef struct FilterXOperatorIn_
 {
   FilterXBinaryOp super;
+
+  /* compiled form of a literal list on the right hand side, see _compile_literal_list() */
+  gboolean compiled;
+  GHashTable *members;
+  FilterXSubnetTrie *subnets;
 } FilterXOperatorIn;
 
+/*
+ * String and integer elements of a literal list are stored in a hash set,
+ * keyed by the element objects themselves. As with list membership,
+ * elements only match members of the same type.
+ */
+static guint
+_member_hash(gconstpointer key)
+{
+  FilterXObject *obj = (FilterXObject *) key;
+  gsize len;
+  gint64 value;
+
+  const gchar *str = filterx_string_get_value_ref(obj, &len);
+  if (str)
+    {
+      guint hash = 5381;
+      for (gsize i = 0; i < len; i++)
+        hash = (hash << 5) + hash + (guchar) str[i];
+      return hash;
+    }
+
+  if (filterx_integer_unwrap(obj, &value))
+    return g_int64_hash(&value);
+
+  g_assert_not_reached();
+}
+
+static gboolean
+_member_equal(gconstpointer a, gconstpointer b)
+{
+  FilterXObject *lhs = (FilterXObject *) a;
+  FilterXObject *rhs = (FilterXObject *) b;
+
+  if (lhs->type != rhs->type)
+    return FALSE;
+
+  gsize lhs_len, rhs_len;
+  const gchar *lhs_str = filterx_string_get_value_ref(lhs, &lhs_len);
+  if (lhs_str)
+    {
+      const gchar *rhs_str = filterx_string_get_value_ref(rhs, &rhs_len);
+      return lhs_len == rhs_len && memcmp(lhs_str, rhs_str, lhs_len) == 0;
+    }
+
+  gint64 lhs_value, rhs_value;
+  if (filterx_integer_unwrap(lhs, &lhs_value) && filterx_integer_unwrap(rhs, &rhs_value))
+    return lhs_value == rhs_value;
+
+  return FALSE;
+}
+
+static inline gboolean
+_is_hashable_member(FilterXObject *obj)
+{
+  return filterx_object_is_type(obj, &FILTERX_TYPE_NAME(string)) ||
+         filterx_object_is_type(obj, &FILTERX_TYPE_NAME(integer));
+}
+
+static FilterXObject *
+_eval_compiled_in(FilterXOperatorIn *self, FilterXObject *member)
+{
+  member = filterx_ref_unwrap_ro(member);
+
+  if (self->members && _is_hashable_member(member) && g_hash_table_contains(self->members, member))
+    return filterx_boolean_new(TRUE);
+
+  if (self->subnets && filterx_subnet_trie_contains(self->subnets, member))
+    return filterx_boolean_new(TRUE);
+
+  return filterx_boolean_new(FALSE);
+}
+
 static FilterXObject *
 _eval_in(FilterXExpr *s)
 {
@@ -48,6 +131,13 @@ _eval_in(FilterXExpr *s)
       return NULL;
     }
 
+  if (self->compiled)
+    {
+      result = _eval_compiled_in(self, member);
+      filterx_object_unref(member);
+      return result;
+    }
+
   FilterXObject *container = filterx_expr_eval(self->super.rhs);
   if (!container)
     {
@@ -64,6 +154,105 @@ exit:
   return result;
 }
 
+static gboolean
+_compile_element(FilterXOperatorIn *self, FilterXObject *element)
+{
+  element = filterx_ref_unwrap_ro(element);
+
+  if (_is_hashable_member(element))
+    {
+      if (!self->members)
+        self->members = g_hash_table_new_full(_member_hash, _member_equal, (GDestroyNotify) filterx_object_unref, NULL);
+      g_hash_table_add(self->members, filterx_object_ref(element));
+      return TRUE;
+    }
+
+  if (filterx_object_is_type(element, &FILTERX_TYPE_NAME(subnet)))
+    {
+      if (!self->subnets)
+        self->subnets = filterx_subnet_trie_new();
+      return filterx_subnet_trie_add(self->subnets, element);
+    }
+
+  return FALSE;
+}
+
+static gboolean
+_compile_literal_list_element(gsize index, FilterXExpr *value, gpointer user_data)
+{
+  FilterXOperatorIn *self = (FilterXOperatorIn *) user_data;
+  FilterXObject *element = NULL;
+
+  if (filterx_expr_is_literal(value))
+    element = filterx_literal_get_value(value);
+  else
+    element = filterx_simple_function_eval_literal_call(value, filterx_typecast_subnet);
+
+  if (!element)
+    return FALSE;
+
+  gboolean success = _compile_element(self, element);
+  filterx_object_unref(element);
+  return success;
+}
+
+static void
+_drop_compiled_list(FilterXOperatorIn *self)
+{
+  if (self->members)
+    g_hash_table_unref(self->members);
+  if (self->subnets)
+    filterx_subnet_trie_free(self->subnets);
+  self->members = NULL;
+  self->subnets = NULL;
+  self->compiled = FALSE;
+}
+
+/*
+ * Membership in a list is a linear scan. If the list on the right hand
+ * side only consists of literal strings, integers and subnet() calls with
+ * literal arguments, we compile it into a hash set and a subnet trie
+ * instead, so that the cost of `in` does not depend on the size of the
+ * list.
+ *
+ * The list is either a literal already (all elements were literals), or a
+ * literal list expression, with the subnet() calls as non-literal elements.
+ */
+static void
+_compile_literal_list(FilterXOperatorIn *self, FilterXObject *container)
+{
+  self->compiled = TRUE;
+
+  if (container)
+    {
+      guint64 len;
+
+      container = filterx_ref_unwrap_ro(container);
+      if (!filterx_object_is_type(container, &FILTERX_TYPE_NAME(list)) || !filterx_object_len(container, &len))
+        {
+          self->compiled = FALSE;
+          return;
+        }
+
+      for (guint64 i = 0; i < len && self->compiled; i++)
+        {
+          FilterXObject *element = filterx_sequence_get_subscript(container, i);
+
+          if (!element || !_compile_element(self, element))
+            self->compiled = FALSE;
+          filterx_object_unref(element);
+        }
+    }
+  else if (!filterx_expr_is_literal_list(self->super.rhs) ||
+           !filterx_literal_list_foreach(self->super.rhs, _compile_literal_list_element, self))
+    {
+      self->compiled = FALSE;
+    }
+
+  if (!self->compiled)
+    _drop_compiled_list(self);
+}
+
 static FilterXExpr *
 _optimize_in(FilterXExpr *s)
 {
@@ -80,11 +269,22 @@ _optimize_in(FilterXExpr *s)
 
   if (member && container)
     result = filterx_literal_new(filterx_object_is_member_of(container, member));
+  else if (!member)
+    _compile_literal_list(self, container);
   filterx_object_unref(member);
   filterx_object_unref(container);
   return result;
 }
 
+static void
+_free_in(FilterXExpr *s)
+{
+  FilterXOperatorIn *self = (FilterXOperatorIn *) s;
+
+  _drop_compiled_list(self);
+  filterx_binary_op_free_method(s);
+}
+
 FilterXExpr *
 filterx_membership_in_new(FilterXExpr *lhs, FilterXExpr *rhs)
 {
@@ -93,6 +293,7 @@ filterx_membership_in_new(FilterXExpr *lhs, FilterXExpr *rhs)
   filterx_binary_op_init_instance(&self->super, "in", FXE_READ, lhs, rhs);
   self->super.super.optimize = _optimize_in;
   self->super.super.eval = _eval_in;
+  self->super.super.free_fn = _free_in;
 
   return &self->super.super;
 }
@@ -30,6 +30,7 @@
 #include "filterx/object-extractor.h"
 #include "filterx/json-repr.h"
 #include "filterx/expr-comparison.h"
+#include "filterx/object-subnet.h"
 #include "logmsg/type-hinting.h"
 #include "utf8utils.h"
 #include "str-format.h"
@@ -201,6 +202,10 @@ _filterx_list_is_member_of(FilterXObject *s, FilterXObject *member)
 
       if (filterx_compare_objects(member, elt, FCMPX_TYPE_AND_VALUE_BASED | FCMPX_EQ))
         return filterx_boolean_new(TRUE);
+
+      /* addresses are members of a list if any of its subnets contain them */
+      if (filterx_object_is_type(elt, &FILTERX_TYPE_NAME(subnet)) && filterx_subnet_contains(elt, member))
+        return filterx_boolean_new(TRUE);
     }
 
   return filterx_boolean_new(FALSE);
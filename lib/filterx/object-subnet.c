@@ -346,6 +346,223 @@ _subnet_is_member_of(FilterXObject *s, FilterXObject *member)
   return _subnet_is_string_member_of(self, member);
 }
 
+/*
+ * Extract an address from an ip() or a string member, without reporting
+ * errors. @family is set to AF_INET or AF_INET6, @addr is large enough for
+ * both.
+ */
+static gboolean
+_extract_address(FilterXObject *member, gint *family, struct in6_addr *addr)
+{
+  const struct in_addr *ipv4 = filterx_ip_get_v4(member);
+  if (ipv4)
+    {
+      *family = AF_INET;
+      memcpy(addr, ipv4, sizeof(*ipv4));
+      return TRUE;
+    }
+
+  const struct in6_addr *ipv6 = filterx_ip_get_v6(member);
+  if (ipv6)
+    {
+      *family = AF_INET6;
+      *addr = *ipv6;
+      return TRUE;
+    }
+
+  const gchar *str;
+  if (!filterx_object_extract_string_as_cstr(member, &str))
+    return FALSE;
+
+  if (g_inet_aton(str, (struct in_addr *) addr) == 1)
+    {
+      *family = AF_INET;
+      return TRUE;
+    }
+  if (inet_pton(AF_INET6, str, addr) == 1)
+    {
+      *family = AF_INET6;
+      return TRUE;
+    }
+  return FALSE;
+}
+
+/* same as the `in` operator, but returns FALSE instead of an error for anything that is not an address */
+gboolean
+filterx_subnet_contains(FilterXObject *s, FilterXObject *member)
+{
+  FilterXSubnet *self = (FilterXSubnet *) s;
+  struct in6_addr addr;
+  gint family;
+
+  g_assert(filterx_object_is_type(s, &FILTERX_TYPE_NAME(subnet)));
+
+  if (!_extract_address(member, &family, &addr) || family != self->family)
+    return FALSE;
+
+  switch (self->family)
+    {
+    case AF_INET:
+    {
+      struct in_addr *ipv4 = (struct in_addr *) &addr;
+      return (ipv4->s_addr & self->ipv4.netmask.s_addr) == self->ipv4.address.s_addr;
+    }
+    case AF_INET6:
+      _apply_ipv6_mask(self, &addr);
+      return memcmp(addr.s6_addr, self->ipv6.address.s6_addr, sizeof(addr.s6_addr)) == 0;
+    default:
+      g_assert_not_reached();
+    }
+}
+
+/*
+ * FilterXSubnetTrie
+ *
+ * Binary trie of subnets, one per address family, used to match an address
+ * against a large number of subnets in O(prefix length) steps.
+ */
+
+typedef struct _FilterXSubnetTrieNode FilterXSubnetTrieNode;
+struct _FilterXSubnetTrieNode
+{
+  FilterXSubnetTrieNode *children[2];
+  gboolean terminal;
+};
+
+struct _FilterXSubnetTrie
+{
+  FilterXSubnetTrieNode *ipv4_root;
+  FilterXSubnetTrieNode *ipv6_root;
+};
+
+static inline gint
+_address_bit(const guint8 *addr, gint bit)
+{
+  return (addr[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+/* returns -1 for netmasks that are not contiguous (e.g. 255.0.255.0) */
+static gint
+_netmask_to_prefix(const guint8 *netmask, gsize netmask_len)
+{
+  gint prefix = 0;
+
+  while (prefix < netmask_len * 8 && _address_bit(netmask, prefix))
+    prefix++;
+
+  for (gint bit = prefix; bit < netmask_len * 8; bit++)
+    {
+      if (_address_bit(netmask, bit))
+        return -1;
+    }
+  return prefix;
+}
+
+static void
+_trie_node_free(FilterXSubnetTrieNode *node)
+{
+  if (!node)
+    return;
+
+  _trie_node_free(node->children[0]);
+  _trie_node_free(node->children[1]);
+  g_free(node);
+}
+
+static void
+_trie_insert(FilterXSubnetTrieNode **root, const guint8 *address, gint prefix)
+{
+  if (!*root)
+    *root = g_new0(FilterXSubnetTrieNode, 1);
+
+  FilterXSubnetTrieNode *node = *root;
+  for (gint bit = 0; bit < prefix && !node->terminal; bit++)
+    {
+      FilterXSubnetTrieNode **child = &node->children[_address_bit(address, bit)];
+
+      if (!*child)
+        *child = g_new0(FilterXSubnetTrieNode, 1);
+      node = *child;
+    }
+
+  /* a shorter prefix covering this subnet makes the longer ones redundant */
+  node->terminal = TRUE;
+  _trie_node_free(node->children[0]);
+  _trie_node_free(node->children[1]);
+  node->children[0] = node->children[1] = NULL;
+}
+
+static gboolean
+_trie_lookup(FilterXSubnetTrieNode *node, const guint8 *address, gint address_bits)
+{
+  for (gint bit = 0; node; bit++)
+    {
+      if (node->terminal)
+        return TRUE;
+      if (bit == address_bits)
+        break;
+      node = node->children[_address_bit(address, bit)];
+    }
+  return FALSE;
+}
+
+FilterXSubnetTrie *
+filterx_subnet_trie_new(void)
+{
+  return g_new0(FilterXSubnetTrie, 1);
+}
+
+/* returns FALSE if @subnet can not be represented by a prefix (non-contiguous netmask) */
+gboolean
+filterx_subnet_trie_add(FilterXSubnetTrie *self, FilterXObject *subnet)
+{
+  FilterXSubnet *other = (FilterXSubnet *) subnet;
+  gint prefix;
+
+  g_assert(filterx_object_is_type(subnet, &FILTERX_TYPE_NAME(subnet)));
+
+  switch (other->family)
+    {
+    case AF_INET:
+      prefix = _netmask_to_prefix((const guint8 *) &other->ipv4.netmask, sizeof(other->ipv4.netmask));
+      if (prefix < 0)
+        return FALSE;
+      _trie_insert(&self->ipv4_root, (const guint8 *) &other->ipv4.address, prefix);
+      return TRUE;
+    case AF_INET6:
+      prefix = _netmask_to_prefix(other->ipv6.netmask.s6_addr, sizeof(other->ipv6.netmask.s6_addr));
+      if (prefix < 0)
+        return FALSE;
+      _trie_insert(&self->ipv6_root, other->ipv6.address.s6_addr, prefix);
+      return TRUE;
+    default:
+      g_assert_not_reached();
+    }
+}
+
+/* matches the same addresses as filterx_subnet_contains() on any of the subnets added */
+gboolean
+filterx_subnet_trie_contains(FilterXSubnetTrie *self, FilterXObject *member)
+{
+  struct in6_addr addr;
+  gint family;
+
+  if (!_extract_address(member, &family, &addr))
+    return FALSE;
+
+  if (family == AF_INET)
+    return _trie_lookup(self->ipv4_root, (const guint8 *) &addr, sizeof(struct in_addr) * 8);
+  return _trie_lookup(self->ipv6_root, addr.s6_addr, sizeof(addr.s6_addr) * 8);
+}
+
+void
+filterx_subnet_trie_free(FilterXSubnetTrie *self)
+{
+  _trie_node_free(self->ipv4_root);
+  _trie_node_free(self->ipv6_root);
+  g_free(self);
+}
+
 /* NOTE: returns NULL for invalid CIDR values */
 FilterXObject *
 filterx_subnet_new_from_cidr(const gchar *cidr)
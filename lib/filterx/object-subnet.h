@@ -31,5 +31,13 @@ FILTERX_DECLARE_TYPE(subnet);
 /* NOTE: returns NULL for invalid CIDR values */
 FilterXObject *filterx_subnet_new_from_cidr(const gchar *cidr);
 FilterXObject *filterx_typecast_subnet(FilterXExpr *s, FilterXObject *args[], gsize args_len);
+gboolean filterx_subnet_contains(FilterXObject *s, FilterXObject *member);
+
+typedef struct _FilterXSubnetTrie FilterXSubnetTrie;
+
+FilterXSubnetTrie *filterx_subnet_trie_new(void);
+gboolean filterx_subnet_trie_add(FilterXSubnetTrie *self, FilterXObject *subnet);
+gboolean filterx_subnet_trie_contains(FilterXSubnetTrie *self, FilterXObject *member);
+void filterx_subnet_trie_free(FilterXSubnetTrie *self);
 
 #endif
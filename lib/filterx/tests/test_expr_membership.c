@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/filterx-lib.h"
+
+#include "filterx/expr-membership.h"
+#include "filterx/expr-literal.h"
+#include "filterx/expr-literal-container.h"
+#include "filterx/expr-function.h"
+#include "filterx/filterx-private.h"
+#include "filterx/filterx-eval.h"
+#include "filterx/object-primitive.h"
+#include "filterx/object-string.h"
+#include "filterx/object-subnet.h"
+
+#include "apphook.h"
+#include "scratch-buffers.h"
+
+typedef GList *(*ListElementsBuilder)(void);
+
+static GList *
+_append_literal(GList *elements, FilterXObject *value)
+{
+  return g_list_append(elements, filterx_literal_element_new(NULL, filterx_literal_new(value)));
+}
+
+static GList *
+_append_subnet(GList *elements, const gchar *cidr)
+{
+  GList *args = g_list_append(NULL, filterx_function_arg_new(NULL, filterx_literal_new(filterx_string_new(cidr, -1))));
+  FilterXExpr *subnet = filterx_simple_function_new("subnet", filterx_function_args_new(args, NULL),
+                                                    filterx_typecast_subnet, NULL);
+  cr_assert_not_null(subnet);
+
+  return g_list_append(elements, filterx_literal_element_new(NULL, subnet));
+}
+
+static FilterXExpr *
+_in_expr_new(FilterXObject *member, ListElementsBuilder build_elements)
+{
+  /* the member is not a literal, so the expression cannot be folded */
+  return filterx_membership_in_new(filterx_object_expr_new(filterx_object_ref(member)),
+                                   filterx_literal_list_new(build_elements()));
+}
+
+static FilterXObject *
+_eval_and_free(FilterXExpr *expr)
+{
+  FilterXObject *result = init_and_eval_expr(expr);
+  filterx_expr_unref(expr);
+  return result;
+}
+
+/* evaluates `member in [...]` both with and without optimization, the
+ * optimized expression uses the compiled list if the list can be compiled */
+static void
+_assert_in(FilterXObject *member, ListElementsBuilder build_elements, gboolean expected)
+{
+  FilterXObject *optimized = _eval_and_free(filterx_expr_optimize(_in_expr_new(member, build_elements)));
+  FilterXObject *interpreted = _eval_and_free(_in_expr_new(member, build_elements));
+
+  cr_assert_not_null(optimized);
+  cr_assert_not_null(interpreted);
+  cr_assert_eq(filterx_object_truthy(optimized), expected);
+  cr_assert_eq(filterx_object_truthy(interpreted), expected);
+
+  filterx_object_unref(optimized);
+  filterx_object_unref(interpreted);
+  filterx_object_unref(member);
+}
+
+static GList *
+_string_list(void)
+{
+  GList *elements = NULL;
+
+  elements = _append_literal(elements, filterx_string_new("foo", -1));
+  elements = _append_literal(elements, filterx_string_new("bar", -1));
+  elements = _append_literal(elements, filterx_string_new("1", -1));
+  return elements;
+}
+
+static GList *
+_integer_list(void)
+{
+  GList *elements = NULL;
+
+  elements = _append_literal(elements, filterx_integer_new(1));
+  elements = _append_literal(elements, filterx_integer_new(42));
+  elements = _append_literal(elements, filterx_integer_new(-7));
+  return elements;
+}
+
+static GList *
+_mixed_list(void)
+{
+  GList *elements = NULL;
+
+  elements = _append_literal(elements, filterx_string_new("foo", -1));
+  elements = _append_subnet(elements, "10.0.0.0/8");
+  elements = _append_literal(elements, filterx_integer_new(42));
+  elements = _append_subnet(elements, "2001:db8::/32");
+  return elements;
+}
+
+static GList *
+_list_with_non_literal_element(void)
+{
+  GList *elements = NULL;
+
+  elements = _append_literal(elements, filterx_string_new("foo", -1));
+  elements = g_list_append(elements,
+                           filterx_literal_element_new(NULL, filterx_object_expr_new(filterx_string_new("bar", -1))));
+  return elements;
+}
+
+static GList *
+_list_with_failing_element(void)
+{
+  GList *elements = NULL;
+
+  elements = _append_literal(elements, filterx_string_new("foo", -1));
+  elements = g_list_append(elements, filterx_literal_element_new(NULL, filterx_dummy_error_new("element failed")));
+  return elements;
+}
+
+Test(expr_membership, test_string_members)
+{
+  _assert_in(filterx_string_new("foo", -1), _string_list, TRUE);
+  _assert_in(filterx_string_new("1", -1), _string_list, TRUE);
+  _assert_in(filterx_string_new("baz", -1), _string_list, FALSE);
+  _assert_in(filterx_string_new("fo", -1), _string_list, FALSE);
+  _assert_in(filterx_string_new("", -1), _string_list, FALSE);
+}
+
+Test(expr_membership, test_integer_members)
+{
+  _assert_in(filterx_integer_new(42), _integer_list, TRUE);
+  _assert_in(filterx_integer_new(-7), _integer_list, TRUE);
+  _assert_in(filterx_integer_new(43), _integer_list, FALSE);
+}
+
+Test(expr_membership, test_members_of_a_different_type_do_not_match)
+{
+  _assert_in(filterx_integer_new(1), _string_list, FALSE);
+  _assert_in(filterx_string_new("1", -1), _integer_list, FALSE);
+  _assert_in(filterx_string_new("42", -1), _integer_list, FALSE);
+  _assert_in(filterx_boolean_new(TRUE), _integer_list, FALSE);
+}
+
+Test(expr_membership, test_mixed_subnet_and_literal_members)
+{
+  _assert_in(filterx_string_new("foo", -1), _mixed_list, TRUE);
+  _assert_in(filterx_integer_new(42), _mixed_list, TRUE);
+  _assert_in(filterx_string_new("10.1.2.3", -1), _mixed_list, TRUE);
+  _assert_in(filterx_string_new("2001:db8::1", -1), _mixed_list, TRUE);
+  _assert_in(filterx_string_new("11.1.2.3", -1), _mixed_list, FALSE);
+  _assert_in(filterx_string_new("2001:db9::1", -1), _mixed_list, FALSE);
+  _assert_in(filterx_string_new("42", -1), _mixed_list, FALSE);
+}
+
+Test(expr_membership, test_lists_with_non_literal_elements_are_evaluated)
+{
+  _assert_in(filterx_string_new("foo", -1), _list_with_non_literal_element, TRUE);
+  _assert_in(filterx_string_new("bar", -1), _list_with_non_literal_element, TRUE);
+  _assert_in(filterx_string_new("baz", -1), _list_with_non_literal_element, FALSE);
+}
+
+Test(expr_membership, test_failing_list_elements_are_not_compiled)
+{
+  FilterXObject *member = filterx_string_new("foo", -1);
+
+  /* the list is evaluated at runtime, so the error of its element is reported */
+  FilterXObject *result = _eval_and_free(filterx_expr_optimize(_in_expr_new(member, _list_with_failing_element)));
+  cr_assert_null(result);
+  filterx_eval_clear_errors();
+
+  filterx_object_unref(member);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  init_libtest_filterx();
+}
+
+static void
+teardown(void)
+{
+  scratch_buffers_explicit_gc();
+  deinit_libtest_filterx();
+  app_shutdown();
+}
+
+TestSuite(expr_membership, .init = setup, .fini = teardown);
@@ -363,6 +363,87 @@ Test(filterx_object_subnet, typecast_rejects_empty_args)
   cr_assert_null(obj);
 }
 
+/* Subnet trie */
+
+static FilterXSubnetTrie *
+_create_trie(const gchar *cidrs[], gsize cidrs_len)
+{
+  FilterXSubnetTrie *trie = filterx_subnet_trie_new();
+
+  for (gsize i = 0; i < cidrs_len; i++)
+    {
+      FilterXObject *subnet = filterx_subnet_new_from_cidr(cidrs[i]);
+      cr_assert_not_null(subnet);
+      cr_assert(filterx_subnet_trie_add(trie, subnet));
+      filterx_object_unref(subnet);
+    }
+  return trie;
+}
+
+static void
+_assert_trie_contains(FilterXSubnetTrie *trie, const gchar *address, gboolean expected)
+{
+  FilterXObject *member = filterx_string_new(address, -1);
+  cr_assert_eq(filterx_subnet_trie_contains(trie, member), expected, "unexpected trie lookup result for %s", address);
+  filterx_object_unref(member);
+}
+
+Test(filterx_object_subnet, trie_matches_any_of_the_subnets)
+{
+  const gchar *cidrs[] = { "10.0.0.0/8", "192.168.1.0/24", "172.16.5.4", "2001:db8::/32", "::1" };
+  FilterXSubnetTrie *trie = _create_trie(cidrs, G_N_ELEMENTS(cidrs));
+
+  _assert_trie_contains(trie, "10.200.1.1", TRUE);
+  _assert_trie_contains(trie, "192.168.1.254", TRUE);
+  _assert_trie_contains(trie, "172.16.5.4", TRUE);
+  _assert_trie_contains(trie, "2001:db8:1::1", TRUE);
+  _assert_trie_contains(trie, "::1", TRUE);
+
+  _assert_trie_contains(trie, "11.0.0.1", FALSE);
+  _assert_trie_contains(trie, "192.168.2.1", FALSE);
+  _assert_trie_contains(trie, "172.16.5.5", FALSE);
+  _assert_trie_contains(trie, "2001:db9::1", FALSE);
+  _assert_trie_contains(trie, "::2", FALSE);
+  _assert_trie_contains(trie, "not-an-address", FALSE);
+
+  filterx_subnet_trie_free(trie);
+}
+
+Test(filterx_object_subnet, trie_shorter_prefix_covers_longer_ones)
+{
+  const gchar *cidrs[] = { "10.1.2.0/24", "10.0.0.0/8", "10.1.0.0/16" };
+  FilterXSubnetTrie *trie = _create_trie(cidrs, G_N_ELEMENTS(cidrs));
+
+  _assert_trie_contains(trie, "10.1.2.3", TRUE);
+  _assert_trie_contains(trie, "10.255.0.1", TRUE);
+  _assert_trie_contains(trie, "9.255.255.255", FALSE);
+
+  filterx_subnet_trie_free(trie);
+}
+
+Test(filterx_object_subnet, trie_default_route_matches_everything_in_its_family)
+{
+  const gchar *cidrs[] = { "0.0.0.0/0" };
+  FilterXSubnetTrie *trie = _create_trie(cidrs, G_N_ELEMENTS(cidrs));
+
+  _assert_trie_contains(trie, "1.2.3.4", TRUE);
+  _assert_trie_contains(trie, "::1", FALSE);
+
+  filterx_subnet_trie_free(trie);
+}
+
+Test(filterx_object_subnet, trie_rejects_non_contiguous_netmask)
+{
+  FilterXSubnetTrie *trie = filterx_subnet_trie_new();
+  FilterXObject *subnet = filterx_subnet_new_from_cidr("10.0.0.0/255.0.255.0");
+
+  cr_assert_not_null(subnet);
+  cr_assert_not(filterx_subnet_trie_add(trie, subnet));
+
+  filterx_object_unref(subnet);
+  filterx_subnet_trie_free(trie);
+}
+
 static void
 setup(void)
 {
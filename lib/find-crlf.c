@@ -23,26 +23,47 @@
 #include "find-crlf.h"
 
 #include <string.h>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define FIND_CRLF_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define FIND_CRLF_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef const gchar *(*FindFirstOf3Func)(const gchar *s, gsize n, gchar a, gchar b, gchar c);
+
+#define IS_ONE_OF3(ch, a, b, c) ((ch) == (a) || (ch) == (b) || (ch) == (c))
+
+static inline const gchar *
+_find_first_of3_bytewise(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  for (; n > 0; s++, n--)
+    {
+      if (IS_ONE_OF3(*s, a, b, c))
+        return s;
+    }
+  return NULL;
+}
+
 /**
- * This is an optimized version of finding either a CR or LF or NUL
- * character in a buffer.  It is used to find these line terminators in
- * syslog traffic.
- *
- * It uses an algorithm very similar to what there's in libc memchr/strchr.
+ * This is an optimized version of finding one of three characters in a
+ * buffer, processing a machine word at a time.  It uses an algorithm very
+ * similar to what there's in libc memchr/strchr and is used on platforms
+ * without a SIMD implementation.
  **/
-const gchar *
-find_cr_or_lf_or_nul(const gchar *s, gsize n)
+static const gchar *
+_find_first_of3_longword(const gchar *s, gsize n, gchar a, gchar b, gchar c)
 {
   const gchar *char_ptr;
   gulong *longword_ptr;
-  gulong longword, magic_bits, cr_charmask, lf_charmask;
-  const char CR = '\r';
-  const char LF = '\n';
+  gulong longword, magic_bits, a_charmask, b_charmask, c_charmask;
 
   /* align input to long boundary */
   for (char_ptr = s; n > 0 && ((gulong) char_ptr & (sizeof(longword) - 1)) != 0; ++char_ptr, n--)
     {
-      if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
+      if (IS_ONE_OF3(*char_ptr, a, b, c))
         return char_ptr;
     }
 
@@ -55,15 +76,16 @@ find_cr_or_lf_or_nul(const gchar *s, gsize n)
 #else
 #error "unknown architecture"
 #endif
-  memset(&cr_charmask, CR, sizeof(cr_charmask));
-  memset(&lf_charmask, LF, sizeof(lf_charmask));
+  memset(&a_charmask, a, sizeof(a_charmask));
+  memset(&b_charmask, b, sizeof(b_charmask));
+  memset(&c_charmask, c, sizeof(c_charmask));
 
   while (n > sizeof(longword))
     {
       longword = *longword_ptr++;
-      if ((((longword + magic_bits) ^ ~longword) & ~magic_bits) != 0 ||
-          ((((longword ^ cr_charmask) + magic_bits) ^ ~(longword ^ cr_charmask)) & ~magic_bits) != 0 ||
-          ((((longword ^ lf_charmask) + magic_bits) ^ ~(longword ^ lf_charmask)) & ~magic_bits) != 0)
+      if (((((longword ^ a_charmask) + magic_bits) ^ ~(longword ^ a_charmask)) & ~magic_bits) != 0 ||
+          ((((longword ^ b_charmask) + magic_bits) ^ ~(longword ^ b_charmask)) & ~magic_bits) != 0 ||
+          ((((longword ^ c_charmask) + magic_bits) ^ ~(longword ^ c_charmask)) & ~magic_bits) != 0)
         {
           gint i;
 
@@ -71,7 +93,7 @@ find_cr_or_lf_or_nul(const gchar *s, gsize n)
 
           for (i = 0; i < sizeof(longword); i++)
             {
-              if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
+              if (IS_ONE_OF3(*char_ptr, a, b, c))
                 return char_ptr;
               char_ptr++;
             }
@@ -79,14 +101,139 @@ find_cr_or_lf_or_nul(const gchar *s, gsize n)
       n -= sizeof(longword);
     }
 
-  char_ptr = (gchar *) longword_ptr;
+  return _find_first_of3_bytewise((gchar *) longword_ptr, n, a, b, c);
+}
+
+#if FIND_CRLF_X86
 
-  while (n-- > 0)
+/* SSE2 is part of the x86_64 baseline, so this needs no runtime check */
+static const gchar *
+_find_first_of3_sse2(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  const __m128i va = _mm_set1_epi8(a);
+  const __m128i vb = _mm_set1_epi8(b);
+  const __m128i vc = _mm_set1_epi8(c);
+
+  while (n >= sizeof(__m128i))
     {
-      if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
-        return char_ptr;
-      ++char_ptr;
+      __m128i chunk = _mm_loadu_si128((const __m128i *) s);
+      __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                                             _mm_cmpeq_epi8(chunk, vb)),
+                                _mm_cmpeq_epi8(chunk, vc));
+      guint32 mask = (guint32) _mm_movemask_epi8(eq);
+
+      if (mask)
+        return s + __builtin_ctz(mask);
+      s += sizeof(__m128i);
+      n -= sizeof(__m128i);
     }
+  return _find_first_of3_bytewise(s, n, a, b, c);
+}
 
-  return NULL;
+__attribute__((target("avx2")))
+static const gchar *
+_find_first_of3_avx2(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  const __m256i va = _mm256_set1_epi8(a);
+  const __m256i vb = _mm256_set1_epi8(b);
+  const __m256i vc = _mm256_set1_epi8(c);
+
+  while (n >= sizeof(__m256i))
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *) s);
+      __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, va),
+                                                   _mm256_cmpeq_epi8(chunk, vb)),
+                                   _mm256_cmpeq_epi8(chunk, vc));
+      guint32 mask = (guint32) _mm256_movemask_epi8(eq);
+
+      if (mask)
+        return s + __builtin_ctz(mask);
+      s += sizeof(__m256i);
+      n -= sizeof(__m256i);
+    }
+  return _find_first_of3_sse2(s, n, a, b, c);
+}
+
+#elif FIND_CRLF_NEON
+
+static const gchar *
+_find_first_of3_neon(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  const uint8x16_t va = vdupq_n_u8((guint8) a);
+  const uint8x16_t vb = vdupq_n_u8((guint8) b);
+  const uint8x16_t vc = vdupq_n_u8((guint8) c);
+
+  while (n >= sizeof(uint8x16_t))
+    {
+      uint8x16_t chunk = vld1q_u8((const guint8 *) s);
+      uint8x16_t eq = vorrq_u8(vorrq_u8(vceqq_u8(chunk, va), vceqq_u8(chunk, vb)), vceqq_u8(chunk, vc));
+
+      /* narrow the 0x00/0xff lanes to one nibble per byte so the result fits in 64 bits */
+      guint64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+
+      if (mask)
+        return s + (__builtin_ctzll(mask) >> 2);
+      s += sizeof(uint8x16_t);
+      n -= sizeof(uint8x16_t);
+    }
+  return _find_first_of3_bytewise(s, n, a, b, c);
+}
+
+#endif
+
+static FindFirstOf3Func
+_select_find_first_of3(void)
+{
+#if FIND_CRLF_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return _find_first_of3_avx2;
+  return _find_first_of3_sse2;
+#elif FIND_CRLF_NEON
+  return _find_first_of3_neon;
+#else
+  return _find_first_of3_longword;
+#endif
+}
+
+static const gchar *_find_first_of3_resolve(const gchar *s, gsize n, gchar a, gchar b, gchar c);
+
+/* resolved on first use, racing threads all store the same value */
+static FindFirstOf3Func find_first_of3 = _find_first_of3_resolve;
+
+static const gchar *
+_find_first_of3_resolve(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  FindFirstOf3Func impl = _select_find_first_of3();
+
+  g_atomic_pointer_set(&find_first_of3, impl);
+  return impl(s, n, a, b, c);
+}
+
+/**
+ * Find either a CR or LF or NUL character in a buffer.  It is used to find
+ * these line terminators in syslog traffic.
+ *
+ * The implementation is chosen at runtime: AVX2 or SSE2 on x86, NEON on
+ * aarch64 and a word-at-a-time scan everywhere else.
+ **/
+const gchar *
+find_cr_or_lf_or_nul(const gchar *s, gsize n)
+{
+  return find_first_of3(s, n, '\r', '\n', '\0');
+}
+
+/* Find either an LF or a NUL character, used as the end-of-message marker
+ * by the text protocol server. */
+const gchar *
+find_lf_or_nul(const gchar *s, gsize n)
+{
+  return find_first_of3(s, n, '\n', '\0', '\0');
+}
+
+/* The portable implementation, kept for unit tests and benchmarks. */
+const gchar *
+find_cr_or_lf_or_nul_scalar(const gchar *s, gsize n)
+{
+  return _find_first_of3_longword(s, n, '\r', '\n', '\0');
 }
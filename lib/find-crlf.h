@@ -26,5 +26,8 @@
 #include "syslog-ng.h"
 
 const gchar *find_cr_or_lf_or_nul(const gchar *s, gsize n);
+const gchar *find_lf_or_nul(const gchar *s, gsize n);
+
+const gchar *find_cr_or_lf_or_nul_scalar(const gchar *s, gsize n);
 
 #endif
@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logmatcher-prefilter.h"
+#include "module-config.h"
+#include "cfg.h"
+#include "apphook.h"
+#include "messages.h"
+#include "tls-support.h"
+
+#include <string.h>
+
+#define MODULE_CONFIG_KEY "logmatcher-prefilter"
+
+/* number of name-value pairs of the same message whose scan results are kept */
+#define PREFILTER_CACHED_SCANS 4
+
+#define BITS_PER_WORD (sizeof(gulong) * 8)
+
+struct _LogMatcherPrefilter
+{
+  gint ref_cnt;
+  gboolean compiled;
+
+  /* literals are stored case folded, indexed by their id */
+  GPtrArray *literals;
+  GHashTable *literal_ids;
+
+  /* the compiled automaton, NULL if there is nothing to filter */
+  guint serial;
+  guint8 byte_class[256];
+  guint num_classes;
+  guint num_states;
+  guint32 *delta;
+  /* outputs of state N are outputs[output_start[N]] .. outputs[output_start[N + 1]] */
+  guint32 *output_start;
+  guint32 *outputs;
+  gsize num_words;
+};
+
+typedef struct _PrefilterScan
+{
+  NVHandle value_handle;
+  gulong *found;
+} PrefilterScan;
+
+TLS_BLOCK_START
+{
+  /* we hold a reference to the scanned message, so that its address can't
+   * be reused by another message while it is in the cache */
+  LogMessage *scan_msg;
+  guint16 scan_generation;
+  guint scan_serial;
+  gint num_scans;
+  gsize scan_words;
+  PrefilterScan scans[PREFILTER_CACHED_SCANS];
+}
+TLS_BLOCK_END;
+
+#define scan_msg __tls_deref(scan_msg)
+#define scan_generation __tls_deref(scan_generation)
+#define scan_serial __tls_deref(scan_serial)
+#define num_scans __tls_deref(num_scans)
+#define scan_words __tls_deref(scan_words)
+#define scans __tls_deref(scans)
+
+static gint prefilter_serial;
+
+static void
+_build_byte_classes(LogMatcherPrefilter *self)
+{
+  guint8 folded_class[256] = { 0 };
+
+  /* class 0 is for bytes that don't occur in any of the literals */
+  self->num_classes = 1;
+  for (guint i = 0; i < self->literals->len; i++)
+    {
+      const guchar *literal = g_ptr_array_index(self->literals, i);
+
+      for (; *literal; literal++)
+        {
+          if (!folded_class[*literal])
+            folded_class[*literal] = self->num_classes++;
+        }
+    }
+
+  for (gint b = 0; b < 256; b++)
+    self->byte_class[b] = folded_class[(guchar) g_ascii_tolower(b)];
+}
+
+static void
+_build_trie(LogMatcherPrefilter *self, gint32 *go, GPtrArray *state_outputs)
+{
+  self->num_states = 1;
+  for (guint i = 0; i < self->literals->len; i++)
+    {
+      const guchar *literal = g_ptr_array_index(self->literals, i);
+      guint32 state = 0;
+
+      for (; *literal; literal++)
+        {
+          gint32 *next = &go[state * self->num_classes + self->byte_class[*literal]];
+
+          if (*next < 0)
+            *next = self->num_states++;
+          state = *next;
+        }
+
+      GArray *outputs = g_ptr_array_index(state_outputs, state);
+      g_array_append_val(outputs, i);
+    }
+}
+
+/* turns the trie into a DFA: missing transitions are resolved through the
+ * failure links, and each state inherits the outputs of its failure state */
+static void
+_build_automaton(LogMatcherPrefilter *self, gint32 *go, GPtrArray *state_outputs)
+{
+  guint32 *fail = g_new0(guint32, self->num_states);
+  guint32 *queue = g_new(guint32, self->num_states);
+  guint queue_head = 0, queue_tail = 0;
+
+  for (guint c = 0; c < self->num_classes; c++)
+    {
+      if (go[c] < 0)
+        {
+          go[c] = 0;
+          continue;
+        }
+      fail[go[c]] = 0;
+      queue[queue_tail++] = go[c];
+    }
+
+  while (queue_head < queue_tail)
+    {
+      guint32 state = queue[queue_head++];
+
+      GArray *fail_outputs = g_ptr_array_index(state_outputs, fail[state]);
+      GArray *outputs = g_ptr_array_index(state_outputs, state);
+      g_array_append_vals(outputs, fail_outputs->data, fail_outputs->len);
+
+      for (guint c = 0; c < self->num_classes; c++)
+        {
+          gint32 *next = &go[state * self->num_classes + c];
+          gint32 fail_next = go[fail[state] * self->num_classes + c];
+
+          if (*next < 0)
+            {
+              *next = fail_next;
+              continue;
+            }
+          fail[*next] = fail_next;
+          queue[queue_tail++] = *next;
+        }
+    }
+
+  g_free(queue);
+  g_free(fail);
+}
+
+static void
+_flatten_outputs(LogMatcherPrefilter *self, GPtrArray *state_outputs)
+{
+  guint32 num_outputs = 0;
+
+  self->output_start = g_new(guint32, self->num_states + 1);
+  for (guint s = 0; s < self->num_states; s++)
+    {
+      self->output_start[s] = num_outputs;
+      num_outputs += ((GArray *) g_ptr_array_index(state_outputs, s))->len;
+    }
+  self->output_start[self->num_states] = num_outputs;
+
+  self->outputs = g_new(guint32, MAX(num_outputs, 1));
+  for (guint s = 0; s < self->num_states; s++)
+    {
+      GArray *outputs = g_ptr_array_index(state_outputs, s);
+      if (outputs->len)
+        memcpy(&self->outputs[self->output_start[s]], outputs->data, outputs->len * sizeof(guint32));
+    }
+}
+
+void
+log_matcher_prefilter_compile(LogMatcherPrefilter *self)
+{
+  if (self->compiled)
+    return;
+
+  self->compiled = TRUE;
+  if (self->literals->len == 0)
+    return;
+
+  _build_byte_classes(self);
+
+  guint max_states = 1;
+  for (guint i = 0; i < self->literals->len; i++)
+    max_states += strlen(g_ptr_array_index(self->literals, i));
+
+  gint32 *go = g_new(gint32, (gsize) max_states * self->num_classes);
+  memset(go, 0xff, (gsize) max_states * self->num_classes * sizeof(gint32));
+
+  GPtrArray *state_outputs = g_ptr_array_new_with_free_func((GDestroyNotify) g_array_unref);
+  for (guint s = 0; s < max_states; s++)
+    g_ptr_array_add(state_outputs, g_array_new(FALSE, FALSE, sizeof(guint32)));
+
+  _build_trie(self, go, state_outputs);
+  _build_automaton(self, go, state_outputs);
+  _flatten_outputs(self, state_outputs);
+  g_ptr_array_free(state_outputs, TRUE);
+
+  guint32 *delta = g_new(guint32, (gsize) self->num_states * self->num_classes);
+  memcpy(delta, go, (gsize) self->num_states * self->num_classes * sizeof(guint32));
+  g_free(go);
+
+  self->num_words = (self->literals->len + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  self->serial = (guint) g_atomic_int_add(&prefilter_serial, 1) + 1;
+
+  /* readers only look at the rest of the automaton once delta is set, so
+   * it is published last, with a barrier */
+  g_atomic_pointer_set(&self->delta, delta);
+
+  msg_debug("Regexp prefilter compiled",
+            evt_tag_int("literals", self->literals->len),
+            evt_tag_int("states", self->num_states),
+            evt_tag_int("byte_classes", self->num_classes));
+}
+
+gint
+log_matcher_prefilter_add_literal(LogMatcherPrefilter *self, const gchar *literal, gssize literal_len)
+{
+  if (self->compiled)
+    return -1;
+
+  if (literal_len < 0)
+    literal_len = strlen(literal);
+
+  g_assert(literal_len > 0 && memchr(literal, 0, literal_len) == NULL);
+
+  gchar *folded = g_ascii_strdown(literal, literal_len);
+  gpointer id;
+
+  if (g_hash_table_lookup_extended(self->literal_ids, folded, NULL, &id))
+    {
+      g_free(folded);
+      return GPOINTER_TO_INT(id);
+    }
+
+  g_ptr_array_add(self->literals, folded);
+  g_hash_table_insert(self->literal_ids, folded, GINT_TO_POINTER(self->literals->len - 1));
+  return self->literals->len - 1;
+}
+
+gsize
+log_matcher_prefilter_get_num_literals(LogMatcherPrefilter *self)
+{
+  return self->literals->len;
+}
+
+static void
+_scan(LogMatcherPrefilter *self, const guint32 *delta, const gchar *value, gsize value_len, gulong *found)
+{
+  const guint8 *byte_class = self->byte_class;
+  guint num_classes = self->num_classes;
+  guint32 state = 0;
+
+  memset(found, 0, self->num_words * sizeof(gulong));
+  for (gsize i = 0; i < value_len; i++)
+    {
+      state = delta[state * num_classes + byte_class[(guchar) value[i]]];
+
+      for (guint32 o = self->output_start[state]; o < self->output_start[state + 1]; o++)
+        found[self->outputs[o] / BITS_PER_WORD] |= 1UL << (self->outputs[o] % BITS_PER_WORD);
+    }
+}
+
+static void
+_release_scan_msg(void)
+{
+  if (scan_msg)
+    log_msg_unref(scan_msg);
+  scan_msg = NULL;
+  num_scans = 0;
+}
+
+static PrefilterScan *
+_lookup_scan(LogMatcherPrefilter *self, LogMessage *msg, NVHandle value_handle)
+{
+  if (scan_msg == msg && scan_generation == msg->generation && scan_serial == self->serial)
+    {
+      for (gint i = 0; i < num_scans; i++)
+        {
+          if (scans[i].value_handle == value_handle)
+            return &scans[i];
+        }
+      return NULL;
+    }
+
+  _release_scan_msg();
+  scan_msg = log_msg_ref(msg);
+  scan_generation = msg->generation;
+  scan_serial = self->serial;
+  return NULL;
+}
+
+static PrefilterScan *
+_alloc_scan(LogMatcherPrefilter *self, NVHandle value_handle)
+{
+  if (scan_words < self->num_words)
+    {
+      for (gint i = 0; i < PREFILTER_CACHED_SCANS; i++)
+        scans[i].found = g_renew(gulong, scans[i].found, self->num_words);
+      scan_words = self->num_words;
+    }
+
+  PrefilterScan *scan = &scans[num_scans < PREFILTER_CACHED_SCANS ? num_scans++ : PREFILTER_CACHED_SCANS - 1];
+  scan->value_handle = value_handle;
+  return scan;
+}
+
+gboolean
+log_matcher_prefilter_is_candidate(LogMatcherPrefilter *self, gint literal_id,
+                                   LogMessage *msg, NVHandle value_handle,
+                                   const gchar *value, gssize value_len)
+{
+  const guint32 *delta = g_atomic_pointer_get(&self->delta);
+
+  /* macros are not stored in the message, their value may change without
+   * the generation counter of the message changing */
+  if (!delta || value_handle == LM_V_NONE || log_msg_is_handle_macro(value_handle))
+    return TRUE;
+
+  PrefilterScan *scan = _lookup_scan(self, msg, value_handle);
+  if (!scan)
+    {
+      if (value_len < 0)
+        value_len = strlen(value);
+
+      scan = _alloc_scan(self, value_handle);
+      _scan(self, delta, value, value_len, scan->found);
+    }
+
+  return !!(scan->found[literal_id / BITS_PER_WORD] & (1UL << (literal_id % BITS_PER_WORD)));
+}
+
+LogMatcherPrefilter *
+log_matcher_prefilter_new(void)
+{
+  LogMatcherPrefilter *self = g_new0(LogMatcherPrefilter, 1);
+
+  self->ref_cnt = 1;
+  self->literals = g_ptr_array_new_with_free_func(g_free);
+  self->literal_ids = g_hash_table_new(g_str_hash, g_str_equal);
+  return self;
+}
+
+LogMatcherPrefilter *
+log_matcher_prefilter_ref(LogMatcherPrefilter *self)
+{
+  self->ref_cnt++;
+  return self;
+}
+
+void
+log_matcher_prefilter_unref(LogMatcherPrefilter *self)
+{
+  if (--self->ref_cnt > 0)
+    return;
+
+  g_hash_table_destroy(self->literal_ids);
+  g_ptr_array_free(self->literals, TRUE);
+  g_free(self->delta);
+  g_free(self->output_start);
+  g_free(self->outputs);
+  g_free(self);
+}
+
+/* per-configuration instance */
+
+typedef struct _LogMatcherPrefilterConfig
+{
+  ModuleConfig super;
+  LogMatcherPrefilter *prefilter;
+} LogMatcherPrefilterConfig;
+
+static void
+_config_post_cfg_init(ModuleConfig *s, GlobalConfig *cfg)
+{
+  LogMatcherPrefilterConfig *self = (LogMatcherPrefilterConfig *) s;
+
+  log_matcher_prefilter_compile(self->prefilter);
+}
+
+static void
+_config_free(ModuleConfig *s)
+{
+  LogMatcherPrefilterConfig *self = (LogMatcherPrefilterConfig *) s;
+
+  log_matcher_prefilter_unref(self->prefilter);
+  module_config_free_method(s);
+}
+
+LogMatcherPrefilter *
+log_matcher_prefilter_get(GlobalConfig *cfg)
+{
+  LogMatcherPrefilterConfig *mc = g_hash_table_lookup(cfg->module_config, MODULE_CONFIG_KEY);
+  if (!mc)
+    {
+      mc = g_new0(LogMatcherPrefilterConfig, 1);
+      mc->super.post_cfg_init = _config_post_cfg_init;
+      mc->super.free_fn = _config_free;
+      mc->prefilter = log_matcher_prefilter_new();
+      g_hash_table_insert(cfg->module_config, g_strdup(MODULE_CONFIG_KEY), mc);
+    }
+  return mc->prefilter;
+}
+
+static void
+_deinit_tls_cache(gpointer user_data)
+{
+  _release_scan_msg();
+  for (gint i = 0; i < PREFILTER_CACHED_SCANS; i++)
+    {
+      g_free(scans[i].found);
+      scans[i].found = NULL;
+    }
+  scan_words = 0;
+}
+
+void
+log_matcher_prefilter_global_init(void)
+{
+  register_application_thread_deinit_hook(_deinit_tls_cache, NULL);
+}
+
+void
+log_matcher_prefilter_global_deinit(void)
+{
+  _deinit_tls_cache(NULL);
+}
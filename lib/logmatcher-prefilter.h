@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LOGMATCHER_PREFILTER_H_INCLUDED
+#define LOGMATCHER_PREFILTER_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "logmsg/logmsg.h"
+
+/*
+ * Configuration wide multi-literal prefilter for regexp matchers.
+ *
+ * Matchers register a literal that every matching value has to contain.
+ * Once the configuration is initialized, the literals are compiled into a
+ * single case-insensitive Aho-Corasick automaton.  The first matcher that
+ * evaluates a name-value pair of a message scans it once for all literals,
+ * the result is cached per thread until the message changes, so the rest
+ * of the matchers can reject the value without running their regexp.
+ *
+ * The prefilter may report false positives (e.g. because of case folding),
+ * but never false negatives.
+ */
+typedef struct _LogMatcherPrefilter LogMatcherPrefilter;
+
+LogMatcherPrefilter *log_matcher_prefilter_new(void);
+LogMatcherPrefilter *log_matcher_prefilter_ref(LogMatcherPrefilter *self);
+void log_matcher_prefilter_unref(LogMatcherPrefilter *self);
+
+/* returns the id of the literal, or -1 if the prefilter was already compiled */
+gint log_matcher_prefilter_add_literal(LogMatcherPrefilter *self, const gchar *literal, gssize literal_len);
+void log_matcher_prefilter_compile(LogMatcherPrefilter *self);
+gsize log_matcher_prefilter_get_num_literals(LogMatcherPrefilter *self);
+
+gboolean log_matcher_prefilter_is_candidate(LogMatcherPrefilter *self, gint literal_id,
+                                            LogMessage *msg, NVHandle value_handle,
+                                            const gchar *value, gssize value_len);
+
+LogMatcherPrefilter *log_matcher_prefilter_get(GlobalConfig *cfg);
+
+void log_matcher_prefilter_global_init(void);
+void log_matcher_prefilter_global_deinit(void);
+
+#endif
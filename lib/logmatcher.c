@@ -39,6 +39,8 @@ log_matcher_store_pattern(LogMatcher *self, const gchar *pattern)
 static void
 log_matcher_free_method(LogMatcher *self)
 {
+  if (self->prefilter)
+    log_matcher_prefilter_unref(self->prefilter);
   g_free(self->pattern);
 }
 
@@ -691,6 +693,330 @@ log_matcher_pcre_re_replace(LogMatcher *s, LogMessage *msg, gint value_handle, c
   return NULL;
 }
 
+/*
+ * Required literal extraction
+ *
+ * Finds the longest run of literal characters that every match of the
+ * regexp has to contain.  The parser is deliberately conservative: it only
+ * looks at the top level of the pattern, skips groups and character
+ * classes, and gives up on anything that could make the rest of the pattern
+ * optional or change how it is interpreted (alternation, option settings,
+ * verbs, \Q..\E, escapes with arguments).
+ */
+
+#define PCRE_REQUIRED_LITERAL_MIN_LEN 3
+
+static gint
+_pcre_skip_class(const gchar *p)
+{
+  gint i = 1;
+
+  if (p[i] == '^')
+    i++;
+  if (p[i] == ']')
+    i++;
+
+  while (p[i])
+    {
+      if (p[i] == '\\')
+        {
+          if (!p[i + 1])
+            return -1;
+          i += 2;
+        }
+      else if (p[i] == '[' && p[i + 1] == ':')
+        {
+          const gchar *end = strstr(&p[i + 2], ":]");
+          if (!end)
+            return -1;
+          i = end - p + 2;
+        }
+      else if (p[i] == ']')
+        {
+          return i + 1;
+        }
+      else
+        {
+          i++;
+        }
+    }
+  return -1;
+}
+
+/* (?i) and friends change the interpretation of the rest of the pattern */
+static gboolean
+_pcre_is_option_setting(const gchar *p)
+{
+  if (p[1] != '?')
+    return FALSE;
+
+  p += 2;
+  while (g_ascii_isalpha(*p) || *p == '-' || *p == '^')
+    p++;
+  return *p == ')';
+}
+
+static gint
+_pcre_skip_group(const gchar *p)
+{
+  gint depth = 0;
+  gint i = 0;
+
+  if (_pcre_is_option_setting(p))
+    return -1;
+
+  while (p[i])
+    {
+      switch (p[i])
+        {
+        case '\\':
+          if (!p[i + 1] || p[i + 1] == 'Q')
+            return -1;
+          i += 2;
+          break;
+        case '[':
+        {
+          gint class_len = _pcre_skip_class(&p[i]);
+          if (class_len < 0)
+            return -1;
+          i += class_len;
+          break;
+        }
+        case '(':
+          /* verbs like (*ACCEPT) can make the rest of the pattern optional */
+          if (p[i + 1] == '*')
+            return -1;
+          depth++;
+          i++;
+          break;
+        case ')':
+          i++;
+          if (--depth == 0)
+            return i;
+          break;
+        default:
+          i++;
+          break;
+        }
+    }
+  return -1;
+}
+
+/* returns the length of the escape sequence or -1 if it is not supported,
+ * *chars points to the escaped character if it is a literal */
+static gint
+_pcre_parse_escape(const gchar *p, const gchar **chars)
+{
+  guchar escaped = p[1];
+
+  *chars = NULL;
+  if (!escaped || escaped >= 0x80)
+    return -1;
+
+  if (!g_ascii_isalnum(escaped))
+    {
+      *chars = &p[1];
+      return 2;
+    }
+
+  /* character types and assertions without arguments */
+  if (strchr("dDwWsShHvVRXNbBAzZGKnrtfea", escaped) && !(escaped == 'N' && p[2] == '{'))
+    return 2;
+
+  return -1;
+}
+
+static gint
+_pcre_utf8_sequence_len(const gchar *p)
+{
+  guchar lead = *p;
+  gint len;
+
+  if (lead < 0x80)
+    return 1;
+  else if ((lead & 0xe0) == 0xc0)
+    len = 2;
+  else if ((lead & 0xf0) == 0xe0)
+    len = 3;
+  else if ((lead & 0xf8) == 0xf0)
+    len = 4;
+  else
+    return 1;
+
+  for (gint i = 1; i < len; i++)
+    {
+      if (((guchar) p[i] & 0xc0) != 0x80)
+        return 1;
+    }
+  return len;
+}
+
+/* returns the length of the quantifier at p (0 if there is none), or -1 if
+ * it can't be parsed, *min_repeat is set to the minimum number of repetitions */
+static gint
+_pcre_parse_quantifier(const gchar *p, gint *min_repeat)
+{
+  const gchar *start = p;
+
+  switch (*p)
+    {
+    case '*':
+    case '?':
+      *min_repeat = 0;
+      p++;
+      break;
+    case '+':
+      *min_repeat = 1;
+      p++;
+      break;
+    case '{':
+    {
+      gboolean has_min = FALSE;
+      gint n = 0;
+
+      p++;
+      while (g_ascii_isdigit(*p))
+        {
+          n = MIN(n * 10 + (*p - '0'), 65535);
+          has_min = TRUE;
+          p++;
+        }
+      if (*p == ',')
+        {
+          p++;
+          while (g_ascii_isdigit(*p))
+            p++;
+        }
+      else if (!has_min)
+        {
+          return -1;
+        }
+      if (*p != '}')
+        return -1;
+      p++;
+      *min_repeat = n;
+      break;
+    }
+    default:
+      *min_repeat = 1;
+      return 0;
+    }
+
+  /* lazy and possessive modifiers */
+  if (*p == '?' || *p == '+')
+    p++;
+  return p - start;
+}
+
+static inline void
+_pcre_finish_literal_run(GString *run, GString *literal)
+{
+  if (run->len > literal->len)
+    g_string_assign_len(literal, run->str, run->len);
+  g_string_truncate(run, 0);
+}
+
+static inline gboolean
+_pcre_can_be_part_of_literal(const gchar *chars, gint chars_len, gint flags)
+{
+  if (!(flags & LMF_ICASE))
+    return TRUE;
+
+  /* the prefilter only folds ASCII case.  In UTF mode caseless 'k' and 's'
+   * also match the KELVIN SIGN and LATIN SMALL LETTER LONG S */
+  if (chars_len > 1 || (guchar) chars[0] >= 0x80)
+    return FALSE;
+  if ((flags & LMF_UTF8) && strchr("kKsS", chars[0]))
+    return FALSE;
+  return TRUE;
+}
+
+gboolean
+log_matcher_pcre_extract_required_literal(const gchar *re, gint flags, GString *literal)
+{
+  GString *run = g_string_sized_new(32);
+  const gchar *p = re;
+
+  g_string_truncate(literal, 0);
+  while (*p)
+    {
+      const gchar *chars = NULL;
+      gint chars_len = 0;
+      gint atom_len;
+
+      switch (*p)
+        {
+        case '|':
+        case ')':
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+          goto give_up;
+        case '(':
+          atom_len = _pcre_skip_group(p);
+          break;
+        case '[':
+          atom_len = _pcre_skip_class(p);
+          break;
+        case '\\':
+          atom_len = _pcre_parse_escape(p, &chars);
+          chars_len = chars ? 1 : 0;
+          break;
+        case '^':
+        case '$':
+          _pcre_finish_literal_run(run, literal);
+          p++;
+          continue;
+        case '.':
+          atom_len = 1;
+          break;
+        default:
+          atom_len = _pcre_utf8_sequence_len(p);
+          chars = p;
+          chars_len = atom_len;
+          break;
+        }
+      if (atom_len < 0)
+        goto give_up;
+      p += atom_len;
+
+      gint min_repeat;
+      gint quantifier_len = _pcre_parse_quantifier(p, &min_repeat);
+      if (quantifier_len < 0)
+        goto give_up;
+      p += quantifier_len;
+
+      if (!chars || min_repeat == 0 || !_pcre_can_be_part_of_literal(chars, chars_len, flags))
+        {
+          _pcre_finish_literal_run(run, literal);
+          continue;
+        }
+
+      g_string_append_len(run, chars, chars_len);
+      if (quantifier_len > 0)
+        _pcre_finish_literal_run(run, literal);
+    }
+  _pcre_finish_literal_run(run, literal);
+  g_string_free(run, TRUE);
+
+  return literal->len >= PCRE_REQUIRED_LITERAL_MIN_LEN;
+
+give_up:
+  g_string_free(run, TRUE);
+  g_string_truncate(literal, 0);
+  return FALSE;
+}
+
+static gboolean
+log_matcher_pcre_re_get_required_literal(LogMatcher *s, GString *literal)
+{
+  if (!s->pattern)
+    return FALSE;
+
+  return log_matcher_pcre_extract_required_literal(s->pattern, s->flags, literal);
+}
+
 static void
 log_matcher_pcre_re_free(LogMatcher *s)
 {
@@ -711,6 +1037,7 @@ log_matcher_pcre_re_new(const LogMatcherOptions *options)
   self->super.compile = log_matcher_pcre_re_compile;
   self->super.match = log_matcher_pcre_re_match;
   self->super.replace = log_matcher_pcre_re_replace;
+  self->super.get_required_literal = log_matcher_pcre_re_get_required_literal;
   self->super.free_fn = log_matcher_pcre_re_free;
 
   return &self->super;
@@ -744,9 +1071,13 @@ log_matcher_match_value(LogMatcher *s, LogMessage *msg, gint value_handle)
   gssize value_len = 0;
   const gchar *value = log_msg_get_value(msg, value_handle, &value_len);
 
-  APPEND_ZERO(value, value, value_len);
-
-  gboolean result = log_matcher_match(s, msg, value_handle, value, value_len);
+  gboolean result = FALSE;
+  if (!s->prefilter ||
+      log_matcher_prefilter_is_candidate(s->prefilter, s->prefilter_literal, msg, value_handle, value, value_len))
+    {
+      APPEND_ZERO(value, value, value_len);
+      result = log_matcher_match(s, msg, value_handle, value, value_len);
+    }
   log_msg_unpin_payload(msg, pin);
   return result;
 }
@@ -829,6 +1160,28 @@ log_matcher_ref(LogMatcher *s)
   return s;
 }
 
+/* registers the required literal of the matcher in the prefilter, values
+ * that don't contain it are rejected by log_matcher_match_value() without
+ * evaluating the matcher */
+void
+log_matcher_attach_prefilter(LogMatcher *s, LogMatcherPrefilter *prefilter)
+{
+  if (s->prefilter || !s->get_required_literal)
+    return;
+
+  GString *literal = g_string_sized_new(32);
+  if (s->get_required_literal(s, literal))
+    {
+      gint literal_id = log_matcher_prefilter_add_literal(prefilter, literal->str, literal->len);
+      if (literal_id >= 0)
+        {
+          s->prefilter = log_matcher_prefilter_ref(prefilter);
+          s->prefilter_literal = literal_id;
+        }
+    }
+  g_string_free(literal, TRUE);
+}
+
 void
 log_matcher_unref(LogMatcher *s)
 {
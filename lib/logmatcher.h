@@ -26,6 +26,7 @@
 
 #include "logmsg/logmsg.h"
 #include "template/templates.h"
+#include "logmatcher-prefilter.h"
 
 #define LOG_MATCHER_ERROR log_template_error_quark()
 
@@ -65,12 +66,17 @@ struct _LogMatcher
   gint ref_cnt;
   gint flags;
   gchar *pattern;
+  /* literal registered in the configuration wide prefilter, see logmatcher-prefilter.h */
+  LogMatcherPrefilter *prefilter;
+  gint prefilter_literal;
   gboolean (*compile)(LogMatcher *s, const gchar *re, GError **error);
   /* value_len can be -1 to indicate unknown length */
   gboolean (*match)(LogMatcher *s, LogMessage *msg, gint value_handle, const gchar *value, gssize value_len);
   /* value_len can be -1 to indicate unknown length, new_length can be returned as -1 to indicate unknown length */
   gchar *(*replace)(LogMatcher *s, LogMessage *msg, gint value_handle, const gchar *value, gssize value_len,
                     LogTemplate *replacement, gssize *new_length);
+  /* optional: returns a literal that all matching values contain */
+  gboolean (*get_required_literal)(LogMatcher *s, GString *literal);
   void (*free_fn)(LogMatcher *s);
 };
 
@@ -119,6 +125,7 @@ LogMatcher *log_matcher_glob_new(const LogMatcherOptions *options);
 LogMatcher *log_matcher_new(const LogMatcherOptions *options);
 LogMatcher *log_matcher_ref(LogMatcher *s);
 void log_matcher_unref(LogMatcher *s);
+void log_matcher_attach_prefilter(LogMatcher *s, LogMatcherPrefilter *prefilter);
 
 
 gboolean log_matcher_options_set_type(LogMatcherOptions *options, const gchar *type);
@@ -128,5 +135,6 @@ void log_matcher_options_init(LogMatcherOptions *options);
 void log_matcher_options_destroy(LogMatcherOptions *options);
 
 void log_matcher_pcre_set_nv_prefix(LogMatcher *s, const gchar *prefix);
+gboolean log_matcher_pcre_extract_required_literal(const gchar *re, gint flags, GString *literal);
 
 #endif
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logmsg/logmsg-pool.h"
+#include "tls-support.h"
+#include "apphook.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+#include "metrics/metric-names.h"
+
+/* size classes are 512, 1024, 2048 and 4096 bytes, class 0 is unpooled */
+#define LOG_MSG_POOL_MIN_BLOCK_SHIFT 9
+#define LOG_MSG_POOL_NUM_CLASSES     4
+#define LOG_MSG_POOL_MAX_BLOCK_SIZE  (1 << (LOG_MSG_POOL_MIN_BLOCK_SHIFT + LOG_MSG_POOL_NUM_CLASSES - 1))
+
+/* number of blocks moved between a thread and the depot at once */
+#define LOG_MSG_POOL_BATCH_SIZE      64
+/* a thread keeps at most this many free blocks per size class */
+#define LOG_MSG_POOL_LOCAL_MAX       (2 * LOG_MSG_POOL_BATCH_SIZE)
+/* the depot keeps at most this many batches per size class */
+#define LOG_MSG_POOL_DEPOT_MAX       32
+
+/* stats are updated once every this many allocations */
+#define LOG_MSG_POOL_STATS_PERIOD    1024
+
+typedef struct _LogMsgPoolFreeBlock LogMsgPoolFreeBlock;
+struct _LogMsgPoolFreeBlock
+{
+  LogMsgPoolFreeBlock *next;
+};
+
+typedef struct _LogMsgPoolFreeList
+{
+  LogMsgPoolFreeBlock *head;
+  gint count;
+} LogMsgPoolFreeList;
+
+/* statically allocated, so the locks need no initialization */
+typedef struct _LogMsgPoolDepot
+{
+  GMutex lock;
+  LogMsgPoolFreeBlock *batches[LOG_MSG_POOL_DEPOT_MAX];
+  gint num_batches;
+} LogMsgPoolDepot;
+
+TLS_BLOCK_START
+{
+  LogMsgPoolFreeList free_lists[LOG_MSG_POOL_NUM_CLASSES];
+  gssize pool_hits;
+  gssize pool_misses;
+  gssize pool_held_bytes_reported;
+  gint pool_ops_since_update;
+  gboolean pool_exit_hook_registered;
+}
+TLS_BLOCK_END;
+
+#define free_lists  __tls_deref(free_lists)
+#define pool_hits  __tls_deref(pool_hits)
+#define pool_misses  __tls_deref(pool_misses)
+#define pool_held_bytes_reported  __tls_deref(pool_held_bytes_reported)
+#define pool_ops_since_update  __tls_deref(pool_ops_since_update)
+#define pool_exit_hook_registered  __tls_deref(pool_exit_hook_registered)
+
+static LogMsgPoolDepot depots[LOG_MSG_POOL_NUM_CLASSES];
+
+static void _deinit_thread_pool(gpointer user_data);
+
+/* not every thread that frees messages runs app_thread_stop() (e.g. threads
+ * of embedded language runtimes), the free lists of those are released
+ * when the thread exits, through the destroy notify of this key */
+static GPrivate thread_pool_exit_hook = G_PRIVATE_INIT(_deinit_thread_pool);
+
+static StatsCounterItem *stats_pool_hits;
+static StatsCounterItem *stats_pool_misses;
+static StatsCounterItem *stats_pool_held_bytes;
+
+static inline gsize
+_class_block_size(gint size_class)
+{
+  return 1 << (LOG_MSG_POOL_MIN_BLOCK_SHIFT + size_class - 1);
+}
+
+static inline gint
+_size_to_class(gsize size)
+{
+  gint size_class = 1;
+
+  while (_class_block_size(size_class) < size)
+    size_class++;
+  return size_class;
+}
+
+/* called before the first block is put on the free lists of a thread */
+static inline void
+_register_thread_exit_hook(void)
+{
+  if (G_LIKELY(pool_exit_hook_registered))
+    return;
+
+  pool_exit_hook_registered = TRUE;
+  g_private_set(&thread_pool_exit_hook, GINT_TO_POINTER(TRUE));
+}
+
+static gboolean
+_depot_get_batch(gint size_class, LogMsgPoolFreeList *free_list)
+{
+  LogMsgPoolDepot *depot = &depots[size_class - 1];
+  LogMsgPoolFreeBlock *batch = NULL;
+
+  g_mutex_lock(&depot->lock);
+  if (depot->num_batches > 0)
+    batch = depot->batches[--depot->num_batches];
+  g_mutex_unlock(&depot->lock);
+
+  if (!batch)
+    return FALSE;
+
+  stats_counter_sub(stats_pool_held_bytes, LOG_MSG_POOL_BATCH_SIZE * _class_block_size(size_class));
+  _register_thread_exit_hook();
+  free_list->head = batch;
+  free_list->count = LOG_MSG_POOL_BATCH_SIZE;
+  return TRUE;
+}
+
+static void
+_depot_put_batch(gint size_class, LogMsgPoolFreeList *free_list)
+{
+  LogMsgPoolDepot *depot = &depots[size_class - 1];
+  LogMsgPoolFreeBlock *batch = free_list->head;
+  LogMsgPoolFreeBlock *last = batch;
+
+  for (gint i = 1; i < LOG_MSG_POOL_BATCH_SIZE; i++)
+    last = last->next;
+  free_list->head = last->next;
+  free_list->count -= LOG_MSG_POOL_BATCH_SIZE;
+  last->next = NULL;
+
+  g_mutex_lock(&depot->lock);
+  if (depot->num_batches < LOG_MSG_POOL_DEPOT_MAX)
+    {
+      depot->batches[depot->num_batches++] = batch;
+      batch = NULL;
+    }
+  g_mutex_unlock(&depot->lock);
+
+  if (batch)
+    {
+      while (batch)
+        {
+          LogMsgPoolFreeBlock *next = batch->next;
+          g_free(batch);
+          batch = next;
+        }
+      return;
+    }
+  stats_counter_add(stats_pool_held_bytes, LOG_MSG_POOL_BATCH_SIZE * _class_block_size(size_class));
+}
+
+gsize
+log_msg_pool_get_local_held_bytes(void)
+{
+  gsize held = 0;
+
+  for (gint i = 0; i < LOG_MSG_POOL_NUM_CLASSES; i++)
+    held += free_lists[i].count * _class_block_size(i + 1);
+  return held;
+}
+
+void
+log_msg_pool_update_stats(void)
+{
+  gssize held = log_msg_pool_get_local_held_bytes();
+
+  stats_counter_add(stats_pool_hits, pool_hits);
+  stats_counter_add(stats_pool_misses, pool_misses);
+  stats_counter_add(stats_pool_held_bytes, held - pool_held_bytes_reported);
+  pool_hits = 0;
+  pool_misses = 0;
+  pool_held_bytes_reported = held;
+  pool_ops_since_update = 0;
+}
+
+static inline void
+_lazy_update_stats(void)
+{
+  if (++pool_ops_since_update >= LOG_MSG_POOL_STATS_PERIOD)
+    log_msg_pool_update_stats();
+}
+
+/* allocates a block of at least *size bytes, *size is updated to the
+ * actual size of the block */
+gpointer
+log_msg_pool_alloc(gsize *size, guint8 *size_class)
+{
+  if (*size > LOG_MSG_POOL_MAX_BLOCK_SIZE)
+    {
+      *size_class = LOG_MSG_POOL_UNPOOLED;
+      return g_malloc(*size);
+    }
+
+  *size_class = _size_to_class(*size);
+  *size = _class_block_size(*size_class);
+
+  LogMsgPoolFreeList *free_list = &free_lists[*size_class - 1];
+  if (!free_list->head && !_depot_get_batch(*size_class, free_list))
+    {
+      pool_misses++;
+      _lazy_update_stats();
+      return g_malloc(*size);
+    }
+
+  LogMsgPoolFreeBlock *block = free_list->head;
+  free_list->head = block->next;
+  free_list->count--;
+
+  pool_hits++;
+  _lazy_update_stats();
+  return block;
+}
+
+void
+log_msg_pool_free(gpointer block, guint8 size_class)
+{
+  if (size_class == LOG_MSG_POOL_UNPOOLED)
+    {
+      g_free(block);
+      return;
+    }
+
+  LogMsgPoolFreeList *free_list = &free_lists[size_class - 1];
+  LogMsgPoolFreeBlock *free_block = (LogMsgPoolFreeBlock *) block;
+
+  _register_thread_exit_hook();
+  free_block->next = free_list->head;
+  free_list->head = free_block;
+  free_list->count++;
+
+  if (free_list->count > LOG_MSG_POOL_LOCAL_MAX)
+    _depot_put_batch(size_class, free_list);
+}
+
+static void
+_release_free_list(LogMsgPoolFreeList *free_list)
+{
+  while (free_list->head)
+    {
+      LogMsgPoolFreeBlock *next = free_list->head->next;
+      g_free(free_list->head);
+      free_list->head = next;
+    }
+  free_list->count = 0;
+}
+
+/* blocks of an exiting thread are returned to the depot, so that the
+ * other threads can reuse them, runs both from app_thread_stop() and when
+ * the thread exits */
+static void
+_deinit_thread_pool(gpointer user_data)
+{
+  for (gint i = 0; i < LOG_MSG_POOL_NUM_CLASSES; i++)
+    {
+      while (free_lists[i].count >= LOG_MSG_POOL_BATCH_SIZE)
+        _depot_put_batch(i + 1, &free_lists[i]);
+      _release_free_list(&free_lists[i]);
+    }
+  log_msg_pool_update_stats();
+}
+
+static void
+_register_stats(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  StatsClusterLabel hit_labels[] = { stats_cluster_label("result", "hit") };
+  stats_cluster_single_key_set(&sc_key, METRIC(events_pool_allocations_total), hit_labels, G_N_ELEMENTS(hit_labels));
+  stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &stats_pool_hits);
+
+  StatsClusterLabel miss_labels[] = { stats_cluster_label("result", "miss") };
+  stats_cluster_single_key_set(&sc_key, METRIC(events_pool_allocations_total), miss_labels, G_N_ELEMENTS(miss_labels));
+  stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &stats_pool_misses);
+
+  stats_cluster_single_key_set(&sc_key, METRIC(events_pool_held_bytes), NULL, 0);
+  stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &stats_pool_held_bytes);
+  stats_unlock();
+}
+
+static void
+_unregister_stats(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  StatsClusterLabel hit_labels[] = { stats_cluster_label("result", "hit") };
+  stats_cluster_single_key_set(&sc_key, METRIC(events_pool_allocations_total), hit_labels, G_N_ELEMENTS(hit_labels));
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &stats_pool_hits);
+
+  StatsClusterLabel miss_labels[] = { stats_cluster_label("result", "miss") };
+  stats_cluster_single_key_set(&sc_key, METRIC(events_pool_allocations_total), miss_labels, G_N_ELEMENTS(miss_labels));
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &stats_pool_misses);
+
+  stats_cluster_single_key_set(&sc_key, METRIC(events_pool_held_bytes), NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &stats_pool_held_bytes);
+  stats_unlock();
+}
+
+void
+log_msg_pool_global_init(void)
+{
+  register_application_thread_deinit_hook(_deinit_thread_pool, NULL);
+  register_application_hook(AH_RUNNING, (ApplicationHookFunc) _register_stats, NULL, AHM_RUN_ONCE);
+}
+
+void
+log_msg_pool_global_deinit(void)
+{
+  _deinit_thread_pool(NULL);
+  _unregister_stats();
+
+  for (gint i = 0; i < LOG_MSG_POOL_NUM_CLASSES; i++)
+    {
+      LogMsgPoolDepot *depot = &depots[i];
+
+      for (gint b = 0; b < depot->num_batches; b++)
+        {
+          LogMsgPoolFreeList batch = { .head = depot->batches[b] };
+          _release_free_list(&batch);
+        }
+      depot->num_batches = 0;
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LOGMSG_POOL_H_INCLUDED
+#define LOGMSG_POOL_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * Size classed allocator for LogMessage blocks (the LogMessage structure,
+ * its queue nodes and the embedded payload).
+ *
+ * Each thread keeps a free list per size class, so allocating and freeing
+ * a message does not touch the general purpose allocator in the steady
+ * state.  Messages are often allocated by a source thread and freed by a
+ * destination thread, so free lists that grow too long are handed over to
+ * a global depot in batches, where the allocating threads can pick them up
+ * with a single lock operation per batch.
+ *
+ * Blocks larger than the largest size class are allocated with g_malloc()
+ * and their size class is LOG_MSG_POOL_UNPOOLED.
+ */
+#define LOG_MSG_POOL_UNPOOLED 0
+
+gpointer log_msg_pool_alloc(gsize *size, guint8 *size_class);
+void log_msg_pool_free(gpointer block, guint8 size_class);
+
+void log_msg_pool_update_stats(void);
+gsize log_msg_pool_get_local_held_bytes(void);
+
+void log_msg_pool_global_init(void);
+void log_msg_pool_global_deinit(void);
+
+#endif
@@ -29,6 +29,7 @@
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
 #include "logmsg/nvtable.h"
+#include "logmsg/logmsg-pool.h"
 #include "stats/stats-registry.h"
 #include "stats/stats-cluster-single.h"
 #include "template/templates.h"
@@ -1278,6 +1279,7 @@ log_msg_alloc(gsize payload_size)
   LogMessage *msg;
   gsize payload_space = payload_size ? nv_table_get_alloc_size(LM_V_MAX, 16, payload_size) : 0;
   gsize alloc_size, payload_ofs = 0;
+  guint8 alloc_class;
 
   /* NOTE: logmsg_node_max is updated from parallel threads without locking. */
   gint nodes = (volatile gint) logmsg_queue_node_max;
@@ -1290,12 +1292,14 @@ log_msg_alloc(gsize payload_size)
       payload_ofs = alloc_size;
       alloc_size += payload_space;
     }
-  msg = g_malloc(alloc_size);
+  msg = log_msg_pool_alloc(&alloc_size, &alloc_class);
 
   memset(msg, 0, sizeof(LogMessage));
+  msg->alloc_class = alloc_class;
 
+  /* the rest of the size class is given to the payload */
   if (payload_size)
-    msg->payload = nv_table_init_borrowed(((gchar *) msg) + payload_ofs, payload_space, LM_V_MAX);
+    msg->payload = nv_table_init_borrowed(((gchar *) msg) + payload_ofs, alloc_size - payload_ofs, LM_V_MAX);
 
   msg->num_nodes = nodes;
   log_msg_update_allocation(msg, alloc_size);
@@ -1346,9 +1350,11 @@ log_msg_alloc_clone(LogMessage *original)
   gint nodes = (volatile gint) logmsg_queue_node_max;
 
   gsize alloc_size = sizeof(LogMessage) + sizeof(LogMessageQueueNode) * nodes;
-  msg = g_malloc(alloc_size);
+  guint8 alloc_class;
+  msg = log_msg_pool_alloc(&alloc_size, &alloc_class);
 
   memcpy(msg, original, sizeof(*msg));
+  msg->alloc_class = alloc_class;
   msg->allocated_bytes = 0;
   msg->num_nodes = nodes;
   log_msg_update_allocation(msg, alloc_size);
@@ -1503,7 +1509,7 @@ _log_msg_free(LogMessage *self)
 
   stats_counter_sub(count_allocated_bytes, self->allocated_bytes);
 
-  g_free(self);
+  log_msg_pool_free(self, self->alloc_class);
 }
 
 /**
@@ -1730,6 +1736,7 @@ log_msg_global_init(void)
   log_msg_registry_init();
   log_tags_global_init();
   log_msg_tags_init();
+  log_msg_pool_global_init();
 
   /* NOTE: we always initialize counters as they are on stats-level(0),
    * however we need to defer that as the stats subsystem may not be
@@ -1747,6 +1754,7 @@ log_msg_get_handle_name(NVHandle handle, gssize *length)
 void
 log_msg_global_deinit(void)
 {
+  log_msg_pool_global_deinit();
   log_tags_global_deinit();
   log_msg_registry_deinit();
 }
@@ -296,6 +296,8 @@ struct _LogMessage
 
   /* is this message currently read only, used to track when we need to copy-on-write */
   guint8 write_protected;
+  /* size class of the block this message was allocated from, see logmsg-pool.h */
+  guint8 alloc_class;
   /* identifier of the source host */
   guint32 host_id;
   /* unique message identifier (upon receipt) */
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+
+#include "logmsg/logmsg.h"
+#include "logmsg/logmsg-pool.h"
+#include "apphook.h"
+
+Test(logmsg_pool, test_blocks_are_rounded_up_to_their_size_class)
+{
+  gsize size = 600;
+  guint8 size_class;
+
+  gpointer block = log_msg_pool_alloc(&size, &size_class);
+  cr_assert_eq(size, 1024);
+  cr_assert_neq(size_class, LOG_MSG_POOL_UNPOOLED);
+  log_msg_pool_free(block, size_class);
+
+  size = 100000;
+  block = log_msg_pool_alloc(&size, &size_class);
+  cr_assert_eq(size, 100000);
+  cr_assert_eq(size_class, LOG_MSG_POOL_UNPOOLED);
+  log_msg_pool_free(block, size_class);
+}
+
+Test(logmsg_pool, test_freed_blocks_are_reused_by_the_same_thread)
+{
+  gsize size = 1000;
+  guint8 size_class;
+
+  gpointer block = log_msg_pool_alloc(&size, &size_class);
+  log_msg_pool_free(block, size_class);
+  cr_assert_eq(log_msg_pool_get_local_held_bytes(), size);
+
+  gpointer reused = log_msg_pool_alloc(&size, &size_class);
+  cr_assert_eq(reused, block);
+  cr_assert_eq(log_msg_pool_get_local_held_bytes(), 0);
+  log_msg_pool_free(reused, size_class);
+}
+
+#define NUM_HANDOFF_MSGS 1000
+
+static gpointer
+_free_messages_in_another_thread(gpointer user_data)
+{
+  LogMessage **msgs = (LogMessage **) user_data;
+
+  for (gint i = 0; i < NUM_HANDOFF_MSGS; i++)
+    log_msg_unref(msgs[i]);
+
+  return GSIZE_TO_POINTER(log_msg_pool_get_local_held_bytes());
+}
+
+Test(logmsg_pool, test_messages_freed_in_another_thread_are_returned_in_batches)
+{
+  LogMessage *msgs[NUM_HANDOFF_MSGS];
+
+  for (gint i = 0; i < NUM_HANDOFF_MSGS; i++)
+    {
+      msgs[i] = log_msg_new_empty();
+      log_msg_set_value(msgs[i], LM_V_MESSAGE, "foobar", -1);
+    }
+
+  GThread *thread = g_thread_new("pool-test", _free_messages_in_another_thread, msgs);
+  gsize held_by_thread = GPOINTER_TO_SIZE(g_thread_join(thread));
+
+  /* the freeing thread only keeps a limited number of blocks, everything
+   * above that was handed over to the depot, so the allocating thread can
+   * reuse those */
+  cr_assert_leq(held_by_thread, 2 * 64 * 4096);
+  LogMessage *msg = log_msg_new_empty();
+  cr_assert_gt(log_msg_pool_get_local_held_bytes(), 0, "a batch should have been taken from the depot");
+  log_msg_unref(msg);
+}
+
+#define NUM_EXITING_THREAD_BLOCKS 100
+
+typedef struct
+{
+  gpointer blocks[NUM_EXITING_THREAD_BLOCKS];
+  guint8 size_class;
+} ExitingThreadBlocks;
+
+static gpointer
+_free_blocks_and_exit(gpointer user_data)
+{
+  ExitingThreadBlocks *blocks = (ExitingThreadBlocks *) user_data;
+
+  for (gint i = 0; i < NUM_EXITING_THREAD_BLOCKS; i++)
+    log_msg_pool_free(blocks->blocks[i], blocks->size_class);
+
+  return NULL;
+}
+
+Test(logmsg_pool, test_free_lists_of_exiting_threads_are_returned_to_the_depot)
+{
+  ExitingThreadBlocks blocks;
+  gsize size;
+
+  for (gint i = 0; i < NUM_EXITING_THREAD_BLOCKS; i++)
+    {
+      size = 1000;
+      blocks.blocks[i] = log_msg_pool_alloc(&size, &blocks.size_class);
+    }
+  cr_assert_eq(log_msg_pool_get_local_held_bytes(), 0);
+
+  /* the thread does not run app_thread_stop(), the freed blocks stay on
+   * its own free list until it exits */
+  GThread *thread = g_thread_new("pool-test", _free_blocks_and_exit, &blocks);
+  g_thread_join(thread);
+
+  guint8 size_class;
+  size = 1000;
+  gpointer block = log_msg_pool_alloc(&size, &size_class);
+  cr_assert_gt(log_msg_pool_get_local_held_bytes(), 0, "the blocks of the exited thread should be in the depot");
+  log_msg_pool_free(block, size_class);
+}
+
+Test(logmsg_pool, test_payload_uses_the_slack_of_the_size_class)
+{
+  LogMessage *msg = log_msg_new_empty();
+  gchar value[401];
+
+  memset(value, 'x', sizeof(value) - 1);
+  value[sizeof(value) - 1] = 0;
+
+  /* fits into the rounded up block, no payload realloc is needed */
+  log_msg_set_value(msg, LM_V_MESSAGE, value, -1);
+  cr_assert(msg->payload->borrowed);
+  cr_assert_str_eq(log_msg_get_value(msg, LM_V_MESSAGE, NULL), value);
+  log_msg_unref(msg);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+}
+
+static void
+teardown(void)
+{
+  app_shutdown();
+}
+
+TestSuite(logmsg_pool, .init = setup, .fini = teardown);
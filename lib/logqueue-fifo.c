@@ -29,6 +29,7 @@
 #include "stats/stats-counter.h"
 #include "stats/stats-cluster-single.h"
 #include "mainloop-worker.h"
+#include "atomic-gssize.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -70,8 +71,44 @@ QueueType log_queue_fifo_type = "FIFO";
  *   - the head of the queue is only manipulated from the output thread
  *   - the tail of the queue is only manipulated from the input threads
  *
+ * With many input threads feeding the same destination, the wait queue
+ * mutex becomes contended.  The lock-free variant (see
+ * log_queue_fifo_lock_free_new()) replaces the wait queue with a
+ * multi-producer single-consumer list of batches: an input thread hands
+ * over its whole input queue with a single atomic exchange and the output
+ * thread takes the batches without locking.  The lock is only grabbed by
+ * the input thread that makes the queue non-empty, in order to wake up a
+ * consumer waiting in log_queue_check_items().
+ *
  */
 
+/* a batch of items handed over by an input thread, see HandoffQueue */
+typedef struct _HandoffBatch HandoffBatch;
+struct _HandoffBatch
+{
+  HandoffBatch *next;
+  struct iv_list_head items;
+  gint len;
+  gint non_flow_controlled_len;
+};
+
+/*
+ * Intrusive multi-producer single-consumer queue (Vyukov's algorithm).
+ * Producers append with an atomic exchange of the tail, the consumer walks
+ * the list from the head.  The stub entry keeps the list non-empty, so
+ * producers never touch the head.
+ */
+typedef struct _HandoffQueue
+{
+  HandoffBatch *head;
+  HandoffBatch *tail;
+  HandoffBatch stub;
+
+  /* maintained by the producers before pushing and by the consumer after popping */
+  atomic_gssize len;
+  atomic_gssize non_flow_controlled_len;
+} HandoffQueue;
+
 typedef struct _InputQueue
 {
   struct iv_list_head items;
@@ -98,6 +135,9 @@ typedef struct _LogQueueFifo
   OverflowQueue wait_queue;
   OverflowQueue backlog_queue; /* entries that were sent but not acked yet */
 
+  gboolean lock_free;
+  HandoffQueue handoff_queue; /* replaces wait_queue if lock_free is set */
+
   gint log_fifo_size;
 
   struct
@@ -124,13 +164,77 @@ log_queue_fifo_get_length(LogQueue *s)
 {
   LogQueueFifo *self = (LogQueueFifo *) s;
 
-  return self->wait_queue.len + self->output_queue.len;
+  return self->wait_queue.len + atomic_gssize_racy_get(&self->handoff_queue.len) + self->output_queue.len;
 }
 
 static gint64
 log_queue_fifo_get_non_flow_controlled_length(LogQueueFifo *self)
 {
-  return self->wait_queue.non_flow_controlled_len + self->output_queue.non_flow_controlled_len;
+  return self->wait_queue.non_flow_controlled_len
+         + atomic_gssize_racy_get(&self->handoff_queue.non_flow_controlled_len)
+         + self->output_queue.non_flow_controlled_len;
+}
+
+static void
+_handoff_queue_init(HandoffQueue *self)
+{
+  self->stub.next = NULL;
+  self->head = &self->stub;
+  self->tail = &self->stub;
+}
+
+/* can be called from any thread */
+static void
+_handoff_queue_push(HandoffQueue *self, HandoffBatch *batch)
+{
+  g_atomic_pointer_set(&batch->next, NULL);
+  HandoffBatch *prev = g_atomic_pointer_exchange((gpointer *) &self->tail, batch);
+  g_atomic_pointer_set(&prev->next, batch);
+}
+
+/*
+ * Can only run from the output thread.
+ *
+ * Returns NULL if the queue is empty, or if a producer has not finished
+ * linking its batch yet, in which case the batch is returned by a later
+ * call.
+ */
+static HandoffBatch *
+_handoff_queue_pop(HandoffQueue *self)
+{
+  HandoffBatch *head = self->head;
+  HandoffBatch *next = g_atomic_pointer_get(&head->next);
+
+  if (head == &self->stub)
+    {
+      if (!next)
+        return NULL;
+
+      self->head = next;
+      head = next;
+      next = g_atomic_pointer_get(&next->next);
+    }
+
+  if (next)
+    {
+      self->head = next;
+      return head;
+    }
+
+  if (head != g_atomic_pointer_get(&self->tail))
+    return NULL;
+
+  /* head is the last batch, put the stub behind it, so it can be removed */
+  _handoff_queue_push(self, &self->stub);
+
+  next = g_atomic_pointer_get(&head->next);
+  if (next)
+    {
+      self->head = next;
+      return head;
+    }
+
+  return NULL;
 }
 
 gboolean
@@ -257,10 +361,61 @@ log_queue_fifo_move_input_unlocked(LogQueueFifo *self, gint thread_index)
   self->input_queues[thread_index].total_size = 0;
 }
 
+static void
+log_queue_fifo_hand_over_batch(LogQueueFifo *self, HandoffBatch *batch)
+{
+  atomic_gssize_add(&self->handoff_queue.non_flow_controlled_len, batch->non_flow_controlled_len);
+  gssize previous_len = atomic_gssize_add(&self->handoff_queue.len, batch->len);
+  _handoff_queue_push(&self->handoff_queue, batch);
+
+  /* the output thread only waits for a push notification if the queue
+   * was empty when it checked it, see log_queue_check_items() */
+  if (previous_len == 0)
+    {
+      g_mutex_lock(&self->super.lock);
+      log_queue_push_notify(&self->super);
+      g_mutex_unlock(&self->super.lock);
+    }
+}
+
+/* move items from the per-thread input queue to the handoff queue, without locking */
+static void
+log_queue_fifo_hand_over_input(LogQueueFifo *self, gint thread_index)
+{
+  InputQueue *input_queue = &self->input_queues[thread_index];
+  gint num_of_messages_to_drop;
+
+  if (log_queue_fifo_calculate_num_of_messages_to_drop(self, input_queue, &num_of_messages_to_drop))
+    log_queue_fifo_drop_messages_from_input_queue(self, input_queue, num_of_messages_to_drop);
+
+  if (input_queue->len == 0)
+    return;
+
+  log_queue_queued_messages_add(&self->super, input_queue->len);
+  log_queue_memory_usage_add(&self->super, input_queue->total_size);
+
+  HandoffBatch *batch = g_new(HandoffBatch, 1);
+  INIT_IV_LIST_HEAD(&batch->items);
+  iv_list_splice_tail_init(&input_queue->items, &batch->items);
+  batch->len = input_queue->len;
+  batch->non_flow_controlled_len = input_queue->non_flow_controlled_len;
+  input_queue->len = 0;
+  input_queue->non_flow_controlled_len = 0;
+  input_queue->total_size = 0;
+
+  log_queue_fifo_hand_over_batch(self, batch);
+}
+
 /* explicitly move input to the wait queue, to be called from the input thread */
 static void
 log_queue_fifo_move_input(LogQueueFifo *self, gint thread_index)
 {
+  if (self->lock_free)
+    {
+      log_queue_fifo_hand_over_input(self, thread_index);
+      return;
+    }
+
   g_mutex_lock(&self->super.lock);
   log_queue_fifo_move_input_unlocked(self, thread_index);
   log_queue_push_notify(&self->super);
@@ -286,7 +441,7 @@ log_queue_fifo_input_batch_callback(gpointer user_data)
   return NULL;
 }
 
-/* lock must be held */
+/* lock must be held, unless the queue is lock-free */
 static inline gboolean
 _message_has_to_be_dropped(LogQueueFifo *self, const LogPathOptions *path_options)
 {
@@ -294,6 +449,39 @@ _message_has_to_be_dropped(LogQueueFifo *self, const LogPathOptions *path_option
          && log_queue_fifo_get_non_flow_controlled_length(self) >= self->log_fifo_size;
 }
 
+/* slow path of the lock-free variant, the message is handed over on its own */
+static void
+log_queue_fifo_push_tail_lock_free(LogQueueFifo *self, LogMessage *msg, const LogPathOptions *path_options)
+{
+  /* racy, the same way as log_queue_fifo_calculate_num_of_messages_to_drop() */
+  if (_message_has_to_be_dropped(self, path_options))
+    {
+      log_queue_dropped_messages_inc(&self->super);
+      log_msg_drop(msg, path_options, AT_PROCESSED);
+
+      msg_debug("Destination queue full, dropping message",
+                evt_tag_int("queue_len", log_queue_fifo_get_length(&self->super)),
+                evt_tag_int("log_fifo_size", self->log_fifo_size),
+                evt_tag_str("persist_name", self->super.persist_name));
+      return;
+    }
+
+  log_msg_write_protect(msg);
+  LogMessageQueueNode *node = log_msg_alloc_queue_node(msg, path_options);
+
+  HandoffBatch *batch = g_new(HandoffBatch, 1);
+  INIT_IV_LIST_HEAD(&batch->items);
+  iv_list_add_tail(&node->list, &batch->items);
+  batch->len = 1;
+  batch->non_flow_controlled_len = path_options->flow_control_requested ? 0 : 1;
+
+  log_queue_queued_messages_inc(&self->super);
+  log_queue_memory_usage_add(&self->super, log_msg_get_size(msg));
+  log_msg_unref(msg);
+
+  log_queue_fifo_hand_over_batch(self, batch);
+}
+
 /**
  * Assumed to be called from one of the input threads. If the thread_index
  * cannot be determined, the item is put directly in the wait queue.
@@ -381,6 +569,12 @@ log_queue_fifo_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *pat
       return;
     }
 
+  if (self->lock_free)
+    {
+      log_queue_fifo_push_tail_lock_free(self, msg, path_options);
+      return;
+    }
+
   /* slow path, put the pending item and the whole input queue to the wait_queue */
 
   g_mutex_lock(&self->super.lock);
@@ -417,12 +611,38 @@ log_queue_fifo_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *pat
   log_msg_unref(msg);
 }
 
+/*
+ * Can only run from the output thread.
+ */
+static void
+_move_items_from_handoff_queue_to_output_queue(LogQueueFifo *self)
+{
+  HandoffBatch *batch;
+
+  while ((batch = _handoff_queue_pop(&self->handoff_queue)))
+    {
+      iv_list_splice_tail_init(&batch->items, &self->output_queue.items);
+      self->output_queue.len += batch->len;
+      self->output_queue.non_flow_controlled_len += batch->non_flow_controlled_len;
+
+      atomic_gssize_sub(&self->handoff_queue.len, batch->len);
+      atomic_gssize_sub(&self->handoff_queue.non_flow_controlled_len, batch->non_flow_controlled_len);
+      g_free(batch);
+    }
+}
+
 /*
  * Can only run from the output thread.
  */
 static inline void
 _move_items_from_wait_queue_to_output_queue(LogQueueFifo *self)
 {
+  if (self->lock_free)
+    {
+      _move_items_from_handoff_queue_to_output_queue(self);
+      return;
+    }
+
   /* slow path, output queue is empty, get some elements from the wait queue */
   g_mutex_lock(&self->super.lock);
   iv_list_splice_tail_init(&self->wait_queue.items, &self->output_queue.items);
@@ -685,6 +905,7 @@ log_queue_fifo_free(LogQueue *s)
     }
 
   log_queue_fifo_free_queue(&self->wait_queue.items);
+  _move_items_from_handoff_queue_to_output_queue(self);
   log_queue_fifo_free_queue(&self->output_queue.items);
   log_queue_fifo_free_queue(&self->backlog_queue.items);
 
@@ -693,9 +914,9 @@ log_queue_fifo_free(LogQueue *s)
   log_queue_free_method(s);
 }
 
-LogQueue *
-log_queue_fifo_new(gint log_fifo_size, const gchar *persist_name, gint stats_level,
-                   StatsClusterKeyBuilder *driver_sck_builder, StatsClusterKeyBuilder *queue_sck_builder)
+static LogQueue *
+_new(gint log_fifo_size, gboolean lock_free, const gchar *persist_name, gint stats_level,
+     StatsClusterKeyBuilder *driver_sck_builder, StatsClusterKeyBuilder *queue_sck_builder)
 {
   LogQueueFifo *self;
 
@@ -734,7 +955,9 @@ log_queue_fifo_new(gint log_fifo_size, const gchar *persist_name, gint stats_lev
   INIT_IV_LIST_HEAD(&self->wait_queue.items);
   INIT_IV_LIST_HEAD(&self->output_queue.items);
   INIT_IV_LIST_HEAD(&self->backlog_queue.items);
+  _handoff_queue_init(&self->handoff_queue);
 
+  self->lock_free = lock_free;
   self->log_fifo_size = log_fifo_size;
 
   _register_counters(self, stats_level, queue_sck_builder);
@@ -747,6 +970,20 @@ log_queue_fifo_new(gint log_fifo_size, const gchar *persist_name, gint stats_lev
   return &self->super;
 }
 
+LogQueue *
+log_queue_fifo_new(gint log_fifo_size, const gchar *persist_name, gint stats_level,
+                   StatsClusterKeyBuilder *driver_sck_builder, StatsClusterKeyBuilder *queue_sck_builder)
+{
+  return _new(log_fifo_size, FALSE, persist_name, stats_level, driver_sck_builder, queue_sck_builder);
+}
+
+LogQueue *
+log_queue_fifo_lock_free_new(gint log_fifo_size, const gchar *persist_name, gint stats_level,
+                             StatsClusterKeyBuilder *driver_sck_builder, StatsClusterKeyBuilder *queue_sck_builder)
+{
+  return _new(log_fifo_size, TRUE, persist_name, stats_level, driver_sck_builder, queue_sck_builder);
+}
+
 QueueType
 log_queue_fifo_get_type(void)
 {
@@ -29,6 +29,9 @@
 LogQueue *log_queue_fifo_new(gint log_fifo_size, const gchar *persist_name, gint stats_level,
                              StatsClusterKeyBuilder *driver_sck_builder,
                              StatsClusterKeyBuilder *queue_sck_builder);
+LogQueue *log_queue_fifo_lock_free_new(gint log_fifo_size, const gchar *persist_name, gint stats_level,
+                                       StatsClusterKeyBuilder *driver_sck_builder,
+                                       StatsClusterKeyBuilder *queue_sck_builder);
 
 QueueType log_queue_fifo_get_type(void);
 
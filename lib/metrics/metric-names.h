@@ -42,6 +42,8 @@
   M(disk_queue_processed_events_total) \
   M(event_processing_latency_seconds) \
   M(events_allocated_bytes) \
+  M(events_pool_allocations_total) \
+  M(events_pool_held_bytes) \
   M(filtered_events_total) \
   M(fx_xxx_evals_total) \
   M(input_event_bytes_total) \
@@ -87,6 +89,7 @@
   M(scratch_buffers_count) \
   M(socket_connections) \
   M(socket_max_connections) \
+  M(socket_receive_batch_size) \
   M(socket_receive_buffer_max_bytes) \
   M(socket_receive_buffer_used_bytes) \
   M(socket_receive_dropped_packets_total) \
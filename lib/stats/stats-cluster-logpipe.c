@@ -64,6 +64,7 @@ _counter_group_logpipe_init(StatsCounterGroupInit *self, StatsCounterGroup *coun
 {
   counter_group->counters = g_new0(StatsCounterItem, SC_TYPE_MAX);
   counter_group->capacity = SC_TYPE_MAX;
+  counter_group->striped_mask = (1 << SC_TYPE_PROCESSED) | (1 << SC_TYPE_WRITTEN) | (1 << SC_TYPE_DROPPED);
   counter_group->counter_names = self->counter.names;
   counter_group->get_type_label = _counter_group_logpipe_get_type_label;
   counter_group->free_fn = _counter_group_logpipe_free;
@@ -71,6 +71,8 @@ struct _StatsCounterGroup
   StatsCounterItem *counters;
   gchar **counter_names;
   guint16 capacity;
+  /* counter types updated from many threads, these are striped when registered by a component */
+  guint32 striped_mask;
   gboolean (*get_type_label)(StatsCounterGroup *self, StatsCluster *cluster, gint type, StatsClusterLabel *label);
   void (*get_type_formatting)(StatsCounterGroup *self, StatsCluster *cluster, gint type,
                               StatsClusterUnit *stored_unit);
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "stats/stats-counter.h"
+#include "tls-support.h"
+
+#include <stdlib.h>
+
+G_STATIC_ASSERT(sizeof(StatsCounterStripe) == STATS_COUNTER_STRIPE_SIZE);
+
+TLS_BLOCK_START
+{
+  /* shifted by one, 0 means that the thread has no slot assigned yet */
+  gint stripe_index;
+}
+TLS_BLOCK_END;
+
+#define stripe_index __tls_deref(stripe_index)
+
+static gint next_stripe_index;
+
+/* threads are assigned slots in a round-robin fashion as they first
+ * update a striped counter, so threads only share a slot if there are more
+ * than STATS_COUNTER_STRIPES of them */
+gint
+stats_counter_get_stripe_index(void)
+{
+  if (G_UNLIKELY(!stripe_index))
+    stripe_index = (g_atomic_int_add(&next_stripe_index, 1) % STATS_COUNTER_STRIPES) + 1;
+
+  return stripe_index - 1;
+}
+
+/* NOTE: should be called with the stats lock held, updates racing with
+ * this function go either to the value or to the slots, both of which are
+ * summed up by stats_counter_get() */
+void
+stats_counter_enable_striping(StatsCounterItem *counter)
+{
+  gpointer stripes;
+
+  if (counter->external || counter->stripes)
+    return;
+
+  if (posix_memalign(&stripes, STATS_COUNTER_STRIPE_SIZE, STATS_COUNTER_STRIPES * sizeof(StatsCounterStripe)) != 0)
+    return;
+
+  memset(stripes, 0, STATS_COUNTER_STRIPES * sizeof(StatsCounterStripe));
+  g_atomic_pointer_set(&counter->stripes, stripes);
+}
+
+void
+stats_counter_free_stripes(StatsCounterItem *counter)
+{
+  free(counter->stripes);
+  counter->stripes = NULL;
+}
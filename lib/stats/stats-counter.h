@@ -28,17 +28,36 @@
 
 #define STATS_COUNTER_MAX_VALUE G_MAXSIZE
 
-typedef struct _StatsCounterItem
+#define STATS_COUNTER_STRIPES 16
+#define STATS_COUNTER_STRIPE_SIZE 64
+
+/* a slot of a striped counter, padded to a cache line, so that threads
+ * updating different slots do not contend */
+typedef struct _StatsCounterStripe
+{
+  atomic_gssize value;
+  gchar padding[STATS_COUNTER_STRIPE_SIZE - sizeof(atomic_gssize)];
+} StatsCounterStripe;
+
+typedef struct _StatsCounterItem StatsCounterItem;
+struct _StatsCounterItem
 {
   union
   {
     atomic_gssize value;
     atomic_gssize *value_ref;
   };
+  /* hot counters are updated in per-thread slots and summed up on query */
+  StatsCounterStripe *stripes;
+  /* the counter an alias (external) counter refers to */
+  StatsCounterItem *aliased;
   gchar *name;
   gint type;
   gboolean external;
-} StatsCounterItem;
+};
+
+gint stats_counter_get_stripe_index(void);
+void stats_counter_enable_striping(StatsCounterItem *counter);
 
 
 static gboolean
@@ -47,13 +66,24 @@ stats_counter_read_only(StatsCounterItem *counter)
   return counter->external;
 }
 
+/* the slot to be updated by the current thread */
+static inline atomic_gssize *
+stats_counter_get_update_slot(StatsCounterItem *counter)
+{
+  StatsCounterStripe *stripes = g_atomic_pointer_get(&counter->stripes);
+
+  if (stripes)
+    return &stripes[stats_counter_get_stripe_index()].value;
+  return &counter->value;
+}
+
 static inline void
 stats_counter_add(StatsCounterItem *counter, gssize add)
 {
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_add(&counter->value, add);
+      atomic_gssize_add(stats_counter_get_update_slot(counter), add);
     }
 }
 
@@ -63,7 +93,7 @@ stats_counter_sub(StatsCounterItem *counter, gssize sub)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_sub(&counter->value, sub);
+      atomic_gssize_sub(stats_counter_get_update_slot(counter), sub);
     }
 }
 
@@ -73,7 +103,7 @@ stats_counter_inc(StatsCounterItem *counter)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_inc(&counter->value);
+      atomic_gssize_inc(stats_counter_get_update_slot(counter));
     }
 }
 
@@ -83,15 +113,24 @@ stats_counter_dec(StatsCounterItem *counter)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_dec(&counter->value);
+      atomic_gssize_dec(stats_counter_get_update_slot(counter));
     }
 }
 
+/* NOTE: increments racing with set() on a striped counter may be lost,
+ * just like with a reset of an ordinary counter */
 static inline void
 stats_counter_set(StatsCounterItem *counter, gsize value)
 {
   if (counter && !stats_counter_read_only(counter))
     {
+      StatsCounterStripe *stripes = g_atomic_pointer_get(&counter->stripes);
+
+      if (stripes)
+        {
+          for (gint i = 0; i < STATS_COUNTER_STRIPES; i++)
+            atomic_gssize_set(&stripes[i].value, 0);
+        }
       atomic_gssize_set(&counter->value, value);
     }
 }
@@ -103,10 +142,21 @@ stats_counter_get(StatsCounterItem *counter)
 
   if (counter)
     {
-      if (!counter->external)
-        result = atomic_gssize_get_unsigned(&counter->value);
-      else
-        result = atomic_gssize_get_unsigned(counter->value_ref);
+      if (counter->external)
+        {
+          if (counter->aliased)
+            return stats_counter_get(counter->aliased);
+          return atomic_gssize_get_unsigned(counter->value_ref);
+        }
+
+      result = atomic_gssize_get_unsigned(&counter->value);
+
+      StatsCounterStripe *stripes = g_atomic_pointer_get(&counter->stripes);
+      if (stripes)
+        {
+          for (gint i = 0; i < STATS_COUNTER_STRIPES; i++)
+            result += atomic_gssize_get_unsigned(&stripes[i].value);
+        }
     }
   return result;
 }
@@ -126,9 +176,12 @@ stats_counter_get_name(StatsCounterItem *counter)
   return NULL;
 }
 
+void stats_counter_free_stripes(StatsCounterItem *counter);
+
 static inline void
 stats_counter_clear(StatsCounterItem *counter)
 {
+  stats_counter_free_stripes(counter);
   g_free(counter->name);
   memset(counter, 0, sizeof(*counter));
 }
@@ -165,6 +165,10 @@ _register_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
       (*counter)->external = FALSE;
       (*counter)->type = type;
       _update_counter_name_if_needed(*counter, sc, type);
+
+      /* dynamic clusters are numerous (per host, per program), so they stay unstriped to save memory */
+      if (!dynamic && (sc->counter_group.striped_mask & (1 << type)))
+        stats_counter_enable_striping(*counter);
     }
   else
     {
@@ -243,7 +247,12 @@ stats_register_external_counter(gint stats_level, const StatsClusterKey *sc_key,
 StatsCluster *
 stats_register_alias_counter(gint level, const StatsClusterKey *sc_key, gint type, StatsCounterItem *aliased_counter)
 {
-  return stats_register_external_counter(level, sc_key, type, &aliased_counter->value);
+  StatsCluster *sc = stats_register_external_counter(level, sc_key, type, &aliased_counter->value);
+
+  /* the value of a striped counter is spread over its slots, the alias has to sum them up */
+  if (sc)
+    stats_cluster_get_counter(sc, type)->aliased = aliased_counter;
+  return sc;
 }
 
 StatsCluster *
@@ -375,6 +375,53 @@ Test(stats_cluster, test_get_counter)
   stats_cluster_free(sc);
 }
 
+static gpointer
+_increment_counter_thread(gpointer user_data)
+{
+  StatsCounterItem *counter = (StatsCounterItem *) user_data;
+
+  for (gint i = 0; i < 10000; i++)
+    stats_counter_inc(counter);
+  return NULL;
+}
+
+Test(stats_cluster, test_hot_counters_are_striped_and_summed_up)
+{
+  StatsClusterKey sc_key;
+  StatsCounterItem *processed, *queued;
+  GThread *threads[4];
+
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_SOURCE | SCS_FILE, "id", "striped");
+  stats_lock();
+  {
+    stats_register_counter(0, &sc_key, SC_TYPE_PROCESSED, &processed);
+    stats_register_counter(0, &sc_key, SC_TYPE_QUEUED, &queued);
+  }
+  stats_unlock();
+
+  cr_assert_not_null(processed->stripes);
+  cr_assert_null(queued->stripes);
+
+  stats_counter_add(processed, 5);
+  for (gint i = 0; i < G_N_ELEMENTS(threads); i++)
+    threads[i] = g_thread_new(NULL, _increment_counter_thread, processed);
+  for (gint i = 0; i < G_N_ELEMENTS(threads); i++)
+    g_thread_join(threads[i]);
+  stats_counter_dec(processed);
+
+  cr_assert_eq(stats_counter_get(processed), 5 + G_N_ELEMENTS(threads) * 10000 - 1);
+
+  stats_counter_set(processed, 3);
+  cr_assert_eq(stats_counter_get(processed), 3);
+
+  stats_lock();
+  {
+    stats_unregister_counter(&sc_key, SC_TYPE_PROCESSED, &processed);
+    stats_unregister_counter(&sc_key, SC_TYPE_QUEUED, &queued);
+  }
+  stats_unlock();
+}
+
 Test(stats_cluster, test_register_type)
 {
   guint first = stats_register_type("HAL");
@@ -55,28 +55,28 @@ _should_render(const gchar *value, LogMessageValueType value_type, LogMessageVal
 }
 
 static void
-log_template_append_elem_value(LogTemplate *self, LogTemplateElem *e, LogTemplateEvalOptions *options,
-                               LogMessage *msg, LogMessageValueType *type, GString *result)
+log_template_append_op_value(LogTemplate *self, const LogTemplateOp *op, LogTemplateEvalOptions *options,
+                             LogMessage *msg, LogMessageValueType *type, GString *result)
 {
   const gchar *value = NULL;
   gssize value_len = -1;
   LogMessageValueType value_type = LM_VT_NONE;
 
-  value = log_msg_get_value_with_type(msg, e->value_handle, &value_len, &value_type);
+  value = log_msg_get_value_with_type(msg, op->value_handle, &value_len, &value_type);
   if (value && _should_render(value, value_type, self->type_hint))
     {
       g_string_append_len(result, value, value_len);
     }
-  else if (e->default_value)
+  else if (op->default_value)
     {
-      g_string_append_len(result, e->default_value, -1);
+      g_string_append_len(result, op->default_value, op->default_value_len);
       value_type = LM_VT_STRING;
     }
   else if (value_type == LM_VT_BYTES || value_type == LM_VT_PROTOBUF)
     {
       msg_warning_once("template: not rendering binary name-value pair, use an explicit type hint",
                        evt_tag_str("template", self->template_str),
-                       evt_tag_str("name", log_msg_get_handle_name(e->value_handle, NULL)),
+                       evt_tag_str("name", log_msg_get_handle_name(op->value_handle, NULL)),
                        evt_tag_str("type", log_msg_value_type_to_str(value_type)));
       value_type = LM_VT_NULL;
     }
@@ -84,30 +84,30 @@ log_template_append_elem_value(LogTemplate *self, LogTemplateElem *e, LogTemplat
 }
 
 static void
-log_template_append_elem_macro(LogTemplate *self, LogTemplateElem *e, LogTemplateEvalOptions *options,
-                               LogMessage *msg, LogMessageValueType *type, GString *result)
+log_template_append_op_macro(LogTemplate *self, const LogTemplateOp *op, LogTemplateEvalOptions *options,
+                             LogMessage *msg, LogMessageValueType *type, GString *result)
 {
   gint len = result->len;
   LogMessageValueType value_type = LM_VT_NONE;
 
-  if (e->macro)
+  if (op->macro)
     {
-      log_macro_expand(e->macro, options, msg, result, &value_type);
-      if (len == result->len && e->default_value)
-        g_string_append(result, e->default_value);
+      log_macro_expand(op->macro, options, msg, result, &value_type);
+      if (len == result->len && op->default_value)
+        g_string_append_len(result, op->default_value, op->default_value_len);
       *type = _propagate_type(*type, value_type);
     }
 }
 
 static void
-log_template_append_elem_func(LogTemplate *self, LogTemplateElem *e, LogTemplateEvalOptions *options,
-                              LogMessage **messages, gint num_messages, gint msg_ndx,
-                              LogMessageValueType *type, GString *result)
+log_template_append_op_func(LogTemplate *self, const LogTemplateOp *op, LogTemplateEvalOptions *options,
+                            LogMessage **messages, gint num_messages, gint msg_ndx,
+                            LogMessageValueType *type, GString *result)
 {
   LogTemplateInvokeArgs args =
   {
-    e->msg_ref ? &messages[msg_ndx] : messages,
-    e->msg_ref ? 1 : num_messages,
+    op->msg_ref ? &messages[msg_ndx] : messages,
+    op->msg_ref ? 1 : num_messages,
     options,
   };
   LogMessageValueType value_type = LM_VT_NONE;
@@ -118,9 +118,9 @@ log_template_append_elem_func(LogTemplate *self, LogTemplateElem *e, LogTemplate
    * we pass the whole set so the arguments can individually
    * specify which message they want to resolve from
    */
-  if (e->func.ops->eval)
-    e->func.ops->eval(e->func.ops, e->func.state, &args);
-  e->func.ops->call(e->func.ops, e->func.state, &args, result, &value_type);
+  if (op->func.ops->eval)
+    op->func.ops->eval(op->func.ops, op->func.state, &args);
+  op->func.ops->call(op->func.ops, op->func.state, &args, result, &value_type);
 
   *type = _propagate_type(*type, value_type);
 }
@@ -130,9 +130,7 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
                                                        LogTemplateEvalOptions *options,
                                                        GString *result, LogMessageValueType *type)
 {
-  LogTemplateElem *e;
   LogMessageValueType t = LM_VT_NONE;
-  gboolean first_elem = TRUE;
   GString *target_buffer = result;
 
   if (!options->opts)
@@ -149,11 +147,12 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
   if (escape)
     target_buffer = scratch_buffers_alloc();
 
-  for (GList *p = self->compiled_template; p; p = g_list_next(p), first_elem = FALSE)
+  for (gsize i = 0; i < self->compiled_ops_len; i++)
     {
+      const LogTemplateOp *op = &self->compiled_ops[i];
       gint msg_ndx;
 
-      if (!first_elem)
+      if (i > 0)
         {
           /* this is the 2nd elem in the compiled template, we are
            * concatenating multiple elements, convert the value to string */
@@ -161,13 +160,19 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
           t = LM_VT_STRING;
         }
 
-      e = (LogTemplateElem *) p->data;
-      if (e->text)
+      if (op->text_len)
         {
-          g_string_append_len(result, e->text, e->text_len);
+          g_string_append_len(result, op->text, op->text_len);
           /* concatenating literal text */
-          if (e->text_len)
+          t = LM_VT_STRING;
+        }
+
+      if (op->type == LTO_LITERAL)
+        {
+          /* escaping the empty expansion of a literal yields a string */
+          if (escape)
             t = LM_VT_STRING;
+          continue;
         }
 
       /* NOTE: msg_ref is 1 larger than the index specified by the user in
@@ -176,31 +181,31 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
        *
        * msg_ref == 0 means that the user didn't specify msg_ref
        * msg_ref >= 1 means that the user supplied the given msg_ref, 1 is equal to @0 */
-      if (e->msg_ref > num_messages)
+      if (op->msg_ref > num_messages)
         {
           /* msg_ref out of range, we expand to empty string without evaluating the element */
           t = LM_VT_STRING;
           continue;
         }
-      msg_ndx = num_messages - e->msg_ref;
+      msg_ndx = num_messages - op->msg_ref;
 
       /* value and macro can't understand a context, assume that no msg_ref means @0 */
-      if (e->msg_ref == 0)
+      if (op->msg_ref == 0)
         msg_ndx--;
 
       if (escape)
         g_string_truncate(target_buffer, 0);
 
-      switch (e->type)
+      switch (op->type)
         {
-        case LTE_VALUE:
-          log_template_append_elem_value(self, e, options, messages[msg_ndx], &t, target_buffer);
+        case LTO_VALUE:
+          log_template_append_op_value(self, op, options, messages[msg_ndx], &t, target_buffer);
           break;
-        case LTE_MACRO:
-          log_template_append_elem_macro(self, e, options, messages[msg_ndx], &t, target_buffer);
+        case LTO_MACRO:
+          log_template_append_op_macro(self, op, options, messages[msg_ndx], &t, target_buffer);
           break;
-        case LTE_FUNC:
-          log_template_append_elem_func(self, e, options, messages, num_messages, msg_ndx, &t, target_buffer);
+        case LTO_FUNC:
+          log_template_append_op_func(self, op, options, messages, num_messages, msg_ndx, &t, target_buffer);
           break;
         default:
           g_assert_not_reached();
@@ -218,7 +223,7 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
     }
   if (type)
     {
-      if (first_elem && t == LM_VT_NONE)
+      if (self->compiled_ops_len == 0 && t == LM_VT_NONE)
         {
           /* empty template string, use LM_VT_STRING before applying the type-cast */
           t = LM_VT_STRING;
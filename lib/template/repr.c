@@ -182,3 +182,53 @@ log_template_elem_free_list(GList *l)
     }
   g_list_free(l);
 }
+
+static void
+_lower_elem(LogTemplateOp *op, const LogTemplateElem *e)
+{
+  op->msg_ref = e->msg_ref;
+  op->text = e->text;
+  op->text_len = e->text ? e->text_len : 0;
+  op->default_value = e->default_value;
+  op->default_value_len = e->default_value ? strlen(e->default_value) : 0;
+
+  /* plain text does not depend on the message, so it needs no msg_ref resolution either */
+  if (log_template_elem_is_literal_string(e) && e->msg_ref == 0)
+    {
+      op->type = LTO_LITERAL;
+      return;
+    }
+
+  switch (e->type)
+    {
+    case LTE_MACRO:
+      op->type = LTO_MACRO;
+      op->macro = e->macro;
+      break;
+    case LTE_VALUE:
+      op->type = LTO_VALUE;
+      op->value_handle = e->value_handle;
+      break;
+    case LTE_FUNC:
+      op->type = LTO_FUNC;
+      op->func.ops = e->func.ops;
+      op->func.state = e->func.state;
+      break;
+    default:
+      g_assert_not_reached();
+    }
+}
+
+LogTemplateOp *
+log_template_ops_new_from_elems(GList *elems, gsize *ops_len)
+{
+  gsize len = g_list_length(elems);
+  LogTemplateOp *ops = len > 0 ? g_new0(LogTemplateOp, len) : NULL;
+  LogTemplateOp *op = ops;
+
+  for (GList *el = elems; el; el = el->next, op++)
+    _lower_elem(op, (LogTemplateElem *) el->data);
+
+  *ops_len = len;
+  return ops;
+}
@@ -69,5 +69,41 @@ log_template_elem_is_literal_string(const LogTemplateElem *self)
 
 void log_template_elem_free_list(GList *el);
 
+/*
+ * The compiled list of LogTemplateElem instances is lowered into a
+ * contiguous array of LogTemplateOp, which is what log_template_format()
+ * walks.  Ops borrow strings and function state from the elements, so the
+ * element list has to outlive the op array.
+ */
+enum
+{
+  LTO_LITERAL,
+  LTO_MACRO,
+  LTO_VALUE,
+  LTO_FUNC
+};
+
+struct _LogTemplateOp
+{
+  guint8 type;
+  guint16 msg_ref;
+  const gchar *text;
+  gsize text_len;
+  const gchar *default_value;
+  gsize default_value_len;
+  union
+  {
+    guint macro;
+    NVHandle value_handle;
+    struct
+    {
+      LogTemplateFunction *ops;
+      gpointer state;
+    } func;
+  };
+};
+
+LogTemplateOp *log_template_ops_new_from_elems(GList *elems, gsize *ops_len);
+
 
 #endif
@@ -182,6 +182,9 @@ _calculate_if_trivial(LogTemplate *self)
 static void
 log_template_reset_compiled(LogTemplate *self)
 {
+  g_free(self->compiled_ops);
+  self->compiled_ops = NULL;
+  self->compiled_ops_len = 0;
   log_template_elem_free_list(self->compiled_template);
   self->compiled_template = NULL;
   self->trivial = FALSE;
@@ -204,6 +207,7 @@ log_template_compile(LogTemplate *self, const gchar *template, GError **error)
   result = log_template_compiler_compile(&compiler, &self->compiled_template, error);
   log_template_compiler_clear(&compiler);
 
+  self->compiled_ops = log_template_ops_new_from_elems(self->compiled_template, &self->compiled_ops_len);
   self->literal = _calculate_if_literal(self);
   self->trivial = _calculate_if_trivial(self);
   return result;
@@ -282,6 +286,7 @@ log_template_compile_literal_string(LogTemplate *self, const gchar *literal)
   self->template_str = g_strdup(literal);
   self->compiled_template = g_list_append(self->compiled_template,
                                           log_template_elem_new_macro(literal, M_NONE, NULL, 0));
+  self->compiled_ops = log_template_ops_new_from_elems(self->compiled_template, &self->compiled_ops_len);
 
   /* double check that the representation here is actually considered trivial. It should be. */
   g_assert(_calculate_if_trivial(self));
@@ -50,6 +50,9 @@ struct _LogTemplate
   gchar *name;
   gchar *template_str;
   GList *compiled_template;
+  /* compiled_template lowered into a flat array, used during evaluation */
+  LogTemplateOp *compiled_ops;
+  gsize compiled_ops_len;
   GlobalConfig *cfg;
   guint top_level:1, escape:1, def_inline:1, trivial:1, literal:1;
 
@@ -376,6 +376,42 @@ Test(template_compile, test_unknown_function)
                            type = LTE_MACRO, msg_ref = 0);
 }
 
+Test(template_compile, test_compiled_ops_follow_element_list)
+{
+  assert_template_compile("literal ${MSGHDR} $(hello) ${VALUE_NAME:-default}@2 tail");
+
+  cr_assert_eq(template->compiled_ops_len, g_list_length(template->compiled_template));
+
+  const LogTemplateOp *op = template->compiled_ops;
+  cr_assert_eq(op->type, LTO_MACRO);
+  cr_assert_eq(op->macro, M_MSGHDR);
+  cr_assert_eq(op->text_len, strlen("literal "));
+
+  op++;
+  cr_assert_eq(op->type, LTO_FUNC);
+  cr_assert_eq(op->func.ops, get_template_function_ops("hello"));
+
+  op++;
+  cr_assert_eq(op->type, LTO_VALUE);
+  cr_assert_eq(op->value_handle, log_msg_get_value_handle("VALUE_NAME"));
+  cr_assert_eq(op->msg_ref, 3);
+  cr_assert_str_eq(op->default_value, "default");
+  cr_assert_eq(op->default_value_len, strlen("default"));
+
+  op++;
+  cr_assert_eq(op->type, LTO_LITERAL);
+  cr_assert_eq(op->text_len, strlen(" tail"));
+}
+
+Test(template_compile, test_compiled_ops_of_literal_string)
+{
+  log_template_compile_literal_string(template, "literal");
+
+  cr_assert_eq(template->compiled_ops_len, 1);
+  cr_assert_eq(template->compiled_ops[0].type, LTO_LITERAL);
+  cr_assert_str_eq(template->compiled_ops[0].text, "literal");
+}
+
 static void
 setup(void)
 {
@@ -26,6 +26,7 @@
 #include "find-crlf.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 struct findcrlf_params
 {
@@ -165,3 +166,38 @@ ParameterizedTest(struct findcrlf_params *params, findcrlf, test)
                 "EOM is at wrong location. msg=%s, eom_ofs=%d, eom=%s\n",
                 params->msg, (gint) params->eom_ofs, eom);
 }
+
+Test(findcrlf, test_simd_matches_scalar_implementation)
+{
+  gchar buf[256];
+  const gchar terminators[] = { '\r', '\n', '\0' };
+
+  srand(0);
+  for (gint round = 0; round < 2000; round++)
+    {
+      gsize len = rand() % sizeof(buf);
+      gsize ofs = rand() % sizeof(buf);
+
+      memset(buf, 'x', sizeof(buf));
+      if (ofs < len)
+        buf[ofs] = terminators[round % G_N_ELEMENTS(terminators)];
+
+      /* vary the start address as well to exercise unaligned heads */
+      gsize start = rand() % 8;
+      if (start > len)
+        start = len;
+
+      cr_assert_eq(find_cr_or_lf_or_nul(buf + start, len - start),
+                   find_cr_or_lf_or_nul_scalar(buf + start, len - start),
+                   "SIMD and scalar results differ, len=%d, ofs=%d, start=%d",
+                   (gint) len, (gint) ofs, (gint) start);
+    }
+}
+
+Test(findcrlf, test_find_lf_or_nul_ignores_cr)
+{
+  const gchar *msg = "abcdefghijklmnopqrstuvwxyz\rabcdefghijklmnopqrstuvwxyz\nfoo";
+
+  cr_assert_eq(find_lf_or_nul(msg, strlen(msg)), strchr(msg, '\n'));
+  cr_assert_null(find_lf_or_nul(msg, 20));
+}
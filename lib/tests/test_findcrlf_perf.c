@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "find-crlf.h"
+#include "timeutils/misc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BUFFER_SIZE (64 * 1024)
+#define ITERATIONS 200
+
+typedef const gchar *(*FindFunc)(const gchar *s, gsize n);
+
+/* fill the buffer with lines of a fixed length, like a read buffer full of syslog traffic */
+static gchar *
+_construct_buffer(gsize line_length)
+{
+  gchar *buffer = g_malloc(BUFFER_SIZE);
+
+  memset(buffer, 'x', BUFFER_SIZE);
+  for (gsize i = line_length; i < BUFFER_SIZE; i += line_length + 1)
+    buffer[i] = '\n';
+  return buffer;
+}
+
+static void
+iterate_lines(const gchar *name, FindFunc find, gsize line_length)
+{
+  gchar *buffer = _construct_buffer(line_length);
+  struct timespec start, end;
+  gsize lines = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (gint i = 0; i < ITERATIONS; i++)
+    {
+      const gchar *p = buffer;
+      const gchar *end_of_buffer = buffer + BUFFER_SIZE;
+      const gchar *eol;
+
+      while ((eol = find(p, end_of_buffer - p)))
+        {
+          lines++;
+          p = eol + 1;
+        }
+    }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  gdouble usec = timespec_diff_usec(&end, &start);
+  printf("      %-8s line length: %5d speed: %12.3f lines/sec, %9.3f MiB/sec\n",
+         name, (gint) line_length, lines * 1e6 / usec,
+         ((gdouble) ITERATIONS * BUFFER_SIZE / (1024 * 1024)) * 1e6 / usec);
+  g_free(buffer);
+}
+
+Test(findcrlf_perf, test_find_cr_or_lf_or_nul_performance)
+{
+  const gsize line_lengths[] = { 16, 64, 128, 256, 512, 1024, 4096 };
+
+  for (gint i = 0; i < G_N_ELEMENTS(line_lengths); i++)
+    {
+      iterate_lines("scalar", find_cr_or_lf_or_nul_scalar, line_lengths[i]);
+      iterate_lines("native", find_cr_or_lf_or_nul, line_lengths[i]);
+    }
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include <criterion/parameterized.h>
+
+#include "logmatcher.h"
+#include "logmatcher-prefilter.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "scratch-buffers.h"
+
+typedef struct _RequiredLiteralTestParams
+{
+  const gchar *pattern;
+  gint flags;
+  const gchar *expected_literal;
+} RequiredLiteralTestParams;
+
+ParameterizedTestParameters(logmatcher_prefilter, test_required_literal_extraction)
+{
+  static RequiredLiteralTestParams params[] =
+  {
+    { "foobar", 0, "foobar" },
+    { "^foo.*bar$", 0, "foo" },
+    { "error: (\\d+) files failed", 0, " files failed" },
+    { "ab+cdef", 0, "cdef" },
+    { "abcd?ef", 0, "abc" },
+    { "fo{0,3}bar", 0, "bar" },
+    { "x{2}yyy", 0, "yyy" },
+    { "sshd\\[\\d+\\]: ", 0, "sshd[" },
+    { "\\.conf\\b", 0, ".conf" },
+    { "[]x]abcd", 0, "abcd" },
+    { "(?<user>\\w+)@example\\.com", 0, "@example.com" },
+    { "(foo|bar)bazz", 0, "bazz" },
+    { "kernel: panic", LMF_ICASE, "kernel: panic" },
+    { "kernel: panic", LMF_ICASE | LMF_UTF8, "ernel: panic" },
+
+    /* no usable literal */
+    { "foo|barbaz", 0, NULL },
+    { "(?i)kernel", 0, NULL },
+    { "(foo(*ACCEPT))barbar", 0, NULL },
+    { "a{foo}", 0, NULL },
+    { "\\x41bcd", 0, NULL },
+    { "a\\Qbcd\\E", 0, NULL },
+    { "ab.cd", 0, NULL },
+  };
+
+  return cr_make_param_array(RequiredLiteralTestParams, params, G_N_ELEMENTS(params));
+}
+
+ParameterizedTest(RequiredLiteralTestParams *params, logmatcher_prefilter, test_required_literal_extraction)
+{
+  GString *literal = g_string_new("");
+  gboolean result = log_matcher_pcre_extract_required_literal(params->pattern, params->flags, literal);
+
+  if (!params->expected_literal)
+    {
+      cr_assert_not(result, "unexpected literal extracted from %s: %s", params->pattern, literal->str);
+    }
+  else
+    {
+      cr_assert(result, "no literal extracted from %s", params->pattern);
+      cr_assert_str_eq(literal->str, params->expected_literal);
+    }
+  g_string_free(literal, TRUE);
+}
+
+static gboolean
+_is_candidate(LogMatcherPrefilter *prefilter, gint literal_id, LogMessage *msg)
+{
+  gssize value_len;
+  const gchar *value = log_msg_get_value(msg, LM_V_MESSAGE, &value_len);
+
+  return log_matcher_prefilter_is_candidate(prefilter, literal_id, msg, LM_V_MESSAGE, value, value_len);
+}
+
+Test(logmatcher_prefilter, test_prefilter_finds_literals_case_insensitively)
+{
+  LogMatcherPrefilter *prefilter = log_matcher_prefilter_new();
+  gint he = log_matcher_prefilter_add_literal(prefilter, "he", -1);
+  gint she = log_matcher_prefilter_add_literal(prefilter, "she", -1);
+  gint hers = log_matcher_prefilter_add_literal(prefilter, "hers", -1);
+  gint failed = log_matcher_prefilter_add_literal(prefilter, "Failed password", -1);
+
+  cr_assert_eq(log_matcher_prefilter_add_literal(prefilter, "SHE", -1), she, "literals should be deduplicated");
+  log_matcher_prefilter_compile(prefilter);
+  cr_assert_eq(log_matcher_prefilter_add_literal(prefilter, "late", -1), -1);
+
+  LogMessage *msg = log_msg_new_empty();
+  log_msg_set_value(msg, LM_V_MESSAGE, "uShErS", -1);
+
+  cr_assert(_is_candidate(prefilter, he, msg));
+  cr_assert(_is_candidate(prefilter, she, msg));
+  cr_assert(_is_candidate(prefilter, hers, msg));
+  cr_assert_not(_is_candidate(prefilter, failed, msg));
+
+  /* changing the message invalidates the cached scan */
+  log_msg_set_value(msg, LM_V_MESSAGE, "sshd: failed PASSWORD for root", -1);
+  cr_assert_not(_is_candidate(prefilter, she, msg));
+  cr_assert(_is_candidate(prefilter, failed, msg));
+
+  log_msg_unref(msg);
+  log_matcher_prefilter_unref(prefilter);
+}
+
+Test(logmatcher_prefilter, test_prefilter_with_many_literals)
+{
+  LogMatcherPrefilter *prefilter = log_matcher_prefilter_new();
+  gint ids[200];
+
+  for (gint i = 0; i < G_N_ELEMENTS(ids); i++)
+    {
+      gchar literal[32];
+
+      g_snprintf(literal, sizeof(literal), "rule%03d:", i);
+      ids[i] = log_matcher_prefilter_add_literal(prefilter, literal, -1);
+    }
+  log_matcher_prefilter_compile(prefilter);
+
+  LogMessage *msg = log_msg_new_empty();
+  log_msg_set_value(msg, LM_V_MESSAGE, "prefix rule007: rule150: rule15 rule199", -1);
+
+  for (gint i = 0; i < G_N_ELEMENTS(ids); i++)
+    cr_assert_eq(_is_candidate(prefilter, ids[i], msg), i == 7 || i == 150, "unexpected result for literal %d", i);
+
+  log_msg_unref(msg);
+  log_matcher_prefilter_unref(prefilter);
+}
+
+static LogMatcher *
+_construct_pcre_matcher(const gchar *pattern, gint flags)
+{
+  LogMatcherOptions matcher_options;
+
+  log_matcher_options_defaults(&matcher_options);
+  matcher_options.flags = flags;
+
+  LogMatcher *m = log_matcher_pcre_re_new(&matcher_options);
+  cr_assert(log_matcher_compile(m, pattern, NULL));
+  return m;
+}
+
+Test(logmatcher_prefilter, test_prefiltered_matchers_give_the_same_results)
+{
+  const gchar *patterns[] =
+  {
+    "Failed password for (\\w+)",
+    "session opened for user \\w+",
+    "kernel: .*oom",
+    "^Accepted publickey",
+    "(?i)connection closed",
+  };
+  const gchar *messages[] =
+  {
+    "Failed password for root from 10.0.0.1",
+    "pam_unix(sshd:session): session opened for user alice",
+    "kernel: Out of memory: oom-kill",
+    "Accepted publickey for bob",
+    "Connection closed by 10.0.0.2",
+    "nothing to see here",
+  };
+  LogMatcherPrefilter *prefilter = log_matcher_prefilter_new();
+  LogMatcher *plain[G_N_ELEMENTS(patterns)];
+  LogMatcher *prefiltered[G_N_ELEMENTS(patterns)];
+
+  for (gint i = 0; i < G_N_ELEMENTS(patterns); i++)
+    {
+      plain[i] = _construct_pcre_matcher(patterns[i], 0);
+      prefiltered[i] = _construct_pcre_matcher(patterns[i], 0);
+      log_matcher_attach_prefilter(prefiltered[i], prefilter);
+    }
+  log_matcher_prefilter_compile(prefilter);
+  cr_assert_eq(log_matcher_prefilter_get_num_literals(prefilter), 4);
+
+  for (gint m = 0; m < G_N_ELEMENTS(messages); m++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+      log_msg_set_value(msg, LM_V_MESSAGE, messages[m], -1);
+
+      for (gint i = 0; i < G_N_ELEMENTS(patterns); i++)
+        cr_assert_eq(log_matcher_match_value(prefiltered[i], msg, LM_V_MESSAGE),
+                     log_matcher_match_value(plain[i], msg, LM_V_MESSAGE),
+                     "prefiltered result differs, pattern: %s, message: %s", patterns[i], messages[m]);
+      log_msg_unref(msg);
+    }
+
+  for (gint i = 0; i < G_N_ELEMENTS(patterns); i++)
+    {
+      log_matcher_unref(plain[i]);
+      log_matcher_unref(prefiltered[i]);
+    }
+  log_matcher_prefilter_unref(prefilter);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+}
+
+static void
+teardown(void)
+{
+  scratch_buffers_explicit_gc();
+  app_shutdown();
+  cfg_free(configuration);
+}
+
+TestSuite(logmatcher_prefilter, .init = setup, .fini = teardown);
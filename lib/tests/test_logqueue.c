@@ -261,6 +261,88 @@ Test(logqueue, test_with_threads)
   fprintf(stderr, "Feed speed: %.2lf\n", (double) TEST_RUNS * MESSAGES_SUM * 1000000 / sum_time);
 }
 
+#define LOCK_FREE_FEEDERS 4
+
+static gboolean
+_consume_messages(LogQueue *q, gint count)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  for (gint msg_count = 0; msg_count < count; msg_count++)
+    {
+      LogMessage *msg;
+      gint slept = 0;
+
+      while ((msg = log_queue_pop_head(q, &path_options)) == NULL)
+        {
+          struct timespec ns = { .tv_sec = 0, .tv_nsec = 1000000 };
+
+          nanosleep(&ns, NULL);
+          if (++slept > 10000)
+            return FALSE;
+        }
+
+      log_msg_ack(msg, &path_options, AT_PROCESSED);
+      log_msg_unref(msg);
+    }
+
+  return TRUE;
+}
+
+Test(logqueue, test_lock_free_fifo_acks_and_counters)
+{
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *q = log_queue_fifo_lock_free_new(OVERFLOW_SIZE, NULL, STATS_LEVEL0, driver_sck_builder,
+                                             queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+
+  fed_messages = 0;
+  acked_messages = 0;
+  feed_some_messages(q, 1);
+  gint size_when_single_msg = stats_counter_get(q->metrics.shared.memory_usage);
+
+  feed_some_messages(q, 99);
+  cr_assert_eq(log_queue_get_length(q), 100);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.queued_messages), 100);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.memory_usage), 100 * size_when_single_msg);
+
+  send_some_messages(q, fed_messages, TRUE);
+  cr_assert_eq(log_queue_get_length(q), 0);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.memory_usage), 0);
+  cr_assert_eq(fed_messages, acked_messages,
+               "did not receive enough acknowledgements: fed_messages=%d, acked_messages=%d",
+               fed_messages, acked_messages);
+
+  log_queue_unref(q);
+}
+
+Test(logqueue, test_lock_free_fifo_with_threads)
+{
+  GThread *thread_feed[LOCK_FREE_FEEDERS];
+
+  main_loop_worker_allocate_thread_space(LOCK_FREE_FEEDERS);
+  main_loop_worker_finalize_thread_space();
+
+  LogQueue *q = log_queue_fifo_lock_free_new(LOCK_FREE_FEEDERS * MESSAGES_PER_FEEDER, NULL, STATS_LEVEL0,
+                                             NULL, NULL);
+
+  acked_messages = 0;
+  for (gint i = 0; i < LOCK_FREE_FEEDERS; i++)
+    thread_feed[i] = g_thread_new(NULL, _threaded_feed, q);
+
+  cr_assert(_consume_messages(q, LOCK_FREE_FEEDERS * MESSAGES_PER_FEEDER),
+            "The wait for messages took too much time");
+
+  for (gint i = 0; i < LOCK_FREE_FEEDERS; i++)
+    g_thread_join(thread_feed[i]);
+
+  cr_assert_eq(acked_messages, LOCK_FREE_FEEDERS * MESSAGES_PER_FEEDER);
+  cr_assert_eq(log_queue_get_length(q), 0);
+  log_queue_unref(q);
+}
+
 Test(logqueue, log_queue_fifo_rewind_all_and_memory_usage)
 {
   StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
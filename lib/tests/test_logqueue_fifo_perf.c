@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "logqueue-fifo.h"
+#include "mainloop.h"
+#include "mainloop-worker.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "timeutils/misc.h"
+
+#include <stdio.h>
+#include <iv.h>
+
+#define MAX_PRODUCERS 64
+#define MESSAGES_PER_RUN (MAX_PRODUCERS * 4096)
+
+/* emulates log-fetch-limit(), the input queue is handed over after this many messages */
+#define FETCH_LIMIT 100
+
+typedef LogQueue *(*FifoConstructor)(gint log_fifo_size, const gchar *persist_name, gint stats_level,
+                                     StatsClusterKeyBuilder *driver_sck_builder,
+                                     StatsClusterKeyBuilder *queue_sck_builder);
+
+typedef struct
+{
+  LogQueue *queue;
+  gint num_messages;
+} ProducerArgs;
+
+static gpointer
+_produce(gpointer user_data)
+{
+  ProducerArgs *args = user_data;
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  iv_init();
+  main_loop_worker_thread_start(MLW_ASYNC_WORKER);
+
+  LogMessage *tmpl = log_msg_new_empty();
+  path_options.flow_control_requested = TRUE;
+
+  for (gint i = 0; i < args->num_messages; i++)
+    {
+      log_queue_push_tail(args->queue, log_msg_clone_cow(tmpl, &path_options), &path_options);
+
+      if ((i % FETCH_LIMIT) == FETCH_LIMIT - 1)
+        main_loop_worker_invoke_batch_callbacks();
+    }
+  main_loop_worker_invoke_batch_callbacks();
+
+  log_msg_unref(tmpl);
+  main_loop_worker_thread_stop();
+  iv_deinit();
+  return NULL;
+}
+
+static void
+_consume(LogQueue *queue, gint num_messages)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  for (gint i = 0; i < num_messages;)
+    {
+      LogMessage *msg = log_queue_pop_head(queue, &path_options);
+      if (!msg)
+        {
+          g_thread_yield();
+          continue;
+        }
+
+      log_queue_ack_backlog(queue, 1);
+      log_msg_unref(msg);
+      i++;
+    }
+}
+
+static void
+_run(const gchar *name, FifoConstructor construct, gint num_producers)
+{
+  GThread *producers[MAX_PRODUCERS];
+  ProducerArgs args;
+  struct timespec start, end;
+
+  args.queue = construct(MESSAGES_PER_RUN, NULL, STATS_LEVEL0, NULL, NULL);
+  args.num_messages = MESSAGES_PER_RUN / num_producers;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (gint i = 0; i < num_producers; i++)
+    producers[i] = g_thread_new(NULL, _produce, &args);
+
+  _consume(args.queue, args.num_messages * num_producers);
+
+  for (gint i = 0; i < num_producers; i++)
+    g_thread_join(producers[i]);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  gdouble usec = timespec_diff_usec(&end, &start);
+  printf("      %-10s producers: %2d speed: %12.3f msg/sec\n",
+         name, num_producers, args.num_messages * num_producers * 1e6 / usec);
+
+  log_queue_unref(args.queue);
+}
+
+Test(logqueue_fifo_perf, test_producer_contention_performance)
+{
+  main_loop_worker_allocate_thread_space(MAX_PRODUCERS);
+  main_loop_worker_finalize_thread_space();
+
+  for (gint num_producers = 1; num_producers <= MAX_PRODUCERS; num_producers *= 2)
+    {
+      _run("locked", log_queue_fifo_new, num_producers);
+      _run("lock-free", log_queue_fifo_lock_free_new, num_producers);
+    }
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  cr_assert(cfg_init(configuration), "cfg_init failed!");
+}
+
+static void
+teardown(void)
+{
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(logqueue_fifo_perf, .init = setup, .fini = teardown);
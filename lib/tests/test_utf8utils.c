@@ -106,3 +106,55 @@ ParameterizedTest(StringValueList *string_value_list, test_utf8utils, test_escap
                                               string_value_list->unsafe_flags), escaping_was_applied);
   g_free(escaped_str);
 }
+
+static const gchar *fragments[] =
+{
+  "syslog-ng", " ", "0123456789abcdefghijklmnopqrstuvwxyz", "\"", "'", "\\", "\n", "\t", "\x01", "\x7f",
+  "árvíztűrő", "€", "\xf0\x9f\x98\x80", "\xad", "\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80",
+  "\xe2\x82", "\xf0\x9f\x98",
+};
+
+static void
+_assert_escaping_matches_scalar(const gchar *str, gsize str_len, guint32 unsafe_flags,
+                                const gchar *control_format, const gchar *invalid_format)
+{
+  GString *expected = g_string_new("");
+  GString *escaped = g_string_new("");
+
+  append_unsafe_utf8_as_escaped_scalar(expected, str, str_len, unsafe_flags, control_format, invalid_format);
+  append_unsafe_utf8_as_escaped(escaped, str, str_len, unsafe_flags, control_format, invalid_format);
+
+  cr_assert_eq(escaped->len, expected->len);
+  cr_assert(memcmp(escaped->str, expected->str, expected->len) == 0,
+            "Escaped output differs from the scalar implementation, expected: %s, actual: %s",
+            expected->str, escaped->str);
+
+  g_string_free(expected, TRUE);
+  g_string_free(escaped, TRUE);
+}
+
+Test(test_utf8utils, test_escaping_matches_scalar_implementation)
+{
+  GRand *rand = g_rand_new_with_seed(42);
+  GString *input = g_string_new("");
+
+  for (gint i = 0; i < 10000; i++)
+    {
+      g_string_truncate(input, 0);
+
+      gint num_fragments = g_rand_int_range(rand, 0, 24);
+      for (gint j = 0; j < num_fragments; j++)
+        g_string_append(input, fragments[g_rand_int_range(rand, 0, G_N_ELEMENTS(fragments))]);
+
+      /* embedded NUL characters are escaped as invalid */
+      if (input->len > 0 && g_rand_int_range(rand, 0, 8) == 0)
+        input->str[g_rand_int_range(rand, 0, input->len)] = '\0';
+
+      guint32 unsafe_flags = g_rand_int_range(rand, 0, 4);
+      _assert_escaping_matches_scalar(input->str, input->len, unsafe_flags, "\\x%02x", "\\x%02x");
+      _assert_escaping_matches_scalar(input->str, input->len, unsafe_flags, "\\u%04x", "\\\\x%02x");
+    }
+
+  g_string_free(input, TRUE);
+  g_rand_free(rand);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Balabit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "utf8utils.h"
+#include "timeutils/misc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define ITERATIONS 100000
+
+typedef void (*EscapeFunc)(GString *escaped_output, const gchar *raw, gssize raw_len, guint32 unsafe_flags,
+                           const gchar *control_format, const gchar *invalid_format);
+
+static void
+escape_value(const gchar *name, EscapeFunc escape, const gchar *description, const gchar *value)
+{
+  GString *escaped = g_string_sized_new(4096);
+  gsize value_len = strlen(value);
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (gint i = 0; i < ITERATIONS; i++)
+    {
+      g_string_truncate(escaped, 0);
+      escape(escaped, value, value_len, AUTF8_UNSAFE_QUOTE, "\\u%04x", "\\\\x%02x");
+    }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  gdouble usec = timespec_diff_usec(&end, &start);
+  printf("      %-8s %-24s speed: %12.3f values/sec, %9.3f MiB/sec\n",
+         name, description, ITERATIONS * 1e6 / usec,
+         ((gdouble) ITERATIONS * value_len / (1024 * 1024)) * 1e6 / usec);
+  g_string_free(escaped, TRUE);
+}
+
+Test(utf8utils_perf, test_json_escaping_performance)
+{
+  const struct
+  {
+    const gchar *description;
+    const gchar *value;
+  } values[] =
+  {
+    { "short ascii", "sshd" },
+    {
+      "syslog message",
+      "Accepted publickey for admin from 192.168.1.100 port 51234 ssh2: RSA SHA256:kLsdmC8w0vIQ5Hfn5dIJ4e"
+    },
+    {
+      "quotes and newlines",
+      "{\"user\": \"admin\", \"action\": \"login\"}\n{\"user\": \"guest\", \"action\": \"logout\"}\n"
+    },
+    {
+      "utf-8 text",
+      "árvíztűrő tükörfúrógép, Árvíztűrő Tükörfúrógép, árvíztűrő tükörfúrógép, Árvíztűrő Tükörfúrógép"
+    },
+  };
+
+  for (gint i = 0; i < G_N_ELEMENTS(values); i++)
+    {
+      escape_value("scalar", append_unsafe_utf8_as_escaped_scalar, values[i].description, values[i].value);
+      escape_value("native", append_unsafe_utf8_as_escaped, values[i].description, values[i].value);
+    }
+}
@@ -77,6 +77,9 @@ struct _LogTransport
     gint buf_len;
     gint pos;
   } ra;
+  /* number of records already received from the kernel (e.g. via a
+   * batched recvmmsg()) that were not yet returned by read() */
+  gint pending_records;
   LogTransportStack *stack;
   const gchar *name;
 };
@@ -109,6 +112,9 @@ log_transport_poll_prepare(LogTransport *self, GIOCondition *cond)
   if (self->ra.buf_len != self->ra.pos)
     return TRUE;
 
+  if (self->pending_records > 0)
+    return TRUE;
+
   return FALSE;
 }
 
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2025 Balazs Scheidler <balazs.scheidler@axoflow.com>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "transport/transport-udp-socket.h"
+#include "transport/transport-haproxy.h"
+#include "transport/transport-stack.h"
+#include "gsockaddr.h"
+#include "apphook.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+
+static gint server_fd = -1;
+static gint client_fd = -1;
+static struct sockaddr_in server_addr;
+
+static void
+_setup_sockets(void)
+{
+  socklen_t len = sizeof(server_addr);
+
+  server_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  cr_assert(server_fd >= 0);
+
+  memset(&server_addr, 0, sizeof(server_addr));
+  server_addr.sin_family = AF_INET;
+  server_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  cr_assert(bind(server_fd, (struct sockaddr *) &server_addr, sizeof(server_addr)) == 0);
+  cr_assert(getsockname(server_fd, (struct sockaddr *) &server_addr, &len) == 0);
+
+  client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  cr_assert(client_fd >= 0);
+}
+
+static void
+_send_datagram(const gchar *payload)
+{
+  cr_assert(sendto(client_fd, payload, strlen(payload), 0,
+                   (struct sockaddr *) &server_addr, sizeof(server_addr)) == strlen(payload));
+}
+
+static void
+_send_proxied_datagram(const gchar *payload)
+{
+  /* PROXY v2 header of a LOCAL command, without addresses */
+  const gchar header[] = "\x0D\x0A\x0D\x0A\x00\x0D\x0A\x51\x55\x49\x54\x0A\x20\x00\x00\x00";
+  GString *packet = g_string_new_len(header, sizeof(header) - 1);
+
+  g_string_append(packet, payload);
+  cr_assert(sendto(client_fd, packet->str, packet->len, 0,
+                   (struct sockaddr *) &server_addr, sizeof(server_addr)) == packet->len);
+  g_string_free(packet, TRUE);
+}
+
+static void
+_assert_read_datagram(LogTransport *t, const gchar *expected)
+{
+  gchar buf[1024];
+  LogTransportAuxData aux;
+
+  log_transport_aux_data_init(&aux);
+  gssize rc = log_transport_read(t, buf, sizeof(buf), &aux);
+  cr_assert(rc == strlen(expected), "unexpected rc = %d", (gint) rc);
+  cr_assert(memcmp(buf, expected, rc) == 0);
+  cr_assert_not_null(aux.peer_addr, "peer address is not set for the datagram");
+  cr_assert(aux.proto == IPPROTO_UDP);
+  log_transport_aux_data_destroy(&aux);
+}
+
+static void
+_assert_read_would_block(LogTransport *t)
+{
+  gchar buf[1024];
+
+  cr_assert(log_transport_read(t, buf, sizeof(buf), NULL) == -1);
+  cr_assert(errno == EAGAIN, "unexpected errno = %d", errno);
+}
+
+Test(transport_udp, test_unbatched_read_returns_datagrams_one_by_one)
+{
+  LogTransport *t = log_transport_udp_socket_new(server_fd);
+
+  _send_datagram("first");
+  _send_datagram("second");
+
+  _assert_read_datagram(t, "first");
+  cr_assert(t->pending_records == 0);
+  _assert_read_datagram(t, "second");
+
+  log_transport_free(t);
+}
+
+#if SYSLOG_NG_HAVE_RECVMMSG
+
+Test(transport_udp, test_batched_read_receives_multiple_datagrams_and_returns_them_in_order)
+{
+  LogTransport *t = log_transport_udp_socket_new(server_fd);
+  log_transport_udp_socket_set_receive_batch_size(t, 8);
+
+  _send_datagram("first");
+  _send_datagram("second");
+  _send_datagram("third");
+
+  _assert_read_datagram(t, "first");
+  cr_assert(t->pending_records == 2, "unexpected pending_records = %d", t->pending_records);
+
+  GIOCondition cond;
+  cr_assert(log_transport_poll_prepare(t, &cond), "pending datagrams must force a fetch without polling");
+
+  _assert_read_datagram(t, "second");
+  _assert_read_datagram(t, "third");
+  cr_assert(t->pending_records == 0);
+  cr_assert_not(log_transport_poll_prepare(t, &cond));
+
+  _assert_read_would_block(t);
+
+  _send_datagram("fourth");
+  _assert_read_datagram(t, "fourth");
+
+  log_transport_free(t);
+}
+
+Test(transport_udp, test_batched_read_skips_empty_datagrams)
+{
+  LogTransport *t = log_transport_udp_socket_new(server_fd);
+  log_transport_udp_socket_set_receive_batch_size(t, 4);
+
+  _send_datagram("");
+  _send_datagram("payload");
+
+  _assert_read_datagram(t, "payload");
+  _assert_read_would_block(t);
+
+  log_transport_free(t);
+}
+
+Test(transport_udp, test_batched_read_grows_slots_with_the_read_buffer)
+{
+  LogTransport *t = log_transport_udp_socket_new(server_fd);
+  log_transport_udp_socket_set_receive_batch_size(t, 4);
+  gchar small_buf[8];
+
+  _send_datagram("short");
+  cr_assert(log_transport_read(t, small_buf, sizeof(small_buf), NULL) == strlen("short"));
+
+  gchar *long_payload = g_strnfill(512, 'x');
+  _send_datagram(long_payload);
+  _assert_read_datagram(t, long_payload);
+  g_free(long_payload);
+
+  log_transport_free(t);
+}
+
+Test(transport_udp, test_pending_datagrams_are_visible_through_the_haproxy_adapter)
+{
+  LogTransportStack stack;
+  LogTransport *t = log_transport_udp_socket_new(server_fd);
+  log_transport_udp_socket_set_receive_batch_size(t, 8);
+  GIOCondition cond;
+  gchar buf[1024];
+
+  log_transport_stack_init(&stack, t);
+  log_transport_stack_add_transport(&stack, LOG_TRANSPORT_HAPROXY,
+                                    log_transport_haproxy_new(LOG_TRANSPORT_INITIAL, LOG_TRANSPORT_INITIAL, SOCK_DGRAM));
+  log_transport_stack_switch(&stack, LOG_TRANSPORT_HAPROXY);
+
+  _send_proxied_datagram("first");
+  _send_proxied_datagram("second");
+
+  cr_assert(log_transport_stack_read(&stack, buf, sizeof(buf), NULL) == strlen("first"));
+  cr_assert(memcmp(buf, "first", strlen("first")) == 0);
+  cr_assert(log_transport_stack_poll_prepare(&stack, &cond), "pending datagrams must force a fetch without polling");
+
+  cr_assert(log_transport_stack_read(&stack, buf, sizeof(buf), NULL) == strlen("second"));
+  cr_assert(memcmp(buf, "second", strlen("second")) == 0);
+  cr_assert_not(log_transport_stack_poll_prepare(&stack, &cond));
+
+  log_transport_stack_deinit(&stack);
+}
+
+#endif
+
+static void
+setup(void)
+{
+  app_startup();
+  _setup_sockets();
+}
+
+static void
+teardown(void)
+{
+  close(server_fd);
+  close(client_fd);
+  app_shutdown();
+}
+
+TestSuite(transport_udp, .init = setup, .fini = teardown);
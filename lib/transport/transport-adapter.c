@@ -28,7 +28,11 @@ log_transport_adapter_read_method(LogTransport *s, gpointer buf, gsize buflen, L
   LogTransportAdapter *self = (LogTransportAdapter *) s;
   LogTransport *transport = log_transport_stack_get_or_create_transport(s->stack, self->base_index);
 
-  return log_transport_read(transport, buf, buflen, aux);
+  gssize rc = log_transport_read(transport, buf, buflen, aux);
+
+  /* the stack only polls the active transport, which is the adapter */
+  s->pending_records = transport->pending_records;
+  return rc;
 }
 
 gssize
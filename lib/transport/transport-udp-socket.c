@@ -25,6 +25,11 @@
 #include "gsocket.h"
 #include "scratch-buffers.h"
 #include "str-format.h"
+#include "messages.h"
+#include "compat/pow2.h"
+#include "metrics/metric-names.h"
+#include "stats/stats-cluster-key-builder.h"
+#include "stats/aggregator/stats-aggregator-registry.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -38,8 +43,31 @@ struct _LogTransportUDP
 {
   LogTransportSocket super;
   GSockAddr *bind_addr;
+
+  /* datagrams received by a single recvmmsg() call, handed out one-by-one
+   * by subsequent read() calls */
+  struct
+  {
+    gint size;
+    gint count;
+    gint pos;
+    gsize slot_size;
+#if SYSLOG_NG_HAVE_RECVMMSG
+    struct mmsghdr *hdrs;
+#endif
+    struct iovec *iovs;
+    struct sockaddr_storage *names;
+    gchar *ctlbufs;
+    gchar *buffers;
+  } batch;
+
+  StatsClusterKey *batch_size_key;
+  StatsAggregator *batch_size;
 };
 
+#define UDP_BATCH_CTLBUF_SIZE 256
+#define UDP_BATCH_MAX_SLOT_SIZE 65536
+
 #if defined(__FreeBSD__) || defined(__OpenBSD__)
 
 GSockAddr *
@@ -158,10 +186,184 @@ _setup_fd(LogTransportUDP *self, gint fd)
 
 }
 
+#if SYSLOG_NG_HAVE_RECVMMSG
+
+static void _batch_free(LogTransportUDP *self);
+
+static void
+_batch_alloc(LogTransportUDP *self, gsize buflen)
+{
+  gint size = self->batch.size;
+
+  _batch_free(self);
+  self->batch.slot_size = MIN(buflen, UDP_BATCH_MAX_SLOT_SIZE);
+  self->batch.hdrs = g_new0(struct mmsghdr, size);
+  self->batch.iovs = g_new0(struct iovec, size);
+  self->batch.names = g_new0(struct sockaddr_storage, size);
+  self->batch.ctlbufs = g_malloc(size * UDP_BATCH_CTLBUF_SIZE);
+  self->batch.buffers = g_malloc(size * self->batch.slot_size);
+
+  for (gint i = 0; i < size; i++)
+    {
+      struct msghdr *msg = &self->batch.hdrs[i].msg_hdr;
+
+      self->batch.iovs[i].iov_base = self->batch.buffers + i * self->batch.slot_size;
+      msg->msg_iov = &self->batch.iovs[i];
+      msg->msg_iovlen = 1;
+      msg->msg_name = &self->batch.names[i];
+#if defined(SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR)
+      msg->msg_control = self->batch.ctlbufs + i * UDP_BATCH_CTLBUF_SIZE;
+#endif
+    }
+}
+
+static void
+_batch_reset_slots(LogTransportUDP *self)
+{
+  for (gint i = 0; i < self->batch.size; i++)
+    {
+      struct msghdr *msg = &self->batch.hdrs[i].msg_hdr;
+
+      self->batch.iovs[i].iov_len = self->batch.slot_size;
+      msg->msg_namelen = sizeof(self->batch.names[i]);
+#if defined(SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR)
+      msg->msg_controllen = UDP_BATCH_CTLBUF_SIZE;
+#endif
+      msg->msg_flags = 0;
+      self->batch.hdrs[i].msg_len = 0;
+    }
+}
+
+static gssize
+_batch_fill(LogTransportUDP *self, gsize buflen)
+{
+  gint rc;
+
+  /* datagrams are truncated to the slot size, so the slots grow with the
+   * buffer of the caller, e.g. when the first read came from a header
+   * parser with a small buffer */
+  if (G_UNLIKELY(!self->batch.hdrs || (buflen > self->batch.slot_size && self->batch.slot_size < UDP_BATCH_MAX_SLOT_SIZE)))
+    _batch_alloc(self, buflen);
+
+  _batch_reset_slots(self);
+  do
+    {
+      rc = recvmmsg(self->super.super.fd, self->batch.hdrs, self->batch.size, MSG_DONTWAIT, NULL);
+    }
+  while (rc == -1 && errno == EINTR);
+
+  if (rc <= 0)
+    {
+      if (rc == 0)
+        errno = EAGAIN;
+      return -1;
+    }
+
+  self->batch.count = rc;
+  self->batch.pos = 0;
+  self->super.super.pending_records = rc;
+  stats_aggregator_add_data_point(self->batch_size, rc);
+  return rc;
+}
+
+static gssize
+log_transport_udp_socket_read_batched_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux)
+{
+  LogTransportUDP *self = (LogTransportUDP *) s;
+
+  while (TRUE)
+    {
+      if (self->batch.pos == self->batch.count && _batch_fill(self, buflen) < 0)
+        return -1;
+
+      struct mmsghdr *slot = &self->batch.hdrs[self->batch.pos++];
+      s->pending_records = self->batch.count - self->batch.pos;
+
+      /* DGRAM sockets should never return EOF, empty datagrams are skipped */
+      if (slot->msg_len == 0)
+        continue;
+
+      gsize len = MIN(slot->msg_len, buflen);
+      memcpy(buf, slot->msg_hdr.msg_iov->iov_base, len);
+      log_transport_socket_extract_from_msghdr(&self->super, &slot->msg_hdr, aux);
+      return len;
+    }
+}
+
+#endif
+
+static void
+_batch_free(LogTransportUDP *self)
+{
+#if SYSLOG_NG_HAVE_RECVMMSG
+  g_free(self->batch.hdrs);
+#endif
+  g_free(self->batch.iovs);
+  g_free(self->batch.names);
+  g_free(self->batch.ctlbufs);
+  g_free(self->batch.buffers);
+}
+
+void
+log_transport_udp_socket_set_receive_batch_size(LogTransport *s, gint batch_size)
+{
+  LogTransportUDP *self = (LogTransportUDP *) s;
+
+  if (batch_size <= 1)
+    return;
+
+#if SYSLOG_NG_HAVE_RECVMMSG
+  self->batch.size = batch_size;
+  self->super.super.read = log_transport_udp_socket_read_batched_method;
+#else
+  msg_warning_once("WARNING: batched UDP receive was requested, but recvmmsg() is not supported on this platform, "
+                   "falling back to receiving a single datagram per read",
+                   evt_tag_int("udp_receive_batch_size", batch_size));
+#endif
+}
+
+static void
+log_transport_udp_socket_register_stats(LogTransport *s, StatsClusterKeyBuilder *kb)
+{
+  LogTransportUDP *self = (LogTransportUDP *) s;
+
+  if (!kb || self->batch.size <= 1 || self->batch_size_key)
+    return;
+
+  stats_cluster_key_builder_push(kb);
+  {
+    stats_cluster_key_builder_set_name(kb, METRIC(socket_receive_batch_size));
+    self->batch_size_key = stats_cluster_key_builder_build_hist(kb);
+  }
+  stats_cluster_key_builder_pop(kb);
+
+  stats_aggregator_lock();
+  stats_register_aggregator_hist(STATS_LEVEL3, self->batch_size_key, round_to_log2(1),
+                                 round_to_log2(self->batch.size) + 1, &self->batch_size);
+  stats_aggregator_unlock();
+}
+
+static void
+log_transport_udp_socket_unregister_stats(LogTransportUDP *self)
+{
+  if (!self->batch_size_key)
+    return;
+
+  stats_aggregator_lock();
+  stats_unregister_aggregator(&self->batch_size);
+  stats_aggregator_unlock();
+
+  stats_cluster_key_free(self->batch_size_key);
+  self->batch_size_key = NULL;
+}
+
 static void
 log_transport_udp_socket_free(LogTransport *s)
 {
   LogTransportUDP *self = (LogTransportUDP *)s;
+
+  log_transport_udp_socket_unregister_stats(self);
+  _batch_free(self);
   g_sockaddr_unref(self->bind_addr);
   log_transport_free_method(s);
 }
@@ -173,7 +375,9 @@ log_transport_udp_socket_new(gint fd)
 
   log_transport_dgram_socket_init_instance(&self->super, fd);
   self->super.super.free_fn = log_transport_udp_socket_free;
+  self->super.super.register_stats = log_transport_udp_socket_register_stats;
   self->super.parse_cmsg = log_transport_udp_parse_cmsg;
+  self->batch.size = 1;
 
   _setup_fd(self, fd);
   return &self->super.super;
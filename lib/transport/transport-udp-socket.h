@@ -25,6 +25,7 @@
 
 #include "transport/logtransport.h"
 
+void log_transport_udp_socket_set_receive_batch_size(LogTransport *s, gint batch_size);
 LogTransport *log_transport_udp_socket_new(gint fd);
 
 
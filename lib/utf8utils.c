@@ -23,6 +23,14 @@
 #include "utf8utils.h"
 #include "str-utils.h"
 
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define UTF8UTILS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define UTF8UTILS_NEON 1
+#include <arm_neon.h>
+#endif
+
 static inline gboolean
 _is_character_unsafe(gunichar uchar, guint32 unsafe_flags)
 {
@@ -30,6 +38,208 @@ _is_character_unsafe(gunichar uchar, guint32 unsafe_flags)
          (uchar == '\'' && (unsafe_flags & AUTF8_UNSAFE_APOSTROPHE));
 }
 
+/*
+ * Clean runs
+ *
+ * Most of the input needs no escaping at all, so before falling back to
+ * the per-character path below we look for the longest prefix that would
+ * be reproduced as is and copy it in one go.  A byte is "clean" if it is
+ * printable ASCII (0x20-0x7f), is not a backslash and is not one of the
+ * characters requested by @unsafe_flags.  Well-formed multi-byte UTF-8
+ * sequences are clean as well.
+ *
+ * The ASCII scan is vectorized, everything else is left to the per-character
+ * path, so the output is the same as without this fast path.
+ */
+
+typedef gsize (*FindUnsafeAsciiFunc)(const gchar *s, gsize n, gchar a, gchar b, gchar c);
+
+#define IS_UNSAFE_ASCII(ch, a, b, c) ((guchar) (ch) < 0x20 || (guchar) (ch) >= 0x80 || \
+                                      (ch) == (a) || (ch) == (b) || (ch) == (c))
+
+static gsize
+_find_unsafe_ascii_bytewise(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (IS_UNSAFE_ASCII(s[i], a, b, c))
+        break;
+    }
+  return i;
+}
+
+#if UTF8UTILS_X86
+
+/* SSE2 is part of the x86_64 baseline, so this needs no runtime check */
+static gsize
+_find_unsafe_ascii_sse2(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  const __m128i vspace = _mm_set1_epi8(0x20);
+  const __m128i va = _mm_set1_epi8(a);
+  const __m128i vb = _mm_set1_epi8(b);
+  const __m128i vc = _mm_set1_epi8(c);
+  gsize i = 0;
+
+  for (; i + sizeof(__m128i) <= n; i += sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) (s + i));
+
+      /* signed comparison: bytes >= 0x80 are negative, so they are caught too */
+      __m128i unsafe = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi8(chunk, vspace),
+                                                 _mm_cmpeq_epi8(chunk, va)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(chunk, vb),
+                                                 _mm_cmpeq_epi8(chunk, vc)));
+      guint32 mask = (guint32) _mm_movemask_epi8(unsafe);
+
+      if (mask)
+        return i + __builtin_ctz(mask);
+    }
+  return i + _find_unsafe_ascii_bytewise(s + i, n - i, a, b, c);
+}
+
+__attribute__((target("avx2")))
+static gsize
+_find_unsafe_ascii_avx2(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  const __m256i vspace = _mm256_set1_epi8(0x20);
+  const __m256i va = _mm256_set1_epi8(a);
+  const __m256i vb = _mm256_set1_epi8(b);
+  const __m256i vc = _mm256_set1_epi8(c);
+  gsize i = 0;
+
+  for (; i + sizeof(__m256i) <= n; i += sizeof(__m256i))
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *) (s + i));
+      __m256i unsafe = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi8(vspace, chunk),
+                                                       _mm256_cmpeq_epi8(chunk, va)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, vb),
+                                                        _mm256_cmpeq_epi8(chunk, vc)));
+      guint32 mask = (guint32) _mm256_movemask_epi8(unsafe);
+
+      if (mask)
+        return i + __builtin_ctz(mask);
+    }
+  return i + _find_unsafe_ascii_sse2(s + i, n - i, a, b, c);
+}
+
+#elif UTF8UTILS_NEON
+
+static gsize
+_find_unsafe_ascii_neon(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  const int8x16_t vspace = vdupq_n_s8(0x20);
+  const uint8x16_t va = vdupq_n_u8((guint8) a);
+  const uint8x16_t vb = vdupq_n_u8((guint8) b);
+  const uint8x16_t vc = vdupq_n_u8((guint8) c);
+  gsize i = 0;
+
+  for (; i + sizeof(uint8x16_t) <= n; i += sizeof(uint8x16_t))
+    {
+      uint8x16_t chunk = vld1q_u8((const guint8 *) (s + i));
+      uint8x16_t unsafe = vorrq_u8(vorrq_u8(vcltq_s8(vreinterpretq_s8_u8(chunk), vspace),
+                                            vceqq_u8(chunk, va)),
+                                   vorrq_u8(vceqq_u8(chunk, vb), vceqq_u8(chunk, vc)));
+
+      /* narrow the 0x00/0xff lanes to one nibble per byte so the result fits in 64 bits */
+      guint64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(unsafe), 4)), 0);
+
+      if (mask)
+        return i + (__builtin_ctzll(mask) >> 2);
+    }
+  return i + _find_unsafe_ascii_bytewise(s + i, n - i, a, b, c);
+}
+
+#endif
+
+static FindUnsafeAsciiFunc
+_select_find_unsafe_ascii(void)
+{
+#if UTF8UTILS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return _find_unsafe_ascii_avx2;
+  return _find_unsafe_ascii_sse2;
+#elif UTF8UTILS_NEON
+  return _find_unsafe_ascii_neon;
+#else
+  return _find_unsafe_ascii_bytewise;
+#endif
+}
+
+static gsize _find_unsafe_ascii_resolve(const gchar *s, gsize n, gchar a, gchar b, gchar c);
+
+/* resolved on first use, racing threads all store the same value */
+static FindUnsafeAsciiFunc find_unsafe_ascii = _find_unsafe_ascii_resolve;
+
+static gsize
+_find_unsafe_ascii_resolve(const gchar *s, gsize n, gchar a, gchar b, gchar c)
+{
+  FindUnsafeAsciiFunc impl = _select_find_unsafe_ascii();
+
+  g_atomic_pointer_set(&find_unsafe_ascii, impl);
+  return impl(s, n, a, b, c);
+}
+
+/*
+ * Returns the length of the well-formed multi-byte UTF-8 sequence at @s or
+ * 0 if there is none.  The rules are those of RFC 3629 (no overlong forms,
+ * no surrogates, nothing above U+10FFFF), the same set of sequences that
+ * g_utf8_get_char_validated() accepts.
+ */
+static inline gsize
+_valid_utf8_sequence_length(const guchar *s, gsize n)
+{
+  guchar lead = s[0];
+
+  if (lead >= 0xc2 && lead <= 0xdf)
+    {
+      if (n >= 2 && (s[1] & 0xc0) == 0x80)
+        return 2;
+    }
+  else if (lead >= 0xe0 && lead <= 0xef)
+    {
+      guchar lo = lead == 0xe0 ? 0xa0 : 0x80;
+      guchar hi = lead == 0xed ? 0x9f : 0xbf;
+
+      if (n >= 3 && s[1] >= lo && s[1] <= hi && (s[2] & 0xc0) == 0x80)
+        return 3;
+    }
+  else if (lead >= 0xf0 && lead <= 0xf4)
+    {
+      guchar lo = lead == 0xf0 ? 0x90 : 0x80;
+      guchar hi = lead == 0xf4 ? 0x8f : 0xbf;
+
+      if (n >= 4 && s[1] >= lo && s[1] <= hi && (s[2] & 0xc0) == 0x80 && (s[3] & 0xc0) == 0x80)
+        return 4;
+    }
+  return 0;
+}
+
+static inline gsize
+_find_clean_run_length(const gchar *str, gsize len, guint32 unsafe_flags)
+{
+  /* disabled characters are replaced by the backslash, which is unsafe anyway */
+  gchar quote = (unsafe_flags & AUTF8_UNSAFE_QUOTE) ? '"' : '\\';
+  gchar apostrophe = (unsafe_flags & AUTF8_UNSAFE_APOSTROPHE) ? '\'' : '\\';
+  FindUnsafeAsciiFunc find = g_atomic_pointer_get(&find_unsafe_ascii);
+  gsize pos = 0;
+
+  while (pos < len)
+    {
+      pos += find(str + pos, len - pos, '\\', quote, apostrophe);
+      if (pos == len)
+        break;
+
+      gsize seq_len = _valid_utf8_sequence_length((const guchar *) str + pos, len - pos);
+      if (!seq_len)
+        break;
+      pos += seq_len;
+    }
+  return pos;
+}
+
 /**
  * This function escapes an unsanitized input (e.g. that can contain binary
  * characters, and produces an escaped format that can be deescaped in need,
@@ -166,8 +376,19 @@ _append_unsafe_utf8_as_escaped_with_specific_length(GString *escaped_output, con
   const gchar *raw_end = raw + raw_len;
 
   while (raw < raw_end)
-    _append_escaped_utf8_character(escaped_output, &raw, raw_end - raw, unsafe_flags,
-                                   control_format, invalid_format);
+    {
+      gsize clean_len = _find_clean_run_length(raw, raw_end - raw, unsafe_flags);
+
+      if (clean_len)
+        {
+          g_string_append_len(escaped_output, raw, clean_len);
+          raw += clean_len;
+          if (raw == raw_end)
+            break;
+        }
+      _append_escaped_utf8_character(escaped_output, &raw, raw_end - raw, unsafe_flags,
+                                     control_format, invalid_format);
+    }
 }
 
 static inline void
@@ -197,6 +418,23 @@ append_unsafe_utf8_as_escaped(GString *escaped_output, const gchar *raw,
                                                         invalid_format);
 }
 
+/* The character-by-character implementation, kept for unit tests and benchmarks. */
+void
+append_unsafe_utf8_as_escaped_scalar(GString *escaped_output, const gchar *raw,
+                                     gssize raw_len, guint32 unsafe_flags,
+                                     const gchar *control_format,
+                                     const gchar *invalid_format)
+{
+  if (raw_len < 0)
+    raw_len = strlen(raw);
+
+  const gchar *raw_end = raw + raw_len;
+
+  while (raw < raw_end)
+    _append_escaped_utf8_character(escaped_output, &raw, raw_end - raw, unsafe_flags,
+                                   control_format, invalid_format);
+}
+
 /**
  * This function escapes an unsanitized input (e.g. that can contain binary
  * characters, and produces an escaped format that can be deescaped in need,
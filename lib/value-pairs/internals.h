@@ -27,6 +27,10 @@
 #include "syslog-ng.h"
 #include "atomic.h"
 
+#define VP_WALK_PLAN_CACHE_SIZE 16
+
+typedef struct _VPWalkPlan VPWalkPlan;
+
 struct _ValuePairs
 {
   GAtomicCounter ref_cnt;
@@ -46,6 +50,10 @@ struct _ValuePairs
    * strings to avoid leaking type information to callers */
   gboolean cast_to_strings;
   gboolean explicit_cast_to_strings;
+
+  /* walk plans, indexed by the hash of the message shape */
+  GMutex walk_plans_lock;
+  VPWalkPlan *walk_plans[VP_WALK_PLAN_CACHE_SIZE];
 };
 
 
@@ -128,6 +128,96 @@ Test(value_pairs_walker, prefix_dat)
   log_msg_unref(msg);
 };
 
+static gboolean
+test_vp_format_obj_start(const gchar *name,
+                         const gchar *prefix, gpointer *prefix_data,
+                         const gchar *prev, gpointer *prev_data,
+                         gpointer user_data)
+{
+  GString *result = (GString *) user_data;
+
+  if (name)
+    g_string_append_printf(result, "%s=", name);
+  g_string_append_c(result, '{');
+  return FALSE;
+}
+
+static gboolean
+test_vp_format_obj_end(const gchar *name,
+                       const gchar *prefix, gpointer *prefix_data,
+                       const gchar *prev, gpointer *prev_data,
+                       gpointer user_data)
+{
+  GString *result = (GString *) user_data;
+
+  g_string_append(result, "}");
+  return FALSE;
+}
+
+static gboolean
+test_vp_format_value(const gchar *name, const gchar *prefix,
+                     LogMessageValueType type, const gchar *value, gsize value_len,
+                     gpointer *prefix_data, gpointer user_data)
+{
+  GString *result = (GString *) user_data;
+
+  g_string_append_printf(result, "%s=%.*s;", name, (gint) value_len, value);
+  return FALSE;
+}
+
+static void
+assert_walk_output(ValuePairs *vp, LogMessage *msg, const gchar *expected)
+{
+  LogTemplateEvalOptions options = {&template_options, LTZ_LOCAL, 0, NULL, LM_VT_STRING};
+  GString *result = g_string_new("");
+
+  value_pairs_walk(vp, test_vp_format_obj_start, test_vp_format_value, test_vp_format_obj_end,
+                   msg, &options, 0, result);
+  cr_assert_str_eq(result->str, expected);
+  g_string_free(result, TRUE);
+}
+
+Test(value_pairs_walker, messages_of_different_shapes)
+{
+  ValuePairs *vp;
+  LogMessage *a, *b;
+
+  log_template_options_init(&template_options, cfg);
+
+  vp = value_pairs_new(cfg);
+  value_pairs_add_glob_pattern(vp, "root.*", TRUE);
+  value_pairs_add_glob_pattern(vp, "top", TRUE);
+
+  a = log_msg_new_empty();
+  log_msg_set_value_by_name(a, "top", "t", -1);
+  log_msg_set_value_by_name(a, "root.x.alma", "1", -1);
+  log_msg_set_value_by_name(a, "root.x.korte", "2", -1);
+  log_msg_set_value_by_name(a, "root.y", "3", -1);
+
+  b = log_msg_new_empty();
+  log_msg_set_value_by_name(b, "root.x.alma", "4", -1);
+  log_msg_set_value_by_name(b, "root.z.szilva", "5", -1);
+
+  /* the same shape is walked again with the cached plan */
+  for (gint i = 0; i < 3; i++)
+    {
+      assert_walk_output(vp, a, "{top=t;root={y=3;x={korte=2;alma=1;}}}");
+      assert_walk_output(vp, b, "{root={z={szilva=5;}x={alma=4;}}}");
+    }
+
+  /* different values, same shape */
+  log_msg_set_value_by_name(a, "root.y", "6", -1);
+  assert_walk_output(vp, a, "{top=t;root={y=6;x={korte=2;alma=1;}}}");
+
+  /* a new name changes the shape */
+  log_msg_set_value_by_name(a, "root.x.banan", "7", -1);
+  assert_walk_output(vp, a, "{top=t;root={y=6;x={korte=2;banan=7;alma=1;}}}");
+  assert_walk_output(vp, b, "{root={z={szilva=5;}x={alma=4;}}}");
+
+  value_pairs_unref(vp);
+  log_msg_unref(a);
+  log_msg_unref(b);
+}
 
 void
 setup(void)
@@ -47,24 +47,92 @@ typedef struct
   LogTemplate *template;
 } VPPairConf;
 
+enum
+{
+  VPR_NVPAIR,
+  VPR_BUILTIN,
+  VPR_PAIR,
+};
+
+/* identifies where a value comes from, the name only depends on this */
+#define VP_RESULT_SOURCE(kind, id) (((guint64) (kind) << 32) + (id))
+
 typedef struct
 {
   /* we don't own any of the fields here, it is assumed that allocations are
    * managed by the caller */
 
-  GString *name;
+  guint64 source;
+  /* the name before applying transformations */
+  const gchar *name;
   GString *value;
   LogMessageValueType type_hint;
 } VPResultValue;
 
 typedef struct
 {
-  GTree *result_tree;
-
-  /* array of VPResultValue instances */
+  /* array of VPResultValue instances, in the order of collection */
   GArray *values;
 } VPResults;
 
+/*
+ * Walk plans
+ *
+ * Messages of the same source tend to carry the same set of name-value
+ * pairs.  The transformed names, their sort order and the nested structure
+ * value_pairs_walk() produces out of them only depend on which values were
+ * collected (the "shape" of the message, see VPResultValue.source), so
+ * these are computed once and reused for all messages of the same shape.
+ *
+ * Plans are immutable once built and are cached in a small direct-mapped
+ * table in ValuePairs, a message of a different shape replaces the plan in
+ * its slot.
+ */
+
+typedef enum
+{
+  VPW_OP_START,
+  VPW_OP_END,
+  VPW_OP_VALUE,
+} VPWalkOpType;
+
+typedef struct
+{
+  VPWalkOpType type;
+  gchar *key;
+  /* VPW_OP_START only */
+  gchar *prefix;
+  /* VPW_OP_VALUE only, index into VPWalkPlan.entries */
+  gint entry;
+} VPWalkOp;
+
+typedef struct
+{
+  /* index into VPResults.values */
+  gint ndx;
+  gchar *name;
+} VPWalkPlanEntry;
+
+struct _VPWalkPlan
+{
+  GAtomicCounter ref_cnt;
+  guint hash;
+  GCompareFunc compare_func;
+  /* 0 if the plan is not used by value_pairs_walk() */
+  gchar key_delimiter;
+
+  guint64 *sources;
+  gint num_sources;
+
+  /* sorted by compare_func, duplicate names removed */
+  VPWalkPlanEntry *entries;
+  gint num_entries;
+
+  /* array of VPWalkOp, replayed by value_pairs_walk() */
+  GArray *ops;
+  gint max_depth;
+};
+
 
 typedef enum
 {
@@ -181,39 +249,112 @@ vp_pair_conf_free(VPPairConf *vpc)
 }
 
 static void
-vp_result_value_init(VPResultValue *rv, GString *name, LogMessageValueType type_hint, GString *value)
+vp_result_value_init(VPResultValue *rv, guint64 source, const gchar *name, LogMessageValueType type_hint,
+                     GString *value)
 {
+  rv->source = source;
   rv->type_hint = type_hint;
   rv->name = name;
   rv->value = value;
 }
 
 static void
-vp_results_init(VPResults *results, GCompareFunc compare_func)
+vp_results_init(VPResults *results)
 {
   results->values = g_array_sized_new(FALSE, FALSE, sizeof(VPResultValue), 16);
-  results->result_tree = g_tree_new_full((GCompareDataFunc) compare_func, NULL,
-                                         NULL, NULL);
 }
 
 static void
 vp_results_deinit(VPResults *results)
 {
-  g_tree_destroy(results->result_tree);
   g_array_free(results->values, TRUE);
 }
 
 static void
-vp_results_insert(VPResults *results, GString *name, LogMessageValueType type_hint, GString *value)
+vp_results_insert(VPResults *results, guint64 source, const gchar *name, LogMessageValueType type_hint,
+                  GString *value)
 {
   VPResultValue *rv;
   gint ndx = results->values->len;
 
   g_array_set_size(results->values, ndx + 1);
   rv = &g_array_index(results->values, VPResultValue, ndx);
-  vp_result_value_init(rv, name, type_hint, value);
-  /* GTree takes over ownership of name */
-  g_tree_insert(results->result_tree, name->str, GINT_TO_POINTER(ndx));
+  vp_result_value_init(rv, source, name, type_hint, value);
+}
+
+static guint
+vp_walk_plan_hash(VPResults *results, GCompareFunc compare_func, gchar key_delimiter)
+{
+  guint hash = g_direct_hash(compare_func) ^ (guchar) key_delimiter;
+
+  for (gint i = 0; i < results->values->len; i++)
+    {
+      guint64 source = g_array_index(results->values, VPResultValue, i).source;
+
+      hash = (hash * 33) ^ (guint) (source ^ (source >> 32));
+    }
+  return hash;
+}
+
+static gboolean
+vp_walk_plan_matches(VPWalkPlan *self, guint hash, VPResults *results,
+                     GCompareFunc compare_func, gchar key_delimiter)
+{
+  if (self->hash != hash ||
+      self->compare_func != compare_func ||
+      self->key_delimiter != key_delimiter ||
+      self->num_sources != results->values->len)
+    return FALSE;
+
+  for (gint i = 0; i < self->num_sources; i++)
+    {
+      if (self->sources[i] != g_array_index(results->values, VPResultValue, i).source)
+        return FALSE;
+    }
+  return TRUE;
+}
+
+static void
+vp_walk_plan_free(VPWalkPlan *self)
+{
+  for (gint i = 0; i < self->num_entries; i++)
+    g_free(self->entries[i].name);
+  g_free(self->entries);
+  g_free(self->sources);
+
+  for (gint i = 0; i < self->ops->len; i++)
+    {
+      VPWalkOp *op = &g_array_index(self->ops, VPWalkOp, i);
+
+      g_free(op->key);
+      g_free(op->prefix);
+    }
+  g_array_free(self->ops, TRUE);
+  g_free(self);
+}
+
+static VPWalkPlan *
+vp_walk_plan_ref(VPWalkPlan *self)
+{
+  g_atomic_counter_inc(&self->ref_cnt);
+  return self;
+}
+
+static void
+vp_walk_plan_unref(VPWalkPlan *self)
+{
+  if (self && g_atomic_counter_dec_and_test(&self->ref_cnt))
+    vp_walk_plan_free(self);
+}
+
+/* to be called whenever the set of names produced by @vp may change */
+static void
+vp_walk_plan_cache_clear(ValuePairs *vp)
+{
+  g_mutex_lock(&vp->walk_plans_lock);
+  for (gint i = 0; i < VP_WALK_PLAN_CACHE_SIZE; i++)
+    g_clear_pointer(&vp->walk_plans[i], vp_walk_plan_unref);
+  g_mutex_unlock(&vp->walk_plans_lock);
 }
 
 static GString *
@@ -239,25 +380,24 @@ vp_transform_apply (ValuePairs *vp, const gchar *key)
 
 /* runs over the name-value pairs requested by the user (e.g. with value_pairs_add_pair) */
 static void
-vp_pairs_foreach(gpointer data, gpointer user_data)
+vp_merge_pairs(ValuePairs *vp, VPResults *results, LogMessage *msg, LogTemplateEvalOptions *options)
 {
-  ValuePairs *vp = ((gpointer *)user_data)[0];
-  LogMessage *msg = ((gpointer *)user_data)[2];
-  LogTemplateEvalOptions *options = ((gpointer *)user_data)[3];
-  VPResults *results = ((gpointer *)user_data)[5];
-  GString *sb = scratch_buffers_alloc();
-  VPPairConf *vpc = (VPPairConf *)data;
-  LogMessageValueType type;
+  for (gint i = 0; i < vp->vpairs->len; i++)
+    {
+      VPPairConf *vpc = (VPPairConf *) g_ptr_array_index(vp->vpairs, i);
+      GString *sb = scratch_buffers_alloc();
+      LogMessageValueType type;
 
-  log_template_append_format_value_and_type((LogTemplate *)vpc->template, msg, options, sb, &type);
+      log_template_append_format_value_and_type((LogTemplate *)vpc->template, msg, options, sb, &type);
 
-  if (vp->omit_empty_values && sb->len == 0)
-    return;
-  if (!vp->include_bytes && (type == LM_VT_BYTES || type == LM_VT_PROTOBUF))
-    return;
-  if (vp->cast_to_strings && vpc->template->explicit_type_hint == LM_VT_NONE)
-    type = LM_VT_STRING;
-  vp_results_insert(results, vp_transform_apply(vp, vpc->name), type, sb);
+      if (vp->omit_empty_values && sb->len == 0)
+        continue;
+      if (!vp->include_bytes && (type == LM_VT_BYTES || type == LM_VT_PROTOBUF))
+        continue;
+      if (vp->cast_to_strings && vpc->template->explicit_type_hint == LM_VT_NONE)
+        type = LM_VT_STRING;
+      vp_results_insert(results, VP_RESULT_SOURCE(VPR_PAIR, i), vpc->name, type, sb);
+    }
 }
 
 /* runs over the LogMessage nv-pairs, and inserts them unless excluded */
@@ -299,7 +439,7 @@ vp_msg_nvpairs_foreach(NVHandle handle, const gchar *name,
   if (vp->cast_to_strings)
     type = LM_VT_STRING;
 
-  vp_results_insert(results, vp_transform_apply(vp, name), type, sb);
+  vp_results_insert(results, VP_RESULT_SOURCE(VPR_NVPAIR, handle), name, type, sb);
 
   return FALSE;
 }
@@ -353,6 +493,7 @@ vp_merge_set(ValuePairs *vp, ValuePairSpec *set)
 static void
 vp_update_builtin_list_of_values(ValuePairs *vp)
 {
+  vp_walk_plan_cache_clear(vp);
   g_ptr_array_set_size(vp->builtins, 0);
 
   if (vp->patterns->len > 0)
@@ -410,52 +551,14 @@ vp_merge_builtins(ValuePairs *vp, VPResults *results, LogMessage *msg, LogTempla
       if (vp->cast_to_strings)
         type = LM_VT_STRING;
 
-      vp_results_insert(results, vp_transform_apply(vp, spec->name), type, sb);
+      vp_results_insert(results, VP_RESULT_SOURCE(VPR_BUILTIN, i), spec->name, type, sb);
     }
 }
 
-static gboolean
-vp_foreach_helper(const gchar *name, gpointer ndx_as_pointer, gpointer data)
+static void
+vp_results_collect(ValuePairs *vp, VPResults *results, LogMessage *msg, LogTemplateEvalOptions *options)
 {
-  VPResults *results = ((gpointer *)data)[0];
-  gint ndx = GPOINTER_TO_INT(ndx_as_pointer);
-  VPResultValue *rv = &g_array_index(results->values, VPResultValue, ndx);
-  VPForeachFunc func = ((gpointer *)data)[1];
-  gpointer user_data = ((gpointer *)data)[2];
-  gboolean *r = ((gpointer *)data)[3];
-
-  gboolean success = !func(name, rv->type_hint,
-                           rv->value->str,
-                           rv->value->len, user_data);
-
-  *r &= success;
-
-  if (!success)
-    {
-      msg_trace("value_pairs_foreach: callback indicates failure",
-                evt_tag_str("name", name),
-                evt_tag_mem("value", rv->value->str, rv->value->len),
-                evt_tag_int("type", rv->type_hint));
-    }
-  return !*r;
-}
-
-
-gboolean
-value_pairs_foreach_sorted (ValuePairs *vp, VPForeachFunc func,
-                            GCompareFunc compare_func,
-                            LogMessage *msg, LogTemplateEvalOptions *options,
-                            gpointer user_data)
-{
-  gpointer args[] = { vp, func, msg, options, user_data, NULL};
-  gboolean result = TRUE;
-  VPResults results;
-  gpointer helper_args[] = { &results, func, user_data, &result };
-  ScratchBuffersMarker mark;
-
-  scratch_buffers_mark(&mark);
-  vp_results_init(&results, compare_func);
-  args[5] = &results;
+  gpointer args[] = { vp, NULL, msg, options, NULL, results };
 
   /*
    * Build up the base set
@@ -464,26 +567,19 @@ value_pairs_foreach_sorted (ValuePairs *vp, VPForeachFunc func,
       vp->patterns->len > 0)
     log_msg_values_foreach(msg, vp_msg_nvpairs_foreach, args);
 
-  vp_merge_builtins(vp, &results, msg, options);
+  vp_merge_builtins(vp, results, msg, options);
 
   /* Merge the explicit key-value pairs too */
-  g_ptr_array_foreach(vp->vpairs, (GFunc)vp_pairs_foreach, args);
-
-  /* Aaand we run it through the callback! */
-  g_tree_foreach(results.result_tree, (GTraverseFunc)vp_foreach_helper, helper_args);
-  vp_results_deinit(&results);
-  scratch_buffers_reclaim_marked(mark);
-
-  return result;
+  vp_merge_pairs(vp, results, msg, options);
 }
 
-gboolean
-value_pairs_foreach(ValuePairs *vp, VPForeachFunc func,
-                    LogMessage *msg, LogTemplateEvalOptions *options,
-                    gpointer user_data)
+static void
+vp_trace_callback_failure(const gchar *name, VPResultValue *rv)
 {
-  return value_pairs_foreach_sorted(vp, func, (GCompareFunc) strcmp,
-                                    msg, options, user_data);
+  msg_trace("value_pairs_foreach: callback indicates failure",
+            evt_tag_str("name", name),
+            evt_tag_mem("value", rv->value->str, rv->value->len),
+            evt_tag_int("type", rv->type_hint));
 }
 
 /*******************************************************************************
@@ -869,10 +965,288 @@ vp_walk_cmp(const gchar *s1, const gchar *s2)
   return strcmp(s2, s1);
 }
 
+/*******************************************************************************
+ * vp_walk_plan (represented by VPWalkPlan)
+ *
+ * Building a plan runs the walker above with callbacks that record the
+ * sequence of start/value/end operations, which is then replayed with the
+ * real callbacks for every message of the same shape.
+ *******************************************************************************/
+
+typedef struct
+{
+  VPWalkPlan *plan;
+  gint entry;
+  gint depth;
+} VPWalkPlanCompiler;
+
+typedef struct
+{
+  const gchar *key;
+  const gchar *prefix;
+  gpointer data;
+} VPWalkFrame;
+
+static gboolean
+vp_walk_plan_record_start(const gchar *name,
+                          const gchar *prefix, gpointer *prefix_data,
+                          const gchar *prev, gpointer *prev_data,
+                          gpointer user_data)
+{
+  VPWalkPlanCompiler *compiler = (VPWalkPlanCompiler *) user_data;
+  VPWalkOp op = { .type = VPW_OP_START, .key = g_strdup(name), .prefix = g_strdup(prefix) };
+
+  g_array_append_val(compiler->plan->ops, op);
+  compiler->depth++;
+  compiler->plan->max_depth = MAX(compiler->plan->max_depth, compiler->depth);
+  return FALSE;
+}
+
+static gboolean
+vp_walk_plan_record_end(const gchar *name,
+                        const gchar *prefix, gpointer *prefix_data,
+                        const gchar *prev, gpointer *prev_data,
+                        gpointer user_data)
+{
+  VPWalkPlanCompiler *compiler = (VPWalkPlanCompiler *) user_data;
+  VPWalkOp op = { .type = VPW_OP_END };
+
+  g_array_append_val(compiler->plan->ops, op);
+  compiler->depth--;
+  return FALSE;
+}
+
+static gboolean
+vp_walk_plan_record_value(const gchar *name, const gchar *prefix,
+                          LogMessageValueType type, const gchar *value, gsize value_len,
+                          gpointer *prefix_data, gpointer user_data)
+{
+  VPWalkPlanCompiler *compiler = (VPWalkPlanCompiler *) user_data;
+  VPWalkOp op = { .type = VPW_OP_VALUE, .key = g_strdup(name), .entry = compiler->entry };
+
+  g_array_append_val(compiler->plan->ops, op);
+  return FALSE;
+}
+
+static void
+vp_walk_plan_compile(VPWalkPlan *self)
+{
+  VPWalkPlanCompiler compiler = { .plan = self };
+  vp_walk_state_t state =
+  {
+    .obj_start = vp_walk_plan_record_start,
+    .obj_end = vp_walk_plan_record_end,
+    .process_value = vp_walk_plan_record_value,
+    .user_data = &compiler,
+    .key_delimiter = self->key_delimiter,
+  };
+
+  vp_stack_init(&state.stack);
+  for (compiler.entry = 0; compiler.entry < self->num_entries; compiler.entry++)
+    value_pairs_walker(self->entries[compiler.entry].name, LM_VT_NONE, NULL, 0, &state);
+  vp_walker_stack_unwind_all_containers(&state);
+  vp_stack_destroy(&state.stack);
+}
+
+static gboolean
+vp_walk_plan_add_entry(gpointer key, gpointer ndx_as_pointer, gpointer user_data)
+{
+  VPWalkPlan *self = (VPWalkPlan *) user_data;
+  VPWalkPlanEntry *entry = &self->entries[self->num_entries++];
+
+  entry->ndx = GPOINTER_TO_INT(ndx_as_pointer);
+  entry->name = g_strdup((const gchar *) key);
+  return FALSE;
+}
+
+static VPWalkPlan *
+vp_walk_plan_new(ValuePairs *vp, VPResults *results, guint hash,
+                 GCompareFunc compare_func, gchar key_delimiter)
+{
+  VPWalkPlan *self = g_new0(VPWalkPlan, 1);
+  GTree *tree = g_tree_new(compare_func);
+  gchar **names = g_new(gchar *, results->values->len);
+
+  g_atomic_counter_set(&self->ref_cnt, 1);
+  self->hash = hash;
+  self->compare_func = compare_func;
+  self->key_delimiter = key_delimiter;
+  self->num_sources = results->values->len;
+  self->sources = g_new(guint64, self->num_sources);
+  self->ops = g_array_new(FALSE, FALSE, sizeof(VPWalkOp));
+
+  /* the tree keeps the last value for duplicate names, like it always did */
+  for (gint i = 0; i < self->num_sources; i++)
+    {
+      VPResultValue *rv = &g_array_index(results->values, VPResultValue, i);
+
+      self->sources[i] = rv->source;
+      names[i] = g_strdup(vp_transform_apply(vp, rv->name)->str);
+      g_tree_insert(tree, names[i], GINT_TO_POINTER(i));
+    }
+
+  self->entries = g_new(VPWalkPlanEntry, g_tree_nnodes(tree));
+  g_tree_foreach(tree, vp_walk_plan_add_entry, self);
+  g_tree_destroy(tree);
+
+  for (gint i = 0; i < self->num_sources; i++)
+    g_free(names[i]);
+  g_free(names);
+
+  if (key_delimiter)
+    vp_walk_plan_compile(self);
+  return self;
+}
+
+/* returns a reference to the plan for the shape of @results */
+static VPWalkPlan *
+vp_walk_plan_lookup(ValuePairs *vp, VPResults *results, GCompareFunc compare_func, gchar key_delimiter)
+{
+  guint hash = vp_walk_plan_hash(results, compare_func, key_delimiter);
+  VPWalkPlan **slot = &vp->walk_plans[hash % VP_WALK_PLAN_CACHE_SIZE];
+  VPWalkPlan *plan = NULL;
+
+  g_mutex_lock(&vp->walk_plans_lock);
+  if (*slot && vp_walk_plan_matches(*slot, hash, results, compare_func, key_delimiter))
+    plan = vp_walk_plan_ref(*slot);
+  g_mutex_unlock(&vp->walk_plans_lock);
+
+  if (plan)
+    return plan;
+
+  plan = vp_walk_plan_new(vp, results, hash, compare_func, key_delimiter);
+
+  g_mutex_lock(&vp->walk_plans_lock);
+  vp_walk_plan_unref(*slot);
+  *slot = vp_walk_plan_ref(plan);
+  g_mutex_unlock(&vp->walk_plans_lock);
+
+  return plan;
+}
+
+static gboolean
+vp_walk_plan_foreach(VPWalkPlan *self, VPResults *results, VPForeachFunc func, gpointer user_data)
+{
+  for (gint i = 0; i < self->num_entries; i++)
+    {
+      VPWalkPlanEntry *entry = &self->entries[i];
+      VPResultValue *rv = &g_array_index(results->values, VPResultValue, entry->ndx);
+
+      if (func(entry->name, rv->type_hint, rv->value->str, rv->value->len, user_data))
+        {
+          vp_trace_callback_failure(entry->name, rv);
+          return FALSE;
+        }
+    }
+  return TRUE;
+}
+
+static void
+vp_walk_plan_end_frame(vp_walk_state_t *state, VPWalkFrame *frames, gint *depth)
+{
+  VPWalkFrame *frame = &frames[--(*depth)];
+  VPWalkFrame *parent = *depth > 0 ? &frames[*depth - 1] : NULL;
+
+  state->obj_end(frame->key, frame->prefix, &frame->data,
+                 parent ? parent->prefix : NULL, parent ? &parent->data : NULL,
+                 state->user_data);
+}
+
+static gboolean
+vp_walk_plan_run(VPWalkPlan *self, VPResults *results, vp_walk_state_t *state)
+{
+  VPWalkFrame *frames = g_newa(VPWalkFrame, self->max_depth + 1);
+  gboolean result = TRUE;
+  gint depth = 0;
+
+  for (gint i = 0; i < self->ops->len && result; i++)
+    {
+      VPWalkOp *op = &g_array_index(self->ops, VPWalkOp, i);
+      VPWalkFrame *parent = depth > 0 ? &frames[depth - 1] : NULL;
+
+      switch (op->type)
+        {
+        case VPW_OP_START:
+        {
+          VPWalkFrame *frame = &frames[depth++];
+
+          frame->key = op->key;
+          frame->prefix = op->prefix;
+          frame->data = NULL;
+          state->obj_start(frame->key, frame->prefix, &frame->data,
+                           parent ? parent->prefix : NULL, parent ? &parent->data : NULL,
+                           state->user_data);
+          break;
+        }
+        case VPW_OP_END:
+          vp_walk_plan_end_frame(state, frames, &depth);
+          break;
+        case VPW_OP_VALUE:
+        {
+          VPWalkPlanEntry *entry = &self->entries[op->entry];
+          VPResultValue *rv = &g_array_index(results->values, VPResultValue, entry->ndx);
+
+          if (state->process_value(op->key, parent ? parent->prefix : NULL,
+                                   rv->type_hint, rv->value->str, rv->value->len,
+                                   parent ? &parent->data : NULL,
+                                   state->user_data))
+            {
+              vp_trace_callback_failure(entry->name, rv);
+              result = FALSE;
+            }
+          break;
+        }
+        default:
+          g_assert_not_reached();
+        }
+    }
+
+  /* close the containers left open by a failing callback */
+  while (depth > 0)
+    vp_walk_plan_end_frame(state, frames, &depth);
+
+  return result;
+}
+
 /*******************************************************************************
  * Public API
  *******************************************************************************/
 
+gboolean
+value_pairs_foreach_sorted (ValuePairs *vp, VPForeachFunc func,
+                            GCompareFunc compare_func,
+                            LogMessage *msg, LogTemplateEvalOptions *options,
+                            gpointer user_data)
+{
+  gboolean result;
+  VPResults results;
+  ScratchBuffersMarker mark;
+
+  scratch_buffers_mark(&mark);
+  vp_results_init(&results);
+  vp_results_collect(vp, &results, msg, options);
+
+  VPWalkPlan *plan = vp_walk_plan_lookup(vp, &results, compare_func, 0);
+
+  /* Aaand we run it through the callback! */
+  result = vp_walk_plan_foreach(plan, &results, func, user_data);
+
+  vp_walk_plan_unref(plan);
+  vp_results_deinit(&results);
+  scratch_buffers_reclaim_marked(mark);
+
+  return result;
+}
+
+gboolean
+value_pairs_foreach(ValuePairs *vp, VPForeachFunc func,
+                    LogMessage *msg, LogTemplateEvalOptions *options,
+                    gpointer user_data)
+{
+  return value_pairs_foreach_sorted(vp, func, (GCompareFunc) strcmp,
+                                    msg, options, user_data);
+}
+
 gboolean
 value_pairs_walk(ValuePairs *vp,
                  VPWalkCallbackFunc obj_start_func,
@@ -883,21 +1257,29 @@ value_pairs_walk(ValuePairs *vp,
 {
   vp_walk_state_t state;
   gboolean result;
+  VPResults results;
+  ScratchBuffersMarker mark;
 
   state.user_data = user_data;
   state.obj_start = obj_start_func;
   state.obj_end = obj_end_func;
   state.process_value = process_value_func;
   state.key_delimiter = key_delimiter ? : '.';
-  vp_stack_init(&state.stack);
 
   state.obj_start(NULL, NULL, NULL, NULL, NULL, user_data);
-  result = value_pairs_foreach_sorted(vp, value_pairs_walker,
-                                      (GCompareFunc)vp_walk_cmp, msg,
-                                      options, &state);
-  vp_walker_stack_unwind_all_containers(&state);
+
+  scratch_buffers_mark(&mark);
+  vp_results_init(&results);
+  vp_results_collect(vp, &results, msg, options);
+
+  VPWalkPlan *plan = vp_walk_plan_lookup(vp, &results, (GCompareFunc) vp_walk_cmp, state.key_delimiter);
+  result = vp_walk_plan_run(plan, &results, &state);
+
+  vp_walk_plan_unref(plan);
+  vp_results_deinit(&results);
+  scratch_buffers_reclaim_marked(mark);
+
   state.obj_end(NULL, NULL, NULL, NULL, NULL, user_data);
-  vp_stack_destroy(&state.stack);
 
   return result;
 }
@@ -996,6 +1378,7 @@ value_pairs_new(GlobalConfig *cfg)
   vp->patterns = g_ptr_array_new();
   vp->transforms = g_ptr_array_new();
   vp->cfg = cfg;
+  g_mutex_init(&vp->walk_plans_lock);
 
   if (cfg_is_config_version_older(cfg, VERSION_VALUE_4_0))
     {
@@ -1045,6 +1428,8 @@ value_pairs_free (ValuePairs *vp)
     }
   g_ptr_array_free(vp->transforms, TRUE);
   g_ptr_array_free(vp->builtins, TRUE);
+  vp_walk_plan_cache_clear(vp);
+  g_mutex_clear(&vp->walk_plans_lock);
   g_free(vp);
 }
 
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "file-follow-inotify.h"
+#include "messages.h"
+#include "mainloop.h"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <iv.h>
+#include <iv_list.h>
+
+/* truncation and removal are reported as IN_MODIFY and IN_ATTRIB respectively */
+#define FILE_FOLLOW_INOTIFY_MASK (IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+
+/* callbacks run in one go, the rest is left to the next iteration of the main loop */
+#define FILE_FOLLOW_INOTIFY_MAX_CALLBACKS_PER_RUN 1024
+
+struct _FileFollowInotifyWatch
+{
+  gint wd;
+  gboolean waiting;
+  struct iv_list_head ready_list;
+
+  FileFollowInotifyCallback callback;
+  gpointer user_data;
+};
+
+/* shared by all watches, lives as long as there are watches */
+static struct
+{
+  struct iv_fd fd;
+  /* wd -> GList of watches, the same file may be followed more than once */
+  GHashTable *watches;
+  gint num_watches;
+
+  struct iv_list_head ready_list;
+  gint num_ready;
+  struct iv_task ready_task;
+
+  gboolean watch_limit_reported;
+} notifier;
+
+static void
+_unlink_ready(FileFollowInotifyWatch *self)
+{
+  if (iv_list_empty(&self->ready_list))
+    return;
+
+  iv_list_del_init(&self->ready_list);
+  notifier.num_ready--;
+}
+
+static void
+_link_ready(FileFollowInotifyWatch *self)
+{
+  if (!iv_list_empty(&self->ready_list))
+    return;
+
+  iv_list_add_tail(&self->ready_list, &notifier.ready_list);
+  notifier.num_ready++;
+
+  if (!iv_task_registered(&notifier.ready_task))
+    iv_task_register(&notifier.ready_task);
+}
+
+static void
+_run_ready_list(gpointer s)
+{
+  /* watches rescheduled by their callbacks are only run in the next round */
+  gint budget = MIN(notifier.num_ready, FILE_FOLLOW_INOTIFY_MAX_CALLBACKS_PER_RUN);
+
+  while (budget-- > 0 && notifier.num_ready > 0)
+    {
+      FileFollowInotifyWatch *watch = iv_list_entry(notifier.ready_list.next, FileFollowInotifyWatch, ready_list);
+
+      _unlink_ready(watch);
+      /* may free the watch */
+      watch->callback(watch->user_data);
+    }
+
+  if (notifier.num_ready > 0 && !iv_task_registered(&notifier.ready_task))
+    iv_task_register(&notifier.ready_task);
+}
+
+static void
+_wake_up_all(void)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init(&iter, notifier.watches);
+  while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+      for (GList *l = value; l; l = l->next)
+        file_follow_inotify_watch_wake_up(l->data);
+    }
+}
+
+static void
+_handle_event(struct inotify_event *event)
+{
+  if (event->mask & IN_Q_OVERFLOW)
+    {
+      msg_debug("file-follow-inotify: event queue overflow, checking all followed files");
+      _wake_up_all();
+      return;
+    }
+
+  GList *watches = g_hash_table_lookup(notifier.watches, GINT_TO_POINTER(event->wd));
+  for (GList *l = watches; l; l = l->next)
+    file_follow_inotify_watch_wake_up(l->data);
+
+  if (event->mask & IN_IGNORED)
+    {
+      /* the kernel dropped the watch (file removed, filesystem unmounted) */
+      for (GList *l = watches; l; l = l->next)
+        ((FileFollowInotifyWatch *) l->data)->wd = -1;
+
+      g_hash_table_remove(notifier.watches, GINT_TO_POINTER(event->wd));
+      g_list_free(watches);
+    }
+}
+
+static void
+_read_events(gpointer s)
+{
+  gchar buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+  while (TRUE)
+    {
+      gssize len = read(notifier.fd.fd, buffer, sizeof(buffer));
+
+      if (len < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          if (errno != EAGAIN)
+            msg_error("file-follow-inotify: error reading inotify events",
+                      evt_tag_error("error"));
+          return;
+        }
+
+      for (gchar *p = buffer; p < buffer + len;)
+        {
+          struct inotify_event *event = (struct inotify_event *) p;
+
+          _handle_event(event);
+          p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+static gboolean
+_start_notifier(void)
+{
+  gint fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0)
+    {
+      msg_warning("file-follow-inotify: could not create inotify object, falling back to polling followed files, "
+                  "you may need to increase /proc/sys/fs/inotify/max_user_instances",
+                  evt_tag_error("error"));
+      return FALSE;
+    }
+
+  IV_FD_INIT(&notifier.fd);
+  notifier.fd.fd = fd;
+  notifier.fd.handler_in = _read_events;
+  iv_fd_register(&notifier.fd);
+
+  notifier.watches = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  INIT_IV_LIST_HEAD(&notifier.ready_list);
+  notifier.num_ready = 0;
+  IV_TASK_INIT(&notifier.ready_task);
+  notifier.ready_task.handler = _run_ready_list;
+
+  return TRUE;
+}
+
+static void
+_stop_notifier(void)
+{
+  g_assert(g_hash_table_size(notifier.watches) == 0 && notifier.num_ready == 0);
+
+  if (iv_task_registered(&notifier.ready_task))
+    iv_task_unregister(&notifier.ready_task);
+
+  g_hash_table_destroy(notifier.watches);
+  notifier.watches = NULL;
+
+  iv_fd_unregister(&notifier.fd);
+  close(notifier.fd.fd);
+}
+
+static void
+_report_add_watch_error(const gchar *filename)
+{
+  if (errno == ENOENT)
+    {
+      msg_debug("file-follow-inotify: followed file does not exist, polling it",
+                evt_tag_str("filename", filename));
+      return;
+    }
+
+  if (errno == ENOSPC)
+    {
+      if (notifier.watch_limit_reported)
+        return;
+
+      notifier.watch_limit_reported = TRUE;
+      msg_warning("file-follow-inotify: inotify watch limit reached, polling the files above the limit, "
+                  "you may need to increase /proc/sys/fs/inotify/max_user_watches",
+                  evt_tag_str("filename", filename),
+                  evt_tag_int("watches", notifier.num_watches));
+      return;
+    }
+
+  msg_warning("file-follow-inotify: could not add inotify watch, polling the file instead",
+              evt_tag_str("filename", filename),
+              evt_tag_error("error"));
+}
+
+static void
+_remove_inotify_watch(FileFollowInotifyWatch *self)
+{
+  GList *watches = g_hash_table_lookup(notifier.watches, GINT_TO_POINTER(self->wd));
+
+  watches = g_list_remove(watches, self);
+  if (watches)
+    {
+      g_hash_table_insert(notifier.watches, GINT_TO_POINTER(self->wd), watches);
+    }
+  else
+    {
+      g_hash_table_remove(notifier.watches, GINT_TO_POINTER(self->wd));
+      inotify_rm_watch(notifier.fd.fd, self->wd);
+    }
+  self->wd = -1;
+}
+
+gboolean
+file_follow_inotify_watch_wait_for_changes(FileFollowInotifyWatch *self)
+{
+  if (self->wd < 0)
+    return FALSE;
+
+  _unlink_ready(self);
+  self->waiting = TRUE;
+  return TRUE;
+}
+
+void
+file_follow_inotify_watch_schedule(FileFollowInotifyWatch *self)
+{
+  self->waiting = FALSE;
+  _link_ready(self);
+}
+
+/* schedules the callback, as if the file was changed */
+void
+file_follow_inotify_watch_wake_up(FileFollowInotifyWatch *self)
+{
+  if (self->waiting)
+    file_follow_inotify_watch_schedule(self);
+}
+
+void
+file_follow_inotify_watch_cancel(FileFollowInotifyWatch *self)
+{
+  self->waiting = FALSE;
+  _unlink_ready(self);
+}
+
+FileFollowInotifyWatch *
+file_follow_inotify_watch_new(const gchar *filename, FileFollowInotifyCallback callback, gpointer user_data)
+{
+  main_loop_assert_main_thread();
+
+  if (notifier.num_watches == 0 && !_start_notifier())
+    return NULL;
+
+  gint wd = inotify_add_watch(notifier.fd.fd, filename, FILE_FOLLOW_INOTIFY_MASK);
+  if (wd < 0)
+    {
+      _report_add_watch_error(filename);
+      if (notifier.num_watches == 0)
+        _stop_notifier();
+      return NULL;
+    }
+
+  FileFollowInotifyWatch *self = g_new0(FileFollowInotifyWatch, 1);
+  self->wd = wd;
+  self->callback = callback;
+  self->user_data = user_data;
+  INIT_IV_LIST_HEAD(&self->ready_list);
+
+  GList *watches = g_hash_table_lookup(notifier.watches, GINT_TO_POINTER(wd));
+  g_hash_table_insert(notifier.watches, GINT_TO_POINTER(wd), g_list_prepend(watches, self));
+  notifier.num_watches++;
+
+  return self;
+}
+
+void
+file_follow_inotify_watch_free(FileFollowInotifyWatch *self)
+{
+  file_follow_inotify_watch_cancel(self);
+  if (self->wd >= 0)
+    _remove_inotify_watch(self);
+  g_free(self);
+
+  if (--notifier.num_watches == 0)
+    _stop_notifier();
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#ifndef MODULES_AFFILE_FILE_FOLLOW_INOTIFY_H_
+#define MODULES_AFFILE_FILE_FOLLOW_INOTIFY_H_
+
+#include "syslog-ng.h"
+
+/*
+ * Event driven following of files, an alternative of polling them with
+ * follow-freq() timers.
+ *
+ * All watches share a single inotify instance.  A watch either waits for
+ * the file to change (file_follow_inotify_watch_wait_for_changes()) or is
+ * put on a ready list (file_follow_inotify_watch_schedule()), which is
+ * processed in a round-robin fashion, invoking the callback of each ready
+ * watch once per round.  The callback is expected to do a bounded amount
+ * of work (e.g. one fetch of a LogReader) and then either reschedule the
+ * watch or wait for changes again, so that busy files cannot starve the
+ * others.
+ *
+ * file_follow_inotify_watch_new() returns NULL and
+ * file_follow_inotify_watch_wait_for_changes() returns FALSE if the file
+ * cannot be watched, callers are expected to fall back to polling.
+ *
+ * Must be used from the main thread.
+ */
+typedef struct _FileFollowInotifyWatch FileFollowInotifyWatch;
+typedef void (*FileFollowInotifyCallback)(gpointer user_data);
+
+FileFollowInotifyWatch *file_follow_inotify_watch_new(const gchar *filename, FileFollowInotifyCallback callback,
+                                                      gpointer user_data);
+void file_follow_inotify_watch_free(FileFollowInotifyWatch *self);
+
+gboolean file_follow_inotify_watch_wait_for_changes(FileFollowInotifyWatch *self);
+void file_follow_inotify_watch_schedule(FileFollowInotifyWatch *self);
+void file_follow_inotify_watch_wake_up(FileFollowInotifyWatch *self);
+void file_follow_inotify_watch_cancel(FileFollowInotifyWatch *self);
+
+#endif /* MODULES_AFFILE_FILE_FOLLOW_INOTIFY_H_ */
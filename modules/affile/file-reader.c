@@ -99,12 +99,20 @@ _construct_poll_events(FileReader *self, gint fd)
   if (self->options->follow_freq > 0)
     {
       LogProtoFileReaderOptions *proto_opts = file_reader_options_get_log_proto_options(self->options);
+      PollEvents *poll_events;
 
       if (proto_opts->multi_line_options.mode == MLM_NONE)
-        return poll_file_changes_new(fd, self->filename->str, self->options->follow_freq, &self->super);
+        poll_events = poll_file_changes_new(fd, self->filename->str, self->options->follow_freq, &self->super);
       else
-        return poll_multiline_file_changes_new(fd, self->filename->str, self->options->follow_freq,
-                                               self->options->multi_line_timeout, self);
+        poll_events = poll_multiline_file_changes_new(fd, self->filename->str, self->options->follow_freq,
+                                                      self->options->multi_line_timeout, self);
+
+      /* multi-line-timeout() relies on being polled at EOF */
+      if (self->options->follow_with_inotify &&
+          (proto_opts->multi_line_options.mode == MLM_NONE || !self->options->multi_line_timeout))
+        poll_file_changes_follow_with_inotify(poll_events);
+
+      return poll_events;
     }
   else if (fd >= 0 && _is_fd_pollable(fd))
     return poll_fd_events_new(fd);
@@ -379,6 +387,7 @@ file_reader_options_defaults(FileReaderOptions *options)
   log_proto_file_reader_options_defaults(file_reader_options_get_log_proto_options(options));
   options->reader_options.parse_options.flags |= LP_LOCAL;
   options->restore_state = FALSE;
+  options->follow_with_inotify = FALSE;
 }
 
 static gboolean
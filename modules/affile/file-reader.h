@@ -31,6 +31,8 @@ typedef struct _FileReaderOptions
   gint follow_freq;
   gint multi_line_timeout;
   gboolean restore_state;
+  /* follow files based on inotify events, follow_freq is only a fallback */
+  gboolean follow_with_inotify;
   LogReaderOptions reader_options;
 } FileReaderOptions;
 
@@ -166,6 +166,11 @@ poll_file_changes_stop_watches(PollEvents *s)
 
   if (iv_timer_registered(&self->follow_timer))
     iv_timer_unregister(&self->follow_timer);
+
+#if SYSLOG_NG_HAVE_INOTIFY
+  if (self->inotify_watch)
+    file_follow_inotify_watch_cancel(self->inotify_watch);
+#endif
 }
 
 static void
@@ -177,6 +182,35 @@ poll_file_changes_rearm_timer(PollFileChanges *self, glong delay)
   iv_timer_register(&self->follow_timer);
 }
 
+/* at EOF: check the file again once it is changed, or after follow_freq if
+ * there are no change notifications */
+static void
+poll_file_changes_wait_for_changes(PollFileChanges *self)
+{
+#if SYSLOG_NG_HAVE_INOTIFY
+  if (self->inotify_watch && file_follow_inotify_watch_wait_for_changes(self->inotify_watch))
+    return;
+#endif
+
+  poll_file_changes_rearm_timer(self, self->follow_freq);
+}
+
+/* there is more to read, continue as soon as possible */
+static void
+poll_file_changes_continue_reading(PollFileChanges *self)
+{
+#if SYSLOG_NG_HAVE_INOTIFY
+  if (self->inotify_watch)
+    {
+      /* round-robin with the other files having data */
+      file_follow_inotify_watch_schedule(self->inotify_watch);
+      return;
+    }
+#endif
+
+  poll_file_changes_rearm_timer(self, 0);
+}
+
 static gboolean
 poll_file_changes_check_eof(PollFileChanges *self)
 {
@@ -218,13 +252,13 @@ poll_file_changes_update_watches(PollEvents *s, GIOCondition cond)
       msg_trace("End of file, following file",
                 evt_tag_str("follow_filename", self->follow_filename));
       if (poll_file_changes_on_eof(self))
-        poll_file_changes_rearm_timer(self, self->follow_freq);
+        poll_file_changes_wait_for_changes(self);
     }
   else
     {
       msg_trace("File exists and contains data",
                 evt_tag_str("follow_filename", self->follow_filename));
-      poll_file_changes_rearm_timer(self, 0);
+      poll_file_changes_continue_reading(self);
     }
 }
 
@@ -234,6 +268,31 @@ poll_file_changes_stop_on_eof(PollEvents *s)
   PollFileChanges *self = (PollFileChanges *) s;
 
   self->stop_on_eof = TRUE;
+
+#if SYSLOG_NG_HAVE_INOTIFY
+  /* the file may not change anymore, check whether we are at EOF already */
+  if (self->inotify_watch)
+    file_follow_inotify_watch_wake_up(self->inotify_watch);
+#endif
+}
+
+/* Follow the file based on inotify events instead of polling it every
+ * follow_freq.  Returns FALSE if the file cannot be watched, in which case
+ * it is polled as usual. */
+gboolean
+poll_file_changes_follow_with_inotify(PollEvents *s)
+{
+#if SYSLOG_NG_HAVE_INOTIFY
+  PollFileChanges *self = (PollFileChanges *) s;
+
+  if (!self->follow_filename || self->inotify_watch)
+    return self->inotify_watch != NULL;
+
+  self->inotify_watch = file_follow_inotify_watch_new(self->follow_filename, poll_file_changes_check_file, self);
+  return self->inotify_watch != NULL;
+#else
+  return FALSE;
+#endif
 }
 
 void
@@ -241,6 +300,10 @@ poll_file_changes_free(PollEvents *s)
 {
   PollFileChanges *self = (PollFileChanges *) s;
 
+#if SYSLOG_NG_HAVE_INOTIFY
+  if (self->inotify_watch)
+    file_follow_inotify_watch_free(self->inotify_watch);
+#endif
   log_pipe_unref(self->control);
   g_free(self->follow_filename);
 }
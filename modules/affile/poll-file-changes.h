@@ -30,6 +30,10 @@
 
 #include <iv.h>
 
+#if SYSLOG_NG_HAVE_INOTIFY
+#include "file-follow-inotify.h"
+#endif
+
 typedef struct _PollFileChanges PollFileChanges;
 
 struct _PollFileChanges
@@ -39,6 +43,9 @@ struct _PollFileChanges
   gchar *follow_filename;
   gint follow_freq;
   struct iv_timer follow_timer;
+#if SYSLOG_NG_HAVE_INOTIFY
+  FileFollowInotifyWatch *inotify_watch;
+#endif
   LogPipe *control;
 
   gboolean stop_on_eof;
@@ -54,6 +61,7 @@ void poll_file_changes_init_instance(PollFileChanges *self, gint fd, const gchar
 void poll_file_changes_update_watches(PollEvents *s, GIOCondition cond);
 void poll_file_changes_stop_watches(PollEvents *s);
 void poll_file_changes_stop_on_eof(PollEvents *s);
+gboolean poll_file_changes_follow_with_inotify(PollEvents *s);
 void poll_file_changes_free(PollEvents *s);
 
 #endif
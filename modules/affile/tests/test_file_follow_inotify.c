@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "file-follow-inotify.h"
+#include "apphook.h"
+#include "timeutils/misc.h"
+
+#include <glib/gstdio.h>
+#include <iv.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define NUM_FILES 3
+#define NUM_ROUNDS 3
+
+typedef struct
+{
+  FileFollowInotifyWatch *watch;
+  gint index;
+  gint num_calls;
+  GString *order;
+} TestFollower;
+
+static gchar *tmpdir;
+static struct iv_timer timeout_timer;
+static gboolean timed_out;
+
+static void
+_timeout(gpointer user_data)
+{
+  timed_out = TRUE;
+  iv_quit();
+}
+
+static void
+_run_main_loop(glong timeout_msec)
+{
+  timed_out = FALSE;
+
+  IV_TIMER_INIT(&timeout_timer);
+  timeout_timer.handler = _timeout;
+  iv_validate_now();
+  timeout_timer.expires = iv_now;
+  timespec_add_msec(&timeout_timer.expires, timeout_msec);
+  iv_timer_register(&timeout_timer);
+
+  iv_main();
+
+  if (iv_timer_registered(&timeout_timer))
+    iv_timer_unregister(&timeout_timer);
+}
+
+static gchar *
+_create_file(const gchar *name)
+{
+  gchar *filename = g_build_filename(tmpdir, name, NULL);
+  cr_assert(g_file_set_contents(filename, "", 0, NULL));
+  return filename;
+}
+
+static void
+_append_line(const gchar *filename)
+{
+  FILE *f = fopen(filename, "a");
+  cr_assert_not_null(f);
+  fputs("new line\n", f);
+  fclose(f);
+}
+
+static void
+_quit_on_first_call(gpointer user_data)
+{
+  TestFollower *follower = user_data;
+
+  follower->num_calls++;
+  iv_quit();
+}
+
+static void
+_reschedule_until_all_rounds_done(gpointer user_data)
+{
+  TestFollower *follower = user_data;
+
+  follower->num_calls++;
+  g_string_append_printf(follower->order, "%d", follower->index);
+
+  if (follower->order->len == NUM_FILES * NUM_ROUNDS)
+    iv_quit();
+  else if (follower->num_calls < NUM_ROUNDS)
+    file_follow_inotify_watch_schedule(follower->watch);
+}
+
+Test(file_follow_inotify, modification_wakes_up_waiting_watch)
+{
+  gchar *filename = _create_file("modified.log");
+  TestFollower follower = {0};
+
+  follower.watch = file_follow_inotify_watch_new(filename, _quit_on_first_call, &follower);
+  cr_assert_not_null(follower.watch);
+  cr_assert(file_follow_inotify_watch_wait_for_changes(follower.watch));
+
+  _append_line(filename);
+  _run_main_loop(5000);
+
+  cr_assert_not(timed_out, "no notification arrived for the modified file");
+  cr_assert_eq(follower.num_calls, 1);
+
+  file_follow_inotify_watch_free(follower.watch);
+  g_unlink(filename);
+  g_free(filename);
+}
+
+Test(file_follow_inotify, changes_are_ignored_unless_waiting)
+{
+  gchar *filename = _create_file("not-waiting.log");
+  TestFollower follower = {0};
+
+  follower.watch = file_follow_inotify_watch_new(filename, _quit_on_first_call, &follower);
+  cr_assert_not_null(follower.watch);
+
+  _append_line(filename);
+  _run_main_loop(200);
+
+  cr_assert(timed_out);
+  cr_assert_eq(follower.num_calls, 0);
+
+  file_follow_inotify_watch_free(follower.watch);
+  g_unlink(filename);
+  g_free(filename);
+}
+
+Test(file_follow_inotify, cancelled_watch_is_not_called)
+{
+  gchar *filename = _create_file("cancelled.log");
+  TestFollower follower = {0};
+
+  follower.watch = file_follow_inotify_watch_new(filename, _quit_on_first_call, &follower);
+  cr_assert_not_null(follower.watch);
+
+  file_follow_inotify_watch_schedule(follower.watch);
+  file_follow_inotify_watch_cancel(follower.watch);
+  _run_main_loop(200);
+
+  cr_assert(timed_out);
+  cr_assert_eq(follower.num_calls, 0);
+
+  file_follow_inotify_watch_free(follower.watch);
+  g_unlink(filename);
+  g_free(filename);
+}
+
+Test(file_follow_inotify, ready_watches_are_run_in_round_robin)
+{
+  TestFollower followers[NUM_FILES] = {0};
+  gchar *filenames[NUM_FILES];
+  GString *order = g_string_new("");
+
+  for (gint i = 0; i < NUM_FILES; i++)
+    {
+      gchar *name = g_strdup_printf("busy-%d.log", i);
+      filenames[i] = _create_file(name);
+      g_free(name);
+
+      followers[i].index = i;
+      followers[i].order = order;
+      followers[i].watch = file_follow_inotify_watch_new(filenames[i], _reschedule_until_all_rounds_done, &followers[i]);
+      cr_assert_not_null(followers[i].watch);
+    }
+
+  for (gint i = 0; i < NUM_FILES; i++)
+    file_follow_inotify_watch_schedule(followers[i].watch);
+
+  _run_main_loop(5000);
+
+  cr_assert_not(timed_out);
+  cr_assert_str_eq(order->str, "012012012");
+
+  for (gint i = 0; i < NUM_FILES; i++)
+    {
+      file_follow_inotify_watch_free(followers[i].watch);
+      g_unlink(filenames[i]);
+      g_free(filenames[i]);
+    }
+  g_string_free(order, TRUE);
+}
+
+Test(file_follow_inotify, missing_file_cannot_be_watched)
+{
+  gchar *filename = g_build_filename(tmpdir, "missing.log", NULL);
+
+  cr_assert_null(file_follow_inotify_watch_new(filename, _quit_on_first_call, NULL));
+
+  g_free(filename);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  tmpdir = g_mkdtemp(g_strdup("test_file_follow_inotifyXXXXXX"));
+  cr_assert_not_null(tmpdir);
+}
+
+static void
+teardown(void)
+{
+  g_rmdir(tmpdir);
+  g_free(tmpdir);
+  app_shutdown();
+}
+
+TestSuite(file_follow_inotify, .init = setup, .fini = teardown);
@@ -368,6 +368,12 @@ _init(LogPipe *s)
 
   _init_opener_options(self, cfg);
 
+#if SYSLOG_NG_HAVE_INOTIFY
+  /* files are followed the same way as directories are monitored */
+  self->file_reader_options.follow_with_inotify = (self->monitor_method == MM_AUTO
+                                                   || self->monitor_method == MM_INOTIFY);
+#endif
+
   if (!_add_directory_monitor(self, self->base_dir))
     return FALSE;
 
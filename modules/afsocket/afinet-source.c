@@ -62,6 +62,14 @@ afinet_sd_set_tls_context(LogDriver *s, TLSContext *tls_context)
   transport_mapper_inet_set_tls_context((TransportMapperInet *) self->super.transport_mapper, tls_context);
 }
 
+void
+afinet_sd_set_udp_receive_batch_size(LogDriver *s, gint batch_size)
+{
+  AFInetSourceDriver *self = (AFInetSourceDriver *) s;
+
+  transport_mapper_inet_set_udp_receive_batch_size((TransportMapperInet *) self->super.transport_mapper, batch_size);
+}
+
 static gboolean
 afinet_sd_setup_addresses(AFSocketSourceDriver *s)
 {
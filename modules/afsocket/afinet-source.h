@@ -37,6 +37,7 @@ typedef struct _AFInetSourceDriver
 } AFInetSourceDriver;
 
 void afinet_sd_set_tls_context(LogDriver *s, TLSContext *tls_context);
+void afinet_sd_set_udp_receive_batch_size(LogDriver *s, gint batch_size);
 
 AFInetSourceDriver *afinet_sd_new_tcp(GlobalConfig *cfg);
 AFInetSourceDriver *afinet_sd_new_tcp6(GlobalConfig *cfg);
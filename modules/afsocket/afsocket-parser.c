@@ -85,6 +85,7 @@ static CfgLexerKeyword afsocket_keywords[] =
   { "so_sndbuf",          KW_SO_SNDBUF },
   { "so_keepalive",       KW_SO_KEEPALIVE },
   { "so_reuseport",       KW_SO_REUSEPORT },
+  { "udp_receive_batch_size", KW_UDP_RECEIVE_BATCH_SIZE },
   { "tcp_keep_alive",     KW_SO_KEEPALIVE }, /* old, once deprecated form, but revived in 3.4 */
   { "tcp_keepalive",      KW_SO_KEEPALIVE }, /* alias for so-keepalive, as tcp is the only option actually using it */
   { "tcp_keepalive_time", KW_TCP_KEEPALIVE_TIME },
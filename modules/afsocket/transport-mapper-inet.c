@@ -64,6 +64,24 @@ transport_mapper_inet_validate_tls_options(TransportMapperInet *self)
   return TRUE;
 }
 
+static gboolean
+transport_mapper_inet_validate_udp_options(TransportMapperInet *self)
+{
+  if (self->udp_receive_batch_size > 1 && self->super.sock_type != SOCK_DGRAM)
+    {
+      msg_error("udp-receive-batch-size() specified for a transport that is not UDP based",
+                evt_tag_str("transport", self->super.transport));
+      return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+transport_mapper_inet_validate_options(TransportMapperInet *self)
+{
+  return transport_mapper_inet_validate_tls_options(self) && transport_mapper_inet_validate_udp_options(self);
+}
+
 static gboolean
 transport_mapper_inet_apply_transport_method(TransportMapper *s, GlobalConfig *cfg)
 {
@@ -72,16 +90,25 @@ transport_mapper_inet_apply_transport_method(TransportMapper *s, GlobalConfig *c
   if (!transport_mapper_apply_transport_method(s, cfg))
     return FALSE;
 
-  return transport_mapper_inet_validate_tls_options(self);
+  return transport_mapper_inet_validate_options(self);
 }
 
 static gboolean
 _setup_socket_transport(TransportMapperInet *self, LogTransportStack *stack)
 {
-  log_transport_stack_add_transport(stack, LOG_TRANSPORT_SOCKET,
-                                    self->super.sock_type == SOCK_DGRAM
-                                    ? log_transport_udp_socket_new(stack->fd)
-                                    : log_transport_stream_socket_new(stack->fd));
+  LogTransport *transport;
+
+  if (self->super.sock_type == SOCK_DGRAM)
+    {
+      transport = log_transport_udp_socket_new(stack->fd);
+      log_transport_udp_socket_set_receive_batch_size(transport, self->udp_receive_batch_size);
+    }
+  else
+    {
+      transport = log_transport_stream_socket_new(stack->fd);
+    }
+
+  log_transport_stack_add_transport(stack, LOG_TRANSPORT_SOCKET, transport);
   return TRUE;
 }
 
@@ -285,6 +312,7 @@ transport_mapper_inet_init_instance(TransportMapperInet *self, const gchar *tran
   self->super.async_init = transport_mapper_inet_async_init;
   self->super.free_fn = transport_mapper_inet_free_method;
   self->super.address_family = AF_INET;
+  self->udp_receive_batch_size = 1;
 }
 
 TransportMapperInet *
@@ -466,7 +494,7 @@ transport_mapper_network_apply_transport(TransportMapper *s, GlobalConfig *cfg)
 
   g_assert(self->server_port != 0);
 
-  if (!transport_mapper_inet_validate_tls_options(self))
+  if (!transport_mapper_inet_validate_options(self))
     return FALSE;
 
   return TRUE;
@@ -608,7 +636,7 @@ transport_mapper_syslog_apply_transport(TransportMapper *s, GlobalConfig *cfg)
     }
   g_assert(self->server_port != 0);
 
-  if (!transport_mapper_inet_validate_tls_options(self))
+  if (!transport_mapper_inet_validate_options(self))
     return FALSE;
 
   return TRUE;
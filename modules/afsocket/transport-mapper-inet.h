@@ -57,6 +57,8 @@ typedef struct _TransportMapperInet
   gboolean proxied;
   /* switch to TLS after plaintext haproxy negotiation */
   gboolean proxied_passthrough;
+  /* number of datagrams to receive with a single recvmmsg() call, 1 disables batching */
+  gint udp_receive_batch_size;
   TLSContext *tls_context;
   TLSVerifier *tls_verifier;
   gpointer secret_store_cb_data;
@@ -88,6 +90,12 @@ transport_mapper_inet_set_tls_context(TransportMapperInet *self, TLSContext *tls
   self->tls_context = tls_context;
 }
 
+static inline void
+transport_mapper_inet_set_udp_receive_batch_size(TransportMapperInet *self, gint batch_size)
+{
+  self->udp_receive_batch_size = batch_size;
+}
+
 static inline void
 transport_mapper_inet_set_tls_verifier(TransportMapperInet *self, TLSVerifier *tls_verifier)
 {
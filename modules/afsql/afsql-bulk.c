@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "afsql-bulk.h"
+
+typedef struct _AFSqlBulkRow
+{
+  /* both NULL for a placeholder */
+  GString *table;
+  GString *values;
+} AFSqlBulkRow;
+
+struct _AFSqlBulkRows
+{
+  GArray *rows;
+};
+
+static void
+_row_clear(AFSqlBulkRow *row)
+{
+  if (row->table)
+    g_string_free(row->table, TRUE);
+  if (row->values)
+    g_string_free(row->values, TRUE);
+}
+
+static inline AFSqlBulkRow *
+_row(AFSqlBulkRows *self, guint index)
+{
+  return &g_array_index(self->rows, AFSqlBulkRow, index);
+}
+
+static inline gboolean
+_is_placeholder(AFSqlBulkRow *row)
+{
+  return row->values == NULL;
+}
+
+/* takes ownership of table and values */
+void
+afsql_bulk_rows_add(AFSqlBulkRows *self, GString *table, GString *values)
+{
+  AFSqlBulkRow row = { .table = table, .values = values };
+
+  g_array_append_val(self->rows, row);
+}
+
+void
+afsql_bulk_rows_add_placeholder(AFSqlBulkRows *self)
+{
+  AFSqlBulkRow row = { 0 };
+
+  g_array_append_val(self->rows, row);
+}
+
+void
+afsql_bulk_rows_clear(AFSqlBulkRows *self)
+{
+  g_array_set_size(self->rows, 0);
+}
+
+guint
+afsql_bulk_rows_len(AFSqlBulkRows *self)
+{
+  return self->rows->len;
+}
+
+/* returns FALSE for placeholders */
+gboolean
+afsql_bulk_rows_get(AFSqlBulkRows *self, guint index, GString **table, GString **values)
+{
+  AFSqlBulkRow *row = _row(self, index);
+
+  if (_is_placeholder(row))
+    return FALSE;
+
+  *table = row->table;
+  *values = row->values;
+  return TRUE;
+}
+
+/*
+ * Renders the rows starting at @first into a single multi-row INSERT
+ * statement.  Consecutive rows of the same table are included, up to
+ * @max_rows rows and @max_size bytes (at least one row is always included).
+ * Placeholders are skipped.  Returns the index of the first row not
+ * covered, @statement is left empty if the covered range only consists of
+ * placeholders.
+ */
+guint
+afsql_bulk_rows_build_statement(AFSqlBulkRows *self, guint first, gint max_rows, gsize max_size,
+                                AFSqlBulkAppendPrefixFunc append_prefix, gpointer user_data,
+                                GString *statement)
+{
+  GString *table = NULL;
+  gint num_rows = 0;
+  guint i;
+
+  g_string_truncate(statement, 0);
+
+  for (i = first; i < self->rows->len; i++)
+    {
+      AFSqlBulkRow *row = _row(self, i);
+
+      if (_is_placeholder(row))
+        continue;
+
+      if (!table)
+        {
+          table = row->table;
+          append_prefix(table, statement, user_data);
+        }
+      else
+        {
+          if (num_rows >= max_rows || !g_string_equal(row->table, table) ||
+              statement->len + 2 + row->values->len > max_size)
+            break;
+
+          g_string_append(statement, ", ");
+        }
+
+      g_string_append_len(statement, row->values->str, row->values->len);
+      num_rows++;
+    }
+
+  return i;
+}
+
+/*
+ * Reports the outcome of the rows in [@first, @last) to the queue, in
+ * order: the rows are acknowledged, the placeholders are dropped.
+ */
+void
+afsql_bulk_rows_complete(AFSqlBulkRows *self, guint first, guint last,
+                         AFSqlBulkResultFunc ack, AFSqlBulkResultFunc drop, gpointer user_data)
+{
+  guint i = first;
+
+  while (i < last)
+    {
+      gboolean placeholder = _is_placeholder(_row(self, i));
+      guint run_end = i + 1;
+
+      while (run_end < last && _is_placeholder(_row(self, run_end)) == placeholder)
+        run_end++;
+
+      if (placeholder)
+        drop(run_end - i, user_data);
+      else
+        ack(run_end - i, user_data);
+      i = run_end;
+    }
+}
+
+AFSqlBulkRows *
+afsql_bulk_rows_new(void)
+{
+  AFSqlBulkRows *self = g_new0(AFSqlBulkRows, 1);
+
+  self->rows = g_array_new(FALSE, FALSE, sizeof(AFSqlBulkRow));
+  g_array_set_clear_func(self->rows, (GDestroyNotify) _row_clear);
+
+  return self;
+}
+
+void
+afsql_bulk_rows_free(AFSqlBulkRows *self)
+{
+  g_array_free(self->rows, TRUE);
+  g_free(self);
+}
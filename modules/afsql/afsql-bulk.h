@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#ifndef AFSQL_BULK_H_INCLUDED
+#define AFSQL_BULK_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/* upper limit of a multi-row INSERT statement, below the default max_allowed_packet of MySQL */
+#define AFSQL_BULK_INSERT_MAX_STATEMENT_SIZE (1024 * 1024)
+
+/*
+ * Rows of a batch rendered for bulk-insert, in the order of the messages
+ * in the batch.  Messages that could not be formatted are kept as
+ * placeholders, so that the messages of the batch can be acknowledged or
+ * dropped in the same order as they were taken from the queue.
+ */
+typedef struct _AFSqlBulkRows AFSqlBulkRows;
+
+typedef void (*AFSqlBulkAppendPrefixFunc)(GString *table, GString *statement, gpointer user_data);
+typedef void (*AFSqlBulkResultFunc)(gint num_messages, gpointer user_data);
+
+AFSqlBulkRows *afsql_bulk_rows_new(void);
+void afsql_bulk_rows_free(AFSqlBulkRows *self);
+
+void afsql_bulk_rows_add(AFSqlBulkRows *self, GString *table, GString *values);
+void afsql_bulk_rows_add_placeholder(AFSqlBulkRows *self);
+void afsql_bulk_rows_clear(AFSqlBulkRows *self);
+guint afsql_bulk_rows_len(AFSqlBulkRows *self);
+
+gboolean afsql_bulk_rows_get(AFSqlBulkRows *self, guint index, GString **table, GString **values);
+guint afsql_bulk_rows_build_statement(AFSqlBulkRows *self, guint first, gint max_rows, gsize max_size,
+                                      AFSqlBulkAppendPrefixFunc append_prefix, gpointer user_data,
+                                      GString *statement);
+void afsql_bulk_rows_complete(AFSqlBulkRows *self, guint first, guint last,
+                              AFSqlBulkResultFunc ack, AFSqlBulkResultFunc drop, gpointer user_data);
+
+#endif
@@ -768,6 +768,9 @@ afsql_dd_disconnect(LogThreadedDestDriver *s)
   dbi_conn_close(self->dbi_ctx);
   self->dbi_ctx = NULL;
   self->transaction_active = FALSE;
+
+  /* the batch is rewound and inserted again after reconnecting */
+  afsql_bulk_rows_clear(self->bulk_rows);
 }
 
 static GString *
@@ -897,14 +900,13 @@ afsql_dd_append_value_to_be_inserted(AFSqlDestDriver *self,
   return TRUE;
 }
 
-static GString *
-afsql_dd_build_insert_command(AFSqlDestDriver *self, LogMessage *msg, GString *table)
+static void
+afsql_dd_append_insert_prefix(AFSqlDestDriver *self, GString *table, GString *insert_command)
 {
-  GString *insert_command = g_string_sized_new(256);
-  GString *value = g_string_sized_new(512);
   gint i, j;
 
-  g_string_printf(insert_command, "INSERT INTO %s%s%s (", self->quote_as_string, table->str, self->quote_as_string);
+  g_string_append_printf(insert_command, "INSERT INTO %s%s%s (", self->quote_as_string, table->str,
+                         self->quote_as_string);
 
   for (i = 0; i < self->fields_len; i++)
     {
@@ -921,7 +923,16 @@ afsql_dd_build_insert_command(AFSqlDestDriver *self, LogMessage *msg, GString *t
         }
     }
 
-  g_string_append(insert_command, ") VALUES (");
+  g_string_append(insert_command, ") VALUES ");
+}
+
+static gboolean
+afsql_dd_append_insert_values(AFSqlDestDriver *self, LogMessage *msg, GString *insert_command)
+{
+  GString *value = g_string_sized_new(512);
+  gint i, j;
+
+  g_string_append(insert_command, "(");
 
   for (i = 0; i < self->fields_len; i++)
     {
@@ -935,7 +946,10 @@ afsql_dd_build_insert_command(AFSqlDestDriver *self, LogMessage *msg, GString *t
           if (!afsql_dd_append_value_to_be_inserted(self,
                                                     &self->fields[i], value, type,
                                                     insert_command))
-            goto drop;
+            {
+              g_string_free(value, TRUE);
+              return FALSE;
+            }
 
           j = i + 1;
           while (j < self->fields_len && (self->fields[j].flags & AFSQL_FF_DEFAULT) == AFSQL_FF_DEFAULT)
@@ -948,12 +962,22 @@ afsql_dd_build_insert_command(AFSqlDestDriver *self, LogMessage *msg, GString *t
   g_string_append(insert_command, ")");
   g_string_free(value, TRUE);
 
-  return insert_command;
+  return TRUE;
+}
 
-drop:
-  g_string_free(value, TRUE);
-  g_string_free(insert_command, TRUE);
-  return NULL;
+static GString *
+afsql_dd_build_insert_command(AFSqlDestDriver *self, LogMessage *msg, GString *table)
+{
+  GString *insert_command = g_string_sized_new(256);
+
+  afsql_dd_append_insert_prefix(self, table, insert_command);
+  if (!afsql_dd_append_insert_values(self, msg, insert_command))
+    {
+      g_string_free(insert_command, TRUE);
+      return NULL;
+    }
+
+  return insert_command;
 }
 
 static inline gboolean
@@ -1009,28 +1033,25 @@ afsql_dd_handle_insert_row_error_depending_on_connection_availability(AFSqlDestD
   return LTR_ERROR;
 }
 
-static LogThreadedResult
-afsql_dd_flush(LogThreadedDestDriver *s)
+static void
+afsql_dd_report_format_error(AFSqlDestDriver *self)
 {
-  AFSqlDestDriver *self = (AFSqlDestDriver *) s;
-
-  if (!afsql_dd_is_transaction_handling_enabled(self))
-    return LTR_SUCCESS;
+  if (self->template_options.on_error & ON_ERROR_SILENT)
+    return;
 
-  if (!afsql_dd_commit_transaction(self))
-    {
-      /* Assuming that in case of error, the queue is rewound by afsql_dd_commit_transaction() */
-      afsql_dd_rollback_transaction(self);
-      return LTR_ERROR;
-    }
-  return LTR_SUCCESS;
+  msg_error("Failed to format message for SQL, dropping message",
+            evt_tag_str("type", self->type),
+            evt_tag_str("host", self->host),
+            evt_tag_str("port", self->port),
+            evt_tag_str("username", self->user),
+            evt_tag_str("database", self->database),
+            evt_tag_str("error", "error converting name-value pair to the requested type"));
 }
 
 static LogThreadedResult
 afsql_dd_run_insert_query(AFSqlDestDriver *self, GString *table, LogMessage *msg)
 {
   GString *insert_command;
-  gboolean drop_silently = self->template_options.on_error & ON_ERROR_SILENT;
 
   insert_command = afsql_dd_build_insert_command(self, msg, table);
   if (insert_command)
@@ -1046,18 +1067,237 @@ afsql_dd_run_insert_query(AFSqlDestDriver *self, GString *table, LogMessage *msg
     }
   else
     {
-      if (!drop_silently)
+      afsql_dd_report_format_error(self);
+      return LTR_DROP;
+    }
+}
+
+/*
+ * bulk-insert: rows are rendered in insert() and kept until flush(), which
+ * sends consecutive rows of the same table as multi-row INSERT statements.
+ * If the database rejects such a statement while the connection is still
+ * alive, the rows are retried one by one, so that only the offending rows
+ * are dropped.  The messages of the batch are acknowledged or dropped
+ * strictly in queue order, as they are stored by the database.
+ */
+static inline gboolean
+afsql_dd_is_bulk_insert_enabled(const AFSqlDestDriver *self)
+{
+  return !!(self->super.flags & AFSQL_DDF_BULK_INSERT);
+}
+
+static gboolean
+afsql_dd_is_bulk_insert_supported(const AFSqlDestDriver *self)
+{
+  /* neither Oracle nor SQLite 2 accepts more than one row in VALUES */
+  return strcmp(self->type, s_oracle) != 0 && strcmp(self->type, "sqlite") != 0;
+}
+
+static gint
+afsql_dd_get_bulk_insert_max_rows(const AFSqlDestDriver *self)
+{
+  /* SQL Server limits VALUES to 1000 rows, SQLite to 500 terms of a compound SELECT */
+  if (strcmp(self->type, s_freetds) == 0)
+    return 1000;
+  if (strcmp(self->type, "sqlite3") == 0)
+    return 500;
+  return G_MAXINT;
+}
+
+static void
+afsql_dd_ack_bulk_messages(gint num_messages, gpointer user_data)
+{
+  AFSqlDestDriver *self = (AFSqlDestDriver *) user_data;
+
+  log_threaded_dest_worker_ack_messages(&self->super.worker.instance, num_messages);
+}
+
+static void
+afsql_dd_drop_bulk_messages(gint num_messages, gpointer user_data)
+{
+  AFSqlDestDriver *self = (AFSqlDestDriver *) user_data;
+
+  log_threaded_dest_worker_drop_messages(&self->super.worker.instance, num_messages);
+}
+
+static void
+afsql_dd_complete_bulk_rows(AFSqlDestDriver *self, guint first, guint last)
+{
+  afsql_bulk_rows_complete(self->bulk_rows, first, last,
+                           afsql_dd_ack_bulk_messages, afsql_dd_drop_bulk_messages, self);
+}
+
+static void
+afsql_dd_append_bulk_insert_prefix(GString *table, GString *statement, gpointer user_data)
+{
+  afsql_dd_append_insert_prefix((AFSqlDestDriver *) user_data, table, statement);
+}
+
+static LogThreadedResult
+afsql_dd_queue_bulk_row(AFSqlDestDriver *self, GString *table, LogMessage *msg)
+{
+  GString *values = g_string_sized_new(256);
+
+  if (!afsql_dd_append_insert_values(self, msg, values))
+    {
+      /* LTR_DROP would drop the whole batch, the message is dropped in order when flushing */
+      afsql_dd_report_format_error(self);
+      afsql_bulk_rows_add_placeholder(self->bulk_rows);
+      g_string_free(values, TRUE);
+      g_string_free(table, TRUE);
+      return LTR_QUEUED;
+    }
+
+  afsql_bulk_rows_add(self->bulk_rows, table, values);
+  return LTR_QUEUED;
+}
+
+static LogThreadedResult
+afsql_dd_insert_bulk_rows_one_by_one(AFSqlDestDriver *self, guint first)
+{
+  guint len = afsql_bulk_rows_len(self->bulk_rows);
+
+  for (guint i = first; i < len; i++)
+    {
+      GString *table, *values;
+
+      if (!afsql_bulk_rows_get(self->bulk_rows, i, &table, &values))
         {
-          msg_error("Failed to format message for SQL, dropping message",
+          afsql_dd_complete_bulk_rows(self, i, i + 1);
+          continue;
+        }
+
+      if (afsql_dd_is_transaction_handling_enabled(self) && !afsql_dd_begin_transaction(self))
+        return LTR_ERROR;
+
+      GString *insert_command = g_string_sized_new(256);
+      afsql_dd_append_insert_prefix(self, table, insert_command);
+      g_string_append_len(insert_command, values->str, values->len);
+      gboolean success = afsql_dd_run_query(self, insert_command->str, FALSE, NULL);
+      g_string_free(insert_command, TRUE);
+
+      if (!success)
+        {
+          if (dbi_conn_ping(self->dbi_ctx) != 1)
+            return afsql_dd_handle_insert_row_error_depending_on_connection_availability(self);
+
+          if (afsql_dd_is_transaction_handling_enabled(self))
+            afsql_dd_rollback_transaction(self);
+
+          msg_error("Row rejected by the database, dropping message",
                     evt_tag_str("type", self->type),
-                    evt_tag_str("host", self->host),
-                    evt_tag_str("port", self->port),
-                    evt_tag_str("username", self->user),
                     evt_tag_str("database", self->database),
-                    evt_tag_str("error", "error converting name-value pair to the requested type"));
+                    evt_tag_str("table", table->str));
+          afsql_dd_drop_bulk_messages(1, self);
+          continue;
         }
-      return LTR_DROP;
+
+      if (afsql_dd_is_transaction_handling_enabled(self) && !afsql_dd_commit_transaction(self))
+        {
+          afsql_dd_rollback_transaction(self);
+          return LTR_ERROR;
+        }
+
+      afsql_dd_ack_bulk_messages(1, self);
     }
+
+  return LTR_SUCCESS;
+}
+
+static LogThreadedResult
+afsql_dd_flush_bulk_rows(AFSqlDestDriver *self)
+{
+  gboolean transaction = afsql_dd_is_transaction_handling_enabled(self);
+  gint max_rows = afsql_dd_get_bulk_insert_max_rows(self);
+  guint len = afsql_bulk_rows_len(self->bulk_rows);
+  GString *statement = g_string_sized_new(AFSQL_BULK_INSERT_MAX_STATEMENT_SIZE / 16);
+  LogThreadedResult result = LTR_SUCCESS;
+  guint first = 0;
+
+  if (len == 0)
+    goto exit;
+
+  if (transaction && !afsql_dd_begin_transaction(self))
+    {
+      result = LTR_ERROR;
+      goto exit;
+    }
+
+  while (first < len)
+    {
+      guint next = afsql_bulk_rows_build_statement(self->bulk_rows, first, max_rows,
+                                                   AFSQL_BULK_INSERT_MAX_STATEMENT_SIZE,
+                                                   afsql_dd_append_bulk_insert_prefix, self, statement);
+
+      /* the statement may be huge, the failure is reported below */
+      if (statement->len > 0 && !afsql_dd_run_query(self, statement->str, TRUE, NULL))
+        {
+          if (dbi_conn_ping(self->dbi_ctx) != 1)
+            {
+              result = afsql_dd_handle_insert_row_error_depending_on_connection_availability(self);
+              goto exit;
+            }
+
+          const gchar *dbi_error;
+          dbi_conn_error(self->dbi_ctx, &dbi_error);
+          msg_warning("Multi-row INSERT failed, retrying the rows one by one",
+                      evt_tag_str("type", self->type),
+                      evt_tag_str("database", self->database),
+                      evt_tag_int("rows", next - first),
+                      evt_tag_str("error", dbi_error));
+
+          if (transaction)
+            {
+              /* everything sent so far is undone, start over */
+              afsql_dd_rollback_transaction(self);
+              first = 0;
+            }
+
+          result = afsql_dd_insert_bulk_rows_one_by_one(self, first);
+          goto exit;
+        }
+
+      /* without a transaction the rows are stored as soon as the statement succeeds */
+      if (!transaction)
+        afsql_dd_complete_bulk_rows(self, first, next);
+      first = next;
+    }
+
+  if (transaction)
+    {
+      if (!afsql_dd_commit_transaction(self))
+        {
+          afsql_dd_rollback_transaction(self);
+          result = LTR_ERROR;
+          goto exit;
+        }
+      afsql_dd_complete_bulk_rows(self, 0, len);
+    }
+
+exit:
+  g_string_free(statement, TRUE);
+  afsql_bulk_rows_clear(self->bulk_rows);
+  return result;
+}
+
+static LogThreadedResult
+afsql_dd_flush(LogThreadedDestDriver *s)
+{
+  AFSqlDestDriver *self = (AFSqlDestDriver *) s;
+
+  if (afsql_dd_is_bulk_insert_enabled(self))
+    return afsql_dd_flush_bulk_rows(self);
+
+  if (!afsql_dd_is_transaction_handling_enabled(self))
+    return LTR_SUCCESS;
+
+  if (!afsql_dd_commit_transaction(self))
+    {
+      /* Assuming that in case of error, the queue is rewound by afsql_dd_commit_transaction() */
+      afsql_dd_rollback_transaction(self);
+      return LTR_ERROR;
+    }
+  return LTR_SUCCESS;
 }
 
 /**
@@ -1077,7 +1317,14 @@ afsql_dd_insert(LogThreadedDestDriver *s, LogMessage *msg)
 
   table = afsql_dd_ensure_accessible_database_table(self, msg);
   if (!table)
-    goto error;
+    {
+      /* the whole batch is rewound or dropped, including the rows queued so far */
+      afsql_bulk_rows_clear(self->bulk_rows);
+      goto error;
+    }
+
+  if (afsql_dd_is_bulk_insert_enabled(self))
+    return afsql_dd_queue_bulk_row(self, table, msg);
 
   if (afsql_dd_should_begin_new_transaction(self) && !afsql_dd_begin_transaction(self))
     goto error;
@@ -1271,7 +1518,14 @@ afsql_dd_init(LogPipe *s)
 
   log_template_options_init(&self->template_options, cfg);
 
-  if (afsql_dd_is_transaction_handling_enabled(self))
+  if (afsql_dd_is_bulk_insert_enabled(self) && !afsql_dd_is_bulk_insert_supported(self))
+    {
+      msg_warning("WARNING: flags(bulk-insert) was ignored because the database type does not support multi-row INSERT",
+                  evt_tag_str("type", self->type));
+      self->super.flags &= ~AFSQL_DDF_BULK_INSERT;
+    }
+
+  if (afsql_dd_is_transaction_handling_enabled(self) || afsql_dd_is_bulk_insert_enabled(self))
     log_threaded_dest_driver_set_batch_lines((LogDriver *)self, _batch_lines(self));
 
   return TRUE;
@@ -1310,6 +1564,7 @@ afsql_dd_free(LogPipe *s)
   g_hash_table_destroy(self->dbd_options);
   g_hash_table_destroy(self->dbd_options_numeric);
   g_free(self->dbi_driver_dir);
+  afsql_bulk_rows_free(self->bulk_rows);
   if (self->session_statements)
     string_list_free(self->session_statements);
   log_threaded_dest_driver_free(s);
@@ -1352,6 +1607,7 @@ afsql_dd_new(GlobalConfig *cfg)
   self->dbd_options = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
   self->dbd_options_numeric = g_hash_table_new_full(g_str_hash, g_int_equal, g_free, NULL);
   self->dbi_driver_dir = NULL;
+  self->bulk_rows = afsql_bulk_rows_new();
 
   log_template_options_defaults(&self->template_options);
   self->super.stats_source = stats_register_type("sql");
@@ -1363,6 +1619,7 @@ CfgFlagHandler afsql_dd_flag_handlers[] =
 {
   { "explicit-commits",   CFH_SET, offsetof(LogThreadedDestDriver, flags), AFSQL_DDF_EXPLICIT_COMMITS },
   { "dont-create-tables", CFH_SET, offsetof(LogThreadedDestDriver, flags), AFSQL_DDF_DONT_CREATE_TABLES },
+  { "bulk-insert",        CFH_SET, offsetof(LogThreadedDestDriver, flags), AFSQL_DDF_BULK_INSERT },
   { NULL },
 };
 
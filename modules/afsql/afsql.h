@@ -29,6 +29,7 @@
 #include "logthrdest/logthrdestdrv.h"
 #include "mainloop-worker.h"
 #include "string-list.h"
+#include "afsql-bulk.h"
 
 #include <dbi.h>
 
@@ -43,8 +44,10 @@ enum
 {
   AFSQL_DDF_EXPLICIT_COMMITS = 0x1000,
   AFSQL_DDF_DONT_CREATE_TABLES = 0x2000,
+  AFSQL_DDF_BULK_INSERT = 0x4000,
 };
 
+
 typedef struct _AFSqlField
 {
   guint32 flags;
@@ -98,6 +101,7 @@ typedef struct _AFSqlDestDriver
   GHashTable *syslogng_conform_tables;
   guint32 failed_message_counter;
   gboolean transaction_active;
+  AFSqlBulkRows *bulk_rows;
 } AFSqlDestDriver;
 
 
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "afsql-bulk.h"
+
+typedef struct
+{
+  GString *results;
+} TestQueue;
+
+static void
+_append_prefix(GString *table, GString *statement, gpointer user_data)
+{
+  g_string_append_printf(statement, "INSERT INTO %s (a) VALUES ", table->str);
+}
+
+static void
+_ack(gint num_messages, gpointer user_data)
+{
+  TestQueue *queue = user_data;
+  g_string_append_printf(queue->results, "A%d ", num_messages);
+}
+
+static void
+_drop(gint num_messages, gpointer user_data)
+{
+  TestQueue *queue = user_data;
+  g_string_append_printf(queue->results, "D%d ", num_messages);
+}
+
+static void
+_add_row(AFSqlBulkRows *rows, const gchar *table, const gchar *value)
+{
+  afsql_bulk_rows_add(rows, g_string_new(table), g_string_new(value));
+}
+
+Test(afsql_bulk, bad_row_in_multi_row_batch_is_dropped_in_queue_order)
+{
+  AFSqlBulkRows *rows = afsql_bulk_rows_new();
+  GString *statement = g_string_new("");
+  TestQueue queue = { .results = g_string_new("") };
+
+  _add_row(rows, "t", "(1)");
+  _add_row(rows, "t", "(2)");
+  afsql_bulk_rows_add_placeholder(rows);
+  _add_row(rows, "t", "(4)");
+  _add_row(rows, "t", "(5)");
+
+  guint next = afsql_bulk_rows_build_statement(rows, 0, G_MAXINT, 1024, _append_prefix, NULL, statement);
+  cr_assert_eq(next, 5);
+  cr_assert_str_eq(statement->str, "INSERT INTO t (a) VALUES (1), (2), (4), (5)");
+
+  afsql_bulk_rows_complete(rows, 0, next, _ack, _drop, &queue);
+  cr_assert_str_eq(queue.results->str, "A2 D1 A2 ");
+
+  g_string_free(queue.results, TRUE);
+  g_string_free(statement, TRUE);
+  afsql_bulk_rows_free(rows);
+}
+
+Test(afsql_bulk, placeholders_are_resolved_by_the_statement_covering_them)
+{
+  AFSqlBulkRows *rows = afsql_bulk_rows_new();
+  GString *statement = g_string_new("");
+  TestQueue queue = { .results = g_string_new("") };
+
+  _add_row(rows, "t", "(1)");
+  afsql_bulk_rows_add_placeholder(rows);
+  afsql_bulk_rows_add_placeholder(rows);
+  _add_row(rows, "t", "(4)");
+
+  guint next = afsql_bulk_rows_build_statement(rows, 0, 1, 1024, _append_prefix, NULL, statement);
+  cr_assert_eq(next, 3, "the placeholders before the next row belong to the first statement");
+  cr_assert_str_eq(statement->str, "INSERT INTO t (a) VALUES (1)");
+  afsql_bulk_rows_complete(rows, 0, next, _ack, _drop, &queue);
+
+  next = afsql_bulk_rows_build_statement(rows, next, 1, 1024, _append_prefix, NULL, statement);
+  cr_assert_eq(next, 4);
+  cr_assert_str_eq(statement->str, "INSERT INTO t (a) VALUES (4)");
+  afsql_bulk_rows_complete(rows, 3, next, _ack, _drop, &queue);
+
+  cr_assert_str_eq(queue.results->str, "A1 D2 A1 ");
+
+  g_string_free(queue.results, TRUE);
+  g_string_free(statement, TRUE);
+  afsql_bulk_rows_free(rows);
+}
+
+Test(afsql_bulk, batch_of_placeholders_only_renders_no_statement)
+{
+  AFSqlBulkRows *rows = afsql_bulk_rows_new();
+  GString *statement = g_string_new("");
+  TestQueue queue = { .results = g_string_new("") };
+
+  afsql_bulk_rows_add_placeholder(rows);
+  afsql_bulk_rows_add_placeholder(rows);
+
+  guint next = afsql_bulk_rows_build_statement(rows, 0, G_MAXINT, 1024, _append_prefix, NULL, statement);
+  cr_assert_eq(next, 2);
+  cr_assert_eq(statement->len, 0);
+
+  afsql_bulk_rows_complete(rows, 0, next, _ack, _drop, &queue);
+  cr_assert_str_eq(queue.results->str, "D2 ");
+
+  g_string_free(queue.results, TRUE);
+  g_string_free(statement, TRUE);
+  afsql_bulk_rows_free(rows);
+}
+
+Test(afsql_bulk, statements_are_split_by_table_row_limit_and_size)
+{
+  AFSqlBulkRows *rows = afsql_bulk_rows_new();
+  GString *statement = g_string_new("");
+
+  _add_row(rows, "t1", "(1)");
+  _add_row(rows, "t1", "(2)");
+  _add_row(rows, "t2", "(3)");
+  _add_row(rows, "t2", "(4)");
+  _add_row(rows, "t2", "(5)");
+
+  cr_assert_eq(afsql_bulk_rows_build_statement(rows, 0, G_MAXINT, 1024, _append_prefix, NULL, statement), 2);
+  cr_assert_str_eq(statement->str, "INSERT INTO t1 (a) VALUES (1), (2)");
+
+  cr_assert_eq(afsql_bulk_rows_build_statement(rows, 2, 2, 1024, _append_prefix, NULL, statement), 4);
+  cr_assert_str_eq(statement->str, "INSERT INTO t2 (a) VALUES (3), (4)");
+
+  /* the first row is always included, even if it exceeds the size limit */
+  cr_assert_eq(afsql_bulk_rows_build_statement(rows, 2, G_MAXINT, 10, _append_prefix, NULL, statement), 3);
+  cr_assert_str_eq(statement->str, "INSERT INTO t2 (a) VALUES (3)");
+
+  g_string_free(statement, TRUE);
+  afsql_bulk_rows_free(rows);
+}
+
+Test(afsql_bulk, clear_removes_all_rows)
+{
+  AFSqlBulkRows *rows = afsql_bulk_rows_new();
+
+  _add_row(rows, "t", "(1)");
+  afsql_bulk_rows_add_placeholder(rows);
+  cr_assert_eq(afsql_bulk_rows_len(rows), 2);
+
+  afsql_bulk_rows_clear(rows);
+  cr_assert_eq(afsql_bulk_rows_len(rows), 0);
+
+  afsql_bulk_rows_free(rows);
+}
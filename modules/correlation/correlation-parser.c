@@ -42,6 +42,7 @@ static CfgLexerKeyword correlation_keywords[] =
   { "sort_key",           KW_SORT_KEY },
   { "scope",              KW_SCOPE },
   { "timeout",            KW_TIMEOUT },
+  { "shards",             KW_SHARDS },
   { "aggregate",          KW_AGGREGATE },
   { "inherit_mode",       KW_INHERIT_MODE },
   { "where",              KW_WHERE },
@@ -26,43 +26,57 @@
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
 
+static inline CorrelationStateShard *
+_get_shard(CorrelationState *self, const CorrelationKey *key)
+{
+  if (self->num_shards == 1)
+    return &self->shards[0];
+
+  g_assert(key != NULL);
+  return &self->shards[correlation_key_hash(key) % self->num_shards];
+}
+
 void
-correlation_state_tx_begin(CorrelationState *self)
+correlation_state_tx_begin(CorrelationState *self, const CorrelationKey *key)
 {
-  g_mutex_lock(&self->lock);
+  g_mutex_lock(&_get_shard(self, key)->lock);
 }
 
 void
-correlation_state_tx_end(CorrelationState *self)
+correlation_state_tx_end(CorrelationState *self, const CorrelationKey *key)
 {
-  g_mutex_unlock(&self->lock);
+  g_mutex_unlock(&_get_shard(self, key)->lock);
 }
 
 CorrelationContext *
 correlation_state_tx_lookup_context(CorrelationState *self, const CorrelationKey *key)
 {
-  return g_hash_table_lookup(self->state, key);
+  return g_hash_table_lookup(_get_shard(self, key)->state, key);
 }
 
 void
 correlation_state_tx_store_context(CorrelationState *self, CorrelationContext *context, gint timeout)
 {
+  CorrelationStateShard *shard = _get_shard(self, &context->key);
+
   g_assert(context->timer == NULL);
 
-  g_hash_table_insert(self->state, &context->key, context);
-  context->timer = timer_wheel_add_timer(self->timer_wheel, timeout, self->expire_callback,
+  g_hash_table_insert(shard->state, &context->key, context);
+  context->timer = timer_wheel_add_timer(shard->timer_wheel, timeout, self->expire_callback,
                                          correlation_context_ref(context), (GDestroyNotify) correlation_context_unref);
 }
 
 void
 correlation_state_tx_remove_context(CorrelationState *self, CorrelationContext *context)
 {
+  CorrelationStateShard *shard = _get_shard(self, &context->key);
+
   /* NOTE: in expire callbacks our timer is already deleted and thus it is
    * set to NULL in which case we don't need to remove it again.  */
 
   if (context->timer)
-    timer_wheel_del_timer(self->timer_wheel, context->timer);
-  g_hash_table_remove(self->state, &context->key);
+    timer_wheel_del_timer(shard->timer_wheel, context->timer);
+  g_hash_table_remove(shard->state, &context->key);
 }
 
 void
@@ -70,15 +84,38 @@ correlation_state_tx_update_context(CorrelationState *self, CorrelationContext *
 {
   g_assert(context->timer != NULL);
 
-  timer_wheel_mod_timer(self->timer_wheel, context->timer, timeout);
+  timer_wheel_mod_timer(_get_shard(self, &context->key)->timer_wheel, context->timer, timeout);
 }
 
 void
 correlation_state_expire_all(CorrelationState *self, gpointer caller_context)
 {
-  g_mutex_lock(&self->lock);
-  timer_wheel_expire_all(self->timer_wheel, caller_context);
-  g_mutex_unlock(&self->lock);
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      g_mutex_lock(&shard->lock);
+      timer_wheel_expire_all(shard->timer_wheel, caller_context);
+      g_mutex_unlock(&shard->lock);
+    }
+}
+
+static void
+_set_time_of_shards(CorrelationState *self, guint64 new_time, gpointer caller_context)
+{
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      /* unlocked peek: time never goes backwards, so a stale value only
+       * costs us a lock acquisition that turns out to be unnecessary */
+      if (timer_wheel_get_time(shard->timer_wheel) >= new_time)
+        continue;
+
+      g_mutex_lock(&shard->lock);
+      timer_wheel_set_time(shard->timer_wheel, new_time, caller_context);
+      g_mutex_unlock(&shard->lock);
+    }
 }
 
 void
@@ -87,8 +124,8 @@ correlation_state_advance_time(CorrelationState *self, gint timeout, gpointer ca
   guint64  new_time;
 
   g_mutex_lock(&self->lock);
-  new_time = timer_wheel_get_time(self->timer_wheel) + timeout;
-  timer_wheel_set_time(self->timer_wheel, new_time, caller_context);
+  new_time = correlation_state_get_time(self) + timeout;
+  _set_time_of_shards(self, new_time, caller_context);
   g_mutex_unlock(&self->lock);
 }
 
@@ -108,15 +145,13 @@ correlation_state_set_time(CorrelationState *self, guint64 sec, gpointer caller_
   if (sec < now.tv_sec)
     now.tv_sec = sec;
 
-  g_mutex_lock(&self->lock);
-  timer_wheel_set_time(self->timer_wheel, now.tv_sec, caller_context);
-  g_mutex_unlock(&self->lock);
+  _set_time_of_shards(self, now.tv_sec, caller_context);
 }
 
 guint64
 correlation_state_get_time(CorrelationState *self)
 {
-  return timer_wheel_get_time(self->timer_wheel);
+  return timer_wheel_get_time(self->shards[0].timer_wheel);
 }
 
 gboolean
@@ -134,7 +169,7 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
     {
       glong diff_sec = (glong)(diff / 1e6);
 
-      timer_wheel_set_time(self->timer_wheel, timer_wheel_get_time(self->timer_wheel) + diff_sec, caller_context);
+      _set_time_of_shards(self, correlation_state_get_time(self) + diff_sec, caller_context);
       /* update last_tick, take the fraction of the seconds not calculated into this update into account */
 
       self->last_tick = now;
@@ -153,28 +188,63 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
   return updated;
 }
 
+/* each shard's TimerWheel holds its own reference to the associated data */
+void
+correlation_state_set_associated_data(CorrelationState *self, gpointer assoc_data,
+                                      GBoxedCopyFunc assoc_data_ref, GDestroyNotify assoc_data_free)
+{
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      gpointer data = assoc_data_ref ? assoc_data_ref(assoc_data) : assoc_data;
+
+      timer_wheel_set_associated_data(self->shards[i].timer_wheel, data, assoc_data_free);
+    }
+}
 
 CorrelationState *
-correlation_state_new(TWCallbackFunc expire_callback)
+correlation_state_new_sharded(TWCallbackFunc expire_callback, gint num_shards)
 {
   CorrelationState *self = g_new0(CorrelationState, 1);
 
+  g_assert(num_shards >= 1);
+
   g_mutex_init(&self->lock);
-  self->state = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
-                                      (GDestroyNotify) correlation_context_unref);
-  self->timer_wheel = timer_wheel_new();
+  self->num_shards = num_shards;
+  self->shards = g_new0(CorrelationStateShard, num_shards);
+  for (gint i = 0; i < num_shards; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      g_mutex_init(&shard->lock);
+      shard->state = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
+                                           (GDestroyNotify) correlation_context_unref);
+      shard->timer_wheel = timer_wheel_new();
+    }
   get_cached_realtime(&self->last_tick);
   g_atomic_counter_set(&self->ref_cnt, 1);
   self->expire_callback = expire_callback;
   return self;
 }
 
+CorrelationState *
+correlation_state_new(TWCallbackFunc expire_callback)
+{
+  return correlation_state_new_sharded(expire_callback, 1);
+}
+
 void
 _free(CorrelationState *self)
 {
-  if (self->state)
-    g_hash_table_destroy(self->state);
-  timer_wheel_free(self->timer_wheel);
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      if (shard->state)
+        g_hash_table_destroy(shard->state);
+      timer_wheel_free(shard->timer_wheel);
+      g_mutex_clear(&shard->lock);
+    }
+  g_free(self->shards);
   g_mutex_clear(&self->lock);
   g_free(self);
 }
@@ -29,18 +29,36 @@
 #include "timerwheel.h"
 #include "timeutils/unixtime.h"
 
-typedef struct _CorrelationState
+/*
+ * Contexts are partitioned into shards by the hash of their
+ * CorrelationKey, each shard owning its own hash table, TimerWheel and
+ * lock.  The shards are advanced in lockstep, so they share the same idea
+ * of the current time.  With a single shard (the default) this is the
+ * same as one state guarded by one lock.
+ */
+typedef struct _CorrelationStateShard
 {
-  GAtomicCounter ref_cnt;
   GMutex lock;
   GHashTable *state;
   TimerWheel *timer_wheel;
+} CorrelationStateShard;
+
+typedef struct _CorrelationState
+{
+  GAtomicCounter ref_cnt;
+  /* protects last_tick */
+  GMutex lock;
+  CorrelationStateShard *shards;
+  gint num_shards;
   TWCallbackFunc expire_callback;
   struct timespec last_tick;
 } CorrelationState;
 
-void correlation_state_tx_begin(CorrelationState *self);
-void correlation_state_tx_end(CorrelationState *self);
+/* A transaction locks the shard of @key, all operations within the
+ * transaction have to act on contexts in that same shard.  A NULL key is
+ * only allowed for states with a single shard. */
+void correlation_state_tx_begin(CorrelationState *self, const CorrelationKey *key);
+void correlation_state_tx_end(CorrelationState *self, const CorrelationKey *key);
 CorrelationContext *correlation_state_tx_lookup_context(CorrelationState *self, const CorrelationKey *key);
 void correlation_state_tx_store_context(CorrelationState *self, CorrelationContext *context, gint timeout);
 void correlation_state_tx_remove_context(CorrelationState *self, CorrelationContext *context);
@@ -51,10 +69,13 @@ guint64 correlation_state_get_time(CorrelationState *self);
 gboolean correlation_state_timer_tick(CorrelationState *self, gpointer caller_context);
 void correlation_state_expire_all(CorrelationState *self, gpointer caller_context);
 void correlation_state_advance_time(CorrelationState *self, gint timeout, gpointer caller_context);
+void correlation_state_set_associated_data(CorrelationState *self, gpointer assoc_data,
+                                           GBoxedCopyFunc assoc_data_ref, GDestroyNotify assoc_data_free);
 
 void correlation_state_init_instance(CorrelationState *self);
 void correlation_state_deinit_instance(CorrelationState *self);
 CorrelationState *correlation_state_new(TWCallbackFunc expire);
+CorrelationState *correlation_state_new_sharded(TWCallbackFunc expire, gint num_shards);
 CorrelationState *correlation_state_ref(CorrelationState *self);
 void correlation_state_unref(CorrelationState *self);
 
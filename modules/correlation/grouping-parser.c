@@ -58,6 +58,20 @@ grouping_parser_set_timeout(LogParser *s, gint timeout)
   self->timeout = timeout;
 }
 
+static void _expire_entry(TimerWheel *wheel, guint64 now, gpointer user_data, gpointer caller_context);
+
+void
+grouping_parser_set_shards(LogParser *s, gint shards)
+{
+  GroupingParser *self = (GroupingParser *) s;
+
+  if (self->correlation->num_shards == shards)
+    return;
+
+  correlation_state_unref(self->correlation);
+  self->correlation = correlation_state_new_sharded(_expire_entry, shards);
+}
+
 void
 grouping_parser_clone_settings(GroupingParser *self, GroupingParser *cloned)
 {
@@ -66,6 +80,7 @@ grouping_parser_clone_settings(GroupingParser *self, GroupingParser *cloned)
   grouping_parser_set_sort_key_template(&cloned->super.super, self->sort_key_template);
   grouping_parser_set_timeout(&cloned->super.super, self->timeout);
   grouping_parser_set_scope(&cloned->super.super, self->scope);
+  grouping_parser_set_shards(&cloned->super.super, self->correlation->num_shards);
 }
 
 /*
@@ -120,12 +135,18 @@ _load_correlation_state(GroupingParser *self, GlobalConfig *cfg)
                                             log_pipe_get_persist_name(&self->super.super.super));
   if (persisted_correlation)
     {
+      if (persisted_correlation->num_shards != self->correlation->num_shards)
+        msg_warning("grouping-parser: the number of shards changed, the new value takes effect after the "
+                    "persisted correlation state is dropped, e.g. after a restart",
+                    evt_tag_int("shards", self->correlation->num_shards),
+                    evt_tag_int("persisted_shards", persisted_correlation->num_shards),
+                    log_pipe_location_tag(&self->super.super.super));
       correlation_state_unref(self->correlation);
       self->correlation = persisted_correlation;
     }
 
-  timer_wheel_set_associated_data(self->correlation->timer_wheel, log_pipe_ref((LogPipe *)self),
-                                  (GDestroyNotify)log_pipe_unref);
+  correlation_state_set_associated_data(self->correlation, self,
+                                        (GBoxedCopyFunc) log_pipe_ref, (GDestroyNotify) log_pipe_unref);
 }
 
 static void
@@ -180,33 +201,37 @@ _expire_entry(TimerWheel *wheel, guint64 now, gpointer user_data, gpointer calle
 }
 
 
+/* NOTE: the returned key refers to @buffer */
+static void
+_format_key(GroupingParser *self, LogMessage *msg, GString *buffer, CorrelationKey *key)
+{
+  log_template_format(self->key_template, msg, &DEFAULT_TEMPLATE_EVAL_OPTIONS, buffer);
+  correlation_key_init(key, self->scope, msg, buffer->str);
+}
+
+/* NOTE: the transaction for @key has to be started by the caller */
 CorrelationContext *
-grouping_parser_lookup_or_create_context(GroupingParser *self, LogMessage *msg)
+grouping_parser_lookup_or_create_context(GroupingParser *self, CorrelationKey *key, GString *key_buffer)
 {
   CorrelationContext *context;
-  CorrelationKey key;
-  GString *buffer = scratch_buffers_alloc();
 
-  log_template_format(self->key_template, msg, &DEFAULT_TEMPLATE_EVAL_OPTIONS, buffer);
-
-  correlation_key_init(&key, self->scope, msg, buffer->str);
-  context = correlation_state_tx_lookup_context(self->correlation, &key);
+  context = correlation_state_tx_lookup_context(self->correlation, key);
   if (!context)
     {
       msg_debug("grouping-parser: Correlation context lookup failure, starting a new context",
-                evt_tag_str("key", key.session_id),
+                evt_tag_str("key", key->session_id),
                 evt_tag_int("timeout", self->timeout),
                 evt_tag_int("expiration", correlation_state_get_time(self->correlation) + self->timeout),
                 log_pipe_location_tag(&self->super.super.super));
 
-      context = grouping_parser_construct_context(self, &key);
+      context = grouping_parser_construct_context(self, key);
       correlation_state_tx_store_context(self->correlation, context, self->timeout);
-      g_string_steal(buffer);
+      g_string_steal(key_buffer);
     }
   else
     {
       msg_debug("grouping-parser: Correlation context lookup successful",
-                evt_tag_str("key", key.session_id),
+                evt_tag_str("key", key->session_id),
                 evt_tag_int("timeout", self->timeout),
                 evt_tag_int("expiration", correlation_state_get_time(self->correlation) + self->timeout),
                 evt_tag_int("num_messages", context->messages->len),
@@ -221,7 +246,7 @@ _aggregate_and_emit(GroupingParser *self, CorrelationContext *context, StatefulP
 {
   LogMessage *genmsg = grouping_parser_aggregate_context(self, context);
   correlation_state_tx_update_context(self->correlation, context, self->timeout);
-  correlation_state_tx_end(self->correlation);
+  correlation_state_tx_end(self->correlation, &context->key);
   if (genmsg)
     {
       stateful_parser_emitted_messages_add(emitted_messages, genmsg);
@@ -232,9 +257,13 @@ _aggregate_and_emit(GroupingParser *self, CorrelationContext *context, StatefulP
 void
 grouping_parser_perform_grouping(GroupingParser *self, LogMessage *msg, StatefulParserEmittedMessages *emitted_messages)
 {
-  correlation_state_tx_begin(self->correlation);
+  CorrelationKey key;
+  GString *buffer = scratch_buffers_alloc();
+
+  _format_key(self, msg, buffer, &key);
+  correlation_state_tx_begin(self->correlation, &key);
 
-  CorrelationContext *context = grouping_parser_lookup_or_create_context(self, msg);
+  CorrelationContext *context = grouping_parser_lookup_or_create_context(self, &key, buffer);
 
   GroupingParserUpdateContextResult r = grouping_parser_update_context(self, context, msg);
 
@@ -246,7 +275,7 @@ grouping_parser_perform_grouping(GroupingParser *self, LogMessage *msg, Stateful
                 evt_tag_int("expiration", correlation_state_get_time(self->correlation) + self->timeout),
                 log_pipe_location_tag(&self->super.super.super));
       correlation_state_tx_update_context(self->correlation, context, self->timeout);
-      correlation_state_tx_end(self->correlation);
+      correlation_state_tx_end(self->correlation, &context->key);
     }
   else if (r == GP_CONTEXT_COMPLETE)
     {
@@ -517,7 +517,7 @@ _pattern_db_process_matching_rule(PatternDB *self, PDBProcessParams *process_par
   LogMessage *msg = process_params->msg;
   GString *buffer = g_string_sized_new(32);
 
-  correlation_state_tx_begin(self->correlation);
+  correlation_state_tx_begin(self->correlation, NULL);
   if (rule->context.id_template)
     {
       CorrelationKey key;
@@ -570,7 +570,7 @@ _pattern_db_process_matching_rule(PatternDB *self, PDBProcessParams *process_par
   _execute_rule_actions(self, process_params, RAT_MATCH);
 
   pdb_rule_unref(rule);
-  correlation_state_tx_end(self->correlation);
+  correlation_state_tx_end(self->correlation, NULL);
 
   if (context)
     log_msg_write_protect(msg);
@@ -658,7 +658,7 @@ _init_state(PatternDB *self)
   self->rate_limits = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
                                             (GDestroyNotify) pdb_rate_limit_free);
   self->correlation = correlation_state_new(pattern_db_expire_entry);
-  timer_wheel_set_associated_data(self->correlation->timer_wheel, self, NULL);
+  correlation_state_set_associated_data(self->correlation, self, NULL, NULL);
 }
 
 static void
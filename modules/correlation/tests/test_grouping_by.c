@@ -152,6 +152,39 @@ Test(grouping_by, grouping_by_drops_original_messages_if_inject_mode_is_aggregat
   log_pipe_unref(&capture->super);
 }
 
+Test(grouping_by, grouping_by_keeps_contexts_apart_when_sharded)
+{
+  LogPipeMock *capture = log_pipe_mock_new(configuration);
+  LogParser *parser = _compile_grouping_by(
+                        "grouping-by(key(\"$PROGRAM\")"
+                        "    aggregate("
+                        "        value(\"aggr\" \"$(list-slice :-1 $(context-values $PROGRAM))\")"
+                        "    )"
+                        "    timeout(1)"
+                        "    shards(8)"
+                        "    inject-mode(aggregate-only)"
+                        "    trigger(\"$(context-length)\" == \"2\")"
+                        ");");
+
+  cr_assert_eq(((GroupingParser *) parser)->correlation->num_shards, 8);
+
+  log_pipe_append(&parser->super, &capture->super);
+  cr_assert(log_pipe_init(&capture->super) == TRUE);
+  cr_assert(log_pipe_init(&parser->super) == TRUE);
+
+  _process_msg(parser, "first");
+  _process_msg(parser, "second");
+  _process_msg(parser, "first");
+  _process_msg(parser, "second");
+
+  cr_assert(capture->captured_messages->len == 2);
+  assert_log_message_value_by_name(log_pipe_mock_get_message(capture, 0), "aggr", "first,first");
+  assert_log_message_value_by_name(log_pipe_mock_get_message(capture, 1), "aggr", "second,second");
+
+  log_pipe_unref(&parser->super);
+  log_pipe_unref(&capture->super);
+}
+
 Test(grouping_by, cfg_persist_name_not_equal)
 {
   LogParser *parser = _compile_grouping_by("grouping-by(key(\"$TEMPLATE1\"));");
@@ -83,6 +83,59 @@ disk_queue_options_set_prealloc(DiskQueueOptions *self, gboolean prealloc)
   self->prealloc = prealloc;
 }
 
+void
+disk_queue_options_set_write_batch_bytes(DiskQueueOptions *self, gint write_batch_bytes)
+{
+  self->write_batch_bytes = write_batch_bytes;
+}
+
+void
+disk_queue_options_set_sync_batches(DiskQueueOptions *self, gint sync_batches)
+{
+  self->sync_batches = sync_batches;
+}
+
+void
+disk_queue_options_set_read_ahead_bytes(DiskQueueOptions *self, gint read_ahead_bytes)
+{
+  self->read_ahead_bytes = read_ahead_bytes;
+}
+
+gboolean
+disk_queue_options_set_compression(DiskQueueOptions *self, const gchar *compression)
+{
+  if (strcmp(compression, "none") == 0)
+    self->compression = DISKQ_COMPRESSION_NONE;
+#ifdef SYSLOG_NG_HAVE_LZ4
+  else if (strcmp(compression, "lz4") == 0)
+    self->compression = DISKQ_COMPRESSION_LZ4;
+#endif
+#ifdef SYSLOG_NG_HAVE_ZSTD
+  else if (strcmp(compression, "zstd") == 0)
+    self->compression = DISKQ_COMPRESSION_ZSTD;
+#endif
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+const gchar *
+disk_queue_compression_to_string(DiskQueueCompression compression)
+{
+  switch (compression)
+    {
+    case DISKQ_COMPRESSION_NONE:
+      return "none";
+    case DISKQ_COMPRESSION_LZ4:
+      return "lz4";
+    case DISKQ_COMPRESSION_ZSTD:
+      return "zstd";
+    default:
+      return "unknown";
+    }
+}
+
 void
 disk_queue_options_check_plugin_settings(DiskQueueOptions *self)
 {
@@ -123,6 +176,10 @@ disk_queue_options_set_default_options(DiskQueueOptions *self)
   self->dir = g_strdup(get_installation_path_for(SYSLOG_NG_PATH_LOCALSTATEDIR));
   self->truncate_size_ratio = -1;
   self->prealloc = -1;
+  self->write_batch_bytes = 0;
+  self->sync_batches = 0;
+  self->compression = DISKQ_COMPRESSION_NONE;
+  self->read_ahead_bytes = 0;
 }
 
 void
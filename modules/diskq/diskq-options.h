@@ -29,6 +29,14 @@
 
 #define MIN_CAPACITY_BYTES 1024*1024
 
+/* stored in the disk-buffer file, do not renumber */
+typedef enum
+{
+  DISKQ_COMPRESSION_NONE = 0,
+  DISKQ_COMPRESSION_LZ4 = 1,
+  DISKQ_COMPRESSION_ZSTD = 2,
+} DiskQueueCompression;
+
 typedef struct _DiskQueueOptions
 {
   gint64 capacity_bytes;
@@ -40,6 +48,10 @@ typedef struct _DiskQueueOptions
   gchar *dir;
   gdouble truncate_size_ratio;
   gboolean prealloc;
+  gint write_batch_bytes;
+  gint sync_batches;
+  DiskQueueCompression compression;
+  gint read_ahead_bytes;
 } DiskQueueOptions;
 
 void disk_queue_options_front_cache_size_set(DiskQueueOptions *self, gint front_cache_size);
@@ -52,6 +64,11 @@ void disk_queue_options_check_plugin_settings(DiskQueueOptions *self);
 void disk_queue_options_set_dir(DiskQueueOptions *self, const gchar *dir);
 void disk_queue_options_set_truncate_size_ratio(DiskQueueOptions *self, gdouble truncate_size_ratio);
 void disk_queue_options_set_prealloc(DiskQueueOptions *self, gboolean prealloc);
+void disk_queue_options_set_write_batch_bytes(DiskQueueOptions *self, gint write_batch_bytes);
+void disk_queue_options_set_sync_batches(DiskQueueOptions *self, gint sync_batches);
+void disk_queue_options_set_read_ahead_bytes(DiskQueueOptions *self, gint read_ahead_bytes);
+gboolean disk_queue_options_set_compression(DiskQueueOptions *self, const gchar *compression);
+const gchar *disk_queue_compression_to_string(DiskQueueCompression compression);
 void disk_queue_options_set_default_options(DiskQueueOptions *self);
 void disk_queue_options_destroy(DiskQueueOptions *self);
 
@@ -44,6 +44,10 @@ static CfgLexerKeyword diskq_keywords[] =
   { "dir",               KW_DIR },
   { "truncate_size_ratio", KW_TRUNCATE_SIZE_RATIO },
   { "prealloc",          KW_PREALLOC },
+  { "write_batch_bytes", KW_WRITE_BATCH_BYTES },
+  { "sync_batches",      KW_SYNC_BATCHES },
+  { "compression",       KW_COMPRESSION },
+  { "read_ahead_bytes",  KW_READ_AHEAD_BYTES },
   { "stats",             KW_STATS },
   { "freq",              KW_FREQ },
   { NULL }
@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "diskq-read-ahead.h"
+#include "logmsg/logmsg-serialize.h"
+#include "apphook.h"
+
+#define DISKQ_READ_AHEAD_MAX_THREADS 4
+
+/* one batch is consumed while the next one is being deserialized */
+#define DISKQ_READ_AHEAD_BATCHES 2
+
+/* records per helper thread job, at least */
+#define DISKQ_READ_AHEAD_MIN_JOB_RECORDS 64
+
+typedef struct _DiskQReadAheadBatch
+{
+  GPtrArray *records;
+  GArray *positions;
+  LogMessage **msgs;
+  gint num_records;
+  gint next;
+  gint64 next_position;
+
+  GMutex lock;
+  GCond done;
+  gint pending_jobs;
+} DiskQReadAheadBatch;
+
+typedef struct _DiskQReadAheadJob
+{
+  DiskQReadAheadBatch *batch;
+  gint first;
+  gint last;
+} DiskQReadAheadJob;
+
+struct _DiskQReadAhead
+{
+  QDisk *qdisk;
+  GQueue *batches;
+  gint64 num_prefetched;
+};
+
+/* the helper threads are shared by all disk-buffers */
+static struct
+{
+  GMutex lock;
+  GAsyncQueue *jobs;
+  GThread *threads[DISKQ_READ_AHEAD_MAX_THREADS];
+  gint num_threads;
+} helpers;
+
+static DiskQReadAheadJob stop_job;
+
+static gboolean
+_deserialize_msg(SerializeArchive *sa, gpointer user_data)
+{
+  LogMessage **pmsg = user_data;
+
+  *pmsg = log_msg_deserialize(sa);
+  return *pmsg != NULL;
+}
+
+static void
+_run_job(DiskQReadAheadJob *job)
+{
+  DiskQReadAheadBatch *batch = job->batch;
+
+  for (gint i = job->first; i < job->last; i++)
+    {
+      GString *record = g_ptr_array_index(batch->records, i);
+      LogMessage *msg = NULL;
+      GError *error = NULL;
+
+      /* failed records are left to the consumer, which reports them */
+      if (!qdisk_deserialize(record, _deserialize_msg, &msg, &error))
+        {
+          if (msg)
+            log_msg_unref(msg);
+          msg = NULL;
+          g_error_free(error);
+        }
+
+      batch->msgs[i] = msg;
+      g_string_free(record, TRUE);
+      g_ptr_array_index(batch->records, i) = NULL;
+    }
+
+  g_mutex_lock(&batch->lock);
+  if (--batch->pending_jobs == 0)
+    g_cond_signal(&batch->done);
+  g_mutex_unlock(&batch->lock);
+
+  g_free(job);
+}
+
+static gpointer
+_helper_thread_func(gpointer user_data)
+{
+  app_thread_start();
+
+  while (TRUE)
+    {
+      DiskQReadAheadJob *job = g_async_queue_pop(helpers.jobs);
+
+      if (job == &stop_job)
+        break;
+      _run_job(job);
+    }
+
+  app_thread_stop();
+  return NULL;
+}
+
+static void
+_stop_helpers(gint type, gpointer user_data)
+{
+  g_mutex_lock(&helpers.lock);
+  for (gint i = 0; i < helpers.num_threads; i++)
+    g_async_queue_push(helpers.jobs, &stop_job);
+
+  for (gint i = 0; i < helpers.num_threads; i++)
+    g_thread_join(helpers.threads[i]);
+
+  helpers.num_threads = 0;
+  g_clear_pointer(&helpers.jobs, g_async_queue_unref);
+  g_mutex_unlock(&helpers.lock);
+}
+
+static gint
+_start_helpers(void)
+{
+  g_mutex_lock(&helpers.lock);
+  if (helpers.num_threads == 0)
+    {
+      gint num_threads = CLAMP(g_get_num_processors() / 2, 1, DISKQ_READ_AHEAD_MAX_THREADS);
+
+      helpers.jobs = g_async_queue_new();
+      for (gint i = 0; i < num_threads; i++)
+        helpers.threads[i] = g_thread_new("diskq-read-ahead", _helper_thread_func, NULL);
+      helpers.num_threads = num_threads;
+
+      register_application_hook(AH_SHUTDOWN, _stop_helpers, NULL, AHM_RUN_ONCE);
+    }
+  g_mutex_unlock(&helpers.lock);
+
+  return helpers.num_threads;
+}
+
+static void
+_batch_wait(DiskQReadAheadBatch *batch)
+{
+  g_mutex_lock(&batch->lock);
+  while (batch->pending_jobs > 0)
+    g_cond_wait(&batch->done, &batch->lock);
+  g_mutex_unlock(&batch->lock);
+}
+
+static void
+_batch_free(DiskQReadAheadBatch *batch)
+{
+  _batch_wait(batch);
+
+  for (gint i = batch->next; i < batch->num_records; i++)
+    {
+      if (batch->msgs[i])
+        log_msg_unref(batch->msgs[i]);
+    }
+
+  g_free(batch->msgs);
+  g_ptr_array_free(batch->records, TRUE);
+  g_array_free(batch->positions, TRUE);
+  g_mutex_clear(&batch->lock);
+  g_cond_clear(&batch->done);
+  g_free(batch);
+}
+
+static void
+_batch_submit(DiskQReadAheadBatch *batch)
+{
+  gint num_threads = _start_helpers();
+  gint num_jobs = (batch->num_records + DISKQ_READ_AHEAD_MIN_JOB_RECORDS - 1) / DISKQ_READ_AHEAD_MIN_JOB_RECORDS;
+  num_jobs = MIN(num_jobs, num_threads);
+
+  batch->pending_jobs = num_jobs;
+  for (gint i = 0; i < num_jobs; i++)
+    {
+      DiskQReadAheadJob *job = g_new0(DiskQReadAheadJob, 1);
+
+      job->batch = batch;
+      job->first = (gint64) batch->num_records * i / num_jobs;
+      job->last = (gint64) batch->num_records * (i + 1) / num_jobs;
+      g_async_queue_push(helpers.jobs, job);
+    }
+}
+
+static DiskQReadAheadBatch *
+_batch_read(DiskQReadAhead *self, gint64 position, gint64 max_records, gsize max_bytes)
+{
+  DiskQReadAheadBatch *batch = g_new0(DiskQReadAheadBatch, 1);
+
+  batch->records = g_ptr_array_new();
+  batch->positions = g_array_new(FALSE, FALSE, sizeof(gint64));
+  g_mutex_init(&batch->lock);
+  g_cond_init(&batch->done);
+
+  batch->num_records = qdisk_read_ahead(self->qdisk, position, MIN(max_records, G_MAXINT), max_bytes,
+                                        batch->records, batch->positions, &batch->next_position);
+  batch->msgs = g_new0(LogMessage *, batch->num_records);
+
+  return batch;
+}
+
+static void
+_fill(DiskQReadAhead *self)
+{
+  gint read_ahead_bytes = qdisk_get_options(self->qdisk)->read_ahead_bytes;
+
+  if (read_ahead_bytes <= 0 || !qdisk_started(self->qdisk))
+    return;
+
+  while (self->batches->length < DISKQ_READ_AHEAD_BATCHES)
+    {
+      gint64 max_records = qdisk_get_length(self->qdisk) - self->num_prefetched;
+      if (max_records <= 0)
+        return;
+
+      DiskQReadAheadBatch *last = g_queue_peek_tail(self->batches);
+      gint64 position = last ? last->next_position : qdisk_get_next_head_position(self->qdisk);
+
+      DiskQReadAheadBatch *batch = _batch_read(self, position, max_records,
+                                               read_ahead_bytes / DISKQ_READ_AHEAD_BATCHES);
+      if (batch->num_records == 0)
+        {
+          _batch_free(batch);
+          return;
+        }
+
+      _batch_submit(batch);
+      g_queue_push_tail(self->batches, batch);
+      self->num_prefetched += batch->num_records;
+    }
+}
+
+/* returns the batch holding the message at the read head, if any */
+static DiskQReadAheadBatch *
+_lookup_head(DiskQReadAhead *self)
+{
+  _fill(self);
+
+  DiskQReadAheadBatch *batch = g_queue_peek_head(self->batches);
+  if (!batch)
+    return NULL;
+
+  gint64 position = g_array_index(batch->positions, gint64, batch->next);
+  if (position != qdisk_get_next_head_position(self->qdisk))
+    {
+      diskq_read_ahead_reset(self);
+      return NULL;
+    }
+
+  _batch_wait(batch);
+  if (!batch->msgs[batch->next])
+    {
+      diskq_read_ahead_reset(self);
+      return NULL;
+    }
+
+  return batch;
+}
+
+LogMessage *
+diskq_read_ahead_pop(DiskQReadAhead *self)
+{
+  DiskQReadAheadBatch *batch = _lookup_head(self);
+  if (!batch)
+    return NULL;
+
+  if (!qdisk_remove_head(self->qdisk))
+    {
+      diskq_read_ahead_reset(self);
+      return NULL;
+    }
+
+  LogMessage *msg = batch->msgs[batch->next];
+  batch->msgs[batch->next] = NULL;
+  batch->next++;
+  self->num_prefetched--;
+
+  if (batch->next == batch->num_records)
+    {
+      g_queue_pop_head(self->batches);
+      _batch_free(batch);
+
+      /* start deserializing the next batch, while this one is being processed */
+      _fill(self);
+    }
+
+  return msg;
+}
+
+LogMessage *
+diskq_read_ahead_peek(DiskQReadAhead *self)
+{
+  DiskQReadAheadBatch *batch = _lookup_head(self);
+  if (!batch)
+    return NULL;
+
+  return log_msg_ref(batch->msgs[batch->next]);
+}
+
+void
+diskq_read_ahead_reset(DiskQReadAhead *self)
+{
+  DiskQReadAheadBatch *batch;
+
+  while ((batch = g_queue_pop_head(self->batches)))
+    _batch_free(batch);
+  self->num_prefetched = 0;
+}
+
+DiskQReadAhead *
+diskq_read_ahead_new(QDisk *qdisk)
+{
+  DiskQReadAhead *self = g_new0(DiskQReadAhead, 1);
+
+  self->qdisk = qdisk;
+  self->batches = g_queue_new();
+
+  return self;
+}
+
+void
+diskq_read_ahead_free(DiskQReadAhead *self)
+{
+  diskq_read_ahead_reset(self);
+  g_queue_free(self->batches);
+  g_free(self);
+}
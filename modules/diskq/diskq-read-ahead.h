@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef DISKQ_READ_AHEAD_H_INCLUDED
+#define DISKQ_READ_AHEAD_H_INCLUDED
+
+#include "logmsg/logmsg.h"
+#include "qdisk.h"
+
+/*
+ * Read-ahead for replaying a disk-buffer file.
+ *
+ * The records following the read head are read in large chunks (see
+ * qdisk_read_ahead()) and deserialized by a set of helper threads, while
+ * the consumer is still processing the previous chunk.  The consumer takes
+ * the prefetched messages in file order, as long as they are at the read
+ * head of the qdisk.  Whenever the read head moves elsewhere (rewind,
+ * messages served from the memory queues, restart) the prefetched messages
+ * are dropped and the caller falls back to reading the records one by one.
+ *
+ * The size of the chunks comes from the read-ahead-bytes() option, 0
+ * disables read-ahead.  All functions must be called under the lock of the
+ * queue owning the qdisk.
+ */
+typedef struct _DiskQReadAhead DiskQReadAhead;
+
+DiskQReadAhead *diskq_read_ahead_new(QDisk *qdisk);
+void diskq_read_ahead_free(DiskQReadAhead *self);
+
+LogMessage *diskq_read_ahead_pop(DiskQReadAhead *self);
+LogMessage *diskq_read_ahead_peek(DiskQReadAhead *self);
+void diskq_read_ahead_reset(DiskQReadAhead *self);
+
+#endif
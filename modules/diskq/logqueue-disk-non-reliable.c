@@ -186,7 +186,8 @@ _log_internal_state(LogQueueDiskNonReliable *self, const gchar *operation)
   msg_info("Non-reliable disk-buffer state",
            evt_tag_str("operation", operation),
            evt_tag_str("filename", qdisk_get_filename(self->super.qdisk)),
-           evt_tag_long("number_of_messages", log_queue_get_length(&self->super.super)));
+           evt_tag_long("number_of_messages", log_queue_get_length(&self->super.super)),
+           evt_tag_str("compression", disk_queue_compression_to_string(qdisk_get_compression(self->super.qdisk))));
 
   msg_debug("Non-reliable disk-buffer internal state",
             evt_tag_str("operation", operation),
@@ -762,6 +763,19 @@ exit:
     scratch_buffers_reclaim_marked(marker);
 }
 
+static void
+_commit(LogQueueDiskNonReliable *self)
+{
+  g_mutex_lock(&self->super.super.lock);
+  if (!qdisk_commit(self->super.qdisk))
+    {
+      msg_error("Error committing messages to non-reliable disk-buffer",
+                evt_tag_str("filename", qdisk_get_filename(self->super.qdisk)),
+                evt_tag_str("persist_name", self->super.super.persist_name));
+    }
+  g_mutex_unlock(&self->super.super.lock);
+}
+
 static void
 _push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *path_options)
 {
@@ -815,6 +829,7 @@ _push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *path_options)
     }
   // slow path
   _push_tail_single_message(s, msg, path_options);
+  _commit(self);
 }
 
 static void
@@ -886,6 +901,7 @@ _move_input(gpointer user_data)
       if (self->input_queues[thread_index].len > 0)
         _move_part_of_input_to_disk_or_flow_control_window(self, &self->input_queues[thread_index]);
     }
+  _commit(self);
 exit:
   log_queue_unref(&self->super.super);
   return NULL;
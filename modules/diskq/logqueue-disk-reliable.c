@@ -81,7 +81,8 @@ _log_internal_state(LogQueueDisk *self, const gchar *operation)
   msg_info("Reliable disk-buffer state",
            evt_tag_str("operation", operation),
            evt_tag_str("filename", qdisk_get_filename(self->qdisk)),
-           evt_tag_long("number_of_messages", log_queue_get_length(&self->super)));
+           evt_tag_long("number_of_messages", log_queue_get_length(&self->super)),
+           evt_tag_str("compression", disk_queue_compression_to_string(qdisk_get_compression(self->qdisk))));
 
   msg_debug("Reliable disk-buffer internal state",
             evt_tag_str("filename", qdisk_get_filename(self->qdisk)),
@@ -361,6 +362,93 @@ _is_space_available_in_front_cache(LogQueueDiskReliable *self)
   return num_of_messages_in_front_cache < self->front_cache_size;
 }
 
+static inline gboolean
+_is_group_commit_enabled(LogQueueDiskReliable *self)
+{
+  DiskQueueOptions *options = qdisk_get_options(self->super.qdisk);
+  return options->write_batch_bytes > 0 || options->sync_batches > 0;
+}
+
+static void
+_ack_uncommitted_messages(LogQueueDiskReliable *self, AckType ack_type)
+{
+  while (!g_queue_is_empty(self->uncommitted))
+    {
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+      LogMessage *msg = g_queue_pop_head(self->uncommitted);
+      POINTER_TO_LOG_PATH_OPTIONS(g_queue_pop_head(self->uncommitted), &path_options);
+
+      log_msg_ack(msg, &path_options, ack_type);
+      log_msg_unref(msg);
+    }
+}
+
+/*
+ * Must be called under the queue's lock.  If the records cannot be written,
+ * the messages stay unacknowledged (holding back their source) and the
+ * write is retried by the commit of the next batch.
+ */
+static void
+_commit(LogQueueDiskReliable *self)
+{
+  if (!qdisk_commit(self->super.qdisk))
+    {
+      msg_error("Error committing messages to reliable disk-buffer, retrying with the next batch",
+                evt_tag_str("filename", qdisk_get_filename(self->super.qdisk)),
+                evt_tag_str("persist_name", self->super.super.persist_name),
+                evt_tag_int("uncommitted_messages", g_queue_get_length(self->uncommitted) / ENTRIES_PER_MSG_IN_MEM_Q));
+      return;
+    }
+
+  _ack_uncommitted_messages(self, AT_PROCESSED);
+}
+
+static gpointer
+_commit_batch(gpointer user_data)
+{
+  LogQueueDiskReliable *self = (LogQueueDiskReliable *) user_data;
+
+  g_mutex_lock(&self->super.super.lock);
+  _commit(self);
+  g_mutex_unlock(&self->super.super.lock);
+
+  log_queue_unref(&self->super.super);
+  return NULL;
+}
+
+/*
+ * With group commit enabled, the message is only acked once the input
+ * batch that pushed it finishes and its record has been written (and
+ * possibly synced) to the disk-buffer file, together with the rest of the
+ * batch.
+ */
+static void
+_ack_when_committed(LogQueueDiskReliable *self, LogMessage *msg, const LogPathOptions *path_options)
+{
+  if (!_is_group_commit_enabled(self))
+    {
+      log_msg_ack(msg, path_options, AT_PROCESSED);
+      return;
+    }
+
+  g_queue_push_tail(self->uncommitted, log_msg_ref(msg));
+  g_queue_push_tail(self->uncommitted, LOG_PATH_OPTIONS_TO_POINTER(path_options));
+
+  gint thread_index = main_loop_worker_get_thread_index();
+  if (thread_index < 0 || thread_index >= self->num_commit_callbacks)
+    {
+      _commit(self);
+      return;
+    }
+
+  if (!main_loop_worker_batch_callback_registered(&self->commit_callbacks[thread_index]))
+    {
+      /* One reference should be held, while the callback is registered */
+      main_loop_worker_register_batch_callback(&self->commit_callbacks[thread_index]);
+      log_queue_ref(&self->super.super);
+    }
+}
+
 static void
 _push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *path_options)
 {
@@ -423,13 +511,14 @@ _push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *path_options)
       goto exit;
     }
 
-  log_msg_ack(msg, path_options, AT_PROCESSED);
+  _ack_when_committed(self, msg, path_options);
 
   if (_is_space_available_in_front_cache(self))
     {
       /*
        * Keep the message in memory for fast-path.
-       * Set its ack_needed to FALSE, because we have already acked it.
+       * Set its ack_needed to FALSE, because we have already acked it
+       * (or it is going to be acked on commit).
        */
       LogPathOptions local_path_options;
       log_path_options_chain(&local_path_options, path_options);
@@ -480,6 +569,13 @@ _free(LogQueue *s)
       self->front_cache = NULL;
     }
 
+  if (self->uncommitted)
+    {
+      g_assert(g_queue_is_empty(self->uncommitted));
+      g_queue_free(self->uncommitted);
+      self->uncommitted = NULL;
+    }
+
   log_queue_disk_free_method(&self->super);
 }
 
@@ -497,6 +593,8 @@ _stop(LogQueueDisk *s, gboolean *persistent)
       result = TRUE;
     }
 
+  /* qdisk_stop() has written out the uncommitted records, unless it failed */
+  _ack_uncommitted_messages(self, result ? AT_PROCESSED : AT_ABORTED);
   _empty_queue(self, self->flow_control_window);
   _empty_queue(self, self->front_cache);
   _empty_queue(self, self->backlog);
@@ -537,7 +635,10 @@ log_queue_disk_reliable_new(DiskQueueOptions *options, const gchar *filename, co
                             StatsClusterKeyBuilder *queue_sck_builder)
 {
   g_assert(options->reliable == TRUE);
-  LogQueueDiskReliable *self = g_new0(LogQueueDiskReliable, 1);
+
+  gint max_threads = main_loop_worker_get_max_number_of_threads();
+  LogQueueDiskReliable *self;
+  self = g_malloc0(sizeof(LogQueueDiskReliable) + max_threads * sizeof(self->commit_callbacks[0]));
   log_queue_disk_init_instance(&self->super, options, "SLRQ", filename, persist_name, stats_level,
                                driver_sck_builder, queue_sck_builder);
   if (options->flow_control_window_bytes < 0)
@@ -548,6 +649,16 @@ log_queue_disk_reliable_new(DiskQueueOptions *options, const gchar *filename, co
   self->backlog = g_queue_new();
   self->front_cache = g_queue_new();
   self->front_cache_size = options->front_cache_size;
+  self->uncommitted = g_queue_new();
+
+  self->num_commit_callbacks = max_threads;
+  for (gint i = 0; i < self->num_commit_callbacks; i++)
+    {
+      worker_batch_callback_init(&self->commit_callbacks[i]);
+      self->commit_callbacks[i].func = _commit_batch;
+      self->commit_callbacks[i].user_data = self;
+    }
+
   _set_virtual_functions(self);
   return &self->super.super;
 }
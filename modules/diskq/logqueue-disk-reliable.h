@@ -26,6 +26,8 @@
 
 #include "logqueue-disk.h"
 
+#include "mainloop-worker.h"
+
 typedef struct _LogQueueDiskReliable
 {
   LogQueueDisk super;
@@ -33,6 +35,10 @@ typedef struct _LogQueueDiskReliable
   GQueue *backlog;
   GQueue *front_cache;
   gint front_cache_size;
+  /* messages already on the disk-buffer, but not yet committed nor acked */
+  GQueue *uncommitted;
+  gint num_commit_callbacks;
+  WorkerBatchCallback commit_callbacks[0];
 } LogQueueDiskReliable;
 
 LogQueue *log_queue_disk_reliable_new(DiskQueueOptions *options, const gchar *filename, const gchar *persist_name,
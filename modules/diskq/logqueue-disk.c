@@ -59,6 +59,7 @@ log_queue_disk_stop(LogQueue *s, gboolean *persistent)
     }
 
   log_queue_queued_messages_sub(s, log_queue_get_length(s));
+  diskq_read_ahead_reset(self->read_ahead);
   return self->stop(self, persistent);
 }
 
@@ -142,6 +143,7 @@ void
 log_queue_disk_free_method(LogQueueDisk *self)
 {
   g_assert(!qdisk_started(self->qdisk));
+  diskq_read_ahead_free(self->read_ahead);
   qdisk_free(self->qdisk);
 
   _unregister_counters(self);
@@ -225,7 +227,13 @@ _peek_disk(LogQueueDisk *self, LogMessage **msg)
 LogMessage *
 log_queue_disk_read_message(LogQueueDisk *self, LogPathOptions *path_options)
 {
-  LogMessage *msg = NULL;
+  LogMessage *msg = diskq_read_ahead_pop(self->read_ahead);
+  if (msg)
+    {
+      path_options->ack_needed = FALSE;
+      return msg;
+    }
+
   do
     {
       if (qdisk_get_length(self->qdisk) == 0)
@@ -258,7 +266,10 @@ log_queue_disk_read_message(LogQueueDisk *self, LogPathOptions *path_options)
 LogMessage *
 log_queue_disk_peek_message(LogQueueDisk *self)
 {
-  LogMessage *msg = NULL;
+  LogMessage *msg = diskq_read_ahead_peek(self->read_ahead);
+  if (msg)
+    return msg;
+
   do
     {
       if (qdisk_get_length(self->qdisk) == 0)
@@ -368,6 +379,7 @@ _restart_diskq(LogQueueDisk *self)
 void
 log_queue_disk_restart_corrupted(LogQueueDisk *self)
 {
+  diskq_read_ahead_reset(self->read_ahead);
   _restart_diskq(self);
   log_queue_queued_messages_reset(&self->super);
   log_queue_disk_update_disk_related_counters(self);
@@ -429,6 +441,7 @@ log_queue_disk_init_instance(LogQueueDisk *self, DiskQueueOptions *options, cons
   self->compaction = options->compaction;
 
   self->qdisk = qdisk_new(options, qdisk_file_id, filename);
+  self->read_ahead = diskq_read_ahead_new(self->qdisk);
   _register_counters(self, stats_level, queue_sck_builder);
 
   if (queue_sck_builder)
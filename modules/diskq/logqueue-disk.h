@@ -27,6 +27,7 @@
 #include "logmsg/logmsg.h"
 #include "logqueue.h"
 #include "qdisk.h"
+#include "diskq-read-ahead.h"
 #include "logmsg/logmsg-serialize.h"
 
 typedef struct _LogQueueDisk LogQueueDisk;
@@ -35,6 +36,7 @@ struct _LogQueueDisk
 {
   LogQueue super;
   QDisk *qdisk;         /* disk based queue */
+  DiskQReadAhead *read_ahead;
   /* TODO:
    * LogQueueDisk should have a separate options class, which should only contain compaction, reliable, etc...
    * Similarly, QDisk should have a separate options class, which should only contain capacity_bytes,
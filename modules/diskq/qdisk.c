@@ -42,6 +42,13 @@
 #include <sys/types.h>
 #include <sys/file.h>
 
+#ifdef SYSLOG_NG_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef SYSLOG_NG_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 /* MADV_RANDOM not defined on legacy Linux systems. Could be removed in the
  * future, when support for Glibc 2.1.X drops.*/
 #ifndef MADV_RANDOM
@@ -50,9 +57,22 @@
 
 #define MAX_RECORD_LENGTH 100 * 1024 * 1024
 
+/*
+ * The two most significant bits of the record length tell how the record
+ * is compressed (see DiskQueueCompression).  The payload of a compressed
+ * record starts with the length of the uncompressed record, followed by
+ * the compressed data.
+ */
+#define QDISK_RECORD_LENGTH_MASK 0x3FFFFFFF
+#define QDISK_RECORD_COMPRESSION_SHIFT 30
+
+/* smaller records rarely compress well enough to be worth it */
+#define QDISK_COMPRESSION_MIN_RECORD_LENGTH 128
+#define QDISK_ZSTD_COMPRESSION_LEVEL 1
+
 #define PATH_QDISK              PATH_LOCALSTATEDIR
 
-#define QDISK_HDR_VERSION_CURRENT 3
+#define QDISK_HDR_VERSION_CURRENT 4
 
 #define QDISK_FILENAME_PREFIX "syslog-ng-"
 #define QDISK_FILENAME_IDX_FMT "%05d"
@@ -78,6 +98,20 @@ struct _QDisk
   gint64 cached_file_size;
   QDiskFileHeader *hdr;
   DiskQueueOptions *options;
+
+  /* records pushed, but not yet written to the file (see qdisk_commit()) */
+  GString *write_buffer;
+  gint64 write_buffer_position;
+  gboolean has_uncommitted_records;
+  gint commits_since_sync;
+
+  GString *compress_buffer;
+  GString *decompress_buffer;
+  GString *read_ahead_buffer;
+#ifdef SYSLOG_NG_HAVE_ZSTD
+  ZSTD_CCtx *zstd_cctx;
+  ZSTD_DCtx *zstd_dctx;
+#endif
 };
 
 #define QDISK_ERROR qdisk_error_quark()
@@ -663,6 +697,165 @@ qdisk_get_next_tail_position(QDisk *self)
   return self->hdr->write_head;
 }
 
+static gboolean
+_flush_write_buffer(QDisk *self)
+{
+  if (self->write_buffer->len == 0)
+    return TRUE;
+
+  /* the records are already accounted for in the header, so they are kept
+   * in the buffer on errors and the write is retried by the next flush */
+  if (!pwrite_strict(self->fd, self->write_buffer->str, self->write_buffer->len, self->write_buffer_position))
+    {
+      msg_error("Error writing disk-queue file",
+                evt_tag_str("filename", self->filename),
+                evt_tag_long("offset", self->write_buffer_position),
+                evt_tag_int("length", self->write_buffer->len),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  g_string_truncate(self->write_buffer, 0);
+  return TRUE;
+}
+
+static gboolean
+_write_record(QDisk *self, GString *record, gint64 position)
+{
+  if (self->options->write_batch_bytes <= 0)
+    {
+      if (!_flush_write_buffer(self))
+        return FALSE;
+
+      if (!pwrite_strict(self->fd, record->str, record->len, position))
+        {
+          msg_error("Error writing disk-queue file",
+                    evt_tag_error("error"));
+          return FALSE;
+        }
+      return TRUE;
+    }
+
+  /* the buffer only ever holds a contiguous region of the file, a wrapped
+   * write head starts a new one */
+  if (self->write_buffer->len > 0 && self->write_buffer_position + self->write_buffer->len != position)
+    {
+      if (!_flush_write_buffer(self))
+        return FALSE;
+    }
+
+  if (self->write_buffer->len == 0)
+    self->write_buffer_position = position;
+
+  gsize prev_len = self->write_buffer->len;
+  g_string_append_len(self->write_buffer, record->str, record->len);
+
+  if (self->write_buffer->len >= self->options->write_batch_bytes && !_flush_write_buffer(self))
+    {
+      /* the caller does not advance the write head, the record is not pushed */
+      g_string_truncate(self->write_buffer, prev_len);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * Writes the records accumulated since the last commit with a single
+ * pwrite() call and issues an fdatasync() every sync-batches() commits.
+ *
+ * Callers are expected to commit at the end of each input batch, before
+ * acknowledging the messages the batch has pushed.  On failure the records
+ * stay uncommitted and the next commit retries writing (and syncing) them,
+ * the messages must not be acknowledged until then.
+ */
+gboolean
+qdisk_commit(QDisk *self)
+{
+  if (!qdisk_started(self) || !self->has_uncommitted_records)
+    return TRUE;
+
+  if (!_flush_write_buffer(self))
+    return FALSE;
+
+  if (self->options->sync_batches > 0 && self->commits_since_sync + 1 >= self->options->sync_batches)
+    {
+      if (fdatasync(self->fd) < 0)
+        {
+          msg_error("Error syncing disk-queue file",
+                    evt_tag_str("filename", self->filename),
+                    evt_tag_error("error"));
+          return FALSE;
+        }
+      self->commits_since_sync = 0;
+    }
+  else if (self->options->sync_batches > 0)
+    {
+      self->commits_since_sync++;
+    }
+
+  self->has_uncommitted_records = FALSE;
+  return TRUE;
+}
+
+static gssize
+_compress(QDisk *self, const gchar *src, gsize src_len, gchar *dst, gsize dst_capacity)
+{
+  switch (self->options->compression)
+    {
+#ifdef SYSLOG_NG_HAVE_LZ4
+    case DISKQ_COMPRESSION_LZ4:
+      return LZ4_compress_default(src, dst, src_len, dst_capacity);
+#endif
+#ifdef SYSLOG_NG_HAVE_ZSTD
+    case DISKQ_COMPRESSION_ZSTD:
+    {
+      if (!self->zstd_cctx)
+        self->zstd_cctx = ZSTD_createCCtx();
+
+      gsize compressed_len = ZSTD_compressCCtx(self->zstd_cctx, dst, dst_capacity, src, src_len,
+                                               QDISK_ZSTD_COMPRESSION_LEVEL);
+      return ZSTD_isError(compressed_len) ? -1 : compressed_len;
+    }
+#endif
+    default:
+      return -1;
+    }
+}
+
+/* returns either the original record or its compressed version stored in
+ * compress_buffer, in case compression saves space */
+static GString *
+_maybe_compress_record(QDisk *self, GString *record)
+{
+  if (self->options->compression == DISKQ_COMPRESSION_NONE)
+    return record;
+
+  guint32 payload_len = record->len - sizeof(guint32);
+  if (payload_len < QDISK_COMPRESSION_MIN_RECORD_LENGTH)
+    return record;
+
+  /* the compressed payload has to be shorter than the original one,
+   * including the uncompressed length in front of it */
+  const gsize header_len = 2 * sizeof(guint32);
+  gsize max_compressed_len = payload_len - sizeof(guint32) - 1;
+
+  g_string_set_size(self->compress_buffer, header_len + max_compressed_len);
+  gssize compressed_len = _compress(self, record->str + sizeof(guint32), payload_len,
+                                    self->compress_buffer->str + header_len, max_compressed_len);
+  if (compressed_len <= 0)
+    return record;
+
+  guint32 length_word = GUINT32_TO_BE((compressed_len + sizeof(guint32)) |
+                                      (self->options->compression << QDISK_RECORD_COMPRESSION_SHIFT));
+  guint32 uncompressed_len = GUINT32_TO_BE(payload_len);
+
+  memcpy(self->compress_buffer->str, &length_word, sizeof(length_word));
+  memcpy(self->compress_buffer->str + sizeof(length_word), &uncompressed_len, sizeof(uncompressed_len));
+  g_string_truncate(self->compress_buffer, header_len + compressed_len);
+  return self->compress_buffer;
+}
+
 gboolean
 qdisk_push_tail(QDisk *self, GString *record)
 {
@@ -679,15 +872,15 @@ qdisk_push_tail(QDisk *self, GString *record)
       self->hdr->write_head = QDISK_RESERVED_SPACE;
     }
 
+  record = _maybe_compress_record(self, record);
+
   if (!qdisk_is_space_avail(self, record->len))
     return FALSE;
 
-  if (!pwrite_strict(self->fd, record->str, record->len, self->hdr->write_head))
-    {
-      msg_error("Error writing disk-queue file",
-                evt_tag_error("error"));
-      return FALSE;
-    }
+  if (!_write_record(self, record, self->hdr->write_head))
+    return FALSE;
+
+  self->has_uncommitted_records = TRUE;
 
   self->hdr->write_head = self->hdr->write_head + record->len;
 
@@ -745,11 +938,15 @@ qdisk_push_tail(QDisk *self, GString *record)
 }
 
 static inline gssize
-_read_record_length_from_disk(QDisk *self, gint64 position, guint32 *record_length)
+_read_record_length_from_disk(QDisk *self, gint64 position, guint32 *record_length,
+                              DiskQueueCompression *compression)
 {
-  gssize bytes_read = pread(self->fd, (gchar *)record_length, sizeof(guint32), position);
+  guint32 length_word;
+  gssize bytes_read = pread(self->fd, (gchar *) &length_word, sizeof(length_word), position);
 
-  *record_length = GUINT32_FROM_BE(*record_length);
+  length_word = GUINT32_FROM_BE(length_word);
+  *record_length = length_word & QDISK_RECORD_LENGTH_MASK;
+  *compression = length_word >> QDISK_RECORD_COMPRESSION_SHIFT;
 
   return bytes_read;
 }
@@ -794,24 +991,81 @@ _is_record_length_valid(QDisk *self, gssize bytes_read, guint32 record_length, g
 }
 
 static inline gboolean
-_try_reading_record_length(QDisk *self, gint64 position, guint32 *record_length)
+_try_reading_record_length(QDisk *self, gint64 position, guint32 *record_length, DiskQueueCompression *compression)
 {
   guint32 read_record_length;
-  gssize bytes_read = _read_record_length_from_disk(self, position, &read_record_length);
+  DiskQueueCompression read_compression;
+  gssize bytes_read = _read_record_length_from_disk(self, position, &read_record_length, &read_compression);
 
   if (!_is_record_length_valid(self, bytes_read, read_record_length, position))
     return FALSE;
 
   *record_length = read_record_length;
+  *compression = read_compression;
+  return TRUE;
+}
+
+static gboolean
+_decompress(QDisk *self, DiskQueueCompression compression, const gchar *src, gsize src_len,
+            gchar *dst, gsize uncompressed_len)
+{
+  switch (compression)
+    {
+#ifdef SYSLOG_NG_HAVE_LZ4
+    case DISKQ_COMPRESSION_LZ4:
+      return LZ4_decompress_safe(src, dst, src_len, uncompressed_len) == uncompressed_len;
+#endif
+#ifdef SYSLOG_NG_HAVE_ZSTD
+    case DISKQ_COMPRESSION_ZSTD:
+      if (!self->zstd_dctx)
+        self->zstd_dctx = ZSTD_createDCtx();
+
+      return ZSTD_decompressDCtx(self->zstd_dctx, dst, uncompressed_len, src, src_len) == uncompressed_len;
+#endif
+    default:
+      msg_error("Disk-queue file contains a record compressed with an algorithm not supported by this build",
+                evt_tag_str("filename", self->filename),
+                evt_tag_str("compression", disk_queue_compression_to_string(compression)));
+      return FALSE;
+    }
+}
+
+static gboolean
+_decompress_record(QDisk *self, DiskQueueCompression compression, GString *compressed, GString *record)
+{
+  guint32 uncompressed_len;
+
+  if (compressed->len <= sizeof(uncompressed_len))
+    goto error;
+
+  memcpy(&uncompressed_len, compressed->str, sizeof(uncompressed_len));
+  uncompressed_len = GUINT32_FROM_BE(uncompressed_len);
+  if (uncompressed_len == 0 || _is_record_length_reached_hard_limit(uncompressed_len))
+    goto error;
+
+  g_string_set_size(record, uncompressed_len);
+  if (!_decompress(self, compression, compressed->str + sizeof(uncompressed_len),
+                   compressed->len - sizeof(uncompressed_len), record->str, uncompressed_len))
+    goto error;
+
   return TRUE;
+
+error:
+  msg_error("Error decompressing disk-queue record",
+            evt_tag_str("filename", self->filename),
+            evt_tag_str("compression", disk_queue_compression_to_string(compression)),
+            evt_tag_long("offset", self->hdr->read_head));
+  return FALSE;
 }
 
 static inline gboolean
-_read_record_from_disk(QDisk *self, GString *record, guint32 record_length)
+_read_record_from_disk(QDisk *self, GString *record, guint32 record_length, DiskQueueCompression compression)
 {
-  g_string_set_size(record, record_length);
+  GString *buffer = compression == DISKQ_COMPRESSION_NONE ? record : self->decompress_buffer;
+
+  g_string_set_size(buffer, record_length);
 
-  gssize bytes_read = pread(self->fd, record->str, record_length, self->hdr->read_head + sizeof(record_length));
+  gssize bytes_read = pread(self->fd, buffer->str, record_length, self->hdr->read_head + sizeof(record_length));
   if (bytes_read != record_length)
     {
       msg_error("Error reading disk-queue file",
@@ -822,6 +1076,9 @@ _read_record_from_disk(QDisk *self, GString *record, guint32 record_length)
       return FALSE;
     }
 
+  if (compression != DISKQ_COMPRESSION_NONE)
+    return _decompress_record(self, compression, buffer, record);
+
   return TRUE;
 }
 
@@ -864,14 +1121,18 @@ qdisk_peek_head(QDisk *self, GString *record)
   if (self->hdr->read_head == self->hdr->write_head)
     return FALSE;
 
+  if (!_flush_write_buffer(self))
+    return FALSE;
+
   if (self->hdr->read_head > self->hdr->write_head)
     self->hdr->read_head = _correct_position_if_max_size_is_reached(self, self->hdr->read_head);
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length))
+  DiskQueueCompression compression;
+  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length, &compression))
     return FALSE;
 
-  if (!_read_record_from_disk(self, record, record_length))
+  if (!_read_record_from_disk(self, record, record_length, compression))
     return FALSE;
 
   return TRUE;
@@ -883,14 +1144,18 @@ qdisk_pop_head(QDisk *self, GString *record)
   if (self->hdr->read_head == self->hdr->write_head)
     return FALSE;
 
+  if (!_flush_write_buffer(self))
+    return FALSE;
+
   if (self->hdr->read_head > self->hdr->write_head)
     self->hdr->read_head = _correct_position_if_max_size_is_reached(self, self->hdr->read_head);
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length))
+  DiskQueueCompression compression;
+  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length, &compression))
     return FALSE;
 
-  if (!_read_record_from_disk(self, record, record_length))
+  if (!_read_record_from_disk(self, record, record_length, compression))
     return FALSE;
 
   _update_position_after_read(self, record_length, &self->hdr->read_head);
@@ -907,19 +1172,114 @@ _skip_record(QDisk *self, gint64 position, gint64 *new_position)
   if (position == self->hdr->write_head)
     return FALSE;
 
+  if (!_flush_write_buffer(self))
+    return FALSE;
+
   if (position > self->hdr->write_head)
     position = _correct_position_if_max_size_is_reached(self, position);
 
   *new_position = position;
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, *new_position, &record_length))
+  DiskQueueCompression compression;
+  if (!_try_reading_record_length(self, *new_position, &record_length, &compression))
     return FALSE;
 
   _update_position_after_read(self, record_length, new_position);
   return TRUE;
 }
 
+/*
+ * Reads the records following position into records (and their positions
+ * into positions) with a single pread() of at most max_bytes, without
+ * moving the read head.  Reading stops at the write head and where the
+ * read head would wrap around, the next call continues from
+ * *next_position.  Records that do not fit into max_bytes are left to
+ * qdisk_pop_head().
+ *
+ * Returns the number of records read.
+ */
+gint
+qdisk_read_ahead(QDisk *self, gint64 position, gint max_records, gsize max_bytes,
+                 GPtrArray *records, GArray *positions, gint64 *next_position)
+{
+  /* the v1 wrap condition depends on the file size at the time of reading */
+  if (self->hdr->use_v1_wrap_condition)
+    return 0;
+
+  if (!_flush_write_buffer(self))
+    return 0;
+
+  if (position > self->hdr->write_head)
+    position = _correct_position_if_max_size_is_reached(self, position);
+
+  if (position == self->hdr->write_head)
+    return 0;
+
+  gsize chunk_len = max_bytes;
+  if (position < self->hdr->write_head)
+    chunk_len = MIN(chunk_len, self->hdr->write_head - position);
+
+  GString *chunk = self->read_ahead_buffer;
+  g_string_set_size(chunk, chunk_len);
+  gssize bytes_read = pread(self->fd, chunk->str, chunk_len, position);
+  if (bytes_read <= 0)
+    return 0;
+
+  gsize chunk_end = bytes_read;
+  gint num_records = 0;
+  gsize offset = 0;
+  gint64 record_position = position;
+
+  while (num_records < max_records && offset + sizeof(guint32) <= chunk_end)
+    {
+      guint32 length_word;
+      memcpy(&length_word, chunk->str + offset, sizeof(length_word));
+      length_word = GUINT32_FROM_BE(length_word);
+
+      guint32 record_length = length_word & QDISK_RECORD_LENGTH_MASK;
+      DiskQueueCompression compression = length_word >> QDISK_RECORD_COMPRESSION_SHIFT;
+
+      /* invalid lengths are reported by qdisk_pop_head() */
+      if (record_length == 0 || _is_record_length_reached_hard_limit(record_length))
+        break;
+
+      if (offset + sizeof(length_word) + record_length > chunk_end)
+        break;
+
+      GString *record = g_string_new_len(chunk->str + offset + sizeof(length_word), record_length);
+      if (compression != DISKQ_COMPRESSION_NONE)
+        {
+          GString *compressed = record;
+
+          record = g_string_sized_new(0);
+          gboolean success = _decompress_record(self, compression, compressed, record);
+          g_string_free(compressed, TRUE);
+          if (!success)
+            {
+              g_string_free(record, TRUE);
+              break;
+            }
+        }
+
+      g_ptr_array_add(records, record);
+      g_array_append_val(positions, record_position);
+      num_records++;
+
+      offset += sizeof(length_word) + record_length;
+      gint64 new_position = position + offset;
+      if (new_position == self->hdr->write_head)
+        break;
+
+      _update_position_after_read(self, record_length, &record_position);
+      if (record_position != new_position)
+        break;
+    }
+
+  *next_position = position + offset;
+  return num_records;
+}
+
 gboolean
 qdisk_remove_head(QDisk *self)
 {
@@ -1396,6 +1756,7 @@ _create_header(QDisk *self)
   self->hdr->length = 0;
   self->hdr->use_v1_wrap_condition = FALSE;
   self->hdr->capacity_bytes = self->options->capacity_bytes;
+  self->hdr->compression = self->options->compression;
 
   return TRUE;
 }
@@ -1427,6 +1788,11 @@ _upgrade_header(QDisk *self)
       self->hdr->capacity_bytes = self->options->capacity_bytes;
     }
 
+  if (self->hdr->version < 4)
+    {
+      self->hdr->compression = DISKQ_COMPRESSION_NONE;
+    }
+
   self->hdr->version = QDISK_HDR_VERSION_CURRENT;
 }
 
@@ -1584,6 +1950,9 @@ _load_qdisk_file(QDisk *self, QDiskMemQLoadFunc func, gpointer user_data)
   if (!_ensure_capacity_bytes(self))
     goto error;
 
+  if (!self->options->read_only)
+    self->hdr->compression = self->options->compression;
+
   return TRUE;
 
 error:
@@ -1704,7 +2073,10 @@ qdisk_stop(QDisk *self, QDiskMemQSaveFunc func, gpointer user_data)
   gboolean result = TRUE;
 
   if (!self->options->read_only)
-    result = _save_state(self, func, user_data);
+    {
+      result = _flush_write_buffer(self);
+      result = _save_state(self, func, user_data) && result;
+    }
 
   _close_file(self);
 
@@ -1788,6 +2160,12 @@ qdisk_get_backlog_count(QDisk *self)
   return self->hdr->backlog_len;
 }
 
+DiskQueueCompression
+qdisk_get_compression(QDisk *self)
+{
+  return self->hdr->compression;
+}
+
 gint
 qdisk_get_flow_control_window_bytes(QDisk *self)
 {
@@ -1804,6 +2182,14 @@ void
 qdisk_free(QDisk *self)
 {
   self->options = NULL;
+  g_string_free(self->write_buffer, TRUE);
+  g_string_free(self->compress_buffer, TRUE);
+  g_string_free(self->decompress_buffer, TRUE);
+  g_string_free(self->read_ahead_buffer, TRUE);
+#ifdef SYSLOG_NG_HAVE_ZSTD
+  ZSTD_freeCCtx(self->zstd_cctx);
+  ZSTD_freeDCtx(self->zstd_dctx);
+#endif
   g_free(self->filename);
   g_free(self);
 }
@@ -1833,6 +2219,10 @@ qdisk_new(DiskQueueOptions *options, const gchar *file_id, const gchar *filename
 
   self->file_id = file_id;
   self->filename = g_strdup(filename);
+  self->write_buffer = g_string_new(NULL);
+  self->compress_buffer = g_string_new(NULL);
+  self->decompress_buffer = g_string_new(NULL);
+  self->read_ahead_buffer = g_string_new(NULL);
 
   return self;
 }
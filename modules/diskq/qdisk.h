@@ -64,6 +64,10 @@ typedef union _QDiskFileHeader
 
     guint8 use_v1_wrap_condition;
     gint64 capacity_bytes;
+
+    /* DiskQueueCompression of the records written last, each record
+     * carries its own compression in its length field */
+    guint8 compression;
   };
   gchar _pad2[QDISK_RESERVED_SPACE];
 } QDiskFileHeader;
@@ -82,9 +86,12 @@ gint64 qdisk_get_max_useful_space(QDisk *self);
 gint64 qdisk_get_empty_space(QDisk *self);
 gint64 qdisk_get_used_useful_space(QDisk *self);
 gboolean qdisk_push_tail(QDisk *self, GString *record);
+gboolean qdisk_commit(QDisk *self);
 gboolean qdisk_pop_head(QDisk *self, GString *record);
 gboolean qdisk_peek_head(QDisk *self, GString *record);
 gboolean qdisk_remove_head(QDisk *self);
+gint qdisk_read_ahead(QDisk *self, gint64 position, gint max_records, gsize max_bytes,
+                      GPtrArray *records, GArray *positions, gint64 *next_position);
 gboolean qdisk_ack_backlog(QDisk *self);
 gboolean qdisk_rewind_backlog(QDisk *self, guint rewind_count);
 void qdisk_empty_backlog(QDisk *self);
@@ -109,6 +116,7 @@ gint64 qdisk_get_reader_head(QDisk *self);
 gint64 qdisk_get_backlog_head(QDisk *self);
 gint64 qdisk_get_backlog_count(QDisk *self);
 gint qdisk_get_flow_control_window_bytes(QDisk *self);
+DiskQueueCompression qdisk_get_compression(QDisk *self);
 gboolean qdisk_is_read_only(QDisk *self);
 const gchar *qdisk_get_filename(QDisk *self);
 gint64 qdisk_get_file_size(QDisk *self);
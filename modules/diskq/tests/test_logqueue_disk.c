@@ -696,6 +696,92 @@ Test(logqueue_disk, test_non_reliable_queue_persistance)
   stop_grabbing_messages();
 }
 
+static void
+_push_numbered_msgs(LogQueue *queue, gint count)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  for (gint i = 0; i < count; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+      gchar value[32];
+
+      g_snprintf(value, sizeof(value), "message %d", i);
+      log_msg_set_value(msg, LM_V_MESSAGE, value, -1);
+      log_queue_push_tail(queue, msg, &path_options);
+    }
+}
+
+static void
+_assert_popped_msgs_are_numbered(LogQueue *queue, gint first, gint count)
+{
+  for (gint i = first; i < first + count; i++)
+    {
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+      LogMessage *msg = log_queue_pop_head(queue, &path_options);
+      gchar expected[32];
+
+      cr_assert(msg, "message %d is missing", i);
+      g_snprintf(expected, sizeof(expected), "message %d", i);
+      cr_assert_str_eq(log_msg_get_value(msg, LM_V_MESSAGE, NULL), expected);
+      log_msg_unref(msg);
+    }
+}
+
+static LogQueue *
+_new_reliable_queue_with_read_ahead(DiskQueueOptions *options, const gchar *filename)
+{
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *queue = log_queue_disk_reliable_new(options, filename, "test_read_ahead", STATS_LEVEL0,
+                                                driver_sck_builder, queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+
+  cr_assert(log_queue_disk_start(queue));
+  return queue;
+}
+
+Test(logqueue_disk, test_reliable_queue_replay_with_read_ahead)
+{
+  const gint num_msgs = 5000;
+  const gchar *filename = "test_read_ahead.rqf";
+  start_grabbing_messages();
+
+  DiskQueueOptions options = {0};
+  disk_queue_options_set_default_options(&options);
+  disk_queue_options_reliable_set(&options, TRUE);
+  disk_queue_options_capacity_bytes_set(&options, 10 * MIN_CAPACITY_BYTES);
+  disk_queue_options_flow_control_window_bytes_set(&options, 4096);
+  disk_queue_options_front_cache_size_set(&options, 0);
+  disk_queue_options_set_read_ahead_bytes(&options, 64 * 1024);
+
+  LogQueue *queue = _new_reliable_queue_with_read_ahead(&options, filename);
+  _push_numbered_msgs(queue, num_msgs);
+
+  /* after a restart every message has to be read back from the file */
+  gboolean persistent;
+  log_queue_disk_stop(queue, &persistent);
+  log_queue_unref(queue);
+  queue = _new_reliable_queue_with_read_ahead(&options, filename);
+  cr_assert_eq(log_queue_get_length(queue), num_msgs);
+
+  _assert_popped_msgs_are_numbered(queue, 0, 2000);
+
+  /* the prefetched messages are behind the rewound read head */
+  log_queue_rewind_backlog(queue, 1000);
+  _assert_popped_msgs_are_numbered(queue, 1000, num_msgs - 1000);
+  log_queue_ack_backlog(queue, num_msgs);
+
+  _assert_log_queue_disk_reliable_is_empty(queue);
+
+  log_queue_disk_stop(queue, &persistent);
+  log_queue_unref(queue);
+  disk_queue_options_destroy(&options);
+  unlink(filename);
+  stop_grabbing_messages();
+}
+
 static void
 setup(void)
 {
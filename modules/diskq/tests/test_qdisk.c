@@ -29,7 +29,9 @@
 #include "scratch-buffers.h"
 
 #include <unistd.h>
+#include <signal.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
 #include <errno.h>
 
 /* QDisk-internal: the frame is a 4-byte integer */
@@ -377,6 +379,207 @@ Test(qdisk, prealloc)
   cleanup_qdisk(filename, qdisk);
 }
 
+static gint64
+_get_real_file_size(const gchar *filename)
+{
+  struct stat file_stats;
+  cr_assert(stat(filename, &file_stats) == 0, "Stat call failed, errno: %d", errno);
+  return file_stats.st_size;
+}
+
+Test(qdisk, write_batch_bytes_defers_writes_until_commit)
+{
+  const gchar *filename = "test_write_batch_bytes.rqf";
+
+  DiskQueueOptions *opts = construct_diskq_options(TDISKQ_RELIABLE, MiB(1));
+  disk_queue_options_set_prealloc(opts, FALSE);
+  disk_queue_options_set_write_batch_bytes(opts, 4096);
+  QDisk *qdisk = qdisk_new(opts, "TEST", filename);
+  qdisk_start(qdisk, NULL, NULL);
+
+  gint64 initial_file_size = _get_real_file_size(filename);
+
+  for (gint i = 0; i < 3; i++)
+    cr_assert(push_dummy_record(qdisk, 128));
+  cr_assert_eq(qdisk_get_length(qdisk), 3);
+  cr_assert_eq(_get_real_file_size(filename), initial_file_size);
+
+  cr_assert(qdisk_commit(qdisk));
+  cr_assert_eq(_get_real_file_size(filename), qdisk_get_writer_head(qdisk));
+
+  /* exceeding write-batch-bytes() writes the buffer without an explicit commit */
+  cr_assert(push_dummy_record(qdisk, 4096));
+  cr_assert_eq(_get_real_file_size(filename), qdisk_get_writer_head(qdisk));
+
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+Test(qdisk, uncommitted_records_can_be_read_back)
+{
+  const gchar *filename = "test_uncommitted_records.rqf";
+
+  DiskQueueOptions *opts = construct_diskq_options(TDISKQ_RELIABLE, MiB(1));
+  disk_queue_options_set_write_batch_bytes(opts, 4096);
+  disk_queue_options_set_sync_batches(opts, 1);
+  QDisk *qdisk = qdisk_new(opts, "TEST", filename);
+  qdisk_start(qdisk, NULL, NULL);
+
+  cr_assert(push_dummy_record(qdisk, 128));
+  cr_assert(push_dummy_record(qdisk, 256));
+
+  GString *popped_data = g_string_new(NULL);
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, 128);
+
+  cr_assert(push_dummy_record(qdisk, 512));
+  cr_assert(qdisk_commit(qdisk));
+
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, 256);
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, 512);
+  cr_assert_eq(qdisk_get_length(qdisk), 0);
+  g_string_free(popped_data, TRUE);
+
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+static void
+_assert_compressed_records_round_trip(const gchar *compression)
+{
+  const gchar *filename = "test_compressed_records.rqf";
+  const gint num_records = 10;
+  const guint record_len = 1024;
+
+  DiskQueueOptions *opts = construct_diskq_options(TDISKQ_RELIABLE, MiB(1));
+  if (!disk_queue_options_set_compression(opts, compression))
+    {
+      disk_queue_options_destroy(opts);
+      g_free(opts);
+      cr_skip_test("%s compression is not supported by this build", compression);
+    }
+
+  QDisk *qdisk = qdisk_new(opts, "TEST", filename);
+  qdisk_start(qdisk, NULL, NULL);
+
+  for (gint i = 0; i < num_records; i++)
+    cr_assert(push_dummy_record(qdisk, record_len));
+  cr_assert_lt(qdisk_get_writer_head(qdisk) - QDISK_RESERVED_SPACE, num_records * (record_len + FRAME_LENGTH) / 2);
+
+  GString *popped_data = g_string_new(NULL);
+  for (gint i = 0; i < num_records; i++)
+    {
+      cr_assert(qdisk_pop_head(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len);
+    }
+
+  /* rewinding needs to skip compressed records */
+  cr_assert(qdisk_rewind_backlog(qdisk, 5));
+  cr_assert_eq(qdisk_get_length(qdisk), 5);
+
+  qdisk_stop(qdisk, NULL, NULL);
+
+  /* records stay readable when compression is turned off */
+  disk_queue_options_set_compression(opts, "none");
+  qdisk_start(qdisk, NULL, NULL);
+  cr_assert_eq(qdisk_get_compression(qdisk), DISKQ_COMPRESSION_NONE);
+
+  for (gint i = 0; i < 5; i++)
+    {
+      cr_assert(qdisk_pop_head(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len);
+    }
+  g_string_free(popped_data, TRUE);
+
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+Test(qdisk, lz4_compressed_records_round_trip)
+{
+  _assert_compressed_records_round_trip("lz4");
+}
+
+Test(qdisk, zstd_compressed_records_round_trip)
+{
+  _assert_compressed_records_round_trip("zstd");
+}
+
+Test(qdisk, records_are_stored_uncompressed_if_compression_does_not_help)
+{
+  const gchar *filename = "test_small_records.rqf";
+
+  DiskQueueOptions *opts = construct_diskq_options(TDISKQ_RELIABLE, MiB(1));
+  if (!disk_queue_options_set_compression(opts, "lz4") && !disk_queue_options_set_compression(opts, "zstd"))
+    {
+      disk_queue_options_destroy(opts);
+      g_free(opts);
+      cr_skip_test("compression is not supported by this build");
+    }
+
+  QDisk *qdisk = qdisk_new(opts, "TEST", filename);
+  qdisk_start(qdisk, NULL, NULL);
+
+  cr_assert(push_dummy_record(qdisk, 64));
+  cr_assert_eq(qdisk_get_writer_head(qdisk), QDISK_RESERVED_SPACE + 64 + FRAME_LENGTH);
+
+  GString *popped_data = g_string_new(NULL);
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, 64);
+  g_string_free(popped_data, TRUE);
+
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+Test(qdisk, records_are_kept_when_writing_the_write_buffer_fails)
+{
+  const gchar *filename = "test_write_buffer_failure.rqf";
+
+  DiskQueueOptions *opts = construct_diskq_options(TDISKQ_RELIABLE, MiB(1));
+  disk_queue_options_set_prealloc(opts, FALSE);
+  disk_queue_options_set_write_batch_bytes(opts, 4096);
+  QDisk *qdisk = qdisk_new(opts, "TEST", filename);
+  qdisk_start(qdisk, NULL, NULL);
+
+  /* make writes beyond the current end of the file fail with EFBIG */
+  struct rlimit orig_limit, limit;
+  cr_assert(getrlimit(RLIMIT_FSIZE, &orig_limit) == 0);
+  limit = orig_limit;
+  limit.rlim_cur = _get_real_file_size(filename);
+  signal(SIGXFSZ, SIG_IGN);
+  cr_assert(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+
+  for (gint i = 0; i < 3; i++)
+    cr_assert(push_dummy_record(qdisk, 128));
+  cr_assert_not(qdisk_commit(qdisk));
+  cr_assert_eq(qdisk_get_length(qdisk), 3);
+
+  /* a record that would trigger a failing write is not pushed */
+  gint64 writer_head = qdisk_get_writer_head(qdisk);
+  cr_assert_not(push_dummy_record(qdisk, 4096));
+  cr_assert_eq(qdisk_get_length(qdisk), 3);
+  cr_assert_eq(qdisk_get_writer_head(qdisk), writer_head);
+
+  cr_assert(setrlimit(RLIMIT_FSIZE, &orig_limit) == 0);
+  cr_assert(qdisk_commit(qdisk));
+  cr_assert_eq(_get_real_file_size(filename), qdisk_get_writer_head(qdisk));
+
+  GString *popped_data = g_string_new(NULL);
+  for (gint i = 0; i < 3; i++)
+    {
+      cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+      assert_dummy_record(popped_data, 128);
+    }
+  cr_assert_eq(qdisk_get_length(qdisk), 0);
+  g_string_free(popped_data, TRUE);
+
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
 static gboolean
 _serialize_len_of_zeroes(SerializeArchive *sa, gpointer user_data)
 {
@@ -33,6 +33,7 @@ static CfgLexerKeyword ebpf_keywords[] =
   { "ebpf", KW_EBPF },
   { "reuseport", KW_REUSEPORT },
   { "sockets", KW_SOCKETS },
+  { "mode", KW_MODE },
   { NULL }
 };
 
@@ -24,69 +24,354 @@
 #include "syslog-ng.h"
 #include "messages.h"
 #include "gprocess.h"
+#include "gsockaddr.h"
+#include "apphook.h"
+#include "timeutils/misc.h"
 
 #include <bpf/libbpf.h>
+#include <bpf/bpf.h>
+#include <iv.h>
+#include <sys/stat.h>
+#include <linux/sock_diag.h>
+
+/* must be kept in sync with MAX_SOCKETS in reuseport.kern.c */
+#define EBPF_REUSEPORT_MAX_SOCKETS 256
+#define EBPF_REUSEPORT_LOAD_UPDATE_MSECS 100
+
+#include "reuseport.skel.c"
+
+/*
+ * In load mode the eBPF program consults the receive queue depth of each
+ * socket in the reuseport group, which is only known to userspace.  The
+ * sockets of the group are set up by different source drivers (and their
+ * plugin instances), so the program, the load map and the list of sockets
+ * are shared between them in an EBPFReusePortGroup, identified by the
+ * local address of the sockets.
+ *
+ * The group outlives the configuration, as sockets may be kept open across
+ * reloads, it is freed when all of its sockets are closed.
+ */
+typedef struct _EBPFReusePortSocket
+{
+  gint fd;
+  ino_t ino;
+} EBPFReusePortSocket;
+
+typedef struct _EBPFReusePortGroup
+{
+  gchar *name;
+  struct reuseport_kern *skel;
+  /* in the same order as in the kernel's reuseport group */
+  GArray *sockets;
+  struct iv_timer load_update_timer;
+} EBPFReusePortGroup;
 
 typedef struct _EBPFReusePort
 {
   LogDriverPlugin super;
-  struct random_kern *random;
+  struct reuseport_kern *skel;
+  EBPFReusePortMode mode;
   gint number_of_sockets;
 } EBPFReusePort;
 
-#include "random.skel.c"
+static GHashTable *reuseport_groups;
 
+static struct reuseport_kern *
+_load_skel(void)
+{
+  cap_t saved_caps = g_process_cap_save();
+  g_process_enable_cap("cap_bpf");
+  struct reuseport_kern *skel = reuseport_kern__open_and_load();
+  g_process_cap_restore(saved_caps);
 
-void
-ebpf_reuseport_set_sockets(LogDriverPlugin *s, gint number_of_sockets)
+  if (!skel)
+    msg_error("ebpf-reuseport(): Unable to load eBPF program to the kernel");
+  return skel;
+}
+
+static struct bpf_program *
+_get_program(struct reuseport_kern *skel, EBPFReusePortMode mode)
 {
-  EBPFReusePort *self = (EBPFReusePort *) s;
-  self->number_of_sockets = number_of_sockets;
+  switch (mode)
+    {
+    case EBPF_REUSEPORT_MODE_RANDOM:
+      return skel->progs.random_choice;
+    case EBPF_REUSEPORT_MODE_FLOW_HASH:
+      return skel->progs.flow_hash_choice;
+    case EBPF_REUSEPORT_MODE_SOURCE_HASH:
+      return skel->progs.source_hash_choice;
+    case EBPF_REUSEPORT_MODE_CPU:
+      return skel->progs.cpu_choice;
+    case EBPF_REUSEPORT_MODE_LOAD:
+      return skel->progs.load_choice;
+    default:
+      g_assert_not_reached();
+    }
 }
 
-static void
-_slot_setup_socket(EBPFReusePort *self, AFSocketSetupSocketSignalData *data)
+static gboolean
+_attach_program(gint sock, struct bpf_program *program)
 {
-  int bpf_fd = bpf_program__fd(self->random->progs.random_choice);
+  int bpf_fd = bpf_program__fd(program);
   if (bpf_fd < 0)
     {
       msg_error("ebpf-reuseport(): setsockopt(SO_ATTACH_REUSEPORT_EBPF) returned error",
                 evt_tag_errno("error", errno));
-      goto error;
+      return FALSE;
     }
 
-  if (setsockopt(data->sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_EBPF, &bpf_fd, sizeof(bpf_fd)) < 0)
+  if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_EBPF, &bpf_fd, sizeof(bpf_fd)) < 0)
     {
       msg_error("ebpf-reuseport(): setsockopt(SO_ATTACH_REUSEPORT_EBPF) returned error",
                 evt_tag_errno("error", errno));
-      goto error;
+      return FALSE;
+    }
+  return TRUE;
+}
+
+/* load mode */
+
+static void
+_group_free(EBPFReusePortGroup *self)
+{
+  if (iv_timer_registered(&self->load_update_timer))
+    iv_timer_unregister(&self->load_update_timer);
+  reuseport_kern__destroy(self->skel);
+  g_array_free(self->sockets, TRUE);
+  g_free(self->name);
+  g_free(self);
+}
+
+static gboolean
+_group_socket_is_open(EBPFReusePortSocket *member)
+{
+  struct stat st;
+
+  /* the fd may have been reused by another file since we have seen it */
+  return fstat(member->fd, &st) == 0 && st.st_ino == member->ino;
+}
+
+/* the kernel fills the hole of a removed socket with the last one, we do
+ * the same to keep the indexes in sync */
+static void
+_group_remove_closed_sockets(EBPFReusePortGroup *self)
+{
+  for (gint i = 0; i < self->sockets->len; )
+    {
+      if (_group_socket_is_open(&g_array_index(self->sockets, EBPFReusePortSocket, i)))
+        i++;
+      else
+        g_array_remove_index_fast(self->sockets, i);
+    }
+  self->skel->bss->number_of_sockets = self->sockets->len;
+}
+
+static void
+_group_update_load(EBPFReusePortGroup *self)
+{
+  int map_fd = bpf_map__fd(self->skel->maps.socket_load);
+
+  for (guint32 i = 0; i < self->sockets->len; i++)
+    {
+      EBPFReusePortSocket *member = &g_array_index(self->sockets, EBPFReusePortSocket, i);
+      guint32 meminfo[SK_MEMINFO_VARS];
+      socklen_t meminfo_len = sizeof(meminfo);
+
+      if (getsockopt(member->fd, SOL_SOCKET, SO_MEMINFO, &meminfo, &meminfo_len) < 0)
+        continue;
+
+      guint32 load = meminfo[SK_MEMINFO_RMEM_ALLOC];
+      bpf_map_update_elem(map_fd, &i, &load, BPF_ANY);
+    }
+}
+
+static void
+_group_start_load_update_timer(EBPFReusePortGroup *self)
+{
+  iv_validate_now();
+  self->load_update_timer.expires = iv_now;
+  timespec_add_msec(&self->load_update_timer.expires, EBPF_REUSEPORT_LOAD_UPDATE_MSECS);
+  iv_timer_register(&self->load_update_timer);
+}
+
+static void
+_group_on_load_update_timer_elapsed(gpointer cookie)
+{
+  EBPFReusePortGroup *self = (EBPFReusePortGroup *) cookie;
+
+  _group_remove_closed_sockets(self);
+  if (self->sockets->len == 0)
+    {
+      g_hash_table_remove(reuseport_groups, self->name);
+      return;
+    }
+
+  _group_update_load(self);
+  _group_start_load_update_timer(self);
+}
+
+static EBPFReusePortGroup *
+_group_new(const gchar *name)
+{
+  struct reuseport_kern *skel = _load_skel();
+  if (!skel)
+    return NULL;
+
+  EBPFReusePortGroup *self = g_new0(EBPFReusePortGroup, 1);
+  self->name = g_strdup(name);
+  self->skel = skel;
+  self->sockets = g_array_new(FALSE, TRUE, sizeof(EBPFReusePortSocket));
+
+  IV_TIMER_INIT(&self->load_update_timer);
+  self->load_update_timer.cookie = self;
+  self->load_update_timer.handler = _group_on_load_update_timer_elapsed;
+  _group_start_load_update_timer(self);
+  return self;
+}
+
+static void
+_free_groups(gint type, gpointer user_data)
+{
+  g_clear_pointer(&reuseport_groups, g_hash_table_destroy);
+}
+
+static gboolean
+_format_group_name(gint sock, gchar *buf, gsize buf_len)
+{
+  struct sockaddr_storage sa;
+  socklen_t sa_len = sizeof(sa);
+  gint sock_type;
+  socklen_t sock_type_len = sizeof(sock_type);
+
+  if (getsockname(sock, (struct sockaddr *) &sa, &sa_len) < 0 ||
+      getsockopt(sock, SOL_SOCKET, SO_TYPE, &sock_type, &sock_type_len) < 0)
+    {
+      msg_error("ebpf-reuseport(): unable to query the local address of the socket",
+                evt_tag_errno("error", errno));
+      return FALSE;
     }
 
-  msg_info("ebpf-reuseport(): eBPF reuseport group randomizer applied",
-           evt_tag_int("sock", data->sock));
+  GSockAddr *addr = g_sockaddr_new((struct sockaddr *) &sa, sa_len);
+  gchar addr_buf[256];
 
-  return;
-error:
-  data->failure = TRUE;
+  g_snprintf(buf, buf_len, "%s:%s", sock_type == SOCK_DGRAM ? "dgram" : "stream",
+             g_sockaddr_format(addr, addr_buf, sizeof(addr_buf), GSA_FULL));
+  g_sockaddr_unref(addr);
+  return TRUE;
 }
 
+static EBPFReusePortGroup *
+_lookup_or_create_group(gint sock)
+{
+  gchar name[300];
+
+  if (!_format_group_name(sock, name, sizeof(name)))
+    return NULL;
+
+  if (!reuseport_groups)
+    {
+      reuseport_groups = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify) _group_free);
+      register_application_hook(AH_PRE_SHUTDOWN, _free_groups, NULL, AHM_RUN_ONCE);
+    }
+
+  EBPFReusePortGroup *group = g_hash_table_lookup(reuseport_groups, name);
+  if (group)
+    return group;
+
+  group = _group_new(name);
+  if (group)
+    g_hash_table_insert(reuseport_groups, group->name, group);
+  return group;
+}
 
 static gboolean
-_attach(LogDriverPlugin *s, LogDriver *driver)
+_join_group(gint sock)
 {
-  EBPFReusePort *self = (EBPFReusePort *)s;
+  EBPFReusePortGroup *group = _lookup_or_create_group(sock);
+  struct stat st;
 
-  cap_t saved_caps = g_process_cap_save();
-  g_process_enable_cap("cap_bpf");
-  self->random = random_kern__open_and_load();
-  g_process_cap_restore(saved_caps);
+  if (!group)
+    return FALSE;
 
-  if (!self->random)
+  _group_remove_closed_sockets(group);
+  if (group->sockets->len >= EBPF_REUSEPORT_MAX_SOCKETS)
     {
-      msg_error("ebpf-reuseport(): Unable to load eBPF program to the kernel");
+      msg_error("ebpf-reuseport(): too many sockets in reuseport group",
+                evt_tag_str("group", group->name),
+                evt_tag_int("max_sockets", EBPF_REUSEPORT_MAX_SOCKETS));
       return FALSE;
     }
-  self->random->bss->number_of_sockets = self->number_of_sockets;
+
+  if (fstat(sock, &st) < 0 || !_attach_program(sock, group->skel->progs.load_choice))
+    return FALSE;
+
+  /* the socket is already bound, so it is the last member of the group */
+  EBPFReusePortSocket member = { .fd = sock, .ino = st.st_ino };
+  g_array_append_val(group->sockets, member);
+  group->skel->bss->number_of_sockets = group->sockets->len;
+  return TRUE;
+}
+
+gboolean
+ebpf_reuseport_set_mode(LogDriverPlugin *s, const gchar *mode)
+{
+  EBPFReusePort *self = (EBPFReusePort *) s;
+
+  if (strcmp(mode, "random") == 0)
+    self->mode = EBPF_REUSEPORT_MODE_RANDOM;
+  else if (strcmp(mode, "flow-hash") == 0)
+    self->mode = EBPF_REUSEPORT_MODE_FLOW_HASH;
+  else if (strcmp(mode, "source-hash") == 0)
+    self->mode = EBPF_REUSEPORT_MODE_SOURCE_HASH;
+  else if (strcmp(mode, "cpu") == 0)
+    self->mode = EBPF_REUSEPORT_MODE_CPU;
+  else if (strcmp(mode, "load") == 0)
+    self->mode = EBPF_REUSEPORT_MODE_LOAD;
+  else
+    return FALSE;
+  return TRUE;
+}
+
+void
+ebpf_reuseport_set_sockets(LogDriverPlugin *s, gint number_of_sockets)
+{
+  EBPFReusePort *self = (EBPFReusePort *) s;
+  self->number_of_sockets = number_of_sockets;
+}
+
+static void
+_slot_setup_socket(EBPFReusePort *self, AFSocketSetupSocketSignalData *data)
+{
+  gboolean success;
+
+  if (self->mode == EBPF_REUSEPORT_MODE_LOAD)
+    success = _join_group(data->sock);
+  else
+    success = _attach_program(data->sock, _get_program(self->skel, self->mode));
+
+  if (!success)
+    {
+      data->failure = TRUE;
+      return;
+    }
+
+  msg_info("ebpf-reuseport(): eBPF reuseport group steering applied",
+           evt_tag_int("sock", data->sock),
+           evt_tag_str("program", bpf_program__name(_get_program(self->skel, self->mode))));
+}
+
+
+static gboolean
+_attach(LogDriverPlugin *s, LogDriver *driver)
+{
+  EBPFReusePort *self = (EBPFReusePort *)s;
+
+  /* in load mode the group loads the program it attaches, our copy is
+   * only used to report loading errors at startup */
+  self->skel = _load_skel();
+  if (!self->skel)
+    return FALSE;
+  self->skel->bss->number_of_sockets = self->number_of_sockets;
 
   SignalSlotConnector *ssc = driver->signal_slot_connector;
   CONNECT(ssc, signal_afsocket_setup_socket, _slot_setup_socket, self);
@@ -108,8 +393,8 @@ _free(LogDriverPlugin *s)
 {
   EBPFReusePort *self = (EBPFReusePort *) s;
 
-  if (self->random)
-    random_kern__destroy(self->random);
+  if (self->skel)
+    reuseport_kern__destroy(self->skel);
   log_driver_plugin_free_method(s);
 }
 
@@ -122,6 +407,7 @@ ebpf_reuseport_new(void)
   self->super.attach = _attach;
   self->super.detach = _detach;
   self->super.free_fn = _free;
+  self->mode = EBPF_REUSEPORT_MODE_RANDOM;
   self->number_of_sockets = 0;
 
   return &self->super;
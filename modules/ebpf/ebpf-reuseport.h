@@ -25,6 +25,16 @@
 
 #include "driver.h"
 
+typedef enum
+{
+  EBPF_REUSEPORT_MODE_RANDOM,
+  EBPF_REUSEPORT_MODE_FLOW_HASH,
+  EBPF_REUSEPORT_MODE_SOURCE_HASH,
+  EBPF_REUSEPORT_MODE_CPU,
+  EBPF_REUSEPORT_MODE_LOAD,
+} EBPFReusePortMode;
+
+gboolean ebpf_reuseport_set_mode(LogDriverPlugin *s, const gchar *mode);
 void ebpf_reuseport_set_sockets(LogDriverPlugin *s, gint number_of_sockets);
 LogDriverPlugin *ebpf_reuseport_new(void);
 
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2023 Balazs Scheidler <bazsi77@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+
+#include "vmlinux.h"
+#include <bpf/bpf_helpers.h>
+
+/* must be kept in sync with EBPF_REUSEPORT_MAX_SOCKETS in ebpf-reuseport.c */
+#define MAX_SOCKETS 256
+
+int number_of_sockets;
+
+/* receive queue depth of each socket in the reuseport group, indexed by
+ * the position of the socket within the group, updated from userspace */
+struct
+{
+  __uint(type, BPF_MAP_TYPE_ARRAY);
+  __uint(max_entries, MAX_SOCKETS);
+  __type(key, __u32);
+  __type(value, __u32);
+} socket_load SEC(".maps");
+
+static __always_inline __u32
+_hash_mix(__u32 hash, __u32 value)
+{
+  hash ^= value;
+  hash *= 0x9e3779b1;
+  return hash ^ (hash >> 15);
+}
+
+static __always_inline __u32
+_hash_addresses(struct __sk_buff *skb, __u32 offset, __u32 *words, __u32 num_words)
+{
+  __u32 hash = 0;
+
+  if (bpf_skb_load_bytes_relative(skb, offset, words, num_words * sizeof(__u32), BPF_HDR_START_NET) < 0)
+    return 0;
+
+  for (__u32 i = 0; i < num_words; i++)
+    hash = _hash_mix(hash, words[i]);
+  return hash;
+}
+
+static __always_inline __u32
+_hash_ports(struct __sk_buff *skb, __u32 hash, __u8 protocol, __u32 offset)
+{
+  __u32 ports;
+
+  if (protocol != IPPROTO_UDP && protocol != IPPROTO_TCP)
+    return hash;
+
+  if (bpf_skb_load_bytes_relative(skb, offset, &ports, sizeof(ports), BPF_HDR_START_NET) < 0)
+    return hash;
+  return _hash_mix(hash, ports);
+}
+
+/* hashes the source address of the packet, and when include_ports is set,
+ * also the destination address, the protocol and both ports */
+static __always_inline __u32
+_hash_flow(struct __sk_buff *skb, bool include_ports)
+{
+  __u32 words[8];
+  __u8 header[10];
+  __u32 hash;
+
+  if (bpf_skb_load_bytes_relative(skb, 0, header, sizeof(header), BPF_HDR_START_NET) < 0)
+    return bpf_get_prandom_u32();
+
+  if ((header[0] >> 4) == 4)
+    {
+      if (!include_ports)
+        return _hash_addresses(skb, 12, words, 1);
+
+      hash = _hash_mix(_hash_addresses(skb, 12, words, 2), header[9]);
+      return _hash_ports(skb, hash, header[9], (header[0] & 0x0f) * 4);
+    }
+  else if ((header[0] >> 4) == 6)
+    {
+      if (!include_ports)
+        return _hash_addresses(skb, 8, words, 4);
+
+      /* extension headers are not followed, the ports are only hashed if
+       * the transport header immediately follows the fixed header */
+      hash = _hash_mix(_hash_addresses(skb, 8, words, 8), header[6]);
+      return _hash_ports(skb, hash, header[6], 40);
+    }
+
+  return bpf_get_prandom_u32();
+}
+
+SEC("socket")
+int random_choice(struct __sk_buff *skb)
+{
+  if (number_of_sockets == 0)
+    return -1;
+
+  return bpf_get_prandom_u32() % number_of_sockets;
+}
+
+SEC("socket")
+int flow_hash_choice(struct __sk_buff *skb)
+{
+  if (number_of_sockets == 0)
+    return -1;
+
+  return _hash_flow(skb, true) % number_of_sockets;
+}
+
+SEC("socket")
+int source_hash_choice(struct __sk_buff *skb)
+{
+  if (number_of_sockets == 0)
+    return -1;
+
+  return _hash_flow(skb, false) % number_of_sockets;
+}
+
+SEC("socket")
+int cpu_choice(struct __sk_buff *skb)
+{
+  if (number_of_sockets == 0)
+    return -1;
+
+  return bpf_get_smp_processor_id() % number_of_sockets;
+}
+
+/* power of two choices: pick two sockets at random and steer the packet
+ * to the one with the shorter receive queue */
+SEC("socket")
+int load_choice(struct __sk_buff *skb)
+{
+  if (number_of_sockets == 0)
+    return -1;
+
+  __u32 first = bpf_get_prandom_u32() % number_of_sockets;
+  __u32 second = bpf_get_prandom_u32() % number_of_sockets;
+  __u32 *first_load = bpf_map_lookup_elem(&socket_load, &first);
+  __u32 *second_load = bpf_map_lookup_elem(&socket_load, &second);
+
+  if (!first_load || !second_load)
+    return first;
+
+  return *second_load < *first_load ? second : first;
+}
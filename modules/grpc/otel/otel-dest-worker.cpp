@@ -30,6 +30,7 @@
 #include <google/protobuf/util/message_differencer.h>
 
 #include "otel-dest-worker.hpp"
+#include "otel-logmsg-handles.hpp"
 
 using namespace syslogng::grpc::otel;
 using namespace google::protobuf::util;
@@ -37,6 +38,50 @@ using namespace opentelemetry::proto::logs::v1;
 using namespace opentelemetry::proto::metrics::v1;
 using namespace opentelemetry::proto::trace::v1;
 
+/* Passthrough helpers */
+
+static const gchar *
+_get_raw_protobuf(LogMessage *msg, NVHandle handle, gssize *len)
+{
+  LogMessageValueType type;
+  const gchar *value = log_msg_get_value_with_type(msg, handle, len, &type);
+
+  if (type != LM_VT_PROTOBUF)
+    return NULL;
+
+  return value;
+}
+
+static inline bool
+_equals(const std::string &str, const gchar *value, gssize len)
+{
+  return str.length() == (size_t) len && memcmp(str.data(), value, len) == 0;
+}
+
+/*
+ * Appending an already serialized submessage as an unknown, length-delimited
+ * field produces the same wire format as setting (or adding to) the field
+ * with that number, without parsing the submessage.
+ */
+static inline void
+_append_raw_field(google::protobuf::Message *message, int field_number, const gchar *value, gssize len)
+{
+  message->GetReflection()->MutableUnknownFields(message)->AddLengthDelimited(field_number)->assign(value, len);
+}
+
+static inline void
+_append_raw_field(google::protobuf::Message *message, int field_number, const std::string &value)
+{
+  _append_raw_field(message, field_number, value.data(), value.length());
+}
+
+/* the resources of passthrough records are not parsed, they never match a formatted message's resource */
+static inline bool
+_is_passthrough(const google::protobuf::Message &resource_container)
+{
+  return !resource_container.GetReflection()->GetUnknownFields(resource_container).empty();
+}
+
 /* C++ Implementations */
 
 bool
@@ -47,12 +92,31 @@ DestWorker::init()
   logs_service_stub = LogsService::NewStub(channel);
   metrics_service_stub = MetricsService::NewStub(channel);
   trace_service_stub = TraceService::NewStub(channel);
+
+  if (get_owner()->get_max_in_flight() > 1)
+    completion_queue = std::make_unique<::grpc::CompletionQueue>();
+
   return true;
 }
 
 void
 DestWorker::deinit()
 {
+  if (completion_queue)
+    {
+      abandon_in_flight_exports();
+      completion_queue->Shutdown();
+
+      void *tag;
+      bool ok;
+      while (completion_queue->Next(&tag, &ok))
+        ;
+      completion_queue.reset();
+    }
+
+  log_msg_unref(client_context_msg);
+  client_context_msg = nullptr;
+
   this->logs_service_stub.reset();
   this->metrics_service_stub.reset();
   this->trace_service_stub.reset();
@@ -87,6 +151,63 @@ DestWorker::DestWorker(GrpcDestWorker *s)
 {
 }
 
+DestDriver *
+DestWorker::get_owner()
+{
+  return static_cast<DestDriver *>(&this->owner);
+}
+
+void
+DestWorker::prepare_client_context(LogMessage *msg)
+{
+  if (client_context.get())
+    return;
+
+  client_context = std::make_unique<::grpc::ClientContext>();
+  prepare_context_dynamic(*client_context, msg);
+
+  /* a ClientContext can only be used for a single call, further Export()
+   * calls of the same batch need their own, see take_client_context() */
+  if (completion_queue)
+    client_context_msg = log_msg_ref(msg);
+}
+
+std::unique_ptr<::grpc::ClientContext>
+DestWorker::take_client_context()
+{
+  if (client_context.get())
+    return std::move(client_context);
+
+  auto context = std::make_unique<::grpc::ClientContext>();
+  if (client_context_msg)
+    prepare_context_dynamic(*context, client_context_msg);
+
+  return context;
+}
+
+void
+DestWorker::reset_batch()
+{
+  client_context.reset();
+  log_msg_unref(client_context_msg);
+  client_context_msg = nullptr;
+  fallback_msg_scope_logs = nullptr;
+  raw_scope_logs.clear();
+  raw_scope_metrics.clear();
+  raw_scope_spans.clear();
+
+  arena.Reset();
+
+  logs_service_request = arena.CreateMessage<ExportLogsServiceRequest>();
+  logs_service_response = arena.CreateMessage<ExportLogsServiceResponse>();
+  metrics_service_request = arena.CreateMessage<ExportMetricsServiceRequest>();
+  metrics_service_response = arena.CreateMessage<ExportMetricsServiceResponse>();
+  trace_service_request = arena.CreateMessage<ExportTraceServiceRequest>();
+  trace_service_response = arena.CreateMessage<ExportTraceServiceResponse>();
+
+  logs_current_batch_bytes = metrics_current_batch_bytes = spans_current_batch_bytes = 0;
+}
+
 void
 DestWorker::clear_current_msg_metadata()
 {
@@ -116,6 +237,8 @@ DestWorker::lookup_scope_logs(LogMessage *msg)
   for (int i = 0; i < logs_service_request->resource_logs_size(); i++)
     {
       ResourceLogs *possible_resource_logs = logs_service_request->mutable_resource_logs(i);
+      if (_is_passthrough(*possible_resource_logs))
+        continue;
       if (MessageDifferencer::Equals(possible_resource_logs->resource(), current_msg_metadata.resource) &&
           possible_resource_logs->schema_url() == current_msg_metadata.resource_schema_url)
         {
@@ -166,6 +289,8 @@ DestWorker::lookup_fallback_scope_logs(LogMessage *msg)
   for (int i = 0; i < logs_service_request->resource_logs_size(); i++)
     {
       ResourceLogs *possible_resource_logs = logs_service_request->mutable_resource_logs(i);
+      if (_is_passthrough(*possible_resource_logs))
+        continue;
       if (MessageDifferencer::Equals(possible_resource_logs->resource(), current_msg_metadata.resource) &&
           possible_resource_logs->schema_url() == current_msg_metadata.resource_schema_url)
         {
@@ -192,6 +317,8 @@ DestWorker::lookup_scope_metrics(LogMessage *msg)
   for (int i = 0; i < metrics_service_request->resource_metrics_size(); i++)
     {
       ResourceMetrics *possible_resource_metrics = metrics_service_request->mutable_resource_metrics(i);
+      if (_is_passthrough(*possible_resource_metrics))
+        continue;
       if (MessageDifferencer::Equals(possible_resource_metrics->resource(), current_msg_metadata.resource) &&
           possible_resource_metrics->schema_url() == current_msg_metadata.resource_schema_url)
         {
@@ -236,6 +363,8 @@ DestWorker::lookup_scope_spans(LogMessage *msg)
   for (int i = 0; i < trace_service_request->resource_spans_size(); i++)
     {
       ResourceSpans *possible_resource_spans = trace_service_request->mutable_resource_spans(i);
+      if (_is_passthrough(*possible_resource_spans))
+        continue;
       if (MessageDifferencer::Equals(possible_resource_spans->resource(), current_msg_metadata.resource) &&
           possible_resource_spans->schema_url() == current_msg_metadata.resource_schema_url)
         {
@@ -271,6 +400,120 @@ DestWorker::lookup_scope_spans(LogMessage *msg)
   return scope_spans;
 }
 
+RawScope *
+DestWorker::lookup_raw_scope(std::vector<RawScope> &raw_scopes, LogMessage *msg)
+{
+  gssize resource_len, resource_schema_url_len, scope_len, scope_schema_url_len;
+
+  const gchar *resource = _get_raw_protobuf(msg, logmsg_handle::RAW_RESOURCE, &resource_len);
+  const gchar *scope = _get_raw_protobuf(msg, logmsg_handle::RAW_SCOPE, &scope_len);
+  if (!resource || !scope)
+    return nullptr;
+
+  const gchar *resource_schema_url = log_msg_get_value(msg, logmsg_handle::RAW_RESOURCE_SCHEMA_URL,
+                                                       &resource_schema_url_len);
+  const gchar *scope_schema_url = log_msg_get_value(msg, logmsg_handle::RAW_SCOPE_SCHEMA_URL,
+                                                    &scope_schema_url_len);
+
+  google::protobuf::Message *resource_container = nullptr;
+  for (RawScope &raw_scope : raw_scopes)
+    {
+      if (!_equals(raw_scope.resource, resource, resource_len) ||
+          !_equals(raw_scope.resource_schema_url, resource_schema_url, resource_schema_url_len))
+        continue;
+
+      if (_equals(raw_scope.scope, scope, scope_len) &&
+          _equals(raw_scope.scope_schema_url, scope_schema_url, scope_schema_url_len))
+        return &raw_scope;
+
+      resource_container = raw_scope.resource_container;
+    }
+
+  raw_scopes.push_back(RawScope
+  {
+    std::string(resource, resource_len),
+    std::string(resource_schema_url, resource_schema_url_len),
+    std::string(scope, scope_len),
+    std::string(scope_schema_url, scope_schema_url_len),
+    resource_container,
+    nullptr,
+  });
+
+  return &raw_scopes.back();
+}
+
+/*
+ * Messages received by opentelemetry() and not parsed since then still carry
+ * their serialized record. These are forwarded as-is, without decoding and
+ * re-encoding them. Parsed (and possibly modified) messages take the
+ * insert_*_from_log_msg() path.
+ */
+template <typename Request, typename ResourceContainer, typename ScopeContainer>
+bool
+DestWorker::insert_raw_record_from_log_msg(LogMessage *msg, NVHandle record_handle, int records_field_number,
+                                           Request *request,
+                                           ResourceContainer *(Request::*add_resource_container)(),
+                                           ScopeContainer *(ResourceContainer::*add_scope_container)(),
+                                           std::vector<RawScope> &raw_scopes, size_t &current_batch_bytes)
+{
+  gssize len;
+  const gchar *raw_record = _get_raw_protobuf(msg, record_handle, &len);
+  if (!raw_record)
+    return false;
+
+  RawScope *raw_scope = lookup_raw_scope(raw_scopes, msg);
+  if (!raw_scope)
+    return false;
+
+  if (!raw_scope->scope_container)
+    {
+      ResourceContainer *resource_container = static_cast<ResourceContainer *>(raw_scope->resource_container);
+      if (!resource_container)
+        {
+          resource_container = (request->*add_resource_container)();
+          _append_raw_field(resource_container, ResourceContainer::kResourceFieldNumber, raw_scope->resource);
+          resource_container->set_schema_url(raw_scope->resource_schema_url);
+          raw_scope->resource_container = resource_container;
+        }
+
+      ScopeContainer *scope_container = (resource_container->*add_scope_container)();
+      _append_raw_field(scope_container, ScopeContainer::kScopeFieldNumber, raw_scope->scope);
+      scope_container->set_schema_url(raw_scope->scope_schema_url);
+      raw_scope->scope_container = scope_container;
+    }
+
+  _append_raw_field(raw_scope->scope_container, records_field_number, raw_record, len);
+
+  current_batch_bytes += len;
+  log_threaded_dest_driver_insert_msg_length_stats(super->super.owner, len);
+  return true;
+}
+
+bool
+DestWorker::insert_raw_log_record_from_log_msg(LogMessage *msg)
+{
+  return insert_raw_record_from_log_msg(msg, logmsg_handle::RAW_LOG, ScopeLogs::kLogRecordsFieldNumber,
+                                        logs_service_request, &ExportLogsServiceRequest::add_resource_logs,
+                                        &ResourceLogs::add_scope_logs, raw_scope_logs, logs_current_batch_bytes);
+}
+
+bool
+DestWorker::insert_raw_metric_from_log_msg(LogMessage *msg)
+{
+  return insert_raw_record_from_log_msg(msg, logmsg_handle::RAW_METRIC, ScopeMetrics::kMetricsFieldNumber,
+                                        metrics_service_request, &ExportMetricsServiceRequest::add_resource_metrics,
+                                        &ResourceMetrics::add_scope_metrics, raw_scope_metrics,
+                                        metrics_current_batch_bytes);
+}
+
+bool
+DestWorker::insert_raw_span_from_log_msg(LogMessage *msg)
+{
+  return insert_raw_record_from_log_msg(msg, logmsg_handle::RAW_SPAN, ScopeSpans::kSpansFieldNumber,
+                                        trace_service_request, &ExportTraceServiceRequest::add_resource_spans,
+                                        &ResourceSpans::add_scope_spans, raw_scope_spans, spans_current_batch_bytes);
+}
+
 bool
 DestWorker::insert_log_record_from_log_msg(LogMessage *msg)
 {
@@ -350,14 +593,20 @@ DestWorker::insert(LogMessage *msg)
   switch (type)
     {
     case MessageType::LOG:
+      if (insert_raw_log_record_from_log_msg(msg))
+        break;
       if (!insert_log_record_from_log_msg(msg))
         goto drop;
       break;
     case MessageType::METRIC:
+      if (insert_raw_metric_from_log_msg(msg))
+        break;
       if (!insert_metric_from_log_msg(msg))
         goto drop;
       break;
     case MessageType::SPAN:
+      if (insert_raw_span_from_log_msg(msg))
+        break;
       if (!insert_span_from_log_msg(msg))
         goto drop;
       break;
@@ -368,11 +617,7 @@ DestWorker::insert(LogMessage *msg)
       g_assert_not_reached();
     }
 
-  if (!client_context.get())
-    {
-      client_context = std::make_unique<::grpc::ClientContext>();
-      prepare_context_dynamic(*client_context, msg);
-    }
+  prepare_client_context(msg);
 
   if (should_initiate_flush())
     return log_threaded_dest_worker_flush(&super->super, LTF_FLUSH_NORMAL);
@@ -495,11 +740,253 @@ DestWorker::flush_spans()
   return result;
 }
 
+template <typename Stub, typename Request, typename Response>
+std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>>
+DestWorker::start_export_call(InFlightExport &in_flight_export, Stub &stub, Request *request, Response *response,
+                              size_t batch_bytes)
+{
+  InFlightExport::Call &call = in_flight_export.calls[in_flight_export.num_calls++];
+  call.owner = &in_flight_export;
+  call.context = take_client_context();
+  call.batch_bytes = batch_bytes;
+  call.completed = false;
+  in_flight_export.pending_calls++;
+
+  auto reader = stub.AsyncExport(call.context.get(), *request, completion_queue.get());
+  reader->Finish(response, &call.status, &call);
+  return reader;
+}
+
+void
+DestWorker::start_export_calls(InFlightExport &in_flight_export)
+{
+  if (logs_service_request->resource_logs_size() > 0)
+    in_flight_export.logs_reader = start_export_call(in_flight_export, *logs_service_stub, logs_service_request,
+                                                     logs_service_response, logs_current_batch_bytes);
+
+  if (metrics_service_request->resource_metrics_size() > 0)
+    in_flight_export.metrics_reader = start_export_call(in_flight_export, *metrics_service_stub,
+                                                        metrics_service_request, metrics_service_response,
+                                                        metrics_current_batch_bytes);
+
+  if (trace_service_request->resource_spans_size() > 0)
+    in_flight_export.trace_reader = start_export_call(in_flight_export, *trace_service_stub, trace_service_request,
+                                                      trace_service_response, spans_current_batch_bytes);
+}
+
+bool
+DestWorker::next_completion(void **tag, bool blocking)
+{
+  bool ok;
+
+  if (blocking)
+    return completion_queue->Next(tag, &ok);
+
+  ::grpc::CompletionQueue::NextStatus status = completion_queue->AsyncNext(tag, &ok, std::chrono::system_clock::now());
+  return status == ::grpc::CompletionQueue::GOT_EVENT;
+}
+
+void
+DestWorker::cancel_export_call(InFlightExport::Call &call)
+{
+  call.context->TryCancel();
+}
+
+void
+DestWorker::complete_export_call(InFlightExport::Call *call)
+{
+  InFlightExport *in_flight_export = call->owner;
+
+  call->completed = true;
+  in_flight_export->pending_calls--;
+
+  owner.metrics.insert_grpc_request_stats(call->status);
+
+  LogThreadedResult result;
+  if (!owner.handle_response(call->status, &result))
+    result = _map_grpc_status_to_log_threaded_result(call->status);
+
+  if (result == LTR_SUCCESS)
+    {
+      log_threaded_dest_worker_written_bytes_add(&super->super, call->batch_bytes);
+      log_threaded_dest_driver_insert_batch_length_stats(super->super.owner, call->batch_bytes);
+    }
+  else if (in_flight_export->result == LTR_SUCCESS)
+    {
+      in_flight_export->result = result;
+    }
+}
+
+bool
+DestWorker::process_next_completion(bool blocking)
+{
+  void *tag;
+
+  if (!next_completion(&tag, blocking))
+    return false;
+
+  complete_export_call(static_cast<InFlightExport::Call *>(tag));
+  return true;
+}
+
+void
+DestWorker::retire_oldest_export()
+{
+  gint batch_size = in_flight.front()->batch_size;
+
+  in_flight_batch_size -= batch_size;
+  super->super.batch_size += batch_size;
+  in_flight.pop_front();
+}
+
+/* gives back all in-flight messages to super.batch_size, so that the
+ * framework rewinds them together with the current batch */
+void
+DestWorker::abandon_in_flight_exports()
+{
+  int pending_calls = 0;
+
+  for (auto &in_flight_export : in_flight)
+    {
+      for (int i = 0; i < in_flight_export->num_calls; i++)
+        {
+          InFlightExport::Call &call = in_flight_export->calls[i];
+          if (!call.completed)
+            cancel_export_call(call);
+        }
+      pending_calls += in_flight_export->pending_calls;
+    }
+
+  /* the calls must finish before their contexts and arenas are freed */
+  void *tag;
+  while (pending_calls > 0 && next_completion(&tag, true))
+    {
+      InFlightExport::Call *call = static_cast<InFlightExport::Call *>(tag);
+      call->completed = true;
+      call->owner->pending_calls--;
+      pending_calls--;
+    }
+
+  while (!in_flight.empty())
+    retire_oldest_export();
+}
+
+LogThreadedResult
+DestWorker::retire_completed_exports()
+{
+  while (!in_flight.empty() && in_flight.front()->pending_calls == 0)
+    {
+      gint batch_size = in_flight.front()->batch_size;
+
+      switch (in_flight.front()->result)
+        {
+        case LTR_SUCCESS:
+          retire_oldest_export();
+          log_threaded_dest_worker_ack_messages(&super->super, batch_size);
+          break;
+
+        case LTR_DROP:
+          retire_oldest_export();
+          log_threaded_dest_worker_drop_messages(&super->super, batch_size);
+          break;
+
+        default:
+        {
+          LogThreadedResult result = in_flight.front()->result;
+
+          abandon_in_flight_exports();
+          return result;
+        }
+        }
+    }
+
+  return LTR_SUCCESS;
+}
+
+/* waits until no more than @max_in_flight batches remain in flight */
+LogThreadedResult
+DestWorker::wait_for_in_flight_exports(size_t max_in_flight)
+{
+  while (true)
+    {
+      while (process_next_completion(false))
+        ;
+
+      LogThreadedResult result = retire_completed_exports();
+      if (result != LTR_SUCCESS)
+        return result;
+
+      if (in_flight.size() <= max_in_flight)
+        return LTR_SUCCESS;
+
+      process_next_completion(true);
+    }
+}
+
+LogThreadedResult
+DestWorker::submit_batch()
+{
+  LogThreadedResult result = wait_for_in_flight_exports(get_owner()->get_max_in_flight() - 1);
+  if (result != LTR_SUCCESS)
+    return result;
+
+  in_flight.push_back(std::make_unique<InFlightExport>());
+  InFlightExport &in_flight_export = *in_flight.back();
+
+  /* the requests live in the arena, hand it over to the in-flight export */
+  std::swap(arena, in_flight_export.arena);
+  start_export_calls(in_flight_export);
+
+  in_flight_export.batch_size = super->super.batch_size;
+  in_flight_batch_size += super->super.batch_size;
+  super->super.batch_size = 0;
+
+  return LTR_SUCCESS;
+}
+
+LogThreadedResult
+DestWorker::flush_async(LogThreadedFlushMode mode)
+{
+  LogThreadedResult result = LTR_SUCCESS;
+
+  if (super->super.batch_size == 0 && in_flight.empty())
+    return LTR_SUCCESS;
+
+  if (mode == LTF_FLUSH_EXPEDITE)
+    {
+      abandon_in_flight_exports();
+      result = LTR_RETRY;
+      goto exit;
+    }
+
+  if (super->super.batch_size > 0)
+    {
+      result = submit_batch();
+      if (result != LTR_SUCCESS)
+        goto exit;
+    }
+
+  /* in-flight messages are not part of super.batch_size, the framework
+   * would not call us again once the queue becomes empty */
+  if (log_queue_get_length(super->super.queue) == 0)
+    result = wait_for_in_flight_exports(0);
+  else
+    result = wait_for_in_flight_exports(SIZE_MAX);
+
+exit:
+  reset_batch();
+
+  return result == LTR_SUCCESS ? LTR_EXPLICIT_ACK_MGMT : result;
+}
+
 LogThreadedResult
 DestWorker::flush(LogThreadedFlushMode mode)
 {
   LogThreadedResult result = LTR_SUCCESS;
 
+  if (completion_queue)
+    return flush_async(mode);
+
   if (mode == LTF_FLUSH_EXPEDITE)
     return LTR_RETRY;
 
@@ -525,19 +1012,7 @@ DestWorker::flush(LogThreadedFlushMode mode)
     }
 
 exit:
-  client_context.reset();
-  fallback_msg_scope_logs = nullptr;
-
-  arena.Reset();
-
-  logs_service_request = arena.CreateMessage<ExportLogsServiceRequest>();
-  logs_service_response = arena.CreateMessage<ExportLogsServiceResponse>();
-  metrics_service_request = arena.CreateMessage<ExportMetricsServiceRequest>();
-  metrics_service_response = arena.CreateMessage<ExportMetricsServiceResponse>();
-  trace_service_request = arena.CreateMessage<ExportTraceServiceRequest>();
-  trace_service_response = arena.CreateMessage<ExportTraceServiceResponse>();
-
-  logs_current_batch_bytes = metrics_current_batch_bytes = spans_current_batch_bytes = 0;
+  reset_batch();
 
   return result;
 }
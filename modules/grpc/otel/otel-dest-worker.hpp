@@ -35,6 +35,12 @@
 #include "otel-dest.hpp"
 #include "otel-protobuf-formatter.hpp"
 
+#include <grpcpp/completion_queue.h>
+
+#include <array>
+#include <deque>
+#include <vector>
+
 namespace syslogng {
 namespace grpc {
 namespace otel {
@@ -52,6 +58,44 @@ using opentelemetry::proto::logs::v1::ScopeLogs;
 using opentelemetry::proto::metrics::v1::ScopeMetrics;
 using opentelemetry::proto::trace::v1::ScopeSpans;
 
+/* resource and scope of the records spliced into a request in their serialized form */
+struct RawScope
+{
+  std::string resource;
+  std::string resource_schema_url;
+  std::string scope;
+  std::string scope_schema_url;
+  google::protobuf::Message *resource_container;
+  google::protobuf::Message *scope_container;
+};
+
+/* a flushed batch, waiting for the responses of its Export() calls */
+struct InFlightExport
+{
+  struct Call
+  {
+    InFlightExport *owner;
+    std::unique_ptr<::grpc::ClientContext> context;
+    ::grpc::Status status;
+    size_t batch_bytes;
+    bool completed;
+  };
+
+  /* owns the requests and responses of the calls */
+  SmartArena arena;
+  std::array<Call, 3> calls;
+
+  /* declared after calls: the readers must be destroyed before the contexts */
+  std::unique_ptr<::grpc::ClientAsyncResponseReader<ExportLogsServiceResponse>> logs_reader;
+  std::unique_ptr<::grpc::ClientAsyncResponseReader<ExportMetricsServiceResponse>> metrics_reader;
+  std::unique_ptr<::grpc::ClientAsyncResponseReader<ExportTraceServiceResponse>> trace_reader;
+
+  int num_calls = 0;
+  int pending_calls = 0;
+  gint batch_size = 0;
+  LogThreadedResult result = LTR_SUCCESS;
+};
+
 class DestWorker : public syslogng::grpc::DestWorker
 {
 public:
@@ -65,6 +109,12 @@ protected:
   void deinit() override;
   bool connect() override;
 
+  DestDriver *get_owner();
+
+  void prepare_client_context(LogMessage *msg);
+  std::unique_ptr<::grpc::ClientContext> take_client_context();
+  void reset_batch();
+
   void clear_current_msg_metadata();
   void get_metadata_for_current_msg(LogMessage *msg);
 
@@ -75,6 +125,16 @@ protected:
 
   bool should_initiate_flush();
 
+  RawScope *lookup_raw_scope(std::vector<RawScope> &raw_scopes, LogMessage *msg);
+  template <typename Request, typename ResourceContainer, typename ScopeContainer>
+  bool insert_raw_record_from_log_msg(LogMessage *msg, NVHandle record_handle, int records_field_number,
+                                      Request *request, ResourceContainer *(Request::*add_resource_container)(),
+                                      ScopeContainer *(ResourceContainer::*add_scope_container)(),
+                                      std::vector<RawScope> &raw_scopes, size_t &current_batch_bytes);
+  bool insert_raw_log_record_from_log_msg(LogMessage *msg);
+  bool insert_raw_metric_from_log_msg(LogMessage *msg);
+  bool insert_raw_span_from_log_msg(LogMessage *msg);
+
   bool insert_log_record_from_log_msg(LogMessage *msg);
   void insert_fallback_log_record_from_log_msg(LogMessage *msg);
   bool insert_metric_from_log_msg(LogMessage *msg);
@@ -84,8 +144,26 @@ protected:
   LogThreadedResult flush_metrics();
   LogThreadedResult flush_spans();
 
+  template <typename Stub, typename Request, typename Response>
+  std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>>
+  start_export_call(InFlightExport &in_flight_export, Stub &stub, Request *request, Response *response,
+                    size_t batch_bytes);
+  /* the completion queue is only accessed through these, so that tests can complete the calls */
+  virtual void start_export_calls(InFlightExport &in_flight_export);
+  virtual bool next_completion(void **tag, bool blocking);
+  virtual void cancel_export_call(InFlightExport::Call &call);
+  void complete_export_call(InFlightExport::Call *call);
+  bool process_next_completion(bool blocking);
+  void retire_oldest_export();
+  void abandon_in_flight_exports();
+  LogThreadedResult retire_completed_exports();
+  LogThreadedResult wait_for_in_flight_exports(size_t max_in_flight);
+  LogThreadedResult submit_batch();
+  LogThreadedResult flush_async(LogThreadedFlushMode mode);
+
 protected:
   std::unique_ptr<::grpc::ClientContext> client_context;
+  LogMessage *client_context_msg = nullptr;
   std::unique_ptr<LogsService::Stub> logs_service_stub;
   std::unique_ptr<MetricsService::Stub> metrics_service_stub;
   std::unique_ptr<TraceService::Stub> trace_service_stub;
@@ -111,6 +189,14 @@ protected:
   } current_msg_metadata;
 
   ScopeLogs *fallback_msg_scope_logs = nullptr;
+
+  std::vector<RawScope> raw_scope_logs;
+  std::vector<RawScope> raw_scope_metrics;
+  std::vector<RawScope> raw_scope_spans;
+
+  std::unique_ptr<::grpc::CompletionQueue> completion_queue;
+  std::deque<std::unique_ptr<InFlightExport>> in_flight;
+  gint in_flight_batch_size = 0;
 };
 
 }
@@ -29,7 +29,7 @@ using namespace syslogng::grpc::otel;
 /* C++ Implementations */
 
 DestDriver::DestDriver(GrpcDestDriver *s) :
-  syslogng::grpc::DestDriver(s)
+  syslogng::grpc::DestDriver(s), max_in_flight(1)
 {
   this->enable_dynamic_headers();
 }
@@ -74,6 +74,14 @@ DestDriver::construct_worker(int worker_index)
   return &worker->super;
 }
 
+void
+otel_dd_set_max_in_flight(LogDriver *s, gint max_in_flight)
+{
+  GrpcDestDriver *self = (GrpcDestDriver *) s;
+  DestDriver *cpp = static_cast<DestDriver *>(self->cpp);
+  cpp->set_max_in_flight((size_t) max_in_flight);
+}
+
 LogDriver *
 otel_dd_new(GlobalConfig *cfg)
 {
@@ -34,6 +34,7 @@
 typedef struct OtelDestDriver_ OtelDestDriver;
 
 LogDriver *otel_dd_new(GlobalConfig *cfg);
+void otel_dd_set_max_in_flight(LogDriver *s, gint max_in_flight);
 
 #include "compat/cpp-end.h"
 
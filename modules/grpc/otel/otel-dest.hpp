@@ -49,8 +49,20 @@ public:
   const char *generate_persist_name();
   LogThreadedDestWorker *construct_worker(int worker_index);
 
+  void set_max_in_flight(size_t m)
+  {
+    this->max_in_flight = m;
+  }
+
+  size_t get_max_in_flight() const
+  {
+    return this->max_in_flight;
+  }
+
 protected:
   friend class DestWorker;
+
+  size_t max_in_flight;
 };
 
 }
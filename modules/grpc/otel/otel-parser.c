@@ -38,6 +38,7 @@ static CfgLexerKeyword otel_keywords[] =
   { "syslog_ng_otlp",            KW_AXOSYSLOG_OTLP },
   { "set_hostname",              KW_SET_HOSTNAME },
   { "keep_alive",                KW_KEEP_ALIVE },
+  { "max_in_flight",             KW_MAX_IN_FLIGHT },
   { NULL }
 };
 
@@ -1121,20 +1121,31 @@ syslogng::grpc::otel::ProtobufParser::store_raw_metadata(LogMessage *msg, const
                                                          const InstrumentationScope &scope,
                                                          const std::string &scope_schema_url)
 {
-  std::string serialized;
+  store_raw_metadata(msg, peer, resource.SerializePartialAsString(), resource_schema_url,
+                     scope.SerializePartialAsString(), scope_schema_url);
+}
 
+/*
+ * Every record of a ResourceX/ScopeX shares the same resource and scope,
+ * the callers can serialize them once and store them for each record.
+ */
+void
+syslogng::grpc::otel::ProtobufParser::store_raw_metadata(LogMessage *msg, const ::grpc::string &peer,
+                                                         const std::string &serialized_resource,
+                                                         const std::string &resource_schema_url,
+                                                         const std::string &serialized_scope,
+                                                         const std::string &scope_schema_url)
+{
   msg->saddr = _extract_saddr(peer);
 
   /* .otel_raw.resource */
-  resource.SerializePartialToString(&serialized);
-  _set_value(msg, logmsg_handle::RAW_RESOURCE, serialized, LM_VT_PROTOBUF);
+  _set_value(msg, logmsg_handle::RAW_RESOURCE, serialized_resource, LM_VT_PROTOBUF);
 
   /* .otel_raw.resource_schema_url */
   _set_value(msg, logmsg_handle::RAW_RESOURCE_SCHEMA_URL, resource_schema_url, LM_VT_STRING);
 
   /* .otel_raw.scope */
-  scope.SerializePartialToString(&serialized);
-  _set_value(msg, logmsg_handle::RAW_SCOPE, serialized, LM_VT_PROTOBUF);
+  _set_value(msg, logmsg_handle::RAW_SCOPE, serialized_scope, LM_VT_PROTOBUF);
 
   /* .otel_raw.scope_schema_url */
   _set_value(msg, logmsg_handle::RAW_SCOPE_SCHEMA_URL, scope_schema_url, LM_VT_STRING);
@@ -63,6 +63,9 @@ public:
   static void store_raw_metadata(LogMessage *msg, const ::grpc::string &peer,
                                  const Resource &resource, const std::string &resource_schema_url,
                                  const InstrumentationScope &scope, const std::string &scope_schema_url);
+  static void store_raw_metadata(LogMessage *msg, const ::grpc::string &peer,
+                                 const std::string &serialized_resource, const std::string &resource_schema_url,
+                                 const std::string &serialized_scope, const std::string &scope_schema_url);
   static void store_raw(LogMessage *msg, const LogRecord &log_record);
   static void store_raw(LogMessage *msg, const Metric &metric);
   static void store_raw(LogMessage *msg, const Span &span);
@@ -99,11 +99,13 @@ syslogng::grpc::otel::TraceServiceCall::Proceed(bool ok)
     {
       const Resource &resource = resource_spans.resource();
       const std::string &resource_spans_schema_url = resource_spans.schema_url();
+      const std::string serialized_resource = resource.SerializePartialAsString();
 
       for (const ScopeSpans &scope_spans : resource_spans.scope_spans())
         {
           const InstrumentationScope &scope = scope_spans.scope();
           const std::string &scope_spans_schema_url = scope_spans.schema_url();
+          const std::string serialized_scope = scope.SerializePartialAsString();
 
           for (const Span &span : scope_spans.spans())
             {
@@ -116,8 +118,8 @@ syslogng::grpc::otel::TraceServiceCall::Proceed(bool ok)
               LogMessage *msg = log_msg_new_empty();
               log_msg_set_recvd_rawmsg_size(msg, span.ByteSizeLong());
 
-              ProtobufParser::store_raw_metadata(msg, ctx.peer(), resource, resource_spans_schema_url, scope,
-                                                 scope_spans_schema_url);
+              ProtobufParser::store_raw_metadata(msg, ctx.peer(), serialized_resource, resource_spans_schema_url,
+                                                 serialized_scope, scope_spans_schema_url);
               ProtobufParser::store_raw(msg, span);
               worker.blocking_post(msg);
 
@@ -156,11 +158,13 @@ syslogng::grpc::otel::LogsServiceCall::Proceed(bool ok)
     {
       const Resource &resource = resource_logs.resource();
       const std::string &resource_logs_schema_url = resource_logs.schema_url();
+      const std::string serialized_resource = resource.SerializePartialAsString();
 
       for (const ScopeLogs &scope_logs : resource_logs.scope_logs())
         {
           const InstrumentationScope &scope = scope_logs.scope();
           const std::string &scope_logs_schema_url = scope_logs.schema_url();
+          const std::string serialized_scope = scope.SerializePartialAsString();
 
           for (const LogRecord &log_record : scope_logs.log_records())
             {
@@ -180,8 +184,8 @@ syslogng::grpc::otel::LogsServiceCall::Proceed(bool ok)
                 }
               else
                 {
-                  ProtobufParser::store_raw_metadata(msg, ctx.peer(), resource, resource_logs_schema_url, scope,
-                                                     scope_logs_schema_url);
+                  ProtobufParser::store_raw_metadata(msg, ctx.peer(), serialized_resource, resource_logs_schema_url,
+                                                     serialized_scope, scope_logs_schema_url);
                   ProtobufParser::store_raw(msg, log_record);
                 }
               worker.blocking_post(msg);
@@ -221,11 +225,13 @@ syslogng::grpc::otel::MetricsServiceCall::Proceed(bool ok)
     {
       const Resource &resource = resource_metrics.resource();
       const std::string &resource_metrics_schema_url = resource_metrics.schema_url();
+      const std::string serialized_resource = resource.SerializePartialAsString();
 
       for (const ScopeMetrics &scope_metrics : resource_metrics.scope_metrics())
         {
           const InstrumentationScope &scope = scope_metrics.scope();
           const std::string &scope_metrics_schema_url = scope_metrics.schema_url();
+          const std::string serialized_scope = scope.SerializePartialAsString();
 
           for (const Metric &metric : scope_metrics.metrics())
             {
@@ -238,8 +244,8 @@ syslogng::grpc::otel::MetricsServiceCall::Proceed(bool ok)
               LogMessage *msg = log_msg_new_empty();
               log_msg_set_recvd_rawmsg_size(msg, metric.ByteSizeLong());
 
-              ProtobufParser::store_raw_metadata(msg, ctx.peer(), resource, resource_metrics_schema_url, scope,
-                                                 scope_metrics_schema_url);
+              ProtobufParser::store_raw_metadata(msg, ctx.peer(), serialized_resource, resource_metrics_schema_url,
+                                                 serialized_scope, scope_metrics_schema_url);
               ProtobufParser::store_raw(msg, metric);
               worker.blocking_post(msg);
 
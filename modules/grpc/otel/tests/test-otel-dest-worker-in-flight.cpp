@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "otel-dest-worker.hpp"
+#include "otel-logmsg-handles.hpp"
+
+#include "compat/cpp-start.h"
+#include "otel-dest.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "logqueue-fifo.h"
+#include "logthrdest/logthrdestdrv.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+#include "compat/cpp-end.h"
+
+#include <criterion/criterion.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+using namespace syslogng::grpc::otel;
+
+#define MAX_IN_FLIGHT 4
+#define BATCH_SIZE 3
+
+/*
+ * Replaces the Export() calls and the completion queue with a stub server,
+ * which responds in the order the test chooses. Each flushed batch is sent
+ * as a single call.
+ */
+class StubExportDestWorker : public DestWorker
+{
+public:
+  using DestWorker::DestWorker;
+  using DestWorker::flush_async;
+
+  /* the server responds to the call of the @export_index-th batch, the worker sees it at its next poll */
+  void respond(size_t export_index, const ::grpc::Status &status)
+  {
+    InFlightExport::Call *call = calls.at(export_index);
+
+    call->status = status;
+    responses.push_back(call);
+  }
+
+  /* the response only arrives once the worker blocks waiting for it */
+  void respond_later(size_t export_index, const ::grpc::Status &status)
+  {
+    delayed_responses.push_back(std::make_pair(export_index, status));
+  }
+
+  size_t get_num_in_flight() const
+  {
+    return in_flight.size();
+  }
+
+  int num_cancelled = 0;
+
+protected:
+  void start_export_calls(InFlightExport &in_flight_export) override
+  {
+    InFlightExport::Call &call = in_flight_export.calls[in_flight_export.num_calls++];
+
+    call.owner = &in_flight_export;
+    call.batch_bytes = 0;
+    call.completed = false;
+    in_flight_export.pending_calls++;
+    calls.push_back(&call);
+  }
+
+  bool next_completion(void **tag, bool blocking) override
+  {
+    if (responses.empty() && blocking && !delayed_responses.empty())
+      {
+        respond(delayed_responses.front().first, delayed_responses.front().second);
+        delayed_responses.pop_front();
+      }
+
+    if (responses.empty())
+      {
+        cr_assert_not(blocking, "the worker waits for a response that never arrives");
+        return false;
+      }
+
+    *tag = responses.front();
+    responses.pop_front();
+    return true;
+  }
+
+  void cancel_export_call(InFlightExport::Call &call) override
+  {
+    num_cancelled++;
+
+    if (std::find(responses.begin(), responses.end(), &call) != responses.end())
+      return;
+
+    size_t export_index = std::find(calls.begin(), calls.end(), &call) - calls.begin();
+    delayed_responses.erase(std::remove_if(delayed_responses.begin(), delayed_responses.end(),
+                                           [export_index](const std::pair<size_t, ::grpc::Status> &response)
+    {
+      return response.first == export_index;
+    }), delayed_responses.end());
+
+    respond(export_index, ::grpc::Status(::grpc::StatusCode::CANCELLED, "cancelled"));
+  }
+
+private:
+  std::vector<InFlightExport::Call *> calls;
+  std::deque<InFlightExport::Call *> responses;
+  std::deque<std::pair<size_t, ::grpc::Status>> delayed_responses;
+};
+
+static LogDriver *driver;
+static GrpcDestWorker *worker;
+static StubExportDestWorker *dest_worker;
+static LogQueue *queue;
+static std::vector<gint> acked_messages;
+
+static void
+_record_ack(LogMessage *msg, AckType ack_type)
+{
+  acked_messages.push_back(atoi(log_msg_get_value_by_name(msg, "SEQ", NULL)));
+}
+
+static void
+_feed_messages(gint num_messages)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  path_options.ack_needed = TRUE;
+
+  for (gint i = 0; i < num_messages; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+      gchar seq[16];
+
+      g_snprintf(seq, sizeof(seq), "%d", i);
+      log_msg_set_value_by_name(msg, "SEQ", seq, -1);
+      log_msg_add_ack(msg, &path_options);
+      msg->ack_func = _record_ack;
+      log_queue_push_tail(queue, msg, &path_options);
+    }
+}
+
+/* takes a batch from the queue the way the threaded destination does, and flushes it */
+static LogThreadedResult
+_send_batch(void)
+{
+  for (gint i = 0; i < BATCH_SIZE; i++)
+    {
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+      LogMessage *msg = log_queue_pop_head(queue, &path_options);
+
+      cr_assert_not_null(msg);
+      log_msg_unref(msg);
+      worker->super.batch_size++;
+    }
+
+  return dest_worker->flush_async(LTF_FLUSH_NORMAL);
+}
+
+static std::vector<gint>
+_range(gint first, gint last)
+{
+  std::vector<gint> range;
+
+  for (gint i = first; i < last; i++)
+    range.push_back(i);
+  return range;
+}
+
+static void
+_assert_acked_messages(const std::vector<gint> &expected)
+{
+  cr_assert_eq(acked_messages.size(), expected.size(), "unexpected number of acked messages: %zu",
+               acked_messages.size());
+  for (size_t i = 0; i < expected.size(); i++)
+    cr_assert_eq(acked_messages[i], expected[i], "message %d was acked out of queue order", acked_messages[i]);
+}
+
+/* rewinds the batch as the threaded destination does after an error, and checks the queue order */
+static void
+_rewind_and_assert_queue_order(const std::vector<gint> &expected)
+{
+  log_threaded_dest_worker_rewind_messages(&worker->super, worker->super.batch_size);
+  cr_assert_eq(worker->super.batch_size, 0);
+
+  for (gint seq : expected)
+    {
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+      LogMessage *msg = log_queue_pop_head(queue, &path_options);
+
+      cr_assert_not_null(msg);
+      cr_assert_eq(atoi(log_msg_get_value_by_name(msg, "SEQ", NULL)), seq, "messages were rewound out of queue order");
+      log_msg_unref(msg);
+    }
+  cr_assert_eq(log_queue_get_length(queue), 0);
+  log_queue_ack_backlog(queue, expected.size());
+}
+
+Test(otel_dest_worker_in_flight, out_of_order_responses_are_acked_in_queue_order)
+{
+  _feed_messages(4 * BATCH_SIZE);
+
+  for (gint i = 0; i < 3; i++)
+    cr_assert_eq(_send_batch(), LTR_EXPLICIT_ACK_MGMT);
+  cr_assert_eq(dest_worker->get_num_in_flight(), 3);
+  cr_assert_eq(worker->super.batch_size, 0);
+
+  dest_worker->respond(2, ::grpc::Status::OK);
+  dest_worker->respond(1, ::grpc::Status::OK);
+  cr_assert_eq(dest_worker->flush_async(LTF_FLUSH_NORMAL), LTR_EXPLICIT_ACK_MGMT);
+  _assert_acked_messages({});
+  cr_assert_eq(dest_worker->get_num_in_flight(), 3);
+
+  dest_worker->respond(0, ::grpc::Status::OK);
+  cr_assert_eq(dest_worker->flush_async(LTF_FLUSH_NORMAL), LTR_EXPLICIT_ACK_MGMT);
+  _assert_acked_messages(_range(0, 3 * BATCH_SIZE));
+  cr_assert_eq(dest_worker->get_num_in_flight(), 0);
+  cr_assert_eq(worker->super.batch_size, 0);
+  cr_assert_eq(stats_counter_get(((LogThreadedDestDriver *) driver)->metrics.written_messages), 3 * BATCH_SIZE);
+}
+
+Test(otel_dest_worker_in_flight, full_window_waits_for_the_oldest_export)
+{
+  _feed_messages((MAX_IN_FLIGHT + 2) * BATCH_SIZE);
+
+  for (gint i = 0; i < MAX_IN_FLIGHT; i++)
+    cr_assert_eq(_send_batch(), LTR_EXPLICIT_ACK_MGMT);
+
+  dest_worker->respond(1, ::grpc::Status::OK);
+  dest_worker->respond_later(0, ::grpc::Status::OK);
+  cr_assert_eq(_send_batch(), LTR_EXPLICIT_ACK_MGMT);
+
+  _assert_acked_messages(_range(0, 2 * BATCH_SIZE));
+  cr_assert_eq(dest_worker->get_num_in_flight(), MAX_IN_FLIGHT - 1);
+}
+
+Test(otel_dest_worker_in_flight, permanent_error_drops_only_the_failed_batch)
+{
+  _feed_messages(4 * BATCH_SIZE);
+
+  for (gint i = 0; i < 3; i++)
+    cr_assert_eq(_send_batch(), LTR_EXPLICIT_ACK_MGMT);
+
+  dest_worker->respond(1, ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "invalid"));
+  dest_worker->respond(2, ::grpc::Status::OK);
+  dest_worker->respond(0, ::grpc::Status::OK);
+  cr_assert_eq(dest_worker->flush_async(LTF_FLUSH_NORMAL), LTR_EXPLICIT_ACK_MGMT);
+
+  _assert_acked_messages(_range(0, 3 * BATCH_SIZE));
+  cr_assert_eq(stats_counter_get(((LogThreadedDestDriver *) driver)->metrics.written_messages), 2 * BATCH_SIZE);
+  cr_assert_eq(stats_counter_get(((LogThreadedDestDriver *) driver)->metrics.dropped_messages), BATCH_SIZE);
+  cr_assert_eq(dest_worker->get_num_in_flight(), 0);
+}
+
+Test(otel_dest_worker_in_flight, temporary_error_rewinds_the_window_in_queue_order)
+{
+  _feed_messages(5 * BATCH_SIZE);
+
+  for (gint i = 0; i < 4; i++)
+    cr_assert_eq(_send_batch(), LTR_EXPLICIT_ACK_MGMT);
+
+  /* the batch after the failed one already succeeded, the last one is still pending */
+  dest_worker->respond(2, ::grpc::Status::OK);
+  dest_worker->respond(1, ::grpc::Status(::grpc::StatusCode::UNAVAILABLE, "unavailable"));
+  cr_assert_eq(dest_worker->flush_async(LTF_FLUSH_NORMAL), LTR_EXPLICIT_ACK_MGMT);
+  _assert_acked_messages({});
+
+  dest_worker->respond(0, ::grpc::Status::OK);
+  cr_assert_eq(dest_worker->flush_async(LTF_FLUSH_NORMAL), LTR_NOT_CONNECTED);
+
+  _assert_acked_messages(_range(0, BATCH_SIZE));
+  cr_assert_eq(dest_worker->num_cancelled, 1);
+  cr_assert_eq(dest_worker->get_num_in_flight(), 0);
+  cr_assert_eq(worker->super.batch_size, 3 * BATCH_SIZE);
+
+  _rewind_and_assert_queue_order(_range(BATCH_SIZE, 5 * BATCH_SIZE));
+}
+
+Test(otel_dest_worker_in_flight, expedite_flush_abandons_all_in_flight_exports)
+{
+  _feed_messages(4 * BATCH_SIZE);
+
+  for (gint i = 0; i < 2; i++)
+    cr_assert_eq(_send_batch(), LTR_EXPLICIT_ACK_MGMT);
+
+  /* a response that arrived but was not processed yet is abandoned as well */
+  dest_worker->respond(0, ::grpc::Status::OK);
+  cr_assert_eq(dest_worker->flush_async(LTF_FLUSH_EXPEDITE), LTR_RETRY);
+
+  _assert_acked_messages({});
+  cr_assert_eq(dest_worker->get_num_in_flight(), 0);
+  cr_assert_eq(worker->super.batch_size, 2 * BATCH_SIZE);
+
+  _rewind_and_assert_queue_order(_range(0, 4 * BATCH_SIZE));
+}
+
+Test(otel_dest_worker_in_flight, drained_queue_waits_for_outstanding_exports)
+{
+  _feed_messages(2 * BATCH_SIZE);
+
+  cr_assert_eq(_send_batch(), LTR_EXPLICIT_ACK_MGMT);
+  _assert_acked_messages({});
+
+  /* the framework does not call flush() again once the queue is empty */
+  dest_worker->respond_later(1, ::grpc::Status::OK);
+  dest_worker->respond_later(0, ::grpc::Status::OK);
+  cr_assert_eq(_send_batch(), LTR_EXPLICIT_ACK_MGMT);
+
+  _assert_acked_messages(_range(0, 2 * BATCH_SIZE));
+  cr_assert_eq(dest_worker->get_num_in_flight(), 0);
+  cr_assert_eq(worker->super.batch_size, 0);
+}
+
+static void
+_register_counter(const gchar *name, StatsCounterItem **counter)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, name, NULL, 0);
+  stats_register_counter(STATS_LEVEL0, &sc_key, SC_TYPE_SINGLE_VALUE, counter);
+  stats_unlock();
+}
+
+void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  otel_logmsg_handles_global_init();
+
+  driver = otel_dd_new(configuration);
+  otel_dd_set_max_in_flight(driver, MAX_IN_FLIGHT);
+  _register_counter("test_written_messages", &((LogThreadedDestDriver *) driver)->metrics.written_messages);
+  _register_counter("test_dropped_messages", &((LogThreadedDestDriver *) driver)->metrics.dropped_messages);
+
+  queue = log_queue_fifo_new(1000, NULL, STATS_LEVEL0, NULL, NULL);
+  worker = grpc_dw_new((GrpcDestDriver *) driver, 0);
+  worker->super.queue = queue;
+  dest_worker = new StubExportDestWorker(worker);
+  worker->cpp = dest_worker;
+  acked_messages.clear();
+}
+
+void
+teardown(void)
+{
+  log_threaded_dest_worker_free(&worker->super);
+  log_queue_unref(queue);
+  log_pipe_unref(&driver->super);
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(otel_dest_worker_in_flight, .init = setup, .fini = teardown);
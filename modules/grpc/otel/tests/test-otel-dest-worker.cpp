@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "otel-dest-worker.hpp"
+#include "otel-protobuf-parser.hpp"
+#include "otel-logmsg-handles.hpp"
+
+#include "compat/cpp-start.h"
+#include "otel-dest.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "compat/cpp-end.h"
+
+#include <criterion/criterion.h>
+
+using namespace syslogng::grpc::otel;
+
+using namespace opentelemetry::proto::resource::v1;
+using namespace opentelemetry::proto::common::v1;
+using namespace opentelemetry::proto::logs::v1;
+using namespace opentelemetry::proto::metrics::v1;
+using namespace opentelemetry::proto::trace::v1;
+
+/* exposes the passthrough path and the requests being built */
+class TestDestWorker : public DestWorker
+{
+public:
+  using DestWorker::DestWorker;
+  using DestWorker::insert_raw_log_record_from_log_msg;
+  using DestWorker::insert_raw_metric_from_log_msg;
+  using DestWorker::insert_raw_span_from_log_msg;
+
+  /* the raw records are unknown fields, serializing and parsing makes them regular ones */
+  template <typename Request>
+  static Request reparse(const Request &request)
+  {
+    Request parsed;
+    cr_assert(parsed.ParseFromString(request.SerializeAsString()));
+    return parsed;
+  }
+
+  ExportLogsServiceRequest get_logs_request()
+  {
+    return reparse(*logs_service_request);
+  }
+
+  ExportMetricsServiceRequest get_metrics_request()
+  {
+    return reparse(*metrics_service_request);
+  }
+
+  ExportTraceServiceRequest get_trace_request()
+  {
+    return reparse(*trace_service_request);
+  }
+};
+
+static LogDriver *driver;
+static GrpcDestWorker *worker;
+static TestDestWorker *dest_worker;
+
+static LogMessage *
+_create_raw_msg(const std::string &resource_name, const std::string &scope_name)
+{
+  LogMessage *msg = log_msg_new_empty();
+  Resource resource;
+  InstrumentationScope scope;
+
+  KeyValue *attribute = resource.add_attributes();
+  attribute->set_key("service.name");
+  attribute->mutable_value()->set_string_value(resource_name);
+  scope.set_name(scope_name);
+
+  ProtobufParser::store_raw_metadata(msg, "", resource, resource_name + "_schema_url", scope,
+                                     scope_name + "_schema_url");
+  return msg;
+}
+
+static LogMessage *
+_create_raw_log_msg(const std::string &resource_name, const std::string &scope_name, const std::string &body)
+{
+  LogMessage *msg = _create_raw_msg(resource_name, scope_name);
+  LogRecord log_record;
+
+  log_record.mutable_body()->set_string_value(body);
+  ProtobufParser::store_raw(msg, log_record);
+  return msg;
+}
+
+Test(otel_dest_worker, raw_log_records_are_grouped_by_resource_and_scope)
+{
+  LogMessage *msgs[] =
+  {
+    _create_raw_log_msg("res_0", "scope_0", "body_0"),
+    _create_raw_log_msg("res_0", "scope_1", "body_1"),
+    _create_raw_log_msg("res_1", "scope_0", "body_2"),
+    _create_raw_log_msg("res_0", "scope_0", "body_3"),
+  };
+
+  for (LogMessage *msg : msgs)
+    {
+      cr_assert(dest_worker->insert_raw_log_record_from_log_msg(msg));
+      log_msg_unref(msg);
+    }
+
+  ExportLogsServiceRequest request = dest_worker->get_logs_request();
+  cr_assert_eq(request.resource_logs_size(), 2);
+
+  const ResourceLogs &resource_logs_0 = request.resource_logs(0);
+  cr_assert_str_eq(resource_logs_0.resource().attributes(0).value().string_value().c_str(), "res_0");
+  cr_assert_str_eq(resource_logs_0.schema_url().c_str(), "res_0_schema_url");
+  cr_assert_eq(resource_logs_0.scope_logs_size(), 2);
+
+  const ScopeLogs &scope_logs_0 = resource_logs_0.scope_logs(0);
+  cr_assert_str_eq(scope_logs_0.scope().name().c_str(), "scope_0");
+  cr_assert_str_eq(scope_logs_0.schema_url().c_str(), "scope_0_schema_url");
+  cr_assert_eq(scope_logs_0.log_records_size(), 2);
+  cr_assert_str_eq(scope_logs_0.log_records(0).body().string_value().c_str(), "body_0");
+  cr_assert_str_eq(scope_logs_0.log_records(1).body().string_value().c_str(), "body_3");
+
+  const ScopeLogs &scope_logs_1 = resource_logs_0.scope_logs(1);
+  cr_assert_str_eq(scope_logs_1.scope().name().c_str(), "scope_1");
+  cr_assert_eq(scope_logs_1.log_records_size(), 1);
+  cr_assert_str_eq(scope_logs_1.log_records(0).body().string_value().c_str(), "body_1");
+
+  const ResourceLogs &resource_logs_1 = request.resource_logs(1);
+  cr_assert_str_eq(resource_logs_1.resource().attributes(0).value().string_value().c_str(), "res_1");
+  cr_assert_eq(resource_logs_1.scope_logs_size(), 1);
+  cr_assert_str_eq(resource_logs_1.scope_logs(0).log_records(0).body().string_value().c_str(), "body_2");
+}
+
+Test(otel_dest_worker, raw_metrics_and_spans_are_added_to_their_own_requests)
+{
+  LogMessage *metric_msg = _create_raw_msg("res_0", "scope_0");
+  Metric metric;
+  metric.set_name("metric_0");
+  metric.mutable_gauge()->add_data_points()->set_as_int(42);
+  ProtobufParser::store_raw(metric_msg, metric);
+
+  LogMessage *span_msg = _create_raw_msg("res_0", "scope_0");
+  Span span;
+  span.set_name("span_0");
+  ProtobufParser::store_raw(span_msg, span);
+
+  cr_assert(dest_worker->insert_raw_metric_from_log_msg(metric_msg));
+  cr_assert(dest_worker->insert_raw_span_from_log_msg(span_msg));
+  log_msg_unref(metric_msg);
+  log_msg_unref(span_msg);
+
+  ExportMetricsServiceRequest metrics_request = dest_worker->get_metrics_request();
+  cr_assert_eq(metrics_request.resource_metrics_size(), 1);
+  cr_assert_str_eq(metrics_request.resource_metrics(0).schema_url().c_str(), "res_0_schema_url");
+  cr_assert_eq(metrics_request.resource_metrics(0).scope_metrics_size(), 1);
+  const ScopeMetrics &scope_metrics = metrics_request.resource_metrics(0).scope_metrics(0);
+  cr_assert_str_eq(scope_metrics.scope().name().c_str(), "scope_0");
+  cr_assert_eq(scope_metrics.metrics_size(), 1);
+  cr_assert_str_eq(scope_metrics.metrics(0).name().c_str(), "metric_0");
+  cr_assert_eq(scope_metrics.metrics(0).gauge().data_points(0).as_int(), 42);
+
+  ExportTraceServiceRequest trace_request = dest_worker->get_trace_request();
+  cr_assert_eq(trace_request.resource_spans_size(), 1);
+  cr_assert_eq(trace_request.resource_spans(0).scope_spans_size(), 1);
+  const ScopeSpans &scope_spans = trace_request.resource_spans(0).scope_spans(0);
+  cr_assert_str_eq(scope_spans.scope().name().c_str(), "scope_0");
+  cr_assert_eq(scope_spans.spans_size(), 1);
+  cr_assert_str_eq(scope_spans.spans(0).name().c_str(), "span_0");
+
+  cr_assert_eq(dest_worker->get_logs_request().resource_logs_size(), 0);
+}
+
+Test(otel_dest_worker, messages_without_raw_records_are_not_passed_through)
+{
+  LogMessage *msg = _create_raw_msg("res_0", "scope_0");
+  cr_assert_not(dest_worker->insert_raw_log_record_from_log_msg(msg));
+  log_msg_unref(msg);
+
+  /* the record alone is not enough, its resource and scope are needed too */
+  msg = log_msg_new_empty();
+  ProtobufParser::store_raw(msg, LogRecord());
+  cr_assert_not(dest_worker->insert_raw_log_record_from_log_msg(msg));
+  log_msg_unref(msg);
+
+  cr_assert_eq(dest_worker->get_logs_request().resource_logs_size(), 0);
+}
+
+void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  otel_logmsg_handles_global_init();
+
+  driver = otel_dd_new(configuration);
+  worker = grpc_dw_new((GrpcDestDriver *) driver, 0);
+  dest_worker = new TestDestWorker(worker);
+  worker->cpp = dest_worker;
+}
+
+void
+teardown(void)
+{
+  log_threaded_dest_worker_free(&worker->super);
+  log_pipe_unref(&driver->super);
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(otel_dest_worker, .init = setup, .fini = teardown);
@@ -116,7 +116,7 @@ _tag_message(HTTPDestinationWorker *self)
   if (!self->super.queue)
     goto unavailable;
 
-  guint batch_index = self->response_signal.offending_message;
+  guint batch_index = self->backlog_offset + self->response_signal.offending_message;
   msg = log_queue_peek_backlog(self->super.queue, batch_index);
 
   if (!msg)
@@ -165,14 +165,14 @@ unavailable:
 static size_t
 _curl_write_function(char *ptr, size_t size, size_t nmemb, void *userdata)
 {
-  HTTPDestinationWorker *self = (HTTPDestinationWorker *) userdata;
+  GString *response_buffer = (GString *) userdata;
   gsize count = nmemb * size;
 
-  if (self->response_buffer->len >= HTTP_RESPONSE_MAX_LENGTH)
+  if (response_buffer->len >= HTTP_RESPONSE_MAX_LENGTH)
     return count;
 
-  gsize remaining = HTTP_RESPONSE_MAX_LENGTH - self->response_buffer->len;
-  g_string_append_len(self->response_buffer, (gchar *) ptr, MIN(remaining, count));
+  gsize remaining = HTTP_RESPONSE_MAX_LENGTH - response_buffer->len;
+  g_string_append_len(response_buffer, (gchar *) ptr, MIN(remaining, count));
 
   return count;
 }
@@ -188,7 +188,7 @@ _setup_static_options_in_curl(HTTPDestinationWorker *self)
   curl_easy_reset(self->curl);
 
   curl_easy_setopt(self->curl, CURLOPT_WRITEFUNCTION, _curl_write_function);
-  curl_easy_setopt(self->curl, CURLOPT_WRITEDATA, self);
+  curl_easy_setopt(self->curl, CURLOPT_WRITEDATA, self->response_buffer);
 
   curl_easy_setopt(self->curl, CURLOPT_URL, owner->url);
 
@@ -229,7 +229,9 @@ _setup_static_options_in_curl(HTTPDestinationWorker *self)
   if (owner->proxy)
     curl_easy_setopt(self->curl, CURLOPT_PROXY, owner->proxy);
 
+  curl_easy_setopt(self->curl, CURLOPT_SHARE, owner->share);
   curl_easy_setopt(self->curl, CURLOPT_SSLVERSION, owner->ssl_version);
+  curl_easy_setopt(self->curl, CURLOPT_HTTP_VERSION, owner->http_version);
   curl_easy_setopt(self->curl, CURLOPT_SSL_VERIFYHOST, owner->peer_verify ? 2L : 0L);
   curl_easy_setopt(self->curl, CURLOPT_SSL_VERIFYPEER, owner->peer_verify ? 1L : 0L);
 
@@ -558,7 +560,7 @@ _finish_request_body(HTTPDestinationWorker *self)
 }
 
 static void
-_debug_response_info(HTTPDestinationWorker *self, const gchar *url, glong http_code)
+_debug_response_info(HTTPDestinationWorker *self, const gchar *url, glong http_code, gint batch_size)
 {
   HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
 
@@ -573,7 +575,7 @@ _debug_response_info(HTTPDestinationWorker *self, const gchar *url, glong http_c
             _tag_request(self),
             evt_tag_mem("response", self->response_buffer->str, self->response_buffer->len),
             evt_tag_int("body_size", self->request_body->len),
-            evt_tag_int("batch_size", self->super.batch_size),
+            evt_tag_int("batch_size", batch_size),
             evt_tag_int("redirected", redirect_count != 0),
             evt_tag_printf("total_time", "%.3f", total_time),
             evt_tag_int("worker_index", self->super.worker_index),
@@ -647,8 +649,8 @@ _custom_map_http_result(HTTPDestinationWorker *self, const gchar *url, HttpRespo
   return LTR_MAX;
 }
 
-static gboolean
-_curl_perform_request(HTTPDestinationWorker *self, const gchar *url)
+static void
+_prepare_request(HTTPDestinationWorker *self, const gchar *url)
 {
   HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
 
@@ -678,7 +680,13 @@ _curl_perform_request(HTTPDestinationWorker *self, const gchar *url)
   curl_easy_setopt(self->curl, CURLOPT_HTTPHEADER, http_curl_header_list_as_slist(self->request_headers));
 
   g_string_truncate(self->response_buffer, 0);
-  CURLcode ret = curl_easy_perform(self->curl);
+}
+
+static gboolean
+_check_curl_result(HTTPDestinationWorker *self, const gchar *url, CURLcode ret)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+
   if (ret != CURLE_OK)
     {
       msg_error("http: error sending HTTP request",
@@ -693,6 +701,13 @@ _curl_perform_request(HTTPDestinationWorker *self, const gchar *url)
   return TRUE;
 }
 
+static gboolean
+_curl_perform_request(HTTPDestinationWorker *self, const gchar *url)
+{
+  _prepare_request(self, url);
+  return _check_curl_result(self, url, curl_easy_perform(self->curl));
+}
+
 static gboolean
 _curl_get_status_code(HTTPDestinationWorker *self, const gchar *url, glong *http_code)
 {
@@ -767,21 +782,18 @@ _update_status_code_metrics(HTTPDestinationWorker *self, const gchar *url, glong
   stats_counter_inc(counter);
 }
 
+/* evaluates the response to the request that has just been completed on self->curl */
 static LogThreadedResult
-_flush_on_target(HTTPDestinationWorker *self, const gchar *url)
+_evaluate_response(HTTPDestinationWorker *self, const gchar *url, gint batch_size)
 {
   HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
-
-  if (!_curl_perform_request(self, url))
-    return LTR_NOT_CONNECTED;
-
   glong http_code = 0;
 
   if (!_curl_get_status_code(self, url, &http_code))
     return LTR_NOT_CONNECTED;
 
   if (debug_flag)
-    _debug_response_info(self, url, http_code);
+    _debug_response_info(self, url, http_code, batch_size);
 
   _update_status_code_metrics(self, url, http_code);
 
@@ -789,7 +801,7 @@ _flush_on_target(HTTPDestinationWorker *self, const gchar *url)
   {
     .result = HTTP_SLOT_SUCCESS,
     .http_code = http_code,
-    .batch_size = self->super.batch_size,
+    .batch_size = batch_size,
     .request_body = self->request_body,
     .response_body = self->response_buffer,
     .offending_message = 0,
@@ -808,6 +820,27 @@ _flush_on_target(HTTPDestinationWorker *self, const gchar *url)
   return _map_http_status_code(self, url, http_code);
 }
 
+static LogThreadedResult
+_flush_on_target(HTTPDestinationWorker *self, const gchar *url)
+{
+  if (!_curl_perform_request(self, url))
+    return LTR_NOT_CONNECTED;
+
+  return _evaluate_response(self, url, self->super.batch_size);
+}
+
+static void
+_request_succeeded(HTTPDestinationWorker *self, HTTPLoadBalancerTarget *target)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  gsize msg_length = self->request_body->len;
+
+  log_threaded_dest_worker_written_bytes_add(&self->super, msg_length);
+  log_threaded_dest_driver_insert_batch_length_stats(self->super.owner, msg_length);
+
+  http_load_balancer_set_target_successful(owner->load_balancer, target);
+}
+
 static gboolean
 _format_request_headers_error_is_critical(GError *error)
 {
@@ -854,6 +887,341 @@ _get_url(HTTPDestinationWorker *self, HTTPLoadBalancerTarget *target)
   return self->url_buffer->str;
 }
 
+/* Asynchronous mode (max-in-flight() > 1)
+ *
+ * Batches are handed over to a curl multi handle and the worker continues
+ * to accumulate the next batch while up to max-in-flight() requests are
+ * being processed by the server.  Requests may complete in any order,
+ * but they are retired (acknowledged) strictly in submission order, as
+ * that is the order of the messages in the backlog of the queue.
+ *
+ * Messages of submitted requests are removed from super.batch_size so that
+ * the threaded destination framework does not acknowledge them on our
+ * behalf.  If the oldest request fails, all in-flight requests are
+ * abandoned and their messages are added back to super.batch_size, so that
+ * the framework rewinds the complete unacknowledged window.
+ */
+
+static inline HTTPInFlightRequest *
+_in_flight_request_at(HTTPDestinationWorker *self, gint index)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+
+  return &self->in_flight.requests[(self->in_flight.head + index) % owner->max_in_flight];
+}
+
+static void
+_swap_pointers(gpointer a, gpointer b)
+{
+  gpointer *pa = (gpointer *) a;
+  gpointer *pb = (gpointer *) b;
+  gpointer tmp = *pa;
+
+  *pa = *pb;
+  *pb = tmp;
+}
+
+static void
+_exchange_batch_with_request(HTTPDestinationWorker *self, HTTPInFlightRequest *request)
+{
+  _swap_pointers(&self->request_body, &request->request_body);
+  _swap_pointers(&self->request_body_compressed, &request->request_body_compressed);
+  _swap_pointers(&self->request_headers, &request->request_headers);
+  _swap_pointers(&self->msg_for_templates, &request->msg_for_templates);
+}
+
+/* makes the worker operate on @request, calling it again switches back */
+static void
+_switch_to_request(HTTPDestinationWorker *self, HTTPInFlightRequest *request)
+{
+  _exchange_batch_with_request(self, request);
+  _swap_pointers(&self->curl, &request->curl);
+  _swap_pointers(&self->response_buffer, &request->response_buffer);
+}
+
+static void
+_start_request_on_target(HTTPDestinationWorker *self, HTTPInFlightRequest *request, HTTPLoadBalancerTarget *target)
+{
+  _switch_to_request(self, request);
+  g_string_assign(request->url, _get_url(self, target));
+  _prepare_request(self, request->url->str);
+  _switch_to_request(self, request);
+
+  request->target = target;
+  request->completed = FALSE;
+  curl_multi_add_handle(self->in_flight.multi, request->curl);
+}
+
+static gboolean
+_restart_request_on_alternative_target(HTTPDestinationWorker *self, HTTPInFlightRequest *request)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  HTTPLoadBalancerTarget *alt_target = http_load_balancer_choose_target(owner->load_balancer, &self->lbc);
+
+  if (alt_target == request->target)
+    {
+      msg_debug("http: Target server down, but no alternative server available. Falling back to retrying after time-reopen()",
+                evt_tag_str("url", request->url->str),
+                evt_tag_int("worker_index", self->super.worker_index),
+                evt_tag_str("driver", owner->super.super.super.id),
+                log_pipe_location_tag(&owner->super.super.super.super));
+      return FALSE;
+    }
+
+  msg_debug("http: Target server down, trying an alternative server",
+            evt_tag_str("url", request->url->str),
+            evt_tag_int("worker_index", self->super.worker_index),
+            evt_tag_str("driver", owner->super.super.super.id),
+            log_pipe_location_tag(&owner->super.super.super.super));
+
+  _start_request_on_target(self, request, alt_target);
+  return TRUE;
+}
+
+static gint
+_get_backlog_offset_of_request(HTTPDestinationWorker *self, HTTPInFlightRequest *request)
+{
+  gint offset = 0;
+
+  for (gint i = 0; i < self->in_flight.len; i++)
+    {
+      HTTPInFlightRequest *r = _in_flight_request_at(self, i);
+      if (r == request)
+        break;
+      offset += r->batch_size;
+    }
+  return offset;
+}
+
+static void
+_complete_request(HTTPDestinationWorker *self, HTTPInFlightRequest *request, CURLcode curl_result)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  LogThreadedResult result = LTR_NOT_CONNECTED;
+
+  _switch_to_request(self, request);
+  self->backlog_offset = _get_backlog_offset_of_request(self, request);
+
+  if (_check_curl_result(self, request->url->str, curl_result))
+    result = _evaluate_response(self, request->url->str, request->batch_size);
+
+  if (result == LTR_SUCCESS)
+    _request_succeeded(self, request->target);
+
+  self->backlog_offset = 0;
+  _switch_to_request(self, request);
+
+  if (result != LTR_SUCCESS)
+    {
+      http_load_balancer_set_target_failed(owner->load_balancer, request->target);
+      if (--request->attempts_left > 0 && _restart_request_on_alternative_target(self, request))
+        return;
+    }
+
+  request->result = result;
+  request->completed = TRUE;
+}
+
+static void
+_drive_in_flight_requests(HTTPDestinationWorker *self)
+{
+  gint running_handles, msgs_in_queue;
+  CURLMsg *curl_msg;
+
+  curl_multi_perform(self->in_flight.multi, &running_handles);
+  while ((curl_msg = curl_multi_info_read(self->in_flight.multi, &msgs_in_queue)))
+    {
+      if (curl_msg->msg != CURLMSG_DONE)
+        continue;
+
+      /* curl_msg is invalidated by curl_multi_remove_handle() */
+      CURL *curl = curl_msg->easy_handle;
+      CURLcode curl_result = curl_msg->data.result;
+      gchar *request = NULL;
+
+      curl_easy_getinfo(curl, CURLINFO_PRIVATE, &request);
+      curl_multi_remove_handle(self->in_flight.multi, curl);
+      _complete_request(self, (HTTPInFlightRequest *) request, curl_result);
+    }
+}
+
+static void
+_reset_in_flight_request(HTTPInFlightRequest *request)
+{
+  g_string_truncate(request->request_body, 0);
+  if (request->request_body_compressed)
+    g_string_truncate(request->request_body_compressed, 0);
+  list_remove_all(request->request_headers);
+  log_msg_unref(request->msg_for_templates);
+  request->msg_for_templates = NULL;
+  request->target = NULL;
+  request->batch_size = 0;
+  request->completed = FALSE;
+}
+
+static void
+_retire_oldest_request(HTTPDestinationWorker *self)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  HTTPInFlightRequest *request = _in_flight_request_at(self, 0);
+
+  self->in_flight.batch_size -= request->batch_size;
+  self->super.batch_size += request->batch_size;
+  _reset_in_flight_request(request);
+
+  self->in_flight.head = (self->in_flight.head + 1) % owner->max_in_flight;
+  self->in_flight.len--;
+}
+
+/* gives back all in-flight messages to super.batch_size, so that the
+ * framework rewinds them together with the current batch */
+static void
+_abandon_in_flight_requests(HTTPDestinationWorker *self)
+{
+  while (self->in_flight.len > 0)
+    {
+      HTTPInFlightRequest *request = _in_flight_request_at(self, 0);
+
+      if (!request->completed)
+        curl_multi_remove_handle(self->in_flight.multi, request->curl);
+      _retire_oldest_request(self);
+    }
+}
+
+static LogThreadedResult
+_retire_completed_requests(HTTPDestinationWorker *self)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+
+  while (self->in_flight.len > 0)
+    {
+      HTTPInFlightRequest *request = _in_flight_request_at(self, 0);
+      gint batch_size = request->batch_size;
+
+      if (!request->completed)
+        break;
+
+      switch (request->result)
+        {
+        case LTR_SUCCESS:
+          _retire_oldest_request(self);
+          log_threaded_dest_worker_ack_messages(&self->super, batch_size);
+          break;
+
+        case LTR_DROP:
+          msg_error("http: Message(s) dropped while sending message to destination",
+                    evt_tag_int("batch_size", batch_size),
+                    evt_tag_int("worker_index", self->super.worker_index),
+                    evt_tag_str("driver", owner->super.super.super.id),
+                    log_pipe_location_tag(&owner->super.super.super.super));
+          _retire_oldest_request(self);
+          log_threaded_dest_worker_drop_messages(&self->super, batch_size);
+          break;
+
+        default:
+        {
+          LogThreadedResult result = request->result;
+
+          _abandon_in_flight_requests(self);
+          return result;
+        }
+        }
+    }
+
+  return LTR_SUCCESS;
+}
+
+/* drives the transfers until no more than @max_in_flight requests remain in flight */
+static LogThreadedResult
+_wait_for_in_flight_requests(HTTPDestinationWorker *self, gint max_in_flight)
+{
+  while (TRUE)
+    {
+      _drive_in_flight_requests(self);
+
+      LogThreadedResult result = _retire_completed_requests(self);
+      if (result != LTR_SUCCESS)
+        return result;
+
+      if (self->in_flight.len <= max_in_flight)
+        return LTR_SUCCESS;
+
+      curl_multi_wait(self->in_flight.multi, NULL, 0, 1000, NULL);
+    }
+}
+
+static LogThreadedResult
+_submit_batch(HTTPDestinationWorker *self)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  GError *error = NULL;
+
+  _finish_request_body(self);
+
+  if (!_try_format_request_headers(self, &error))
+    {
+      if (!_format_request_headers_catch_error(&error))
+        return LTR_NOT_CONNECTED;
+    }
+
+  LogThreadedResult result = _wait_for_in_flight_requests(self, owner->max_in_flight - 1);
+  if (result != LTR_SUCCESS)
+    return result;
+
+  HTTPInFlightRequest *request = _in_flight_request_at(self, self->in_flight.len);
+  self->in_flight.len++;
+
+  _exchange_batch_with_request(self, request);
+  request->batch_size = self->super.batch_size;
+  request->attempts_left = owner->load_balancer->num_targets;
+
+  self->in_flight.batch_size += self->super.batch_size;
+  self->super.batch_size = 0;
+
+  _start_request_on_target(self, request, http_load_balancer_choose_target(owner->load_balancer, &self->lbc));
+  return LTR_SUCCESS;
+}
+
+static LogThreadedResult
+_flush_async(LogThreadedDestWorker *s, LogThreadedFlushMode mode)
+{
+  HTTPDestinationWorker *self = (HTTPDestinationWorker *) s;
+  LogThreadedResult result = LTR_SUCCESS;
+
+  if (self->super.batch_size == 0 && self->in_flight.len == 0)
+    return LTR_SUCCESS;
+
+  if (mode == LTF_FLUSH_EXPEDITE)
+    {
+      _abandon_in_flight_requests(self);
+      result = LTR_RETRY;
+      goto exit;
+    }
+
+  if (self->super.batch_size > 0)
+    {
+      result = _submit_batch(self);
+      if (result != LTR_SUCCESS)
+        goto exit;
+    }
+
+  /* in-flight messages are not part of super.batch_size, the framework
+   * would not call us again once the queue becomes empty */
+  if (log_queue_get_length(self->super.queue) == 0)
+    result = _wait_for_in_flight_requests(self, 0);
+  else
+    result = _wait_for_in_flight_requests(self, G_MAXINT);
+
+exit:
+  _reset_request_headers(self);
+  _reset_request_body(self);
+
+  log_msg_unref(self->msg_for_templates);
+  self->msg_for_templates = NULL;
+
+  return result == LTR_SUCCESS ? LTR_EXPLICIT_ACK_MGMT : result;
+}
+
 /* we flush the accumulated data if
  *   1) we reach batch_size,
  *   2) the message queue becomes empty
@@ -890,11 +1258,7 @@ _flush(LogThreadedDestWorker *s, LogThreadedFlushMode mode)
       retval = _flush_on_target(self, url);
       if (retval == LTR_SUCCESS)
         {
-          gsize msg_length = self->request_body->len;
-          log_threaded_dest_worker_written_bytes_add(&self->super, msg_length);
-          log_threaded_dest_driver_insert_batch_length_stats(self->super.owner, msg_length);
-
-          http_load_balancer_set_target_successful(owner->load_balancer, target);
+          _request_succeeded(self, target);
           break;
         }
       http_load_balancer_set_target_failed(owner->load_balancer, target);
@@ -982,6 +1346,81 @@ _insert_single(LogThreadedDestWorker *s, LogMessage *msg)
   return log_threaded_dest_worker_flush(&self->super, LTF_FLUSH_NORMAL);
 }
 
+static gboolean
+_init_in_flight_requests(HTTPDestinationWorker *self)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+
+  if (!(self->in_flight.multi = curl_multi_init()))
+    {
+      msg_error("http: cannot initialize libcurl multi interface",
+                evt_tag_int("worker_index", self->super.worker_index),
+                evt_tag_str("driver", owner->super.super.super.id),
+                log_pipe_location_tag(&owner->super.super.super.super));
+      return FALSE;
+    }
+
+  if (http_dd_is_http2_enabled(owner))
+    {
+      /* streams of all in-flight requests share a single connection per target */
+      curl_multi_setopt(self->in_flight.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+      curl_multi_setopt(self->in_flight.multi, CURLMOPT_MAX_HOST_CONNECTIONS, 1L);
+    }
+
+  self->in_flight.requests = g_new0(HTTPInFlightRequest, owner->max_in_flight);
+  for (gint i = 0; i < owner->max_in_flight; i++)
+    {
+      HTTPInFlightRequest *request = &self->in_flight.requests[i];
+
+      request->request_body = g_string_sized_new(32768);
+      if (self->request_body_compressed)
+        request->request_body_compressed = g_string_sized_new(32768);
+      request->request_headers = http_curl_header_list_new();
+      request->response_buffer = g_string_sized_new(1024);
+      request->url = g_string_new(NULL);
+
+      if (!(request->curl = curl_easy_duphandle(self->curl)))
+        return FALSE;
+      curl_easy_setopt(request->curl, CURLOPT_WRITEDATA, request->response_buffer);
+      curl_easy_setopt(request->curl, CURLOPT_PRIVATE, request);
+      if (http_dd_is_http2_enabled(owner))
+        curl_easy_setopt(request->curl, CURLOPT_PIPEWAIT, 1L);
+    }
+
+  return TRUE;
+}
+
+static void
+_deinit_in_flight_requests(HTTPDestinationWorker *self)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+
+  if (!self->in_flight.multi)
+    return;
+
+  /* the framework rewinds the backlog, including the messages of abandoned requests */
+  _abandon_in_flight_requests(self);
+
+  for (gint i = 0; self->in_flight.requests && i < owner->max_in_flight; i++)
+    {
+      HTTPInFlightRequest *request = &self->in_flight.requests[i];
+
+      if (request->curl)
+        curl_easy_cleanup(request->curl);
+      g_string_free(request->request_body, TRUE);
+      if (request->request_body_compressed)
+        g_string_free(request->request_body_compressed, TRUE);
+      list_free(request->request_headers);
+      g_string_free(request->response_buffer, TRUE);
+      g_string_free(request->url, TRUE);
+    }
+  g_free(self->in_flight.requests);
+  self->in_flight.requests = NULL;
+
+  curl_multi_cleanup(self->in_flight.multi);
+  self->in_flight.multi = NULL;
+}
+
 static gboolean
 _init(LogThreadedDestWorker *s)
 {
@@ -1013,6 +1452,9 @@ _init(LogThreadedDestWorker *s)
 
   _reset_request_body(self);
 
+  if (owner->max_in_flight > 1 && !_init_in_flight_requests(self))
+    return FALSE;
+
   return log_threaded_dest_worker_init_method(s);
 }
 
@@ -1021,6 +1463,8 @@ _deinit(LogThreadedDestWorker *s)
 {
   HTTPDestinationWorker *self = (HTTPDestinationWorker *) s;
 
+  _deinit_in_flight_requests(self);
+
   if (self->url_buffer)
     g_string_free(self->url_buffer, TRUE);
 
@@ -1055,7 +1499,7 @@ http_dw_new(LogThreadedDestDriver *o, gint worker_index)
   log_threaded_dest_worker_init_instance(&self->super, o, worker_index);
   self->super.init = _init;
   self->super.deinit = _deinit;
-  self->super.flush = _flush;
+  self->super.flush = owner->max_in_flight > 1 ? _flush_async : _flush;
   self->super.free_fn = http_dw_free;
 
   if (owner->super.batch_lines > 0 || owner->batch_bytes > 0)
@@ -32,6 +32,23 @@
 #include "metrics/dyn-metrics-store.h"
 #include "http-signals.h"
 
+/* a batch handed over to curl multi, used when max-in-flight() is larger than 1 */
+typedef struct _HTTPInFlightRequest
+{
+  CURL *curl;
+  GString *request_body;
+  GString *request_body_compressed;
+  List *request_headers;
+  GString *response_buffer;
+  LogMessage *msg_for_templates;
+  HTTPLoadBalancerTarget *target;
+  GString *url;
+  gint batch_size;
+  gint attempts_left;
+  gboolean completed;
+  LogThreadedResult result;
+} HTTPInFlightRequest;
+
 typedef struct _HTTPDestinationWorker
 {
   LogThreadedDestWorker super;
@@ -45,6 +62,19 @@ typedef struct _HTTPDestinationWorker
   GString *response_buffer;
   LogMessage *msg_for_templates;
 
+  /* index of the first message of the current request in the backlog */
+  gint backlog_offset;
+
+  struct
+  {
+    CURLM *multi;
+    /* ring buffer of max-in-flight() requests, completed in any order, retired in order */
+    HTTPInFlightRequest *requests;
+    gint head, len;
+    /* number of messages in requests that are not yet retired */
+    gint batch_size;
+  } in_flight;
+
   HttpRequestSignalData request_signal;
   HttpResponseSignalData response_signal;
 
@@ -283,6 +283,48 @@ http_dd_set_ssl_version(LogDriver *d, const gchar *value)
   return TRUE;
 }
 
+gboolean
+http_dd_set_http_version(LogDriver *d, const gchar *value)
+{
+  HTTPDestinationDriver *self = (HTTPDestinationDriver *) d;
+
+  if (strcasecmp(value, "default") == 0)
+    self->http_version = CURL_HTTP_VERSION_NONE;
+  else if (strcmp(value, "1.0") == 0)
+    self->http_version = CURL_HTTP_VERSION_1_0;
+  else if (strcmp(value, "1.1") == 0)
+    self->http_version = CURL_HTTP_VERSION_1_1;
+  else if (strcmp(value, "2") == 0)
+    {
+      /* h2 over TLS and h2c via the Upgrade header over cleartext */
+      self->http_version = CURL_HTTP_VERSION_2_0;
+    }
+#if SYSLOG_NG_HAVE_DECL_CURL_HTTP_VERSION_2TLS
+  else if (strcasecmp(value, "2-tls") == 0)
+    {
+      /* h2 over TLS, HTTP/1.1 over cleartext */
+      self->http_version = CURL_HTTP_VERSION_2TLS;
+    }
+#endif
+#if SYSLOG_NG_HAVE_DECL_CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE
+  else if (strcasecmp(value, "2-prior-knowledge") == 0)
+    {
+      /* h2c without the HTTP/1.1 Upgrade round trip */
+      self->http_version = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+    }
+#endif
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+http_dd_is_http2_enabled(HTTPDestinationDriver *self)
+{
+  return self->http_version >= CURL_HTTP_VERSION_2_0;
+}
+
 void
 http_dd_set_accept_encoding(LogDriver *d, const gchar *encoding)
 {
@@ -365,6 +407,14 @@ http_dd_set_batch_bytes(LogDriver *d, glong batch_bytes)
   self->batch_bytes = batch_bytes;
 }
 
+void
+http_dd_set_max_in_flight(LogDriver *d, gint max_in_flight)
+{
+  HTTPDestinationDriver *self = (HTTPDestinationDriver *) d;
+
+  self->max_in_flight = max_in_flight;
+}
+
 void
 http_dd_set_body_prefix(LogDriver *d, LogTemplate *body_prefix)
 {
@@ -465,6 +515,19 @@ http_dd_init(LogPipe *s)
   if (self->batch_bytes > 0 && self->super.batch_lines == 0)
     self->super.batch_lines = G_MAXINT;
 
+  if (http_dd_is_http2_enabled(self) && !(curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2))
+    {
+      msg_warning("WARNING: http-version() requests HTTP/2, but libcurl was built without HTTP/2 support, "
+                  "falling back to HTTP/1.1",
+                  log_pipe_location_tag(&self->super.super.super.super));
+    }
+
+  if (http_dd_is_http2_enabled(self) && self->max_in_flight == 1)
+    {
+      msg_warning("WARNING: HTTP/2 multiplexing is only used by the http() driver if max-in-flight() is larger than 1",
+                  log_pipe_location_tag(&self->super.super.super.super));
+    }
+
   log_template_options_init(&self->template_options, cfg);
 
   http_load_balancer_set_recovery_timeout(self->load_balancer, self->super.time_reopen);
@@ -486,6 +549,10 @@ http_dd_free(LogPipe *s)
     g_string_free(self->accept_encoding, TRUE);
   log_template_unref(self->body_template);
 
+  curl_share_cleanup(self->share);
+  for (gint i = 0; i < CURL_LOCK_DATA_LAST; i++)
+    g_mutex_clear(&self->share_locks[i]);
+
   curl_global_cleanup();
 
   g_free(self->user);
@@ -505,6 +572,41 @@ http_dd_free(LogPipe *s)
   log_threaded_dest_driver_free(s);
 }
 
+static void
+_share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+  HTTPDestinationDriver *self = (HTTPDestinationDriver *) userptr;
+
+  g_mutex_lock(&self->share_locks[data]);
+}
+
+static void
+_share_unlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+  HTTPDestinationDriver *self = (HTTPDestinationDriver *) userptr;
+
+  g_mutex_unlock(&self->share_locks[data]);
+}
+
+/* Workers share resolved addresses and TLS sessions, so that only the
+ * first connection to a target needs a full handshake.  Connections
+ * themselves cannot be shared between threads, those are multiplexed
+ * within a worker instead, see max-in-flight() and http-version().
+ */
+static void
+_setup_share(HTTPDestinationDriver *self)
+{
+  for (gint i = 0; i < CURL_LOCK_DATA_LAST; i++)
+    g_mutex_init(&self->share_locks[i]);
+
+  self->share = curl_share_init();
+  curl_share_setopt(self->share, CURLSHOPT_LOCKFUNC, _share_lock);
+  curl_share_setopt(self->share, CURLSHOPT_UNLOCKFUNC, _share_unlock);
+  curl_share_setopt(self->share, CURLSHOPT_USERDATA, self);
+  curl_share_setopt(self->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(self->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
 LogDriver *
 http_dd_new(GlobalConfig *cfg)
 {
@@ -521,12 +623,14 @@ http_dd_new(GlobalConfig *cfg)
   self->super.worker.construct = http_dw_new;
 
   curl_global_init(CURL_GLOBAL_ALL);
+  _setup_share(self);
 
   self->ssl_version = CURL_SSLVERSION_DEFAULT;
   self->peer_verify = TRUE;
   /* disable batching even if the global batch_lines is specified */
   self->super.batch_lines = 0;
   self->batch_bytes = 0;
+  self->max_in_flight = 1;
   self->body_suffix = g_string_new("");
   self->delimiter = g_string_new("\n");
   self->accept_encoding = (SYSLOG_NG_HTTP_COMPRESSION_ENABLED ? g_string_new("") : NULL);
@@ -32,6 +32,7 @@
 #include "logthrdest/logthrdestdrv.h"
 #include "http-loadbalancer.h"
 #include "response-handler.h"
+#include <curl/curl.h>
 
 typedef struct
 {
@@ -56,6 +57,10 @@ typedef struct
   GString *body_suffix;
   GString *delimiter;
   long ssl_version;
+  long http_version;
+  /* DNS and TLS session caches shared by the workers */
+  CURLSH *share;
+  GMutex share_locks[CURL_LOCK_DATA_LAST];
   GString *accept_encoding;
   gint8 content_compression;
   gboolean force_content_compression;
@@ -65,12 +70,14 @@ typedef struct
   short int method_type;
   glong timeout;
   glong batch_bytes;
+  gint max_in_flight;
   LogTemplate *body_template;
   LogTemplateOptions template_options;
   HttpResponseHandlers *response_handlers;
 } HTTPDestinationDriver;
 
 gboolean http_dd_init(LogPipe *s);
+gboolean http_dd_is_http2_enabled(HTTPDestinationDriver *self);
 gboolean http_dd_deinit(LogPipe *s);
 LogDriver *http_dd_new(GlobalConfig *cfg);
 
@@ -90,10 +97,12 @@ void http_dd_set_cipher_suite(LogDriver *d, const gchar *ciphers);
 gboolean http_dd_set_tls13_cipher_suite(LogDriver *d, const gchar *tls13_ciphers);
 void http_dd_set_proxy(LogDriver *d, const gchar *proxy);
 gboolean http_dd_set_ssl_version(LogDriver *d, const gchar *value);
+gboolean http_dd_set_http_version(LogDriver *d, const gchar *value);
 void http_dd_set_peer_verify(LogDriver *d, gboolean verify);
 gboolean http_dd_set_ocsp_stapling_verify(LogDriver *d, gboolean verify);
 void http_dd_set_timeout(LogDriver *d, glong timeout);
 void http_dd_set_batch_bytes(LogDriver *d, glong batch_bytes);
+void http_dd_set_max_in_flight(LogDriver *d, gint max_in_flight);
 void http_dd_set_body_prefix(LogDriver *d, LogTemplate *body_prefix);
 void http_dd_set_body_suffix(LogDriver *d, const gchar *body_suffix);
 void http_dd_set_delimiter(LogDriver *d, const gchar *delimiter);
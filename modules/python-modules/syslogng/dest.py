@@ -43,6 +43,28 @@ except ImportError:
 
 
 class LogDestination(LogDestination):
+    """Base class of Python destinations
+
+    Batching:
+        A class may implement send_batch(self, msgs) in addition to, or
+        instead of send().  It is not defined here, as its presence is what
+        enables batching.  If present, send_batch() receives the messages of
+        a whole batch (see batch-lines()) as a list, so the per-message
+        overhead of calling into Python is avoided.
+
+        It returns either a single LogDestinationResult (or bool) that
+        applies to the whole batch, or a list with one result for each
+        message.  With a list, SUCCESS and DROP are applied to their own
+        message, while any other result stops processing the list and
+        applies to the rest of the batch.
+
+        Messages that cannot be converted (e.g. value-pairs() fails with
+        on-error("drop-message")) are dropped and left out of the list.
+
+        The LogMessage objects are reused across calls, do not keep
+        references to them.
+    """
+
     DROP = LogDestinationResult.DROP
     ERROR = LogDestinationResult.ERROR
     SUCCESS = LogDestinationResult.SUCCESS
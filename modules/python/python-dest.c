@@ -37,6 +37,13 @@
 #include "messages.h"
 #include "python-persist.h"
 
+typedef struct
+{
+  LogMessage *msg;
+  gint32 seq_num;
+  gboolean converted;
+} PythonDestPendingMessage;
+
 typedef struct
 {
   LogThreadedDestDriver super;
@@ -53,10 +60,17 @@ typedef struct
     PyObject *is_opened;
     PyObject *open;
     PyObject *send;
+    PyObject *send_batch;
     PyObject *flush;
     PyObject *generate_persist_name;
     GPtrArray *_refs_to_clean;
+
+    /* LogMessage wrappers reused by send_batch() */
+    GPtrArray *batch_wrappers;
   } py;
+
+  /* messages queued for send_batch(), array of PythonDestPendingMessage */
+  GArray *pending_batch;
 } PythonDestDriver;
 
 typedef struct _PyLogDestination
@@ -257,6 +271,14 @@ _py_invoke_flush(PythonDestDriver *self)
   return result;
 }
 
+static void
+_clear_pending_batch(PythonDestDriver *self)
+{
+  for (gint i = 0; i < self->pending_batch->len; i++)
+    log_msg_unref(g_array_index(self->pending_batch, PythonDestPendingMessage, i).msg);
+  g_array_set_size(self->pending_batch, 0);
+}
+
 static LogThreadedResult
 _py_invoke_send(PythonDestDriver *self, PyObject *dict)
 {
@@ -382,10 +404,12 @@ _py_init_bindings(PythonDestDriver *self)
   self->py.open = _py_get_attr_or_null(self->py.instance, "open");
   self->py.flush = _py_get_attr_or_null(self->py.instance, "flush");
   self->py.send = _py_get_attr_or_null(self->py.instance, "send");
+  self->py.send_batch = _py_get_attr_or_null(self->py.instance, "send_batch");
   self->py.generate_persist_name = _py_get_attr_or_null(self->py.instance, "generate_persist_name");
-  if (!self->py.send)
+  self->py.batch_wrappers = g_ptr_array_new_with_free_func((GDestroyNotify) _py_clear);
+  if (!self->py.send && !self->py.send_batch)
     {
-      msg_error("python-dest: Error initializing Python destination, class does not have a send() method",
+      msg_error("python-dest: Error initializing Python destination, class does not have a send() or send_batch() method",
                 evt_tag_str("driver", self->super.super.super.id),
                 evt_tag_str("class", self->binding.class));
       return FALSE;
@@ -411,6 +435,7 @@ _py_init_bindings(PythonDestDriver *self)
   g_ptr_array_add(self->py._refs_to_clean, self->py.open);
   g_ptr_array_add(self->py._refs_to_clean, self->py.flush);
   g_ptr_array_add(self->py._refs_to_clean, self->py.send);
+  g_ptr_array_add(self->py._refs_to_clean, self->py.send_batch);
   g_ptr_array_add(self->py._refs_to_clean, self->py.generate_persist_name);
 
   return TRUE;
@@ -424,6 +449,9 @@ _py_free_bindings(PythonDestDriver *self)
 
   if (self->py._refs_to_clean)
     g_ptr_array_free(self->py._refs_to_clean, TRUE);
+
+  if (self->py.batch_wrappers)
+    g_ptr_array_free(self->py.batch_wrappers, TRUE);
 }
 
 static gboolean
@@ -448,7 +476,7 @@ _py_init_object(PythonDestDriver *self)
 }
 
 static gboolean
-_py_construct_message(PythonDestDriver *self, LogMessage *msg, PyObject **msg_object)
+_py_construct_message(PythonDestDriver *self, LogMessage *msg, gint32 seq_num, PyObject **msg_object)
 {
   GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super.super);
   gboolean success;
@@ -456,7 +484,7 @@ _py_construct_message(PythonDestDriver *self, LogMessage *msg, PyObject **msg_ob
 
   if (self->vp)
     {
-      LogTemplateEvalOptions options = {&self->template_options, LTZ_LOCAL, self->super.worker.instance.seq_num, NULL, LM_VT_STRING};
+      LogTemplateEvalOptions options = {&self->template_options, LTZ_LOCAL, seq_num, NULL, LM_VT_STRING};
       success = py_value_pairs_apply(self->vp, &options, msg, msg_object);
       if (!success && (self->template_options.on_error & ON_ERROR_DROP_MESSAGE))
         return FALSE;
@@ -508,7 +536,7 @@ python_dd_insert(LogThreadedDestDriver *d, LogMessage *msg)
         }
     }
 
-  if (!_py_construct_message(self, msg, &msg_object))
+  if (!_py_construct_message(self, msg, self->super.worker.instance.seq_num, &msg_object))
     goto exit;
 
   result =_py_invoke_send(self, msg_object);
@@ -519,6 +547,212 @@ exit:
   return result;
 }
 
+/* send_batch() support
+ *
+ * If the Python class implements send_batch(), insert() only queues the
+ * messages and the whole batch is passed as a list to send_batch() from
+ * flush(), acquiring the GIL once per batch instead of once per message.
+ */
+
+static PyObject *
+_py_get_batch_wrapper(PythonDestDriver *self, gint index, LogMessage *msg)
+{
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super.super);
+  PyObject *wrapper;
+
+  if (index < self->py.batch_wrappers->len)
+    {
+      wrapper = g_ptr_array_index(self->py.batch_wrappers, index);
+
+      /* the wrapper can only be reused if the Python code did not keep a reference */
+      if (Py_REFCNT(wrapper) == 1)
+        {
+          py_log_message_rebind(wrapper, msg);
+          Py_INCREF(wrapper);
+          return wrapper;
+        }
+
+      wrapper = py_log_message_new(msg, cfg);
+      if (!wrapper)
+        return NULL;
+      Py_DECREF(g_ptr_array_index(self->py.batch_wrappers, index));
+      g_ptr_array_index(self->py.batch_wrappers, index) = wrapper;
+    }
+  else
+    {
+      wrapper = py_log_message_new(msg, cfg);
+      if (!wrapper)
+        return NULL;
+      g_ptr_array_add(self->py.batch_wrappers, wrapper);
+    }
+
+  Py_INCREF(wrapper);
+  return wrapper;
+}
+
+static void
+_py_release_batch_wrappers(PythonDestDriver *self)
+{
+  for (gint i = 0; i < self->py.batch_wrappers->len; i++)
+    {
+      PyObject *wrapper = g_ptr_array_index(self->py.batch_wrappers, i);
+
+      if (Py_REFCNT(wrapper) == 1)
+        py_log_message_rebind(wrapper, NULL);
+    }
+}
+
+/* returns the list of messages to pass to send_batch(), messages that
+ * cannot be converted are left out and marked as such */
+static PyObject *
+_py_construct_batch(PythonDestDriver *self)
+{
+  PyObject *batch = PyList_New(0);
+
+  for (gint i = 0; i < self->pending_batch->len; i++)
+    {
+      PythonDestPendingMessage *pending = &g_array_index(self->pending_batch, PythonDestPendingMessage, i);
+      PyObject *msg_object;
+
+      if (self->vp)
+        {
+          if (!_py_construct_message(self, pending->msg, pending->seq_num, &msg_object))
+            msg_object = NULL;
+        }
+      else
+        {
+          msg_object = _py_get_batch_wrapper(self, PyList_GET_SIZE(batch), pending->msg);
+        }
+
+      pending->converted = msg_object != NULL;
+      if (!msg_object)
+        {
+          if (PyErr_Occurred())
+            _py_finish_exception_handling();
+          msg_error("python-dest: Error converting message for send_batch(), dropping message",
+                    evt_tag_str("driver", self->super.super.super.id),
+                    evt_tag_int("seq_num", pending->seq_num));
+          continue;
+        }
+
+      PyList_Append(batch, msg_object);
+      Py_DECREF(msg_object);
+    }
+
+  return batch;
+}
+
+/* drops the messages that could not be converted, starting at *position,
+ * up to the next one that was passed to send_batch() */
+static void
+_drop_unconverted_messages(PythonDestDriver *self, gint *position)
+{
+  while (*position < self->pending_batch->len &&
+         !g_array_index(self->pending_batch, PythonDestPendingMessage, *position).converted)
+    {
+      log_threaded_dest_worker_drop_messages(&self->super.worker.instance, 1);
+      (*position)++;
+    }
+}
+
+static LogThreadedResult
+_py_ack_batch_results(PythonDestDriver *self, PyObject *results, gint batch_size, gint position)
+{
+  LogThreadedDestWorker *worker = &self->super.worker.instance;
+
+  if (PySequence_Size(results) != batch_size)
+    {
+      msg_error("python-dest: The number of results returned by send_batch() does not match the number of messages. Retrying batch later",
+                evt_tag_str("driver", self->super.super.super.id),
+                evt_tag_int("results", PySequence_Size(results)),
+                evt_tag_int("batch_size", batch_size));
+      return LTR_ERROR;
+    }
+
+  for (gint i = 0; i < batch_size; i++)
+    {
+      PyObject *item = PySequence_GetItem(results, i);
+      LogThreadedResult result = pyobject_to_worker_insert_result(item);
+      Py_DECREF(item);
+
+      _drop_unconverted_messages(self, &position);
+      switch (result)
+        {
+        case LTR_SUCCESS:
+          log_threaded_dest_worker_ack_messages(worker, 1);
+          break;
+        case LTR_DROP:
+          log_threaded_dest_worker_drop_messages(worker, 1);
+          break;
+        case LTR_QUEUED:
+        case LTR_EXPLICIT_ACK_MGMT:
+          msg_error("python-dest: QUEUED and EXPLICIT_ACK_MGMT cannot be used as per-message results of send_batch(). Retrying the rest of the batch later",
+                    evt_tag_str("driver", self->super.super.super.id));
+          return LTR_ERROR;
+        default:
+          /* the rest of the batch is handled by the caller according to this result */
+          return result;
+        }
+      position++;
+    }
+  _drop_unconverted_messages(self, &position);
+
+  return LTR_SUCCESS;
+}
+
+/* acks the messages passed to send_batch() and drops the rest, in queue order */
+static void
+_ack_converted_messages(PythonDestDriver *self, gint position)
+{
+  for (gint i = position; i < self->pending_batch->len; i++)
+    {
+      if (g_array_index(self->pending_batch, PythonDestPendingMessage, i).converted)
+        log_threaded_dest_worker_ack_messages(&self->super.worker.instance, 1);
+      else
+        log_threaded_dest_worker_drop_messages(&self->super.worker.instance, 1);
+    }
+}
+
+static LogThreadedResult
+_py_invoke_send_batch(PythonDestDriver *self)
+{
+  LogThreadedResult result;
+  PyObject *batch = _py_construct_batch(self);
+  gint batch_size = PyList_GET_SIZE(batch);
+  gint position = 0;
+
+  /* the leading unconvertible messages are dropped first, so that the
+   * rest of the batch can be rewound or dropped by our caller */
+  _drop_unconverted_messages(self, &position);
+  if (batch_size == 0)
+    {
+      Py_DECREF(batch);
+      return LTR_SUCCESS;
+    }
+
+  PyObject *ret = _py_invoke_function(self->py.send_batch, batch, self->binding.class, self->super.super.super.id);
+  Py_DECREF(batch);
+
+  if (!ret)
+    {
+      result = LTR_ERROR;
+    }
+  else if (PyList_Check(ret) || PyTuple_Check(ret))
+    {
+      result = _py_ack_batch_results(self, ret, batch_size, position);
+    }
+  else
+    {
+      result = pyobject_to_worker_insert_result(ret);
+      if (result == LTR_SUCCESS && position + batch_size < self->pending_batch->len)
+        _ack_converted_messages(self, position);
+    }
+  Py_XDECREF(ret);
+
+  _py_release_batch_wrappers(self);
+  return result;
+}
+
 static gboolean
 python_dd_open(PythonDestDriver *self)
 {
@@ -531,14 +765,37 @@ python_dd_open(PythonDestDriver *self)
   return retval;
 }
 
+static LogThreadedResult
+python_dd_insert_batched(LogThreadedDestDriver *d, LogMessage *msg)
+{
+  PythonDestDriver *self = (PythonDestDriver *)d;
+  PythonDestPendingMessage pending = { log_msg_ref(msg), self->super.worker.instance.seq_num };
+
+  g_array_append_val(self->pending_batch, pending);
+  return LTR_QUEUED;
+}
+
 static LogThreadedResult
 python_dd_flush(LogThreadedDestDriver *s)
 {
   PythonDestDriver *self = (PythonDestDriver *)s;
+  LogThreadedResult result = LTR_SUCCESS;
   PyGILState_STATE gstate;
 
   gstate = PyGILState_Ensure();
-  LogThreadedResult result = _py_invoke_flush(self);
+  if (self->pending_batch->len > 0)
+    {
+      if (self->py.is_opened && !_py_invoke_is_opened(self) && !_py_invoke_open(self))
+        result = LTR_NOT_CONNECTED;
+      else
+        result = _py_invoke_send_batch(self);
+
+      /* whatever was not acked is rewound or dropped by our caller, based on result */
+      _clear_pending_batch(self);
+    }
+
+  if (result == LTR_SUCCESS)
+    result = _py_invoke_flush(self);
   PyGILState_Release(gstate);
   return result;
 };
@@ -574,6 +831,7 @@ python_dd_disconnect(LogThreadedDestDriver *d)
 {
   PythonDestDriver *self = (PythonDestDriver *) d;
 
+  _clear_pending_batch(self);
   python_dd_close(self);
 }
 
@@ -595,6 +853,8 @@ python_dd_init(LogPipe *d)
     goto fail;
   PyGILState_Release(gstate);
 
+  self->super.worker.insert = self->py.send_batch ? python_dd_insert_batched : python_dd_insert;
+
   if (!log_threaded_dest_driver_init_method(d))
     return FALSE;
 
@@ -641,6 +901,8 @@ python_dd_free(LogPipe *d)
   _py_free_bindings(self);
   PyGILState_Release(gstate);
 
+  _clear_pending_batch(self);
+  g_array_free(self->pending_batch, TRUE);
   value_pairs_unref(self->vp);
 
   python_binding_clear(&self->binding);
@@ -654,6 +916,7 @@ python_dd_new(GlobalConfig *cfg)
 
   log_threaded_dest_driver_init_instance(&self->super, cfg);
   log_template_options_defaults(&self->template_options);
+  self->pending_batch = g_array_new(FALSE, FALSE, sizeof(PythonDestPendingMessage));
 
   self->super.super.super.super.init = python_dd_init;
   self->super.super.super.super.deinit = python_dd_deinit;
@@ -157,7 +157,8 @@ _py_log_message_ass_subscript(PyObject *o, PyObject *key, PyObject *value)
 static void
 py_log_message_free(PyLogMessage *self)
 {
-  log_msg_unref(self->msg);
+  if (self->msg)
+    log_msg_unref(self->msg);
   Py_CLEAR(self->bookmark_data);
   Py_TYPE(self)->tp_free((PyObject *) self);
 }
@@ -181,6 +182,19 @@ py_log_message_new(LogMessage *msg, GlobalConfig *cfg)
   return (PyObject *) self;
 }
 
+/* Point an existing wrapper, not referenced by Python code anymore, to
+ * another message.  A NULL @msg releases the message held by the wrapper. */
+void
+py_log_message_rebind(PyObject *s, LogMessage *msg)
+{
+  PyLogMessage *self = (PyLogMessage *) s;
+
+  if (self->msg)
+    log_msg_unref(self->msg);
+  self->msg = msg ? log_msg_ref(msg) : NULL;
+  Py_CLEAR(self->bookmark_data);
+}
+
 static int
 py_log_message_init(PyObject *s, PyObject *args, PyObject *kwds)
 {
@@ -38,6 +38,7 @@ extern PyTypeObject py_log_message_type;
 
 int py_is_log_message(PyObject *obj);
 PyObject *py_log_message_new(LogMessage *msg, GlobalConfig *cfg);
+void py_log_message_rebind(PyObject *s, LogMessage *msg);
 
 void py_log_message_global_init(void);
 
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+/* this has to come first for modules which include the Python.h header */
+#include "python-module.h"
+
+#include <criterion/criterion.h>
+
+#include "python-helpers.h"
+#include "python-dest.h"
+#include "python-options.h"
+#include "python-main.h"
+#include "python-startup.h"
+#include "python-global.h"
+#include "logthrdest/logthrdestdrv.h"
+#include "value-pairs/value-pairs.h"
+#include "mainloop-worker.h"
+#include "mainloop.h"
+#include "apphook.h"
+
+#include <time.h>
+
+MainLoop *main_loop;
+MainLoopOptions main_loop_options = {0};
+
+CFG_LTYPE yyltype;
+GlobalConfig *empty_cfg;
+
+static void
+_load_code(const gchar *code)
+{
+  PyGILState_STATE gstate;
+  gstate = PyGILState_Ensure();
+  cr_assert(python_evaluate_global_code(empty_cfg, code, &yyltype));
+  PyGILState_Release(gstate);
+}
+
+static gboolean
+_eval_bool(const gchar *expression)
+{
+  PyGILState_STATE gstate;
+  gstate = PyGILState_Ensure();
+
+  PyObject *globals = PyModule_GetDict(_py_get_main_module(python_config_get(empty_cfg)));
+  PyObject *result = PyRun_String(expression, Py_eval_input, globals, globals);
+  cr_assert_not_null(result, "error evaluating Python expression: %s", expression);
+
+  gboolean value = PyObject_IsTrue(result);
+  Py_DECREF(result);
+
+  PyGILState_Release(gstate);
+  return value;
+}
+
+#define MAX_SPIN_ITERATIONS 10000
+
+static void
+_spin_for_counter_value(StatsCounterItem *counter, gssize expected_value)
+{
+  struct timespec sleep_time = { 0, 1000000 };
+  gssize value = stats_counter_get(counter);
+
+  for (gint c = 0; value != expected_value && c < MAX_SPIN_ITERATIONS; c++)
+    {
+      nanosleep(&sleep_time, NULL);
+      value = stats_counter_get(counter);
+    }
+  cr_assert_eq(value, expected_value,
+               "counter did not reach the expected value, expected_value=%" G_GSSIZE_FORMAT ", value=%" G_GSSIZE_FORMAT,
+               expected_value, value);
+}
+
+static LogDriver *
+_create_dest(gint batch_lines)
+{
+  LogDriver *d = python_dd_new(empty_cfg);
+  python_binding_set_class(python_dd_get_binding(d), "Dest");
+  ((LogThreadedDestDriver *) d)->batch_lines = batch_lines;
+  return d;
+}
+
+static void
+_start_dest(LogDriver *d)
+{
+  cr_assert(log_pipe_init((LogPipe *) d));
+}
+
+static void
+_stop_dest(LogDriver *d)
+{
+  main_loop_sync_worker_startup_and_teardown();
+  log_pipe_deinit((LogPipe *) d);
+  log_pipe_unref((LogPipe *) d);
+}
+
+/* VALUE is set as bytes if the message is not to be converted by value-pairs() */
+static void
+_send_message(LogDriver *d, const gchar *message, gboolean convertible)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT_NOACK;
+  LogMessage *msg = log_msg_new_empty();
+
+  log_msg_set_value(msg, LM_V_MESSAGE, message, -1);
+  log_msg_set_value_by_name_with_type(msg, "VALUE", message, -1, convertible ? LM_VT_STRING : LM_VT_BYTES);
+  log_pipe_queue((LogPipe *) d, msg, &path_options);
+}
+
+static void
+_set_value_pairs_dropping_unconvertible_messages(LogDriver *d)
+{
+  ValuePairs *vp = value_pairs_new(empty_cfg);
+  LogTemplate *template = log_template_new(empty_cfg, NULL);
+
+  cr_assert(log_template_compile(template, "$VALUE", NULL));
+  value_pairs_add_pair(vp, "value", template);
+  value_pairs_set_include_bytes(vp, TRUE);
+  log_template_unref(template);
+
+  python_dd_set_value_pairs(d, vp);
+  python_dd_get_template_options(d)->on_error = ON_ERROR_DROP_MESSAGE | ON_ERROR_SILENT;
+}
+
+static StatsCounterItem *
+_written_messages(LogDriver *d)
+{
+  return ((LogThreadedDestDriver *) d)->metrics.written_messages;
+}
+
+static StatsCounterItem *
+_dropped_messages(LogDriver *d)
+{
+  return ((LogThreadedDestDriver *) d)->metrics.dropped_messages;
+}
+
+const gchar *python_batch_dest_code = "\n\
+from _syslogng import LogDestination\n\
+sent = []\n\
+ids = []\n\
+kept = []\n\
+def value(v):\n\
+    return v.decode() if isinstance(v, bytes) else v\n\
+class Dest(LogDestination):\n\
+    def send_batch(self, msgs):\n\
+        values = []\n\
+        for msg in msgs:\n\
+            if isinstance(msg, dict):\n\
+                values.append(value(msg['value']))\n\
+            else:\n\
+                values.append(value(msg['MESSAGE']))\n\
+                ids.append(id(msg))\n\
+        sent.extend(values)\n\
+        if self.options.get('keep'):\n\
+            kept.extend(msgs)\n\
+        if self.options.get('per_message'):\n\
+            return [self.DROP if int(v) % 2 else self.SUCCESS for v in values]\n\
+        return self.SUCCESS\n\
+    def init(self, options):\n\
+        self.options = options\n\
+        return True";
+
+static void
+_set_option(LogDriver *d, const gchar *name)
+{
+  PythonOption *opt = python_option_string_new(name, "yes");
+  python_options_add_option(python_dd_get_binding(d)->options, opt);
+  python_option_unref(opt);
+}
+
+Test(python_dest_batch, unconvertible_messages_are_dropped_and_the_rest_of_the_batch_is_sent)
+{
+  _load_code(python_batch_dest_code);
+
+  LogDriver *d = _create_dest(4);
+  _set_value_pairs_dropping_unconvertible_messages(d);
+  _start_dest(d);
+
+  _send_message(d, "0", FALSE);
+  _send_message(d, "1", TRUE);
+  _send_message(d, "2", FALSE);
+  _send_message(d, "3", TRUE);
+  _spin_for_counter_value(_written_messages(d), 2);
+  _spin_for_counter_value(_dropped_messages(d), 2);
+
+  cr_assert(_eval_bool("sent == ['1', '3']"));
+
+  _stop_dest(d);
+}
+
+Test(python_dest_batch, unconvertible_messages_are_dropped_with_per_message_results)
+{
+  _load_code(python_batch_dest_code);
+
+  LogDriver *d = _create_dest(4);
+  _set_option(d, "per_message");
+  _set_value_pairs_dropping_unconvertible_messages(d);
+  _start_dest(d);
+
+  _send_message(d, "1", FALSE);
+  _send_message(d, "2", TRUE);
+  _send_message(d, "4", TRUE);
+  _send_message(d, "5", FALSE);
+  _spin_for_counter_value(_written_messages(d), 2);
+  _spin_for_counter_value(_dropped_messages(d), 2);
+
+  cr_assert(_eval_bool("sent == ['2', '4']"));
+
+  _stop_dest(d);
+}
+
+Test(python_dest_batch, per_message_results_are_applied_to_their_own_message)
+{
+  _load_code(python_batch_dest_code);
+
+  LogDriver *d = _create_dest(4);
+  _set_option(d, "per_message");
+  _start_dest(d);
+
+  for (gint i = 0; i < 4; i++)
+    {
+      gchar buf[8];
+
+      g_snprintf(buf, sizeof(buf), "%d", i);
+      _send_message(d, buf, TRUE);
+    }
+  _spin_for_counter_value(_written_messages(d), 2);
+  _spin_for_counter_value(_dropped_messages(d), 2);
+
+  cr_assert(_eval_bool("sent == ['0', '1', '2', '3']"));
+
+  _stop_dest(d);
+}
+
+Test(python_dest_batch, message_wrappers_are_reused_across_batches)
+{
+  _load_code(python_batch_dest_code);
+
+  LogDriver *d = _create_dest(2);
+  _start_dest(d);
+
+  _send_message(d, "0", TRUE);
+  _send_message(d, "1", TRUE);
+  _spin_for_counter_value(_written_messages(d), 2);
+  _send_message(d, "2", TRUE);
+  _send_message(d, "3", TRUE);
+  _spin_for_counter_value(_written_messages(d), 4);
+
+  cr_assert(_eval_bool("sent == ['0', '1', '2', '3']"));
+  /* batches are at most 2 messages long, so at most 2 wrappers are needed */
+  cr_assert(_eval_bool("len(set(ids)) <= 2"));
+
+  _stop_dest(d);
+}
+
+Test(python_dest_batch, message_wrappers_kept_by_python_code_are_not_reused)
+{
+  _load_code(python_batch_dest_code);
+
+  LogDriver *d = _create_dest(2);
+  _set_option(d, "keep");
+  _start_dest(d);
+
+  _send_message(d, "0", TRUE);
+  _send_message(d, "1", TRUE);
+  _spin_for_counter_value(_written_messages(d), 2);
+  _send_message(d, "2", TRUE);
+  _send_message(d, "3", TRUE);
+  _spin_for_counter_value(_written_messages(d), 4);
+
+  cr_assert(_eval_bool("[value(msg['MESSAGE']) for msg in kept] == ['0', '1', '2', '3']"));
+  cr_assert(_eval_bool("len(set(id(msg) for msg in kept)) == 4"));
+
+  _stop_dest(d);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+
+  main_loop = main_loop_get_instance();
+  main_loop_init(main_loop, &main_loop_options);
+  main_loop_worker_allocate_thread_space(2);
+  main_loop_worker_finalize_thread_space();
+
+  _py_init_interpreter(FALSE);
+
+  empty_cfg = cfg_new_snippet();
+}
+
+static void
+teardown(void)
+{
+  cfg_free(empty_cfg);
+  main_loop_deinit(main_loop);
+  app_shutdown();
+}
+
+TestSuite(python_dest_batch, .init = setup, .fini = teardown);
@@ -36,6 +36,8 @@ static CfgLexerKeyword redis_keywords[] =
   { "port",     KW_PORT },
   { "auth",     KW_AUTH },
   { "timeout",  KW_TIMEOUT },
+  { "max_in_flight", KW_MAX_IN_FLIGHT },
+  { "transaction", KW_TRANSACTION },
   { NULL }
 };
 
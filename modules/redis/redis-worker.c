@@ -29,6 +29,9 @@
 #include "scratch-buffers.h"
 #include "utf8utils.h"
 
+#include <poll.h>
+#include <errno.h>
+
 
 static LogThreadedResult
 _flush(LogThreadedDestWorker *s, LogThreadedFlushMode mode)
@@ -194,6 +197,43 @@ exit:
   return status;
 }
 
+typedef enum
+{
+  REDIS_COMMAND_PENDING,
+  REDIS_COMMAND_EXECUTED,
+  REDIS_COMMAND_NOT_EXECUTED,
+} RedisCommandState;
+
+/* a message of the pipelined mode and the result of its command */
+typedef struct _RedisPipelineEntry
+{
+  LogMessage *msg;
+  RedisCommandState state;
+} RedisPipelineEntry;
+
+static RedisPipelineEntry *
+_pipeline_entry_new(LogMessage *msg)
+{
+  RedisPipelineEntry *self = g_new0(RedisPipelineEntry, 1);
+
+  self->msg = log_msg_ref(msg);
+  self->state = REDIS_COMMAND_PENDING;
+  return self;
+}
+
+static void
+_pipeline_entry_free(RedisPipelineEntry *self)
+{
+  log_msg_unref(self->msg);
+  g_free(self);
+}
+
+static void
+_clear_pipeline_entries(GQueue *entries)
+{
+  while (!g_queue_is_empty(entries))
+    _pipeline_entry_free(g_queue_pop_head(entries));
+}
 
 static gboolean
 redis_worker_init(LogThreadedDestWorker *d)
@@ -208,6 +248,10 @@ redis_worker_init(LogThreadedDestWorker *d)
   self->argv[0] = owner->command->str;
   self->argvlen[0] = owner->command->len;
 
+  self->pipeline = g_queue_new();
+  self->rewound = g_queue_new();
+  self->transactions = g_queue_new();
+
   msg_debug("Worker thread started",
             evt_tag_str("driver", self->super.owner->super.super.id));
 
@@ -234,6 +278,11 @@ redis_worker_deinit(LogThreadedDestWorker *d)
 
   g_free(self->argv);
   g_free(self->argvlen);
+  _clear_pipeline_entries(self->pipeline);
+  g_queue_free(self->pipeline);
+  _clear_pipeline_entries(self->rewound);
+  g_queue_free(self->rewound);
+  g_queue_free(self->transactions);
   redis_worker_disconnect(d);
 
   log_threaded_dest_worker_deinit_method(d);
@@ -272,6 +321,402 @@ _trace_reply_message(redisReply *r)
 
 
 
+/* Pipelined mode (max-in-flight() > 0)
+ *
+ * Commands are appended to the output buffer of the connection as messages
+ * arrive and are written out on every flush without waiting for their
+ * replies.  Replies are processed as they become available, the worker only
+ * blocks if more than max-in-flight() commands are outstanding or when the
+ * queue becomes empty.
+ *
+ * Every message taken from the queue but not acknowledged yet has an entry
+ * in self->pipeline, in queue order.  Redis replies in command order, so
+ * each reply belongs to the oldest entry still waiting for one, and the
+ * entries are acknowledged from the head as soon as their commands are
+ * known to have been executed.
+ *
+ * Redis keeps executing the commands following a failed one, so on an
+ * error reply the rest of the replies are read first.  Then every message
+ * not acknowledged yet is handed back to the framework for rewind/retry,
+ * and their entries are kept in self->rewound: when the messages come back,
+ * the commands Redis has already executed are not sent again.
+ *
+ * Messages in the pipeline are not part of super.batch_size, except for
+ * the current batch.  On failures the connection is freed, so that stale
+ * replies are discarded and connect() opens and authenticates a new one.
+ */
+
+static const gchar *
+_format_command(RedisDestWorker *self, LogMessage *msg)
+{
+  _fill_argv_from_template_list(self, msg);
+  return _argv_to_string(self);
+}
+
+static void
+_skip_resolved_entries(RedisDestWorker *self)
+{
+  while (self->next_reply && ((RedisPipelineEntry *) self->next_reply->data)->state != REDIS_COMMAND_PENDING)
+    self->next_reply = self->next_reply->next;
+}
+
+/* the oldest entry waiting for a reply */
+static GList *
+_find_next_reply(RedisDestWorker *self)
+{
+  if (!self->next_reply)
+    self->next_reply = self->pipeline->head;
+
+  _skip_resolved_entries(self);
+  g_assert(self->next_reply);
+  return self->next_reply;
+}
+
+/* the @n-th entry waiting for a reply, counting from the oldest one */
+static RedisPipelineEntry *
+_peek_pending_entry(RedisDestWorker *self, gint n)
+{
+  for (GList *l = _find_next_reply(self); l; l = l->next)
+    {
+      RedisPipelineEntry *entry = l->data;
+
+      if (entry->state == REDIS_COMMAND_PENDING && n-- == 0)
+        return entry;
+    }
+
+  g_assert_not_reached();
+}
+
+static void
+_resolve_next_command(RedisDestWorker *self, RedisCommandState state)
+{
+  GList *link = _find_next_reply(self);
+
+  ((RedisPipelineEntry *) link->data)->state = state;
+  self->in_flight--;
+
+  /* move on right away, resolved entries may be acknowledged and freed */
+  self->next_reply = link->next;
+  _skip_resolved_entries(self);
+}
+
+static void
+_command_failed(RedisDestWorker *self, const gchar *error)
+{
+  RedisDriver *owner = (RedisDriver *) self->super.owner;
+  ScratchBuffersMarker marker;
+
+  scratch_buffers_mark(&marker);
+  msg_error("REDIS command failed",
+            evt_tag_str("driver", owner->super.super.super.id),
+            evt_tag_str("command", _format_command(self, _peek_pending_entry(self, 0)->msg)),
+            evt_tag_str("error", error));
+  scratch_buffers_reclaim_marked(marker);
+
+  _resolve_next_command(self, REDIS_COMMAND_NOT_EXECUTED);
+}
+
+static void
+_ack_executed_messages(RedisDestWorker *self)
+{
+  RedisPipelineEntry *entry;
+  gint num_executed = 0;
+
+  while ((entry = g_queue_peek_head(self->pipeline)) && entry->state == REDIS_COMMAND_EXECUTED)
+    {
+      g_queue_pop_head(self->pipeline);
+      _pipeline_entry_free(entry);
+      num_executed++;
+    }
+
+  if (num_executed == 0)
+    return;
+
+  self->super.batch_size += num_executed;
+  log_threaded_dest_worker_ack_messages(&self->super, num_executed);
+}
+
+static gboolean
+_pipeline_failed(RedisDestWorker *self)
+{
+  RedisPipelineEntry *entry = g_queue_peek_head(self->pipeline);
+
+  return entry && entry->state == REDIS_COMMAND_NOT_EXECUTED;
+}
+
+/* hands every message not acknowledged yet back to the framework */
+static LogThreadedResult
+_abandon_pipeline(RedisDestWorker *self, LogThreadedResult result)
+{
+  _ack_executed_messages(self);
+
+  /* the messages are rewound in front of the ones rewound earlier */
+  self->super.batch_size = g_queue_get_length(self->pipeline);
+  while (!g_queue_is_empty(self->pipeline))
+    g_queue_push_head(self->rewound, g_queue_pop_tail(self->pipeline));
+
+  self->next_reply = NULL;
+  self->in_flight = 0;
+  self->batch_commands = 0;
+  g_queue_clear(self->transactions);
+  self->transaction_replies = 0;
+
+  redis_worker_disconnect(&self->super);
+  return result;
+}
+
+/* the commands waiting for a reply are retried, as it is unknown whether Redis has executed them */
+static LogThreadedResult
+_pipeline_connection_failed(RedisDestWorker *self, const gchar *error)
+{
+  RedisDriver *owner = (RedisDriver *) self->super.owner;
+
+  msg_error("REDIS server error, suspending",
+            evt_tag_str("driver", owner->super.super.super.id),
+            evt_tag_str("error", error),
+            evt_tag_int("in_flight", self->in_flight),
+            evt_tag_int("time_reopen", self->super.time_reopen));
+
+  return _abandon_pipeline(self, LTR_NOT_CONNECTED);
+}
+
+static void
+_process_command_reply(RedisDestWorker *self, redisReply *reply)
+{
+  if (reply->type == REDIS_REPLY_ERROR)
+    _command_failed(self, reply->str);
+  else
+    _resolve_next_command(self, REDIS_COMMAND_EXECUTED);
+}
+
+static void
+_process_transaction_reply(RedisDestWorker *self, redisReply *reply)
+{
+  RedisDriver *owner = (RedisDriver *) self->super.owner;
+  gint transaction_size = GPOINTER_TO_INT(g_queue_peek_head(self->transactions));
+
+  /* +OK to MULTI, then +QUEUED to each command */
+  if (self->transaction_replies <= transaction_size)
+    {
+      if (reply->type == REDIS_REPLY_ERROR && self->transaction_replies > 0)
+        {
+          ScratchBuffersMarker marker;
+          LogMessage *msg = _peek_pending_entry(self, self->transaction_replies - 1)->msg;
+
+          scratch_buffers_mark(&marker);
+          msg_error("REDIS command rejected, the transaction is going to be aborted",
+                    evt_tag_str("driver", owner->super.super.super.id),
+                    evt_tag_str("command", _format_command(self, msg)),
+                    evt_tag_str("error", reply->str));
+          scratch_buffers_reclaim_marked(marker);
+        }
+      self->transaction_replies++;
+      return;
+    }
+
+  /* the reply to EXEC carries the results of the commands */
+  g_queue_pop_head(self->transactions);
+  self->transaction_replies = 0;
+
+  if (reply->type != REDIS_REPLY_ARRAY || reply->elements != transaction_size)
+    {
+      msg_error("REDIS transaction aborted",
+                evt_tag_str("driver", owner->super.super.super.id),
+                evt_tag_str("error", reply->type == REDIS_REPLY_ERROR ? reply->str : "unexpected reply to EXEC"),
+                evt_tag_int("transaction_size", transaction_size));
+
+      for (gint i = 0; i < transaction_size; i++)
+        _resolve_next_command(self, REDIS_COMMAND_NOT_EXECUTED);
+      return;
+    }
+
+  for (gsize i = 0; i < reply->elements; i++)
+    _process_command_reply(self, reply->element[i]);
+}
+
+static gboolean
+_wait_for_replies(RedisDestWorker *self, gboolean block)
+{
+  RedisDriver *owner = (RedisDriver *) self->super.owner;
+  struct pollfd pfd = { .fd = self->c->fd, .events = POLLIN };
+  gint timeout = 0;
+  gint rc;
+
+  if (block)
+    timeout = owner->timeout.tv_sec > 0 ? owner->timeout.tv_sec * 1000 : -1;
+
+  do
+    rc = poll(&pfd, 1, timeout);
+  while (rc < 0 && errno == EINTR);
+
+  return rc > 0;
+}
+
+/* processes the replies available, waits for more if more than @max_in_flight commands are still unanswered */
+static LogThreadedResult
+_process_replies(RedisDestWorker *self, gint max_in_flight)
+{
+  RedisDriver *owner = (RedisDriver *) self->super.owner;
+
+  while (self->in_flight > 0)
+    {
+      redisReply *reply = NULL;
+
+      if (redisGetReplyFromReader(self->c, (void **) &reply) != REDIS_OK)
+        return _pipeline_connection_failed(self, self->c->errstr);
+
+      if (!reply)
+        {
+          gboolean block = self->in_flight > max_in_flight;
+
+          if (!_wait_for_replies(self, block))
+            {
+              if (block)
+                return _pipeline_connection_failed(self, "timeout while waiting for replies");
+              break;
+            }
+
+          if (redisBufferRead(self->c) != REDIS_OK)
+            return _pipeline_connection_failed(self, self->c->errstr);
+          continue;
+        }
+
+      _trace_reply_message(reply);
+      if (owner->transaction)
+        _process_transaction_reply(self, reply);
+      else
+        _process_command_reply(self, reply);
+      freeReplyObject(reply);
+    }
+
+  _ack_executed_messages(self);
+  return LTR_SUCCESS;
+}
+
+static LogThreadedResult
+_flush_pipelined(LogThreadedDestWorker *s, LogThreadedFlushMode mode)
+{
+  RedisDestWorker *self = (RedisDestWorker *) s;
+  RedisDriver *owner = (RedisDriver *) self->super.owner;
+
+  if (g_queue_is_empty(self->pipeline))
+    return LTR_SUCCESS;
+
+  if (mode == LTF_FLUSH_EXPEDITE)
+    return _abandon_pipeline(self, LTR_RETRY);
+
+  if (self->c == NULL || self->c->err)
+    return _abandon_pipeline(self, LTR_NOT_CONNECTED);
+
+  if (self->batch_commands > 0)
+    {
+      if (owner->transaction)
+        {
+          redisAppendCommand(self->c, "EXEC");
+          g_queue_push_tail(self->transactions, GINT_TO_POINTER(self->batch_commands));
+        }
+
+      self->in_flight += self->batch_commands;
+      self->batch_commands = 0;
+
+      gint done = 0;
+      while (!done)
+        {
+          if (redisBufferWrite(self->c, &done) != REDIS_OK)
+            return _pipeline_connection_failed(self, self->c->errstr);
+        }
+    }
+
+  /* from now on the messages of the batch are only tracked by the pipeline */
+  s->batch_size = 0;
+
+  /* in-flight messages are not part of batch_size, the framework would
+   * not call us again once the queue becomes empty */
+  gint max_in_flight = log_queue_get_length(s->queue) == 0 ? 0 : owner->max_in_flight;
+  LogThreadedResult result = _process_replies(self, max_in_flight);
+  if (result != LTR_SUCCESS)
+    return result;
+
+  if (_pipeline_failed(self))
+    {
+      /* find out which of the commands sent after the failed one have been executed */
+      result = _process_replies(self, 0);
+      if (result != LTR_SUCCESS)
+        return result;
+
+      return _abandon_pipeline(self, LTR_ERROR);
+    }
+
+  return LTR_EXPLICIT_ACK_MGMT;
+}
+
+/* reuses the entry of a rewound message, which tells whether its command has already been executed */
+static RedisPipelineEntry *
+_take_rewound_entry(RedisDestWorker *self, LogMessage *msg)
+{
+  RedisPipelineEntry *entry = g_queue_peek_head(self->rewound);
+
+  if (entry && entry->msg == msg)
+    {
+      g_queue_pop_head(self->rewound);
+      if (entry->state != REDIS_COMMAND_EXECUTED)
+        entry->state = REDIS_COMMAND_PENDING;
+      return entry;
+    }
+
+  /* the rewound messages have been dropped in the meantime */
+  _clear_pipeline_entries(self->rewound);
+  return _pipeline_entry_new(msg);
+}
+
+static LogThreadedResult
+redis_worker_insert_pipelined(LogThreadedDestWorker *s, LogMessage *msg)
+{
+  RedisDestWorker *self = (RedisDestWorker *)s;
+  RedisDriver *owner = (RedisDriver *) self->super.owner;
+  RedisPipelineEntry *entry = _take_rewound_entry(self, msg);
+
+  /* batch_size already includes msg */
+  g_queue_push_tail(self->pipeline, entry);
+
+  if (entry->state == REDIS_COMMAND_EXECUTED)
+    {
+      msg_debug("REDIS command already executed before the message was rewound, not sending it again",
+                evt_tag_str("driver", owner->super.super.super.id));
+      return LTR_QUEUED;
+    }
+
+  if (self->c == NULL || self->c->err)
+    return _abandon_pipeline(self, LTR_NOT_CONNECTED);
+
+  ScratchBuffersMarker marker;
+  scratch_buffers_mark(&marker);
+
+  if (owner->transaction && self->batch_commands == 0)
+    redisAppendCommand(self->c, "MULTI");
+
+  _fill_argv_from_template_list(self, msg);
+
+  if (redisAppendCommandArgv(self->c, self->argc, (const gchar **)self->argv, self->argvlen) != REDIS_OK)
+    {
+      msg_error("REDIS server error, suspending",
+                evt_tag_str("driver", owner->super.super.super.id),
+                evt_tag_str("command", _argv_to_string(self)),
+                evt_tag_str("error", self->c->errstr),
+                evt_tag_int("time_reopen", self->super.time_reopen));
+      scratch_buffers_reclaim_marked(marker);
+      return _abandon_pipeline(self, LTR_NOT_CONNECTED);
+    }
+  self->batch_commands++;
+
+  msg_debug("REDIS command appended",
+            evt_tag_str("driver", owner->super.super.super.id),
+            evt_tag_str("command", _argv_to_string(self)));
+
+  scratch_buffers_reclaim_marked(marker);
+  return LTR_QUEUED;
+}
+
 static gboolean
 send_redis_command(RedisDestWorker *self, const char *format, ...)
 {
@@ -309,10 +754,10 @@ redis_worker_connect(LogThreadedDestWorker *s)
 
   if (self->c && check_connection_to_redis(self))
     return TRUE;
-  else if (self->c)
-    redisReconnect(self->c);
-  else
-    self->c = redisConnectWithTimeout(owner->host, owner->port, owner->timeout);
+
+  /* a new connection is authenticated below, redisReconnect() would skip that */
+  redis_worker_disconnect(s);
+  self->c = redisConnectWithTimeout(owner->host, owner->port, owner->timeout);
 
   if (self->c == NULL || self->c->err)
     {
@@ -358,6 +803,7 @@ redis_worker_connect(LogThreadedDestWorker *s)
 LogThreadedDestWorker *redis_worker_new(LogThreadedDestDriver *o, gint worker_index)
 {
   RedisDestWorker *self = g_new0(RedisDestWorker, 1);
+  RedisDriver *owner = (RedisDriver *) o;
 
   log_threaded_dest_worker_init_instance(&self->super, o, worker_index);
 
@@ -365,9 +811,17 @@ LogThreadedDestWorker *redis_worker_new(LogThreadedDestDriver *o, gint worker_in
   self->super.deinit = redis_worker_deinit;
   self->super.connect = redis_worker_connect;
   self->super.disconnect = redis_worker_disconnect;
-  self->super.insert = o->batch_lines > 0 ? redis_worker_insert_batch : redis_worker_insert;
-  if(o->batch_lines > 0)
-    self->super.flush = _flush;
+  if (owner->max_in_flight > 0)
+    {
+      self->super.insert = redis_worker_insert_pipelined;
+      self->super.flush = _flush_pipelined;
+    }
+  else
+    {
+      self->super.insert = o->batch_lines > 0 ? redis_worker_insert_batch : redis_worker_insert;
+      if(o->batch_lines > 0)
+        self->super.flush = _flush;
+    }
 
   return &self->super;
 }
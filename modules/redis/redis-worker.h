@@ -43,6 +43,19 @@ typedef struct _RedisDestWorker
   gchar **argv;
   size_t *argvlen;
 
+  /* pipelined mode: messages taken from the queue and not acknowledged yet, oldest first */
+  GQueue *pipeline;
+  /* the oldest entry of the pipeline waiting for a reply */
+  GList *next_reply;
+  /* number of commands sent whose replies are pending */
+  gint in_flight;
+  /* number of commands appended in the current batch */
+  gint batch_commands;
+  /* entries of the messages handed back to the queue, to skip the commands already executed */
+  GQueue *rewound;
+  /* size of each MULTI/EXEC block in flight and the number of replies received for the oldest one */
+  GQueue *transactions;
+  gint transaction_replies;
 } RedisDestWorker;
 
 LogThreadedDestWorker *redis_worker_new(LogThreadedDestDriver *owner, gint worker_index);
@@ -69,6 +69,22 @@ redis_dd_set_auth(LogDriver *d, const gchar *auth)
   self->auth = g_strdup(auth);
 }
 
+void
+redis_dd_set_max_in_flight(LogDriver *d, gint max_in_flight)
+{
+  RedisDriver *self = (RedisDriver *)d;
+
+  self->max_in_flight = max_in_flight;
+}
+
+void
+redis_dd_set_transaction(LogDriver *d, gboolean transaction)
+{
+  RedisDriver *self = (RedisDriver *)d;
+
+  self->transaction = transaction;
+}
+
 void
 redis_dd_set_timeout(LogDriver *d, const glong timeout)
 {
@@ -156,6 +172,12 @@ redis_dd_init(LogPipe *s)
       return FALSE;
     }
 
+  if (self->transaction && self->max_in_flight == 0)
+    {
+      msg_warning("WARNING: transaction() is only used by the redis() destination if max-in-flight() is set",
+                  log_pipe_location_tag(s));
+    }
+
   if (!log_threaded_dest_driver_init_method(s))
     return FALSE;
 
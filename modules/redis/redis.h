@@ -36,6 +36,9 @@ typedef struct _RedisDriver
   gint   port;
   gchar *auth;
   struct timeval timeout;
+  /* commands sent ahead of their replies, 0 disables pipelining */
+  gint max_in_flight;
+  gboolean transaction;
 
   LogTemplateOptions template_options;
 
@@ -50,6 +53,8 @@ void redis_dd_set_timeout(LogDriver *d, const glong timeout);
 void redis_dd_set_host(LogDriver *d, const gchar *host);
 void redis_dd_set_port(LogDriver *d, gint port);
 void redis_dd_set_auth(LogDriver *d, const gchar *auth);
+void redis_dd_set_max_in_flight(LogDriver *d, gint max_in_flight);
+void redis_dd_set_transaction(LogDriver *d, gboolean transaction);
 void redis_dd_set_command_ref(LogDriver *d, const gchar *command,
                               GList *arguments);
 LogTemplateOptions *redis_dd_get_template_options(LogDriver *d);
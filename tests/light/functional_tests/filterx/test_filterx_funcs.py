@@ -1381,6 +1381,24 @@ def test_subnet_ipv6_membership(config, syslog_ng):
     assert file_final.read_log() == '{"member":true,"non_member":false}'
 
 
+def test_subnet_list_membership(config, syslog_ng):
+    (file_final,) = create_config(
+        config, r"""
+    result = json();
+    result.member_v4 = "10.1.2.3" in [subnet("192.168.0.0/24"), subnet("10.0.0.0/8"), subnet("2001:db8::/32")];
+    result.member_v6 = ip("2001:db8::1") in [subnet("192.168.0.0/24"), subnet("10.0.0.0/8"), subnet("2001:db8::/32")];
+    result.non_member = "11.0.0.1" in [subnet("192.168.0.0/24"), subnet("10.0.0.0/8"), subnet("2001:db8::/32")];
+    result.mixed = "example.com" in ["example.org", "example.com", subnet("10.0.0.0/8")];
+    result.not_an_address = "example.net" in [subnet("10.0.0.0/8")];
+    $MSG = result;
+    """,
+    )
+    syslog_ng.start(config)
+
+    assert file_final.get_stats()["processed"] == 1
+    assert file_final.read_log() == '{"member_v4":true,"member_v6":true,"non_member":false,"mixed":true,"not_an_address":false}'
+
+
 def test_subnet_repr(config, syslog_ng):
     (file_final,) = create_config(
         config, r"""